@@ -9,27 +9,185 @@
 #include <JuceHeader.h>
 #include "AdditiveVoice.h"
 #include "UnisonProcessor.h"
+#include "DeadlineMonitor.h"
+#include <bitset>
 
 namespace synth
 {
 
-static constexpr int kMaxPolyphony = 8;
+/**
+ * Compact picture of the engine captured on the audio thread when a block
+ * misses its deadline. Plain data only, so it can be copied without allocating.
+ */
+template <typename Config>
+struct BasicEngineSnapshot
+{
+    struct VoiceState
+    {
+        bool active = false;
+        int note = -1;
+        int unisonCount = 0;
+        int activeCount = 0; // harmonics below Nyquist after filtering
+    };
+
+    /**
+     * The scalar voice parameters the report prints. Captured field by field
+     * rather than copying BasicVoiceParams, whose spectra, ratio table and
+     * morph slots would cost kilobytes on a block that is already late.
+     */
+    struct ParamState
+    {
+        float oscRatio = 0.0f;
+        float filterCutoff = 0.0f;
+        float filterBoost = 0.0f;
+        float filterStretch = 0.0f;
+        PartialTuning partialTuning = PartialTuning::harmonic;
+        float waveFilterMix = 0.0f;   // 0 while the waveform filter is off
+        float morphAmount = 0.0f;
+        float morphPosition = 0.0f;
+        int morphSlotsFilled = 0;
+        bool resynthesis = false;     // enabled with a library loaded
+        float resynthesisSpeed = 0.0f;
+        float noiseLevel = 0.0f;
+        float noiseTilt = 0.0f;
+        bool noiseFromWaveform = false;
+        UnisonMode unisonMode = UnisonMode::perVoice;
+        int unisonCount = 0;
+        float unisonDetune = 0.0f;
+        SpectralPanMode spectralPanMode = SpectralPanMode::off;
+        float spectralPanWidth = 0.0f;
+        float envAttack = 0.0f;
+        float envDecay = 0.0f;
+        float envSustain = 0.0f;
+        float envRelease = 0.0f;
+        float partialDecayTilt = 0.0f;
+        float partialAttackDelay = 0.0f;
+        std::array<ModulationSettings::Slot, ModulationSettings::kNumSlots> modulation{};
+
+        void capture(const BasicVoiceParams<Config>& p) noexcept
+        {
+            oscRatio = p.oscRatio;
+            filterCutoff = p.filterCutoff;
+            filterBoost = p.filterBoost;
+            filterStretch = p.filterStretch;
+            partialTuning = p.partialTuning;
+            waveFilterMix = p.waveFilterEnabled ? p.waveFilterMix : 0.0f;
+            morphAmount = p.morphAmount;
+            morphPosition = p.morphPosition;
+            morphSlotsFilled = p.morphSlots.getNumFilled();
+            resynthesis = p.resynthesisEnabled && p.partialLibrary != nullptr;
+            resynthesisSpeed = p.resynthesisSpeed;
+            noiseLevel = p.noiseLevel;
+            noiseTilt = p.noiseTilt;
+            noiseFromWaveform = p.noiseFromWaveform;
+            unisonMode = p.unisonMode;
+            unisonCount = p.unisonCount;
+            unisonDetune = p.unisonDetune;
+            spectralPanMode = p.spectralPanMode;
+            spectralPanWidth = p.spectralPanWidth;
+            envAttack = p.envAttack;
+            envDecay = p.envDecay;
+            envSustain = p.envSustain;
+            envRelease = p.envRelease;
+            partialDecayTilt = p.partialDecayTilt;
+            partialAttackDelay = p.partialAttackDelay;
+            modulation = p.modulation.slots;
+        }
+    };
+
+    juce::int64 blockIndex = 0;
+    double load = 0.0;        // elapsed / budget
+    double budgetMs = 0.0;
+    int numSamples = 0;
+    double sampleRate = 0.0;
+    int activeVoices = 0;
+    std::array<VoiceState, Config::maxPolyphony> voices{};
+    ParamState params;
+
+    /** Human-readable one-block report for logging. */
+    juce::String describe() const
+    {
+        juce::String text;
+        text << "Deadline miss at block " << blockIndex << ": load " << juce::String(load * 100.0, 1)
+             << "% of " << juce::String(budgetMs, 3) << " ms (" << numSamples << " samples @ "
+             << juce::String(sampleRate, 0) << " Hz), " << activeVoices << " active voices\n";
+
+        for (size_t v = 0; v < voices.size(); ++v)
+        {
+            const auto& voice = voices[v];
+            if (voice.active)
+                text << "  voice " << static_cast<int>(v) << ": note " << voice.note
+                     << ", unison " << voice.unisonCount << ", activeCount " << voice.activeCount << "\n";
+        }
+
+        text << "  params: ratio " << params.oscRatio << ", cutoff " << params.filterCutoff
+             << ", boost " << params.filterBoost << " dB, stretch " << params.filterStretch
+             << ", tuning " << static_cast<int>(params.partialTuning)
+             << ", waveMix " << params.waveFilterMix
+             << ", morph " << params.morphAmount << " @ " << params.morphPosition
+             << " (" << params.morphSlotsFilled << " slots)"
+             << ", resynthesis " << (params.resynthesis ? "on" : "off")
+             << " x " << params.resynthesisSpeed
+             << ", noise " << params.noiseLevel << " tilt " << params.noiseTilt << " dB/oct"
+             << (params.noiseFromWaveform ? " (waveform)" : "")
+             << ", unison " << params.unisonCount << " x " << params.unisonDetune << " ct"
+             << (params.unisonMode == UnisonMode::economy ? " (economy)" : "")
+             << ", spectral pan " << static_cast<int>(params.spectralPanMode) << " x " << params.spectralPanWidth
+             << ", ADSR " << params.envAttack << "/" << params.envDecay << "/"
+             << params.envSustain << "/" << params.envRelease
+             << ", partial tilt " << params.partialDecayTilt << " / spread " << params.partialAttackDelay << " s";
+
+        for (int i = 0; i < ModulationSettings::kNumSlots; ++i)
+        {
+            const auto& slot = params.modulation[static_cast<size_t>(i)];
+            if (slot.isActive())
+                text << ", mod " << (i + 1) << ": source " << static_cast<int>(slot.source)
+                     << " -> " << static_cast<int>(slot.destination) << " x " << slot.amount;
+        }
+
+        return text;
+    }
+};
 
 /**
- * Main synthesis engine. Owns:
- *   - juce::Synthesiser with 8 AdditiveVoice instances
- *   - UnisonProcessor for stereo widening
+ * Main synthesis engine, sized at compile time by Config (see EngineConfig.h).
+ * Owns:
+ *   - a juce::Synthesiser with Config::maxPolyphony voices, extended with
+ *     the note history glides need, MPE master-channel pitch bend and the
+ *     channel controllers the modulation matrix reads
+ *   - UnisonProcessor, the post-mix stack behind economy unison
+ *   - ResidualNoise, the noise layer every voice adds its level to
  *   - Shared voice parameters
+ *   - TraceRecorder for audio-thread event timelines (off by default)
+ *   - DeadlineMonitor that snapshots engine state on block overruns
  */
-class AdditiveSynthEngine
+template <typename Config>
+class BasicSynthEngine
 {
 public:
-    AdditiveSynthEngine()
+    static constexpr int kMaxPolyphony = Config::maxPolyphony;
+
+    using Voice = BasicAdditiveVoice<Config>;
+    using VoiceParams = BasicVoiceParams<Config>;
+    using HarmonicData = typename Voice::HarmonicData;
+    using Snapshot = BasicEngineSnapshot<Config>;
+
+    BasicSynthEngine()
     {
+        // The bar and membrane tunings are computed once; do it here rather than on the audio thread
+        Voice::PartialRatios::prepareModelTables();
+
         synth.addSound(new AdditiveSound());
 
         for (int i = 0; i < kMaxPolyphony; ++i)
-            synth.addVoice(new AdditiveVoice(voiceParams));
+        {
+            auto* voice = new Voice(voiceParams);
+            voice->setTraceRecorder(&traceRecorder, i);
+            voice->setNoteHistory(&synth.getNoteHistory());
+            voice->setChannelControllers(&synth.getChannelControllers());
+            voice->setResidualNoise(&residualNoise);
+            synth.addVoice(voice);
+        }
     }
 
     void prepareToPlay(double sampleRate, int samplesPerBlock)
@@ -41,25 +199,84 @@ public:
         // Prepare each voice
         for (int i = 0; i < synth.getNumVoices(); ++i)
         {
-            if (auto* voice = dynamic_cast<AdditiveVoice*>(synth.getVoice(i)))
+            if (auto* voice = dynamic_cast<Voice*>(synth.getVoice(i)))
                 voice->prepareToPlay(sampleRate, samplesPerBlock);
         }
 
         unisonProcessor.prepareToPlay(sampleRate, samplesPerBlock);
+        residualNoise.prepare(sampleRate, samplesPerBlock);
+        deadlineMonitor.prepare(sampleRate);
     }
 
-    void processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+    /** Render one block; instantiated for float and double buffers. */
+    template <typename SampleType>
+    void processBlock(juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages)
     {
         const int numSamples = buffer.getNumSamples();
+        const auto blockStart = TraceRecorder::now();
         buffer.clear();
 
+        if (traceRecorder.isRecording())
+        {
+            for (const auto metadata : midiMessages)
+                traceRecorder.instant(TraceEventType::midi, TraceRecorder::kMidiTrack,
+                                      TraceRecorder::packMidi(metadata.data, metadata.numBytes),
+                                      metadata.samplePosition);
+        }
+
+        const bool noiseFromWaveform = voiceParams.noiseFromWaveform && voiceParams.waveFilterEnabled;
+        residualNoise.beginBlock(numSamples, voiceParams.noiseTilt,
+                                 noiseFromWaveform ? voiceParams.waveFilterSpectrum.data() : nullptr,
+                                 static_cast<int>(voiceParams.waveFilterSpectrum.size()));
+
         // Render synth directly to stereo buffer
-        // (unison detuning + stereo spread is handled inside each AdditiveVoice)
+        // (per-voice unison detuning + stereo spread is handled inside each AdditiveVoice)
         synth.renderNextBlock(buffer, midiMessages, 0, numSamples);
 
+        // Economy unison: voices rendered once, detuned copies stacked from the mix.
+        // Entering it starts from silence rather than the mix from when it was last on
+        if (voiceParams.unisonMode == UnisonMode::economy && unisonMode != UnisonMode::economy)
+            unisonProcessor.reset();
+
+        unisonMode = voiceParams.unisonMode;
+
+        if (unisonMode == UnisonMode::economy)
+        {
+            unisonProcessor.setVoiceCount(voiceParams.unisonCount);
+            unisonProcessor.setDetuneAmount(voiceParams.unisonDetune);
+            unisonProcessor.setStereoWidth(voiceParams.stereoWidth);
+            unisonProcessor.process(buffer, numSamples);
+        }
+
+        // One noise layer for all voices, at the levels they added while rendering
+        residualNoise.render(buffer, numSamples);
+
         // Apply master gain
-        const float gainLinear = juce::Decibels::decibelsToGain(masterGainDb);
+        const auto gainLinear = juce::Decibels::decibelsToGain(static_cast<SampleType>(masterGainDb));
         buffer.applyGain(gainLinear);
+
+        if (traceRecorder.isRecording())
+            traceRecorder.complete(TraceEventType::block, TraceRecorder::kBlockTrack,
+                                   blockStart, numSamples, getNumActiveVoices());
+
+        const double load = deadlineMonitor.blockFinished(blockStart, numSamples);
+        if (deadlineMonitor.isOverrun(load))
+            deadlineMonitor.publish([this, load, numSamples](Snapshot& snapshot)
+                                    { fillSnapshot(snapshot, load, numSamples); });
+    }
+
+    /**
+     * Return to the state of a freshly prepared engine: every voice silenced
+     * and everything carried from note to note cleared, so what is rendered
+     * next doesn't depend on what was rendered before (offline jobs, a
+     * host's transport jump).
+     */
+    void reset()
+    {
+        synth.allNotesOff(0, false);
+        synth.resetHistory();
+        residualNoise.reset();
+        unisonProcessor.reset();
     }
 
     void releaseResources()
@@ -68,21 +285,37 @@ public:
     }
 
     /** Access voice parameters for updating from APVTS. */
-    AdditiveVoiceParams& getVoiceParams() { return voiceParams; }
-    const AdditiveVoiceParams& getVoiceParams() const { return voiceParams; }
+    VoiceParams& getVoiceParams() { return voiceParams; }
+    const VoiceParams& getVoiceParams() const { return voiceParams; }
 
     /** Access unison processor for updating parameters. */
-    UnisonProcessor& getUnisonProcessor() { return unisonProcessor; }
+    BasicUnisonProcessor<Config>& getUnisonProcessor() { return unisonProcessor; }
+
+    /** Audio-thread event tracer; start/stop it from the message thread. */
+    TraceRecorder& getTraceRecorder() { return traceRecorder; }
+
+    /** Overrun counters and the last deadline-miss snapshot. */
+    DeadlineMonitor<Snapshot>& getDeadlineMonitor() { return deadlineMonitor; }
 
     /** Set master gain in dB. */
     void setMasterGain(float gainDb) { masterGainDb = gainDb; }
 
+    /** Number of voices currently sounding (including release tails). */
+    int getNumActiveVoices() const
+    {
+        int count = 0;
+        for (int i = 0; i < synth.getNumVoices(); ++i)
+            if (synth.getVoice(i)->isVoiceActive())
+                ++count;
+        return count;
+    }
+
     /** Get the first active voice's harmonic data for visualization. */
     const HarmonicData* getActiveHarmonicData() const
     {
         for (int i = 0; i < synth.getNumVoices(); ++i)
         {
-            auto* voice = dynamic_cast<const AdditiveVoice*>(synth.getVoice(i));
+            auto* voice = dynamic_cast<const Voice*>(synth.getVoice(i));
             if (voice != nullptr && voice->isVoiceActive())
                 return &voice->getHarmonicData();
         }
@@ -96,13 +329,17 @@ public:
     HarmonicData computePreviewHarmonics() const
     {
         constexpr float refFreq = 440.0f;
-        auto data = HarmonicSeries::compute(
+        typename Voice::PartialRatios ratios;
+        ratios.update({ voiceParams.partialTuning, voiceParams.filterStretch, voiceParams.stringInharmonicity,
+                        voiceParams.customPartialRatios.data(), voiceParams.numCustomPartialRatios });
+
+        auto data = Voice::HarmonicSeries::computePartials(
             voiceParams.oscRatio, voiceParams.sawPhase, voiceParams.sqrPhase,
-            refFreq, currentSampleRate);
+            ratios.countBelow(currentSampleRate * 0.5 / refFreq));
 
         SpectralFilter::apply(
             data, voiceParams.filterCutoff, voiceParams.filterBoost,
-            voiceParams.filterPhase, voiceParams.filterStretch,
+            voiceParams.filterPhase, ratios,
             refFreq, currentSampleRate);
 
         if (voiceParams.waveFilterEnabled && voiceParams.waveFilterMix > 0.0f)
@@ -111,19 +348,197 @@ public:
                 data, voiceParams.waveFilterSpectrum, voiceParams.waveFilterMix);
         }
 
+        if (voiceParams.morphAmount > 0.0f)
+        {
+            HarmonicData scratch;
+            voiceParams.morphSlots.apply(data, voiceParams.morphPosition, voiceParams.morphAmount,
+                                         scratch, getActiveRenderKernels());
+        }
+
+        return data;
+    }
+
+    /**
+     * The oscillator and filter spectrum over every partial, independent of
+     * pitch and tuning (harmonic ratios, and a 1 Hz reference pitch so nothing
+     * is dropped at Nyquist), for storing in a morph slot. The morph itself is
+     * left out, so storing while morphing doesn't feed a slot back into itself.
+     */
+    HarmonicData computeSpectrumSnapshot() const
+    {
+        typename Voice::PartialRatios ratios;
+        ratios.update({});
+
+        auto data = Voice::HarmonicSeries::computePartials(
+            voiceParams.oscRatio, voiceParams.sawPhase, voiceParams.sqrPhase, Config::maxHarmonics);
+
+        SpectralFilter::apply(
+            data, voiceParams.filterCutoff, voiceParams.filterBoost,
+            voiceParams.filterPhase, ratios, 1.0f, currentSampleRate);
+
+        if (voiceParams.waveFilterEnabled && voiceParams.waveFilterMix > 0.0f)
+        {
+            SpectralFilter::applyWaveformFilter(
+                data, voiceParams.waveFilterSpectrum, voiceParams.waveFilterMix);
+        }
+
         return data;
     }
 
 private:
-    juce::Synthesiser synth;
-    AdditiveVoiceParams voiceParams;
-    UnisonProcessor unisonProcessor;
+    /**
+     * juce::Synthesiser, plus what a voice can't see from inside startNote:
+     * the previous note and whether a key is still held (for glides), and
+     * in MPE mode the master channel's pitch wheel, which bends every voice
+     * rather than only the notes playing on channel 1.
+     */
+    class VoiceSynthesiser : public juce::Synthesiser
+    {
+    public:
+        explicit VoiceSynthesiser(const VoiceParams& sharedParams) : params(sharedParams) {}
+
+        const NoteHistory& getNoteHistory() const noexcept { return history; }
+        const ChannelControllers& getChannelControllers() const noexcept { return controllers; }
+
+        /**
+         * Forget the previous note, held keys, pitch wheels and channel
+         * controllers, so the next note neither glides in from an earlier one
+         * nor starts bent or modulated by it. Call with every voice stopped.
+         */
+        void resetHistory() noexcept
+        {
+            history = {};
+            controllers = {};
+            keysDown = {};
+            numKeysDown = 0;
+
+            for (auto& wheel : lastPitchWheelValues)
+                wheel = 8192;
+
+            for (int i = 0; i < getNumVoices(); ++i)
+                static_cast<Voice*>(getVoice(i))->masterPitchWheelMoved(8192);
+        }
+
+        void noteOn(int midiChannel, int midiNoteNumber, float velocity) override
+        {
+            history.keyHeld = numKeysDown > 0;
+            juce::Synthesiser::noteOn(midiChannel, midiNoteNumber, velocity);
+            history.previousNote = midiNoteNumber;
+            setKeyDown(midiChannel, midiNoteNumber, true);
+        }
+
+        void noteOff(int midiChannel, int midiNoteNumber, float velocity, bool allowTailOff) override
+        {
+            setKeyDown(midiChannel, midiNoteNumber, false);
+            juce::Synthesiser::noteOff(midiChannel, midiNoteNumber, velocity, allowTailOff);
+        }
+
+        void allNotesOff(int midiChannel, bool allowTailOff) override
+        {
+            for (int channel = 1; channel <= 16; ++channel)
+                if (midiChannel <= 0 || midiChannel == channel)
+                    for (int note = 0; note < 128; ++note)
+                        setKeyDown(channel, note, false);
+
+            juce::Synthesiser::allNotesOff(midiChannel, allowTailOff);
+        }
+
+        void handlePitchWheel(int midiChannel, int wheelValue) override
+        {
+            if (params.mpeEnabled && midiChannel == 1)
+            {
+                for (int i = 0; i < getNumVoices(); ++i)
+                    static_cast<Voice*>(getVoice(i))->masterPitchWheelMoved(wheelValue);
+
+                return;
+            }
+
+            juce::Synthesiser::handlePitchWheel(midiChannel, wheelValue);
+        }
+
+        void handleController(int midiChannel, int controllerNumber, int controllerValue) override
+        {
+            if (controllerNumber == 1 && juce::isPositiveAndBelow(midiChannel - 1, 16))
+                controllers.modWheel[static_cast<size_t>(midiChannel - 1)] = controllerValue / 127.0f;
+
+            juce::Synthesiser::handleController(midiChannel, controllerNumber, controllerValue);
+        }
+
+        void handleChannelPressure(int midiChannel, int channelPressureValue) override
+        {
+            if (juce::isPositiveAndBelow(midiChannel - 1, 16))
+                controllers.pressure[static_cast<size_t>(midiChannel - 1)] = channelPressureValue / 127.0f;
+
+            juce::Synthesiser::handleChannelPressure(midiChannel, channelPressureValue);
+        }
+
+    private:
+        const VoiceParams& params;
+        NoteHistory history;
+        ChannelControllers controllers;
+        std::array<std::bitset<128>, 16> keysDown;
+        int numKeysDown = 0;
+
+        void setKeyDown(int midiChannel, int midiNoteNumber, bool isDown) noexcept
+        {
+            if (!juce::isPositiveAndBelow(midiChannel - 1, 16) || !juce::isPositiveAndBelow(midiNoteNumber, 128))
+                return;
+
+            auto& keys = keysDown[static_cast<size_t>(midiChannel - 1)];
+            if (keys.test(static_cast<size_t>(midiNoteNumber)) == isDown)
+                return;
+
+            keys.set(static_cast<size_t>(midiNoteNumber), isDown);
+            numKeysDown += isDown ? 1 : -1;
+        }
+    };
+
+    // Declared first so it outlives the voices that hold a pointer to it
+    TraceRecorder traceRecorder;
+
+    VoiceParams voiceParams;
+    VoiceSynthesiser synth{ voiceParams };
+    BasicUnisonProcessor<Config> unisonProcessor;
+    UnisonMode unisonMode = UnisonMode::perVoice;  // as of the last block
+    ResidualNoise residualNoise;
     float masterGainDb = 0.0f;
 
+    DeadlineMonitor<Snapshot> deadlineMonitor;
+
     double currentSampleRate = 44100.0;
     int currentBlockSize = 512;
 
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AdditiveSynthEngine)
+    void fillSnapshot(Snapshot& snapshot, double load, int numSamples) const noexcept
+    {
+        snapshot.blockIndex = deadlineMonitor.getStats().blocks;
+        snapshot.load = load;
+        snapshot.numSamples = numSamples;
+        snapshot.sampleRate = currentSampleRate;
+        snapshot.budgetMs = 1000.0 * numSamples / currentSampleRate;
+        snapshot.activeVoices = 0;
+        snapshot.params.capture(voiceParams);
+
+        for (int i = 0; i < kMaxPolyphony; ++i)
+        {
+            auto& state = snapshot.voices[static_cast<size_t>(i)];
+            state = {};
+
+            auto* voice = dynamic_cast<const Voice*>(synth.getVoice(i));
+            if (voice == nullptr || !voice->isVoiceActive())
+                continue;
+
+            state.active = true;
+            state.note = voice->getCurrentlyPlayingNote();
+            state.unisonCount = voice->getUnisonCount();
+            state.activeCount = voice->getHarmonicData().activeCount;
+            ++snapshot.activeVoices;
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BasicSynthEngine)
 };
 
+using EngineSnapshot      = BasicEngineSnapshot<ActiveEngineConfig>;
+using AdditiveSynthEngine = BasicSynthEngine<ActiveEngineConfig>;
+
 } // namespace synth
@@ -7,9 +7,23 @@
 #pragma once
 
 #include <JuceHeader.h>
-#include "SineLUT.h"
+#include "SineKernels.h"
+#include "DsfOscillator.h"
 #include "HarmonicSeries.h"
+#include "ModulationMatrix.h"
+#include "PartialRatios.h"
+#include "PartialDataFile.h"
+#include "PartialTracks.h"
+#include "ResidualNoise.h"
+#include "PartialEnvelopes.h"
+#include "PitchControl.h"
+#include "SpectralMorph.h"
+#include "SpectralPan.h"
 #include "SpectralFilter.h"
+#include "RenderKernels.h"
+#include "TraceRecorder.h"
+#include "UnisonProcessor.h"
+#include <type_traits>
 
 namespace synth
 {
@@ -27,7 +41,8 @@ public:
 /**
  * Parameters shared across all voices, updated from APVTS on the audio thread.
  */
-struct AdditiveVoiceParams
+template <typename Config>
+struct BasicVoiceParams
 {
     float oscRatio      = 0.5f;   // 0=square, 1=saw
     float sawPhase      = 0.0f;   // radians
@@ -35,15 +50,46 @@ struct AdditiveVoiceParams
     float filterCutoff  = 128.0f; // harmonic number
     float filterBoost   = 0.0f;   // dB
     float filterPhase   = 0.0f;   // radians
-    float filterStretch = 1.0f;   // stretch factor
+    float filterStretch = 1.0f;   // partial ratio exponent (ratio^stretch)
+
+    // Partial frequencies (see PartialRatios.h): a model, or a custom table
+    PartialTuning partialTuning = PartialTuning::harmonic;
+    float stringInharmonicity   = 0.001f; // B, PartialTuning::stiffString
+    std::array<float, Config::maxHarmonics> customPartialRatios{};
+    int   numCustomPartialRatios = 0;     // PartialTuning::custom; 0 = harmonic
 
     // Waveform filter (imported spectrum)
     bool  waveFilterEnabled = false;
     float waveFilterMix     = 0.0f;
-    std::array<float, kMaxHarmonics> waveFilterSpectrum{};
+    std::array<float, Config::maxHarmonics> waveFilterSpectrum{};
+
+    // Spectral morph (see SpectralMorph.h): amount 0 = the oscillator and
+    // filter spectrum alone, 1 = the stored spectrum at morphPosition
+    float morphAmount   = 0.0f;   // 0..1
+    float morphPosition = 0.0f;   // 0..1 across the filled slots, in slot order
+    BasicMorphSlots<Config::maxHarmonics> morphSlots;
+
+    // Resynthesis (see PartialTracks.h): the voice plays the tracks of the
+    // library's set for its note instead of the oscillator and filters. The
+    // library is owned by the processor, which keeps it alive while any block
+    // can read it; the prefetcher (may be nullptr) pages mapped sets in ahead.
+    bool  resynthesisEnabled = false;
+    const PartialLibrary* partialLibrary = nullptr;
+    PartialPrefetcher* partialPrefetcher = nullptr;
+    float resynthesisSpeed = 1.0f;    // playback rate through the sample, 0 = frozen
 
-    // Unison (rendered per-voice, not post-processed)
-    int   unisonCount   = 1;      // 1..8
+    // Noise layer (see ResidualNoise.h), synthesised once for all voices by
+    // the engine: each voice adds its level, tilted around its own note
+    float noiseLevel = 0.0f;          // 0..1, RMS of white noise relative to the partials' gain
+    float noiseTilt  = -3.0f;         // dB per octave, pivoting on the note
+    bool  noiseFromWaveform = false;  // shape by the imported waveform's spectral envelope
+
+    // Modulation matrix (see ModulationMatrix.h), evaluated per voice at control rate
+    ModulationSettings modulation;
+
+    // Unison: rendered per voice, or by the engine's UnisonProcessor in economy mode
+    UnisonMode unisonMode = UnisonMode::perVoice;
+    int   unisonCount   = 1;      // 1..Config::maxUnisonVoices
     float unisonDetune  = 10.0f;  // cents
     float stereoWidth   = 0.5f;   // 0..1
 
@@ -52,16 +98,72 @@ struct AdditiveVoiceParams
     float envDecay   = 0.1f;
     float envSustain = 0.8f;
     float envRelease = 0.3f;
+
+    // Per-partial envelopes (see PartialEnvelopes.h); both zero = one shared ADSR.
+    // Latched at note-on.
+    float partialDecayTilt   = 0.0f;  // partial n decays in envDecay / n^tilt
+    float partialAttackDelay = 0.0f;  // seconds per octave of partial number
+
+    // Spectral panning: a stereo position per partial (see SpectralPan.h),
+    // on top of the unison pan spread
+    SpectralPanMode spectralPanMode = SpectralPanMode::off;
+    float spectralPanWidth = 0.0f;    // 0..1
+    int   spectralPanSeed  = 1;       // SpectralPanMode::random
+
+    // Pitch (see PitchControl.h). In MPE mode MIDI channel 1 is the master
+    // channel, bending every note, and each other channel carries one note
+    // with its own pitch bend.
+    float     pitchBendRange    = 2.0f;   // semitones (MPE: master channel)
+    bool      mpeEnabled        = false;
+    float     mpePitchBendRange = 48.0f;  // semitones, per-note bend in MPE mode
+    GlideMode glideMode         = GlideMode::off;
+    float     glideTime         = 0.1f;   // seconds, whatever the interval
+
+    // Offline rendering (host bounce/export): double-precision phase, exact sine,
+    // harmonics rebuilt every kHighQualityControlInterval samples with per-sample
+    // amplitude ramps. Set from AudioProcessor::isNonRealtime().
+    bool highQuality = false;
+
+    // Sine evaluation per render path (see SineKernels.h)
+    SineKernel realtimeSineKernel = SineKernel::table;
+    SineKernel offlineSineKernel  = SineKernel::exact;
+
+    // Render unfiltered saw/square blends in closed form when cheaper (see DsfOscillator)
+    bool allowClosedForm = true;
 };
 
 /**
  * Single voice for additive synthesis.
- * Maintains 256 phase accumulators and renders via SineLUT.
+ * Maintains Config::maxHarmonics phase accumulators per unison sub-voice and
+ * evaluates each partial with the sine kernel chosen for the current path.
+ *
+ * Unfiltered saw/square blends with enough partials take a closed-form
+ * shortcut on the real-time path (see DsfOscillator, canUseClosedForm).
+ *
+ * With modulation routed (see ModulationMatrix.h) a block is rendered in
+ * spans of VoiceModulation::kControlInterval samples, one control point
+ * each; the spectrum is rebuilt mid-block only when a span's modulation
+ * moved a spectral parameter (see Rebuild).
+ *
+ * Renders natively into float or double buffers (see renderRealtime). When
+ * params.highQuality is set the voice renders through a separate exact path
+ * instead (see renderHighQuality). Switching between paths mid-note carries
+ * the phases across, so the change is inaudible.
  */
-class AdditiveVoice : public juce::SynthesiserVoice
+template <typename Config>
+class BasicAdditiveVoice : public juce::SynthesiserVoice
 {
 public:
-    AdditiveVoice(const AdditiveVoiceParams& sharedParams)
+    static constexpr int kMaxHarmonics = Config::maxHarmonics;
+    static constexpr int kMaxUnisonVoices = Config::maxUnisonVoices;
+
+    using Params = BasicVoiceParams<Config>;
+    using HarmonicData = BasicHarmonicData<kMaxHarmonics>;
+    using HarmonicSeries = BasicHarmonicSeries<kMaxHarmonics>;
+    using PartialEnvelopes = BasicPartialEnvelopes<kMaxHarmonics>;
+    using PartialRatios = BasicPartialRatios<kMaxHarmonics>;
+
+    BasicAdditiveVoice(const Params& sharedParams)
         : params(sharedParams)
     {
     }
@@ -72,28 +174,65 @@ public:
     }
 
     void startNote(int midiNoteNumber, float velocity,
-                   juce::SynthesiserSound*, int /*currentPitchWheelPosition*/) override
+                   juce::SynthesiserSound*, int currentPitchWheelPosition) override
     {
         noteVelocity = velocity;
-        noteFrequency = static_cast<float>(juce::MidiMessage::getMidiNoteInHertz(midiNoteNumber));
+        noteFrequencyHz = juce::MidiMessage::getMidiNoteInHertz(midiNoteNumber);
+
+        // Modulation first: its pitch and spectral offsets apply from the first sample
+        notePressure = 0.0f;
+        noteChannel = 1;
+        for (int channel = 1; channel <= 16; ++channel)
+            if (isPlayingChannel(channel))
+                noteChannel = channel;
+
+        modulationActive = params.modulation.isActive();
+        updateControllers();
+        modulation.noteOn(params.modulation, velocity, midiNoteNumber, voiceIndex);
+
+        // Pitch: this channel's wheel, and a glide in from the previous note when asked for
+        noteWheelPosition = currentPitchWheelPosition;
+        const bool glide = noteHistory != nullptr
+                           && (params.glideMode == GlideMode::always
+                               || (params.glideMode == GlideMode::legato && noteHistory->keyHeld));
+        updatePitchBend();
+        pitch.startNote(midiNoteNumber, glide ? noteHistory->previousNote : -1, params.glideTime, currentSampleRate);
 
         // Reset phase accumulators for all unison sub-voices
         for (auto& arr : uniPhaseAccumulators)
             arr.fill(0.0f);
+        for (auto& arr : uniPhasesDouble)
+            arr.fill(0.0);
+        closedFormActive = false;
+        resynthesisSeconds = 0.0;
+        prefetchedTracks = nullptr;
 
         // Update ADSR parameters and start envelope
+        partialEnvelopesActive = params.partialDecayTilt != 0.0f || params.partialAttackDelay > 0.0f;
         updateADSR();
         adsr.noteOn();
 
+        if (partialEnvelopesActive)
+            partialEnvelopes.noteOn(*renderKernels);
+
         // Compute initial harmonics
-        rebuildHarmonics();
+        rebuildHarmonics(Rebuild::full);
+
+        if (traceRecorder != nullptr)
+            traceRecorder->instant(TraceEventType::voiceStart, TraceRecorder::voiceTrack(voiceIndex),
+                                   midiNoteNumber, juce::roundToInt(velocity * 127.0f));
     }
 
     void stopNote(float /*velocity*/, bool allowTailOff) override
     {
+        if (traceRecorder != nullptr)
+            traceRecorder->instant(TraceEventType::voiceStop, TraceRecorder::voiceTrack(voiceIndex),
+                                   getCurrentlyPlayingNote(), allowTailOff ? 1 : 0);
+
         if (allowTailOff)
         {
             adsr.noteOff();
+            modulation.noteOff();
         }
         else
         {
@@ -102,144 +241,996 @@ public:
         }
     }
 
-    void pitchWheelMoved(int /*newPitchWheelValue*/) override {}
+    /** This note's channel wheel; applied from the next block on, ramped across it. */
+    void pitchWheelMoved(int newPitchWheelValue) override { noteWheelPosition = newPitchWheelValue; }
+
+    /** MPE master-channel wheel, which bends every note; sent to all voices, playing or not. */
+    void masterPitchWheelMoved(int newPitchWheelValue) noexcept { masterWheelPosition = newPitchWheelValue; }
+
+    /** Where startNote looks up the previous note for glides (may be nullptr: no glide). */
+    void setNoteHistory(const NoteHistory* history) noexcept { noteHistory = history; }
+
+    /** The engine's shared noise layer the voice adds its level to (may be nullptr: no noise). */
+    void setResidualNoise(ResidualNoise* noise) noexcept { residualNoise = noise; }
+
+    /** Where the voice reads its channel's mod wheel and pressure (may be nullptr: both at zero). */
+    void setChannelControllers(const ChannelControllers* controllers) noexcept { channelControllers = controllers; }
+
+    /** Channel controllers are read from setChannelControllers' state at each control point instead. */
     void controllerMoved(int /*controllerNumber*/, int /*newControllerValue*/) override {}
 
+    /** Polyphonic pressure on this note; the mod matrix takes the larger of it and channel pressure. */
+    void aftertouchChanged(int newAftertouchValue) override { notePressure = newAftertouchValue / 127.0f; }
+
     void prepareToPlay(double sampleRate, int /*samplesPerBlock*/)
     {
         adsr.setSampleRate(sampleRate);
+        partialEnvelopes.setSampleRate(sampleRate);
+        modulation.setSampleRate(sampleRate);
         currentSampleRate = sampleRate;
     }
 
+    /** Attach an event tracer (may be nullptr). Call before playback starts. */
+    void setTraceRecorder(TraceRecorder* recorder, int indexInEngine)
+    {
+        traceRecorder = recorder;
+        voiceIndex = indexInEngine;
+    }
+
     void renderNextBlock(juce::AudioBuffer<float>& outputBuffer,
                          int startSample, int numSamples) override
+    {
+        renderVoice(outputBuffer, startSample, numSamples);
+    }
+
+    /** Native 64-bit rendering for hosts that process in double precision. */
+    void renderNextBlock(juce::AudioBuffer<double>& outputBuffer,
+                         int startSample, int numSamples) override
+    {
+        renderVoice(outputBuffer, startSample, numSamples);
+    }
+
+    /**
+     * Render with a specific instruction-set variant instead of the one picked
+     * at startup (see getActiveSimdLevel); for benchmarks and A/B tests.
+     */
+    void setSimdLevel(SimdLevel level) noexcept { renderKernels = &getRenderKernels(level); }
+
+    /** Get the current monophonic output for visualization. */
+    float getCurrentOutput() const noexcept { return lastOutput; }
+
+    /** Number of unison sub-voices currently rendered; one in economy mode, where the engine stacks the mix. */
+    int getUnisonCount() const noexcept
+    {
+        return params.unisonMode == UnisonMode::economy ? 1 : juce::jlimit(1, kMaxUnisonVoices, params.unisonCount);
+    }
+
+    /** Get current harmonic data for spectrum visualization. */
+    const HarmonicData& getHarmonicData() const noexcept { return harmonicData; }
+
+    /** True while the voice renders through the closed-form oscillator instead of the partial bank. */
+    bool isUsingClosedForm() const noexcept { return closedFormActive; }
+
+    /** Samples between harmonic rebuilds on the high-quality path. */
+    static constexpr int kHighQualityControlInterval = 32;
+
+    /** Samples between per-partial envelope control points on the real-time path. */
+    static constexpr int kEnvelopeControlInterval = 32;
+
+    /**
+     * Fewest partials for which the closed form beats the SIMD partial bank;
+     * its cost per sample is flat, the bank's grows linearly.
+     */
+    static constexpr int kClosedFormMinPartials = 48;
+
+    /** Largest spectral-filter attenuation of the top partial the closed form may ignore (~-86 dB). */
+    static constexpr float kClosedFormGainTolerance = 5.0e-5f;
+
+private:
+    const Params& params;
+
+    double noteFrequencyHz = 440.0;
+    float noteVelocity = 0.0f;
+    double currentSampleRate = 44100.0;
+    float lastOutput = 0.0f;
+
+    juce::ADSR adsr;
+    double envelopeLevel = 0.0;   // ADSR output at the last sample rendered
+    HarmonicData harmonicData;
+
+    ResidualNoise* residualNoise = nullptr;
+
+    // Modulation matrix state, and where this note's controllers come from
+    VoiceModulation modulation;
+    bool modulationActive = false;
+    const ChannelControllers* channelControllers = nullptr;
+    int noteChannel = 1;
+    float notePressure = 0.0f;
+
+    /**
+     * How much of the spectrum a render span recomputes. Shared parameters
+     * only change between blocks, so inside a block only modulated values
+     * can move: a mid-block rebuild reuses the oscillator series when its
+     * own inputs are unmodulated, and is skipped when nothing spectral moved.
+     */
+    enum class Rebuild
+    {
+        full,       // start of a block: anything may have changed
+        modulated,  // mid-block, after modulation moved a spectral parameter
+        none        // mid-block, spectrum unchanged
+    };
+
+    // The oscillator's saw/square series at the last rebuild, and what it was computed for
+    HarmonicData oscillatorSeries;
+    float seriesRatio = 0.0f;
+    int seriesCount = -1;
+
+    TraceRecorder* traceRecorder = nullptr;
+    int voiceIndex = 0;
+
+    const RenderKernels* renderKernels = &getActiveRenderKernels();
+
+    // Pitch offset from the note (bend, glide) as a per-block ratio ramp
+    VoicePitch pitch;
+    const NoteHistory* noteHistory = nullptr;
+    int noteWheelPosition = 8192, masterWheelPosition = 8192;
+
+    // Per-unison-voice phase accumulators: [unisonIdx][harmonicIdx]
+    std::array<std::array<float, kMaxHarmonics>, kMaxUnisonVoices> uniPhaseAccumulators{};
+
+    // Double-precision phases (radians, same layout as above) for the 64-bit kernel
+    // and the high-quality path; only one of the two sets is live at a time
+    std::array<std::array<double, kMaxHarmonics>, kMaxUnisonVoices> uniPhasesDouble{};
+    bool phasesInDouble = false;
+
+    // Frequency ratio of each partial to the fundamental, rebuilt only when the tuning changes
+    PartialRatios partialRatios;
+
+    // Resynthesis: the lanes' frequency ratios at the last rebuild (unsorted,
+    // unlike partialRatios), and how far into the sample the note has played
+    std::array<double, kMaxHarmonics> trackRatios{};
+    bool resynthesisActive = false;
+    double resynthesisSeconds = 0.0;
+
+    // The set prefetch was last requested for, and the frame it was requested up to
+    const PartialTrackSet* prefetchedTracks = nullptr;
+    int prefetchedUpTo = 0;
+
+    // Float kernel: per-unison phase increments, fixed for the duration of a block
+    std::array<std::array<float, kMaxHarmonics>, kMaxUnisonVoices> partialIncrements{};
+
+    // Double kernel: phase increments of the undetuned note, fixed for the duration
+    // of a block; each unison voice scales them by its detune and the pitch ramp
+    std::array<double, kMaxHarmonics> partialIncrementsDouble{};
+
+    // Per-partial envelopes, and the amplitude ramp of the current control period
+    // (amplitude at ramp position p: envelopeAmplitudes[n] + p * envelopeSteps[n])
+    PartialEnvelopes partialEnvelopes;
+    bool partialEnvelopesActive = false;
+    std::array<float, kMaxHarmonics> envelopeAmplitudes{}, envelopeSteps{};
+
+    // Spectrum between two morph slots, when the morph position falls between them
+    HarmonicData morphScratch;
+
+    // Per-partial stereo gains (see SpectralPan.h), refreshed at rebuild time
+    BasicSpectralPan<kMaxHarmonics> spectralPan;
+    bool spectralPanActive = false;
+
+    // Closed-form path: one oscillator per unison voice, and the spectrum it renders
+    // (numHarmonics == 0 when the current spectrum doesn't qualify)
+    std::array<DsfOscillator, kMaxUnisonVoices> closedFormOscillators;
+    DsfSpectrum closedFormSpectrum;
+    bool closedFormActive = false;
+    int closedFormUnisonCount = 0;
+
+    // High-quality path: per-partial amplitude/phase ramps of the current control period
+    std::array<double, kMaxHarmonics> hqIncrements{};
+    std::array<double, kMaxHarmonics> hqAmplitudes{}, hqAmplitudeSteps{};
+    std::array<double, kMaxHarmonics> hqPhaseOffsets{}, hqPhaseOffsetSteps{};
+
+    template <typename T>
+    void computeUnisonSpread(int uniCount, std::array<T, kMaxUnisonVoices>& freqMul,
+                             std::array<T, kMaxUnisonVoices>& panL,
+                             std::array<T, kMaxUnisonVoices>& panR) const
+    {
+        for (int u = 0; u < uniCount; ++u)
+        {
+            T detuneOffsetCents = T(0);
+            T panPos = T(0.5);
+
+            if (uniCount > 1)
+            {
+                // Spread from -1 to +1
+                const T spread = static_cast<T>(u) / static_cast<T>(uniCount - 1)
+                                 * T(2) - T(1);
+                detuneOffsetCents = static_cast<T>(modulated(ModDestination::unisonDetune, params.unisonDetune)) * spread;
+                panPos = T(0.5) + static_cast<T>(modulated(ModDestination::stereoWidth, params.stereoWidth)) * spread * T(0.5);
+                panPos = juce::jlimit(T(0), T(1), panPos);
+            }
+
+            freqMul[u] = std::pow(T(2), detuneOffsetCents / T(1200));
+            panL[u] = std::cos(panPos * juce::MathConstants<T>::halfPi);
+            panR[u] = std::sin(panPos * juce::MathConstants<T>::halfPi);
+        }
+    }
+
+    /** Shared entry point of the float and double renderNextBlock overloads. */
+    template <typename SampleType>
+    void renderVoice(juce::AudioBuffer<SampleType>& outputBuffer, int startSample, int numSamples)
     {
         if (!isVoiceActive())
             return;
 
-        rebuildHarmonics();
+        const TraceRecorder::ScopedEvent traceSlice(traceRecorder, TraceEventType::renderSlice,
+                                                    TraceRecorder::voiceTrack(voiceIndex),
+                                                    startSample, numSamples);
+
+        // The offline path and the 64-bit kernel both accumulate phase in double
+        usePhaseStorage(params.highQuality || std::is_same_v<SampleType, double>);
+
         updateADSR();
+        modulationActive = params.modulation.isActive();
+
+        if (!modulationActive)
+        {
+            renderSpan(outputBuffer, startSample, numSamples, Rebuild::full);
+        }
+        else
+        {
+            // One control point per span; the first span always rebuilds, as shared parameters may have moved
+            updateControllers();
+
+            for (int offset = 0; offset < numSamples && isVoiceActive(); offset += VoiceModulation::kControlInterval)
+            {
+                const int length = juce::jmin(VoiceModulation::kControlInterval, numSamples - offset);
+                const bool spectrumMoved = modulation.advance(params.modulation, length);
 
-        const auto& sineLUT = SineLUT::getInstance();
-        const int activeHarmonics = harmonicData.activeCount;
-        const int uniCount = juce::jlimit(1, kMaxUnisonVoices, params.unisonCount);
+                renderSpan(outputBuffer, startSample + offset, length,
+                           offset == 0 ? Rebuild::full : spectrumMoved ? Rebuild::modulated : Rebuild::none);
+            }
+        }
+
+        // The noise layer itself is rendered once for all voices by the engine
+        const float noiseLevel = modulated(ModDestination::noiseLevel, params.noiseLevel);
+        if (residualNoise != nullptr && noiseLevel > 0.0f)
+            residualNoise->addVoice(noteVelocity * 0.25 * envelopeLevel * noiseLevel,
+                                    noteFrequencyHz * pitch.getEndRatio(), numSamples);
+    }
+
+    /** Render one span of a block (the whole block when nothing is modulated). */
+    template <typename SampleType>
+    void renderSpan(juce::AudioBuffer<SampleType>& outputBuffer, int startSample, int numSamples, Rebuild rebuild)
+    {
+        // Pitch changes never trigger a rebuild: the kernels ramp the increments instead
+        updatePitchBend();
+        pitch.advance(numSamples);
+
+        // One kernel instantiation per sine kernel; the choice is made once per span
+        if (params.highQuality)
+        {
+            leaveClosedForm();
+            dispatchSineKernel(params.offlineSineKernel, [&](auto kernel)
+            {
+                renderHighQuality<decltype(kernel)::value>(outputBuffer, startSample, numSamples);
+            });
+        }
+        else
+            dispatchSineKernel(params.realtimeSineKernel, [&](auto kernel)
+            {
+                renderRealtime<decltype(kernel)::value>(outputBuffer, startSample, numSamples, rebuild);
+            });
+    }
+
+    /**
+     * Real-time kernel, instantiated once per sample type: the float build
+     * accumulates and mixes in float, the double build in double throughout
+     * (phases, partial sums, envelope), so 64-bit hosts get the extra phase
+     * precision without a conversion pass.
+     *
+     * The float partial loop runs through the SIMD variant chosen at startup
+     * (RenderKernels); silent partials keep advancing their phase there, so
+     * every lane does the same work. The double loop is the scalar
+     * accumulatePartialsDouble, picked per span among its instantiations for
+     * the envelope and panning modes, so neither loop branches per partial.
+     *
+     * When the spectrum qualifies (canUseClosedForm) every unison voice is a
+     * single DsfOscillator instead, whatever the sine kernel.
+     *
+     * Spectral panning switches the float kernel to its stereo variant (one
+     * left/right gain pair per partial, applied under the unison pan).
+     *
+     * Pitch bend and glide scale every phase increment by the block's pitch
+     * ratio ramp, and partials the highest pitch of the block would push past
+     * Nyquist are left out (PartialRatios::getCountBelowNyquist).
+     *
+     * With per-partial envelopes the block is split into control periods of
+     * kEnvelopeControlInterval samples; the kernel ramps each partial's
+     * amplitude across the period instead of reading it from harmonicData.
+     */
+    template <SineKernel Kernel, typename SampleType>
+    void renderRealtime(juce::AudioBuffer<SampleType>& outputBuffer, int startSample, int numSamples,
+                        Rebuild rebuild)
+    {
+        using T = SampleType;
+
+        if (rebuild != Rebuild::none)
+            rebuildHarmonics(rebuild);
+
+        advanceResynthesis(numSamples);
+
+        // Resynthesis lanes past Nyquist are already silenced by the rebuild
+        const int activeHarmonics = resynthesisActive
+                                      ? harmonicData.activeCount
+                                      : juce::jmin(harmonicData.activeCount,
+                                                   partialRatios.getCountBelowNyquist(noteFrequencyHz * pitch.getHighestRatio(),
+                                                                                      currentSampleRate * 0.5));
+        const double ratioStep = (pitch.getEndRatio() - pitch.getStartRatio()) / numSamples;
+        const int uniCount = getUnisonCount();
         const bool isStereo = outputBuffer.getNumChannels() >= 2;
 
         // Gain normalization: constant-power across unison voices
-        const float gainPerUni = 1.0f / std::sqrt(static_cast<float>(uniCount));
+        const T gainPerUni = T(1) / std::sqrt(static_cast<T>(uniCount));
 
         // Precompute per-unison frequency multiplier and stereo pan
-        std::array<float, kMaxUnisonVoices> freqMul{};
-        std::array<float, kMaxUnisonVoices> panL{}, panR{};
+        std::array<T, kMaxUnisonVoices> freqMul{};
+        std::array<T, kMaxUnisonVoices> panL{}, panR{};
+        computeUnisonSpread(uniCount, freqMul, panL, panR);
 
-        for (int u = 0; u < uniCount; ++u)
+        constexpr T twoPi = juce::MathConstants<T>::twoPi;
+        const T invSampleRate = T(1) / static_cast<T>(currentSampleRate);
+        const T fundamental = static_cast<T>(noteFrequencyHz);
+        const double* ratios = getCurrentRatios();
+        const T noteGain = static_cast<T>(noteVelocity) * T(0.25);
+        auto& phaseAccumulators = getPhaseAccumulators<T>();
+        const auto accumulatePartials = renderKernels->accumulatePartials[static_cast<int>(Kernel)];
+        const auto accumulatePartialsRamped = renderKernels->accumulatePartialsRamped[static_cast<int>(Kernel)];
+        const auto accumulatePartialsStereo = renderKernels->accumulatePartialsStereo[static_cast<int>(Kernel)];
+        const int endSample = startSample + numSamples;
+        int rampPosition = 0, rampLength = 0;
+        const bool useClosedForm = closedFormSpectrum.numHarmonics > 0 && pitch.isSteady();
+
+        if (useClosedForm)
+            enterClosedForm(uniCount, freqMul, activeHarmonics);
+        else
+            leaveClosedForm();
+
+        // Nothing here changes within the block: float has one increment per unison
+        // voice and partial, double one per partial scaled by each voice's detune
+        DoublePartialLoop accumulateDouble = nullptr;
+
+        if constexpr (std::is_same_v<T, float>)
         {
-            float detuneOffsetCents = 0.0f;
-            float panPos = 0.5f;
+            if (!useClosedForm)
+                for (int u = 0; u < uniCount; ++u)
+                {
+                    const T unisonIncrement = twoPi * fundamental * freqMul[u] * invSampleRate;
 
-            if (uniCount > 1)
+                    for (int n = 0; n < activeHarmonics; ++n)
+                        partialIncrements[u][n] = unisonIncrement * static_cast<T>(ratios[n]);
+                }
+        }
+        else
+        {
+            if (!useClosedForm)
             {
-                // Spread from -1 to +1
-                const float spread = static_cast<float>(u) / static_cast<float>(uniCount - 1)
-                                     * 2.0f - 1.0f;
-                detuneOffsetCents = params.unisonDetune * spread;
-                panPos = 0.5f + params.stereoWidth * spread * 0.5f;
-                panPos = juce::jlimit(0.0f, 1.0f, panPos);
+                const T noteIncrement = twoPi * fundamental * invSampleRate;
+
+                for (int n = 0; n < activeHarmonics; ++n)
+                    partialIncrementsDouble[n] = noteIncrement * ratios[n];
             }
 
-            freqMul[u] = std::pow(2.0f, detuneOffsetCents / 1200.0f);
-            panL[u] = std::cos(panPos * juce::MathConstants<float>::halfPi);
-            panR[u] = std::sin(panPos * juce::MathConstants<float>::halfPi);
+            accumulateDouble = partialEnvelopesActive
+                                 ? (spectralPanActive ? &accumulatePartialsDouble<Kernel, true, true>
+                                                      : &accumulatePartialsDouble<Kernel, true, false>)
+                                 : (spectralPanActive ? &accumulatePartialsDouble<Kernel, false, true>
+                                                      : &accumulatePartialsDouble<Kernel, false, false>);
         }
 
-        const float invSampleRate = 1.0f / static_cast<float>(currentSampleRate);
-
-        for (int sample = startSample; sample < startSample + numSamples; ++sample)
+        for (int sample = startSample; sample < endSample; ++sample, ++rampPosition)
         {
-            float leftOut = 0.0f;
-            float rightOut = 0.0f;
+            T leftOut = T(0);
+            T rightOut = T(0);
+            const T pitchRatio = static_cast<T>(pitch.getStartRatio() + ratioStep * (sample - startSample));
+
+            if (partialEnvelopesActive && rampPosition == rampLength)
+            {
+                rampLength = juce::jmin(kEnvelopeControlInterval, endSample - sample);
+                rampPosition = 0;
+                prepareEnvelopeRamp(rampLength, activeHarmonics);
+            }
 
             for (int u = 0; u < uniCount; ++u)
             {
-                float uniOutput = 0.0f;
+                T uniOutput = T(0);
+                T uniRight = T(0); // only with spectral panning; otherwise both channels take uniOutput
 
-                for (int n = 0; n < activeHarmonics; ++n)
+                if (useClosedForm)
                 {
-                    if (harmonicData.amplitudes[n] <= 0.0f)
-                        continue;
-
-                    uniOutput += harmonicData.amplitudes[n]
-                                 * sineLUT.lookup(uniPhaseAccumulators[u][n]
-                                                  + harmonicData.phases[n]);
-
-                    // Advance phase: detuned frequency per unison voice
-                    const float stretchedN = std::pow(static_cast<float>(n + 1),
-                                                      params.filterStretch);
-                    const float freq = noteFrequency * freqMul[u] * stretchedN;
-                    uniPhaseAccumulators[u][n] += SineLUT::kTwoPi * freq * invSampleRate;
+                    uniOutput = static_cast<T>(closedFormOscillators[u].next());
+                }
+                else if constexpr (std::is_same_v<T, float>)
+                {
+                    if (spectralPanActive)
+                    {
+                        StereoPartials partials;
+                        partials.phases = phaseAccumulators[u].data();
+                        partials.increments = partialIncrements[u].data();
+                        partials.incrementScale = pitchRatio;
+                        partials.amplitudes = partialEnvelopesActive ? envelopeAmplitudes.data()
+                                                                     : harmonicData.amplitudes.data();
+                        partials.amplitudeSteps = partialEnvelopesActive ? envelopeSteps.data() : nullptr;
+                        partials.rampPosition = static_cast<float>(rampPosition);
+                        partials.phaseOffsets = harmonicData.phases.data();
+                        partials.gainsLeft = spectralPan.getLeftGains();
+                        partials.gainsRight = spectralPan.getRightGains();
 
-                    if (uniPhaseAccumulators[u][n] >= SineLUT::kTwoPi)
-                        uniPhaseAccumulators[u][n] -= SineLUT::kTwoPi;
+                        const auto sum = accumulatePartialsStereo(partials, activeHarmonics);
+                        uniOutput = sum.left;
+                        uniRight = sum.right;
+                    }
+                    else if (partialEnvelopesActive)
+                        uniOutput = accumulatePartialsRamped(phaseAccumulators[u].data(), partialIncrements[u].data(),
+                                                             pitchRatio, envelopeAmplitudes.data(), envelopeSteps.data(),
+                                                             static_cast<float>(rampPosition),
+                                                             harmonicData.phases.data(), activeHarmonics);
+                    else
+                        uniOutput = accumulatePartials(phaseAccumulators[u].data(), partialIncrements[u].data(),
+                                                       pitchRatio, harmonicData.amplitudes.data(), harmonicData.phases.data(),
+                                                       activeHarmonics);
+                }
+                else
+                {
+                    const auto sum = accumulateDouble(phaseAccumulators[u].data(), partialIncrementsDouble.data(),
+                                                      freqMul[u] * pitchRatio,
+                                                      partialEnvelopesActive ? envelopeAmplitudes.data()
+                                                                             : harmonicData.amplitudes.data(),
+                                                      envelopeSteps.data(), static_cast<double>(rampPosition),
+                                                      harmonicData.phases.data(), spectralPan.getLeftGains(),
+                                                      spectralPan.getRightGains(), activeHarmonics);
+                    uniOutput = sum.left;
+                    uniRight = sum.right;
                 }
 
+                if (!spectralPanActive || useClosedForm)
+                    uniRight = uniOutput;
+
                 leftOut  += uniOutput * panL[u] * gainPerUni;
-                rightOut += uniOutput * panR[u] * gainPerUni;
+                rightOut += uniRight * panR[u] * gainPerUni;
             }
 
             // Apply ADSR envelope and velocity
-            const float envelopeValue = adsr.getNextSample();
-            leftOut  *= envelopeValue * noteVelocity * 0.25f;
-            rightOut *= envelopeValue * noteVelocity * 0.25f;
+            const T envelopeValue = static_cast<T>(adsr.getNextSample());
+            envelopeLevel = static_cast<double>(envelopeValue);
+            leftOut  *= envelopeValue * noteGain;
+            rightOut *= envelopeValue * noteGain;
 
             if (!adsr.isActive())
             {
+                if (traceRecorder != nullptr)
+                    traceRecorder->instant(TraceEventType::voiceStop, TraceRecorder::voiceTrack(voiceIndex),
+                                           getCurrentlyPlayingNote(), 0);
+
                 clearCurrentNote();
                 break;
             }
 
-            outputBuffer.addSample(0, sample, leftOut);
+            outputBuffer.addSample(0, sample, static_cast<SampleType>(leftOut));
             if (isStereo)
-                outputBuffer.addSample(1, sample, rightOut);
+                outputBuffer.addSample(1, sample, static_cast<SampleType>(rightOut));
         }
     }
 
-    /** Get the current monophonic output for visualization. */
-    float getCurrentOutput() const noexcept { return lastOutput; }
+    struct DoubleSum
+    {
+        double left = 0.0, right = 0.0;
+    };
 
-    /** Get current harmonic data for spectrum visualization. */
-    const HarmonicData& getHarmonicData() const noexcept { return harmonicData; }
+    using DoublePartialLoop = DoubleSum (*)(double*, const double*, double, const float*, const float*, double,
+                                            const float*, const float*, const float*, int) noexcept;
 
-private:
-    const AdditiveVoiceParams& params;
+    /**
+     * The double-precision partial loop: sum `count` partials and advance
+     * their phases by increments[n] * incrementScale. Ramped reads amplitudes
+     * as amplitudes[n] + rampPosition * steps[n]; Stereo weights each partial
+     * by its spectral pan gains (otherwise both sums are the mono sum). Like
+     * the float kernels, silent partials are summed and advanced too.
+     */
+    template <SineKernel Kernel, bool Ramped, bool Stereo>
+    static DoubleSum accumulatePartialsDouble(double* phases, const double* increments, double incrementScale,
+                                              const float* amplitudes, const float* steps, double rampPosition,
+                                              const float* phaseOffsets, const float* gainsLeft,
+                                              const float* gainsRight, int count) noexcept
+    {
+        constexpr double twoPi = juce::MathConstants<double>::twoPi;
+        DoubleSum sum;
 
-    float noteFrequency = 440.0f;
-    float noteVelocity = 0.0f;
-    double currentSampleRate = 44100.0;
-    float lastOutput = 0.0f;
+        for (int n = 0; n < count; ++n)
+        {
+            double amplitude = static_cast<double>(amplitudes[n]);
+            if constexpr (Ramped)
+                amplitude += rampPosition * static_cast<double>(steps[n]);
 
-    juce::ADSR adsr;
-    HarmonicData harmonicData;
+            const double term = amplitude * evaluateSine<Kernel>(phases[n] + static_cast<double>(phaseOffsets[n]));
 
-    // Per-unison-voice phase accumulators: [unisonIdx][harmonicIdx]
-    static constexpr int kMaxUnisonVoices = 8;
-    std::array<std::array<float, kMaxHarmonics>, kMaxUnisonVoices> uniPhaseAccumulators{};
+            if constexpr (Stereo)
+            {
+                sum.left  += term * static_cast<double>(gainsLeft[n]);
+                sum.right += term * static_cast<double>(gainsRight[n]);
+            }
+            else
+                sum.left += term;
+
+            const double phase = phases[n] + increments[n] * incrementScale;
+            phases[n] = phase >= twoPi ? phase - twoPi : phase;
+        }
+
+        if constexpr (!Stereo)
+            sum.right = sum.left;
+
+        return sum;
+    }
+
+    /** Phase accumulators used by the kernel for sample type T. */
+    template <typename T>
+    auto& getPhaseAccumulators() noexcept
+    {
+        if constexpr (std::is_same_v<T, double>)
+            return uniPhasesDouble;
+        else
+            return uniPhaseAccumulators;
+    }
+
+    /** Carry the phases over when switching between float and double storage, so the switch is seamless. */
+    void usePhaseStorage(bool useDouble)
+    {
+        if (useDouble == phasesInDouble)
+            return;
+
+        for (int u = 0; u < kMaxUnisonVoices; ++u)
+            for (int n = 0; n < kMaxHarmonics; ++n)
+            {
+                if (useDouble)
+                    uniPhasesDouble[u][n] = static_cast<double>(uniPhaseAccumulators[u][n]);
+                else
+                    uniPhaseAccumulators[u][n] = static_cast<float>(uniPhasesDouble[u][n]);
+            }
+
+        phasesInDouble = useDouble;
+    }
+
+    /**
+     * Advance the per-partial envelopes by one control period and set up the
+     * amplitude ramp across it, from the previous control point to the new one.
+     */
+    void prepareEnvelopeRamp(int length, int numPartials)
+    {
+        partialEnvelopes.advance(length, *renderKernels);
+
+        const float* startLevels = partialEnvelopes.getPreviousLevels();
+        const float* endLevels = partialEnvelopes.getLevels();
+        const float invLength = 1.0f / static_cast<float>(length);
+
+        for (int n = 0; n < numPartials; ++n)
+        {
+            const float amplitude = harmonicData.amplitudes[n];
+            envelopeAmplitudes[n] = amplitude * startLevels[n];
+            envelopeSteps[n] = amplitude * (endLevels[n] - startLevels[n]) * invLength;
+        }
+    }
+
+    /**
+     * Start (or continue) a block on the closed-form oscillators. On entry each
+     * unison voice picks up the fundamental's phase from the partial bank.
+     */
+    template <typename T>
+    void enterClosedForm(int uniCount, const std::array<T, kMaxUnisonVoices>& freqMul, int numHarmonics)
+    {
+        const double phaseScale = juce::MathConstants<double>::twoPi * noteFrequencyHz * pitch.getEndRatio()
+                                  / currentSampleRate;
+        auto spectrum = closedFormSpectrum;
+        spectrum.numHarmonics = juce::jmin(spectrum.numHarmonics, numHarmonics);
+
+        for (int u = 0; u < uniCount; ++u)
+        {
+            auto& oscillator = closedFormOscillators[u];
+            const bool continuing = closedFormActive && u < closedFormUnisonCount;
+            const double phase = continuing ? oscillator.getFundamentalPhase()
+                                            : (phasesInDouble ? uniPhasesDouble[u][0]
+                                                              : static_cast<double>(uniPhaseAccumulators[u][0]));
+
+            oscillator.beginBlock(phase, phaseScale * static_cast<double>(freqMul[u]), spectrum);
+        }
+
+        closedFormActive = true;
+        closedFormUnisonCount = uniCount;
+    }
+
+    /**
+     * Hand the note back to the partial bank: harmonic n of a closed-form
+     * voice sits at n times the fundamental's phase, so the switch is seamless.
+     */
+    void leaveClosedForm()
+    {
+        if (!closedFormActive)
+            return;
+
+        constexpr double twoPi = juce::MathConstants<double>::twoPi;
+
+        for (int u = 0; u < closedFormUnisonCount; ++u)
+        {
+            const double fundamentalPhase = closedFormOscillators[u].getFundamentalPhase();
+
+            for (int n = 0; n < kMaxHarmonics; ++n)
+            {
+                const double phase = std::fmod(static_cast<double>(n + 1) * fundamentalPhase, twoPi);
+
+                if (phasesInDouble)
+                    uniPhasesDouble[u][n] = phase;
+                else
+                    uniPhaseAccumulators[u][n] = static_cast<float>(phase);
+            }
+        }
+
+        closedFormActive = false;
+    }
+
+    /**
+     * The closed form renders exactly HarmonicSeries' saw/square blend, so it
+     * applies when nothing downstream reshapes that spectrum: no resynthesis,
+     * harmonic tuning with no stretch, no boost, no waveform filter or morph,
+     * no per-partial envelopes or panning, and a cutoff far enough above the top partial
+     * that the sigmoid leaves it within kClosedFormGainTolerance. Phase
+     * rotation stays linear in n and folds into the oscillator's offsets.
+     */
+    bool canUseClosedForm() const
+    {
+        const int numHarmonics = harmonicData.activeCount;
+
+        const float oscRatio = modulated(ModDestination::oscRatio, params.oscRatio);
+
+        if (!params.allowClosedForm || resynthesisActive || partialEnvelopesActive || spectralPanActive
+            || numHarmonics < kClosedFormMinPartials
+            || !partialRatios.isHarmonic() || modulated(ModDestination::filterBoost, params.filterBoost) != 0.0f
+            || oscRatio < 0.0f || oscRatio > 1.0f
+            || (params.waveFilterEnabled && modulated(ModDestination::waveFilterMix, params.waveFilterMix) > 0.0f)
+            || isMorphing())
+            return false;
+
+        // Same sigmoid as SpectralFilter, at the highest partial
+        const float cutoff = modulated(ModDestination::filterCutoff, params.filterCutoff);
+        const float topGain = 1.0f / (1.0f + std::exp((static_cast<float>(numHarmonics) - cutoff) / 2.0f));
+        return topGain >= 1.0f - kClosedFormGainTolerance;
+    }
+
+    /** The closed-form equivalent of the current harmonicData, or an empty spectrum. */
+    DsfSpectrum describeClosedForm() const
+    {
+        if (!canUseClosedForm())
+            return {};
+
+        const double ratio = modulated(ModDestination::oscRatio, params.oscRatio);
+        const double sawPhase = params.sawPhase;
+        const double sqrPhase = params.sqrPhase;
+        const double rotation = modulated(ModDestination::filterPhase, params.filterPhase);
+
+        // Mirrors HarmonicSeries' phase blend: odd harmonics mix both shapes, even ones are saw only
+        const double oddPhase = ratio >= 1.0 ? sawPhase
+                              : ratio <= 0.0 ? sqrPhase
+                                             : ratio * sawPhase + (1.0 - ratio) * sqrPhase;
+
+        DsfSpectrum spectrum;
+        spectrum.numHarmonics = harmonicData.activeCount;
+        spectrum.evenGain = ratio;
+        spectrum.oddOffset = oddPhase + rotation;
+        spectrum.evenOffset = sawPhase + rotation;
+        return spectrum;
+    }
+
+    /**
+     * Offline path: double-precision phase accumulation, the offline sine
+     * kernel (std::sin unless overridden), every partial below Nyquist rendered, and harmonics recomputed every
+     * kHighQualityControlInterval samples with amplitudes and phase offsets
+     * ramped per sample between control points. Several times slower than
+     * the real-time kernel, which is fine when the host isn't waiting on us.
+     */
+    template <SineKernel Kernel, typename SampleType>
+    void renderHighQuality(juce::AudioBuffer<SampleType>& outputBuffer, int startSample, int numSamples)
+    {
+        const int uniCount = getUnisonCount();
+        const bool isStereo = outputBuffer.getNumChannels() >= 2;
+        const double gainPerUni = 1.0 / std::sqrt(static_cast<double>(uniCount));
+
+        std::array<double, kMaxUnisonVoices> freqMul{};
+        std::array<double, kMaxUnisonVoices> panL{}, panR{};
+        computeUnisonSpread(uniCount, freqMul, panL, panR);
+
+        constexpr double twoPi = juce::MathConstants<double>::twoPi;
+        constexpr double nyquistIncrement = juce::MathConstants<double>::pi;
+        const double phaseScale = twoPi * noteFrequencyHz / currentSampleRate;
+        const double noteGain = static_cast<double>(noteVelocity) * 0.25;
+        const int endSample = startSample + numSamples;
+        const double ratioStep = (pitch.getEndRatio() - pitch.getStartRatio()) / numSamples;
+
+        for (int chunkStart = startSample; chunkStart < endSample; chunkStart += kHighQualityControlInterval)
+        {
+            const int chunkLength = juce::jmin(kHighQualityControlInterval, endSample - chunkStart);
+
+            // Ramp from the last control point to the new one over this chunk
+            const auto previous = harmonicData;
+            advanceResynthesis(chunkLength);
+            rebuildHarmonics(Rebuild::full);
+
+            const int numPartials = juce::jmax(previous.activeCount, harmonicData.activeCount);
+            const double invLength = 1.0 / static_cast<double>(chunkLength);
+
+            // Per-partial envelopes share the control points of the harmonics
+            if (partialEnvelopesActive)
+                partialEnvelopes.advance(chunkLength, *renderKernels);
+
+            for (int n = 0; n < numPartials; ++n)
+            {
+                const double startGain = partialEnvelopesActive ? partialEnvelopes.getPreviousLevels()[n] : 1.0;
+                const double endGain = partialEnvelopesActive ? partialEnvelopes.getLevels()[n] : 1.0;
+
+                hqIncrements[n] = phaseScale * getCurrentRatios()[n];
+                hqAmplitudes[n] = previous.amplitudes[n] * startGain;
+                hqAmplitudeSteps[n] = (harmonicData.amplitudes[n] * endGain - hqAmplitudes[n]) * invLength;
+                hqPhaseOffsets[n] = previous.phases[n];
+                hqPhaseOffsetSteps[n] = (static_cast<double>(harmonicData.phases[n]) - previous.phases[n]) * invLength;
+            }
+
+            for (int sample = chunkStart; sample < chunkStart + chunkLength; ++sample)
+            {
+                const double pitchRatio = pitch.getStartRatio() + ratioStep * (sample - startSample);
+
+                for (int n = 0; n < numPartials; ++n)
+                {
+                    hqAmplitudes[n] += hqAmplitudeSteps[n];
+                    hqPhaseOffsets[n] += hqPhaseOffsetSteps[n];
+                }
+
+                double leftOut = 0.0;
+                double rightOut = 0.0;
+
+                for (int u = 0; u < uniCount; ++u)
+                {
+                    double uniOutput = 0.0, uniRight = 0.0;
+                    auto& phases = uniPhasesDouble[u];
+
+                    for (int n = 0; n < numPartials; ++n)
+                    {
+                        const double increment = hqIncrements[n] * freqMul[u] * pitchRatio;
+                        if (increment >= nyquistIncrement)
+                            continue;
+
+                        if (hqAmplitudes[n] != 0.0)
+                        {
+                            const double term = hqAmplitudes[n] * evaluateSine<Kernel>(phases[n] + hqPhaseOffsets[n]);
+
+                            if (spectralPanActive)
+                            {
+                                uniOutput += term * spectralPan.getLeftGains()[n];
+                                uniRight  += term * spectralPan.getRightGains()[n];
+                            }
+                            else
+                            {
+                                uniOutput += term;
+                            }
+                        }
+
+                        phases[n] += increment;
+                        if (phases[n] >= twoPi)
+                            phases[n] -= twoPi;
+                    }
+
+                    if (!spectralPanActive)
+                        uniRight = uniOutput;
+
+                    leftOut  += uniOutput * panL[u] * gainPerUni;
+                    rightOut += uniRight * panR[u] * gainPerUni;
+                }
+
+                const double envelopeValue = adsr.getNextSample();
+                envelopeLevel = envelopeValue;
+                leftOut  *= envelopeValue * noteGain;
+                rightOut *= envelopeValue * noteGain;
+
+                if (!adsr.isActive())
+                {
+                    if (traceRecorder != nullptr)
+                        traceRecorder->instant(TraceEventType::voiceStop, TraceRecorder::voiceTrack(voiceIndex),
+                                               getCurrentlyPlayingNote(), 0);
 
-    void rebuildHarmonics()
+                    clearCurrentNote();
+                    return;
+                }
+
+                outputBuffer.addSample(0, sample, static_cast<SampleType>(leftOut));
+                if (isStereo)
+                    outputBuffer.addSample(1, sample, static_cast<SampleType>(rightOut));
+            }
+        }
+    }
+
+    void rebuildHarmonics(Rebuild rebuild)
     {
-        harmonicData = HarmonicSeries::compute(
-            params.oscRatio, params.sawPhase, params.sqrPhase,
-            noteFrequency, currentSampleRate);
+        TraceRecorder::ScopedEvent traceRebuild(traceRecorder, TraceEventType::rebuild,
+                                                TraceRecorder::voiceTrack(voiceIndex),
+                                                getCurrentlyPlayingNote());
 
-        SpectralFilter::apply(
-            harmonicData, params.filterCutoff, params.filterBoost,
-            params.filterPhase, params.filterStretch,
-            noteFrequency, currentSampleRate);
+        const PartialTrackSet* tracks = params.resynthesisEnabled && params.partialLibrary != nullptr
+                                          ? params.partialLibrary->findTracks(getCurrentlyPlayingNote())
+                                          : nullptr;
+        resynthesisActive = tracks != nullptr;
 
-        if (params.waveFilterEnabled && params.waveFilterMix > 0.0f)
+        if (resynthesisActive)
         {
-            SpectralFilter::applyWaveformFilter(
-                harmonicData, params.waveFilterSpectrum, params.waveFilterMix);
+            readPartialTracks(*tracks);
         }
+        else
+        {
+            // At the lowest pitch of the block, so the spectrum covers every partial
+            // the block can need; the render paths drop the ones a higher pitch
+            // pushes past Nyquist
+            const auto frequency = static_cast<float>(noteFrequencyHz * pitch.getLowestRatio());
+
+            partialRatios.update({ params.partialTuning, modulated(ModDestination::filterStretch, params.filterStretch),
+                                   params.stringInharmonicity,
+                                   params.customPartialRatios.data(), params.numCustomPartialRatios });
+
+            // The series only depends on the oscillator shape and partial count, so a
+            // mid-block rebuild for, say, a modulated cutoff starts from the last one
+            const float oscRatio = modulated(ModDestination::oscRatio, params.oscRatio);
+            const int count = partialRatios.countBelow(currentSampleRate * 0.5 / frequency);
+
+            if (rebuild == Rebuild::full || oscRatio != seriesRatio || count != seriesCount)
+            {
+                oscillatorSeries = HarmonicSeries::computePartials(oscRatio, params.sawPhase, params.sqrPhase, count);
+                seriesRatio = oscRatio;
+                seriesCount = count;
+            }
+
+            harmonicData = oscillatorSeries;
+
+            SpectralFilter::apply(
+                harmonicData, modulated(ModDestination::filterCutoff, params.filterCutoff),
+                modulated(ModDestination::filterBoost, params.filterBoost),
+                modulated(ModDestination::filterPhase, params.filterPhase), partialRatios,
+                frequency, currentSampleRate, *renderKernels);
+
+            const float waveFilterMix = modulated(ModDestination::waveFilterMix, params.waveFilterMix);
+            if (params.waveFilterEnabled && waveFilterMix > 0.0f)
+            {
+                SpectralFilter::applyWaveformFilter(
+                    harmonicData, params.waveFilterSpectrum, waveFilterMix);
+            }
+
+            // Last, so a fully morphed voice plays the stored spectrum exactly
+            if (isMorphing())
+                params.morphSlots.apply(harmonicData, modulated(ModDestination::morphPosition, params.morphPosition),
+                                        modulated(ModDestination::morphAmount, params.morphAmount),
+                                        morphScratch, *renderKernels);
+        }
+
+        spectralPanActive = spectralPan.update(params.spectralPanMode,
+                                               modulated(ModDestination::spectralPanWidth, params.spectralPanWidth),
+                                               params.spectralPanSeed, harmonicData.activeCount);
+        closedFormSpectrum = describeClosedForm();
+
+        traceRebuild.setSecondArg(harmonicData.activeCount);
+    }
+
+    /**
+     * Resynthesis: the lanes of the note's set at the current point in the
+     * sample replace the oscillator's spectrum, each lane at its own
+     * frequency ratio and starting from its analysed phase. The spectral and
+     * waveform filters and the morph work per harmonic, so they are left out.
+     * trackRatios aren't sorted, so lanes the highest pitch of the block
+     * would push past Nyquist are silenced here rather than cut off by count.
+     */
+    void readPartialTracks(const PartialTrackSet& tracks) noexcept
+    {
+        prefetchPartialTracks(tracks);
+
+        const int numLanes = juce::jmin(tracks.getNumLanes(), kMaxHarmonics);
+
+        tracks.read(resynthesisSeconds, numLanes, harmonicData.amplitudes.data(), trackRatios.data());
+        tracks.readStartPhases(numLanes, harmonicData.phases.data());
+
+        // Their ratio is zeroed too: a silent lane's phase would otherwise keep advancing by
+        // more than the single 2 pi the kernels wrap per sample, and grow without bound
+        const double ratioLimit = currentSampleRate * 0.5 / (noteFrequencyHz * pitch.getHighestRatio());
+        for (int n = 0; n < numLanes; ++n)
+            if (trackRatios[n] >= ratioLimit)
+            {
+                harmonicData.amplitudes[n] = 0.0f;
+                trackRatios[n] = 0.0;
+            }
+
+        std::fill(harmonicData.amplitudes.begin() + numLanes, harmonicData.amplitudes.end(), 0.0f);
+        harmonicData.activeCount = numLanes;
+    }
+
+    /**
+     * Ask the prefetcher to page in the next PartialPrefetcher::kWindowSeconds
+     * of the set once playback is within half a window of the frames already
+     * asked for (and from the current frame when the set changes).
+     */
+    void prefetchPartialTracks(const PartialTrackSet& tracks) noexcept
+    {
+        if (params.partialPrefetcher == nullptr || !tracks.isView())
+            return;
+
+        const int frame = tracks.frameAt(resynthesisSeconds);
+        const int window = static_cast<int>(std::ceil(PartialPrefetcher::kWindowSeconds / tracks.getFrameSeconds()));
+
+        if (&tracks != prefetchedTracks)
+        {
+            prefetchedTracks = &tracks;
+            prefetchedUpTo = frame;
+        }
+
+        if (prefetchedUpTo < tracks.getNumFrames() && frame + window / 2 >= prefetchedUpTo)
+        {
+            const int upTo = juce::jmin(tracks.getNumFrames(), frame + window);
+            params.partialPrefetcher->request(tracks, prefetchedUpTo, upTo - prefetchedUpTo);
+            prefetchedUpTo = upTo;
+        }
+    }
+
+    /** Move the resynthesis playback point on by numSamples of note time. */
+    void advanceResynthesis(int numSamples) noexcept
+    {
+        resynthesisSeconds += numSamples / currentSampleRate
+                              * modulated(ModDestination::resynthesisSpeed, params.resynthesisSpeed);
+    }
+
+    /** Frequency ratio of each partial now playing: the tuning's, or the resynthesis lanes'. */
+    const double* getCurrentRatios() const noexcept
+    {
+        return resynthesisActive ? trackRatios.data() : partialRatios.getRatios();
+    }
+
+    bool isMorphing() const noexcept
+    {
+        return modulated(ModDestination::morphAmount, params.morphAmount) > 0.0f && params.morphSlots.getNumFilled() > 0;
+    }
+
+    /** A shared parameter with this voice's modulation applied. */
+    float modulated(ModDestination destination, float value) const noexcept
+    {
+        return modulationActive ? modulation.apply(destination, value) : value;
+    }
+
+    /** Hand the note's current mod wheel and pressure to the modulation sources. */
+    void updateControllers() noexcept
+    {
+        if (channelControllers == nullptr)
+        {
+            modulation.setControllers(0.0f, notePressure);
+            return;
+        }
+
+        const auto channel = static_cast<size_t>(noteChannel - 1);
+        modulation.setControllers(channelControllers->modWheel[channel],
+                                  juce::jmax(notePressure, channelControllers->pressure[channel]));
+    }
+
+    /**
+     * Bend ranges are read every block, so changing them moves held notes too.
+     * Pitch modulation adds to the note's own bend. In MPE mode the master
+     * channel's wheel is the master bend, applied to every note once: a note
+     * played on the master channel itself has no bend of its own on top.
+     */
+    void updatePitchBend() noexcept
+    {
+        const bool onMasterChannel = params.mpeEnabled && isPlayingChannel(1);
+        const double noteRange = onMasterChannel   ? 0.0
+                               : params.mpeEnabled ? params.mpePitchBendRange
+                                                   : params.pitchBendRange;
+
+        pitch.setBend(pitchWheelToBend(noteWheelPosition) * noteRange + modulated(ModDestination::pitch, 0.0f));
+        pitch.setMasterBend(params.mpeEnabled ? pitchWheelToBend(masterWheelPosition) * params.pitchBendRange : 0.0);
     }
 
     void updateADSR()
@@ -249,10 +1240,24 @@ private:
         adsrParams.decay   = params.envDecay;
         adsrParams.sustain = params.envSustain;
         adsrParams.release = params.envRelease;
+
+        // Per-partial envelopes take over attack/decay/sustain; the ADSR is left as gate and release
+        if (partialEnvelopesActive)
+        {
+            partialEnvelopes.setParameters({ params.envAttack, params.envDecay, params.envSustain,
+                                             params.partialDecayTilt, params.partialAttackDelay });
+            adsrParams.attack  = 0.0f;
+            adsrParams.decay   = 0.0f;
+            adsrParams.sustain = 1.0f;
+        }
+
         adsr.setParameters(adsrParams);
     }
 
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AdditiveVoice)
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BasicAdditiveVoice)
 };
 
+using AdditiveVoiceParams = BasicVoiceParams<ActiveEngineConfig>;
+using AdditiveVoice       = BasicAdditiveVoice<ActiveEngineConfig>;
+
 } // namespace synth
@@ -0,0 +1,225 @@
+/*
+  ==============================================================================
+    AudioRecorder.h - Direct-to-disk recording through a lock-free FIFO
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <type_traits>
+
+namespace synth
+{
+
+/**
+ * Records the output to a WAV or FLAC file (chosen by extension).
+ *
+ * The audio thread only copies each block into a preallocated ring buffer;
+ * a background thread drains it into an AudioFormatWriter every 20 ms, so
+ * memory stays bounded however long the take. No disk I/O, allocation,
+ * locking or signalling happens on the audio thread. If the disk falls
+ * behind and a block doesn't fit, the whole block is dropped and counted.
+ */
+class AudioRecorder : private juce::Thread
+{
+public:
+    static constexpr double kFifoSeconds = 4.0; // buffered audio between the audio thread and the disk
+
+    AudioRecorder() : juce::Thread("Audio Recorder") {}
+
+    ~AudioRecorder() override { stop(); }
+
+    /** Default take location: ~/Documents/AdditiveSynthesizer/Recordings/take-<time>.<extension> */
+    static juce::File getDefaultOutputFile(const juce::String& extension)
+    {
+        return juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+            .getChildFile("AdditiveSynthesizer")
+            .getChildFile("Recordings")
+            .getChildFile("take-" + juce::Time::getCurrentTime().formatted("%Y%m%d-%H%M%S") + "." + extension)
+            .getNonexistentSibling();
+    }
+
+    //==========================================================================
+    // Message thread
+
+    /** Create the file and start recording. Returns false if it can't be written. */
+    bool start(const juce::File& file, double sampleRate, int numChannels, int bitsPerSample = 24)
+    {
+        stop();
+
+        if (sampleRate <= 0.0 || numChannels <= 0)
+            return false;
+
+        writer = createWriter(file, sampleRate, numChannels, bitsPerSample);
+        if (writer == nullptr)
+            return false;
+
+        outputFile = file;
+        recordingSampleRate = sampleRate;
+
+        const int fifoSize = juce::roundToInt(sampleRate * kFifoSeconds);
+        fifoBuffer.setSize(numChannels, fifoSize);
+        fifo.setTotalSize(fifoSize);
+        fifo.reset();
+
+        recordedSamples.store(0);
+        droppedBlocks.store(0);
+        droppedSamples.store(0);
+
+        startThread();
+        active.store(true);
+        return true;
+    }
+
+    /** Stop recording, write what is still buffered and close the file. */
+    void stop()
+    {
+        if (!active.exchange(false))
+            return;
+
+        // Let a push that saw `active` finish before the FIFO is drained for the last time
+        while (insidePush.load())
+            juce::Thread::yield();
+
+        stopThread(2000);
+        drain();
+        writer.reset();
+    }
+
+    bool isRecording() const noexcept { return active.load(std::memory_order_relaxed); }
+    const juce::File& getOutputFile() const noexcept { return outputFile; }
+    double getRecordingSampleRate() const noexcept { return recordingSampleRate; }
+
+    /** Length of audio written to disk so far. */
+    double getRecordedSeconds() const noexcept
+    {
+        return static_cast<double>(recordedSamples.load(std::memory_order_relaxed)) / recordingSampleRate;
+    }
+
+    /** Blocks discarded because the disk couldn't keep up. */
+    juce::int64 getNumDroppedBlocks() const noexcept { return droppedBlocks.load(std::memory_order_relaxed); }
+    juce::int64 getNumDroppedSamples() const noexcept { return droppedSamples.load(std::memory_order_relaxed); }
+
+    //==========================================================================
+    // Audio thread
+
+    /** Queue a block for writing; double blocks are converted to float on the way in. */
+    template <typename SampleType>
+    void push(const juce::AudioBuffer<SampleType>& buffer, int numSamples) noexcept
+    {
+        insidePush.store(true);
+
+        if (active.load() && numSamples > 0 && buffer.getNumChannels() > 0)
+        {
+            if (fifo.getFreeSpace() < numSamples)
+            {
+                droppedBlocks.fetch_add(1, std::memory_order_relaxed);
+                droppedSamples.fetch_add(numSamples, std::memory_order_relaxed);
+            }
+            else
+            {
+                const auto scope = fifo.write(numSamples);
+
+                for (int ch = 0; ch < fifoBuffer.getNumChannels(); ++ch)
+                {
+                    // Mono output feeds every channel of the file
+                    const int source = juce::jmin(ch, buffer.getNumChannels() - 1);
+
+                    if (scope.blockSize1 > 0)
+                        copyToFifo(ch, scope.startIndex1, buffer, source, 0, scope.blockSize1);
+                    if (scope.blockSize2 > 0)
+                        copyToFifo(ch, scope.startIndex2, buffer, source, scope.blockSize1, scope.blockSize2);
+                }
+            }
+        }
+
+        insidePush.store(false);
+    }
+
+private:
+    juce::AbstractFifo fifo{ 1 };
+    juce::AudioBuffer<float> fifoBuffer;
+
+    std::unique_ptr<juce::AudioFormatWriter> writer;
+    juce::File outputFile;
+    double recordingSampleRate = 44100.0;
+
+    std::atomic<bool> active{ false };
+    std::atomic<bool> insidePush{ false };
+    std::atomic<juce::int64> recordedSamples{ 0 };
+    std::atomic<juce::int64> droppedBlocks{ 0 };
+    std::atomic<juce::int64> droppedSamples{ 0 };
+
+    template <typename SampleType>
+    void copyToFifo(int destChannel, int destStart, const juce::AudioBuffer<SampleType>& source,
+                    int sourceChannel, int sourceStart, int numSamples) noexcept
+    {
+        if constexpr (std::is_same_v<SampleType, float>)
+        {
+            fifoBuffer.copyFrom(destChannel, destStart, source, sourceChannel, sourceStart, numSamples);
+        }
+        else
+        {
+            const auto* in = source.getReadPointer(sourceChannel, sourceStart);
+            auto* out = fifoBuffer.getWritePointer(destChannel, destStart);
+            for (int i = 0; i < numSamples; ++i)
+                out[i] = static_cast<float>(in[i]);
+        }
+    }
+
+    static std::unique_ptr<juce::AudioFormatWriter> createWriter(const juce::File& file, double sampleRate,
+                                                                 int numChannels, int bitsPerSample)
+    {
+        file.getParentDirectory().createDirectory();
+        file.deleteFile();
+
+        auto fileStream = std::make_unique<juce::FileOutputStream>(file);
+        if (!fileStream->openedOk())
+            return {};
+
+        const auto options = juce::AudioFormatWriterOptions{}
+                                 .withSampleRate(sampleRate)
+                                 .withNumChannels(numChannels)
+                                 .withBitsPerSample(bitsPerSample);
+
+        std::unique_ptr<juce::OutputStream> stream = std::move(fileStream);
+
+        if (file.hasFileExtension("flac"))
+            return juce::FlacAudioFormat().createWriterFor(stream, options);
+
+        return juce::WavAudioFormat().createWriterFor(stream, options);
+    }
+
+    //==========================================================================
+    // Writer thread
+
+    void run() override
+    {
+        while (!threadShouldExit())
+        {
+            wait(20);
+            drain();
+        }
+    }
+
+    void drain()
+    {
+        const auto scope = fifo.read(fifo.getNumReady());
+
+        if (writer != nullptr)
+        {
+            if (scope.blockSize1 > 0)
+                writer->writeFromAudioSampleBuffer(fifoBuffer, scope.startIndex1, scope.blockSize1);
+            if (scope.blockSize2 > 0)
+                writer->writeFromAudioSampleBuffer(fifoBuffer, scope.startIndex2, scope.blockSize2);
+        }
+
+        recordedSamples.fetch_add(scope.blockSize1 + scope.blockSize2, std::memory_order_relaxed);
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioRecorder)
+};
+
+} // namespace synth
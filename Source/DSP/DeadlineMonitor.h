@@ -0,0 +1,152 @@
+/*
+  ==============================================================================
+    DeadlineMonitor.h - Block deadline accounting with lock-free diagnostic snapshot
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+
+namespace synth
+{
+
+/**
+ * Compares the time spent rendering each block against its real-time budget
+ * (numSamples / sampleRate) and keeps overrun counters.
+ *
+ * On an overrun the owner can publish a SnapshotType describing what the
+ * engine was doing. The snapshot lives in a single lock-free slot: the audio
+ * thread never waits for the reader — if the reader is busy copying, the new
+ * snapshot is skipped and counted; an unread snapshot is replaced by a newer one.
+ *
+ * SnapshotType must be copy-assignable without allocating.
+ */
+template <typename SnapshotType>
+class DeadlineMonitor
+{
+public:
+    struct Stats
+    {
+        juce::int64 blocks = 0;
+        juce::int64 overruns = 0;
+        juce::int64 skippedSnapshots = 0;
+        double lastLoad = 0.0;  // elapsed / budget of the last block
+        double worstLoad = 0.0;
+    };
+
+    DeadlineMonitor() = default;
+
+    static juce::int64 now() noexcept { return juce::Time::getHighResolutionTicks(); }
+
+    void prepare(double newSampleRate)
+    {
+        sampleRate = newSampleRate;
+        resetStats();
+    }
+
+    /** Blocks whose load exceeds this ratio count as overruns (1.0 = missed deadline). */
+    void setOverrunThreshold(double loadRatio) noexcept { overrunThreshold = loadRatio; }
+
+    /**
+     * Account for a finished block. Call on the audio thread.
+     * @return the block's load (elapsed time / budget); > threshold means overrun.
+     */
+    double blockFinished(juce::int64 startTicks, int numSamples) noexcept
+    {
+        if (numSamples <= 0 || sampleRate <= 0.0)
+            return 0.0;
+
+        const double elapsed = juce::Time::highResolutionTicksToSeconds(now() - startTicks);
+        const double load = elapsed * sampleRate / static_cast<double>(numSamples);
+
+        blocks.fetch_add(1, std::memory_order_relaxed);
+        lastLoad.store(load, std::memory_order_relaxed);
+
+        if (load > worstLoad.load(std::memory_order_relaxed))
+            worstLoad.store(load, std::memory_order_relaxed);
+
+        if (load > overrunThreshold)
+            overruns.fetch_add(1, std::memory_order_relaxed);
+
+        return load;
+    }
+
+    bool isOverrun(double load) const noexcept { return load > overrunThreshold; }
+
+    /**
+     * Fill the snapshot slot from the audio thread. `fill` receives a
+     * SnapshotType& and must not allocate or block.
+     */
+    template <typename FillFn>
+    bool publish(FillFn&& fill) noexcept
+    {
+        int expected = kEmpty;
+        if (!slotState.compare_exchange_strong(expected, kWriting, std::memory_order_acquire))
+        {
+            // Replace an older snapshot nobody has read yet
+            expected = kReady;
+            if (!slotState.compare_exchange_strong(expected, kWriting, std::memory_order_acquire))
+            {
+                skippedSnapshots.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+
+        fill(slot);
+        slotState.store(kReady, std::memory_order_release);
+        return true;
+    }
+
+    /** Take the pending snapshot, if any. Call from a non-audio thread. */
+    bool retrieve(SnapshotType& destination) noexcept
+    {
+        int expected = kReady;
+        if (!slotState.compare_exchange_strong(expected, kReading, std::memory_order_acquire))
+            return false;
+
+        destination = slot;
+        slotState.store(kEmpty, std::memory_order_release);
+        return true;
+    }
+
+    Stats getStats() const noexcept
+    {
+        Stats stats;
+        stats.blocks = blocks.load(std::memory_order_relaxed);
+        stats.overruns = overruns.load(std::memory_order_relaxed);
+        stats.skippedSnapshots = skippedSnapshots.load(std::memory_order_relaxed);
+        stats.lastLoad = lastLoad.load(std::memory_order_relaxed);
+        stats.worstLoad = worstLoad.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    void resetStats() noexcept
+    {
+        blocks.store(0, std::memory_order_relaxed);
+        overruns.store(0, std::memory_order_relaxed);
+        skippedSnapshots.store(0, std::memory_order_relaxed);
+        lastLoad.store(0.0, std::memory_order_relaxed);
+        worstLoad.store(0.0, std::memory_order_relaxed);
+    }
+
+private:
+    enum SlotState { kEmpty, kWriting, kReady, kReading };
+
+    double sampleRate = 44100.0;
+    double overrunThreshold = 1.0;
+
+    std::atomic<juce::int64> blocks{ 0 };
+    std::atomic<juce::int64> overruns{ 0 };
+    std::atomic<juce::int64> skippedSnapshots{ 0 };
+    std::atomic<double> lastLoad{ 0.0 };
+    std::atomic<double> worstLoad{ 0.0 };
+
+    std::atomic<int> slotState{ kEmpty };
+    SnapshotType slot{};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DeadlineMonitor)
+};
+
+} // namespace synth
@@ -0,0 +1,193 @@
+/*
+  ==============================================================================
+    DsfOscillator.h - Closed-form band-limited saw/square blend (DSF/BLIT style)
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <cmath>
+
+namespace synth
+{
+
+/**
+ * The unfiltered saw/square spectrum HarmonicSeries produces, in closed form:
+ *
+ *   x(θ) = Σ_{n odd ≤ N} sin(n(θ + oddOffset)) / n
+ *        + evenGain · Σ_{n even ≤ N} sin(n(θ + evenOffset)) / n
+ *
+ * (oddOffset/evenOffset: the saw/square phase blend plus filter phase rotation,
+ * which are linear in n for this spectrum.)
+ */
+struct DsfSpectrum
+{
+    int numHarmonics = 0;   // N, highest harmonic below Nyquist
+    double evenGain = 1.0;  // oscRatio: even harmonics only come from the saw
+    double oddOffset = 0.0; // radians at the fundamental
+    double evenOffset = 0.0;
+};
+
+/**
+ * Renders a DsfSpectrum at a cost independent of the partial count.
+ *
+ * Each half (odd and even harmonics) is the integral of a Dirichlet kernel,
+ * which has a closed form:
+ *   Σ_{m=1..M} cos((2m-1)x) = sin(2Mx) / (2 sin x)
+ *   Σ_{m=1..E} cos(2mx)     = sin((2E+1)x) / (2 sin x) - 1/2
+ * Per sample the kernels are integrated over the phase step with 3-point
+ * Gauss-Legendre quadrature, with their sines advanced by complex rotation
+ * (no trig calls per sample). The running sums are re-seeded exactly by
+ * direct summation at the start of every block, so quadrature error can't
+ * accumulate beyond one block.
+ */
+class DsfOscillator
+{
+public:
+    /**
+     * Start a block at fundamental phase `phase` (radians) advancing by
+     * `increment` per sample. O(N) once, for the exact re-seed.
+     */
+    void beginBlock(double phase, double increment, const DsfSpectrum& spectrum) noexcept
+    {
+        fundamentalPhase = phase;
+        phaseIncrement = increment;
+        halfStep = 0.5 * increment;
+
+        const int n = spectrum.numHarmonics;
+        numOdd = (n + 1) / 2;
+        numEven = n / 2;
+        evenGain = spectrum.evenGain;
+
+        oddSum = seriesSum(phase + spectrum.oddOffset, n, 1);
+        evenSum = numEven > 0 ? seriesSum(phase + spectrum.evenOffset, n, 2) : 0.0;
+
+        odd.begin(phase + spectrum.oddOffset, increment, 2.0 * numOdd);
+        even.begin(phase + spectrum.evenOffset, increment, 2.0 * numEven + 1.0);
+    }
+
+    /** Current sample, then advance one sample. */
+    double next() noexcept
+    {
+        const double output = oddSum + evenGain * evenSum;
+
+        oddSum += halfStep * odd.integrate([this](double num, const Phasor& den) { return oddKernel(num, den); });
+
+        if (numEven > 0)
+            evenSum += halfStep * even.integrate([this](double num, const Phasor& den) { return evenKernel(num, den); });
+
+        fundamentalPhase += phaseIncrement;
+        if (fundamentalPhase >= kTwoPi)
+            fundamentalPhase -= kTwoPi;
+
+        return output;
+    }
+
+    /** Phase of the fundamental, for handing the note back to the partial bank. */
+    double getFundamentalPhase() const noexcept { return fundamentalPhase; }
+
+private:
+    static constexpr double kTwoPi = 6.283185307179586;
+    static constexpr double kSingular = 1.0e-9; // |sin x| below this: use the kernel's limit
+
+    /** Gauss-Legendre nodes on [-1, 1] mapped to [0, 1], and their weights. */
+    static constexpr std::array<double, 3> kNodes{ 0.5 - 0.3872983346207417, 0.5, 0.5 + 0.3872983346207417 };
+    static constexpr std::array<double, 3> kWeights{ 5.0 / 9.0, 8.0 / 9.0, 5.0 / 9.0 };
+
+    /** Unit phasor e^{ix}, advanced by complex multiplication. */
+    struct Phasor
+    {
+        double re = 1.0, im = 0.0;
+
+        void set(double x) noexcept { re = std::cos(x); im = std::sin(x); }
+
+        void rotate(const Phasor& by) noexcept
+        {
+            const double r = re * by.re - im * by.im;
+            im = re * by.im + im * by.re;
+            re = r;
+        }
+    };
+
+    /** sin x and sin(kx) at the three quadrature nodes of the current step. */
+    struct KernelPhasors
+    {
+        std::array<Phasor, 3> base, multiple;
+        Phasor baseStep, multipleStep;
+
+        void begin(double x, double step, double k) noexcept
+        {
+            for (size_t j = 0; j < 3; ++j)
+            {
+                const double node = x + kNodes[j] * step;
+                base[j].set(node);
+                multiple[j].set(k * node);
+            }
+
+            baseStep.set(step);
+            multipleStep.set(k * step);
+        }
+
+        /** Σ_j w_j · kernel(sin(k·node_j), sin(node_j)), then move to the next step. */
+        template <typename Kernel>
+        double integrate(Kernel&& kernel) noexcept
+        {
+            double sum = 0.0;
+            for (size_t j = 0; j < 3; ++j)
+            {
+                sum += kWeights[j] * kernel(multiple[j].im, base[j]);
+                base[j].rotate(baseStep);
+                multiple[j].rotate(multipleStep);
+            }
+            return sum;
+        }
+    };
+
+    double oddKernel(double num, const Phasor& den) const noexcept
+    {
+        if (std::abs(den.im) < kSingular)
+            return den.re > 0.0 ? numOdd : -numOdd;
+
+        return num / (2.0 * den.im);
+    }
+
+    double evenKernel(double num, const Phasor& den) const noexcept
+    {
+        if (std::abs(den.im) < kSingular)
+            return numEven;
+
+        return num / (2.0 * den.im) - 0.5;
+    }
+
+    /** Σ sin(nx)/n over n = first, first + 2, ... ≤ last, by the Chebyshev recurrence. */
+    static double seriesSum(double x, int last, int first) noexcept
+    {
+        // Step of two harmonics: sin((n+2)x) = 2cos(2x) sin(nx) - sin((n-2)x)
+        const double twoCos = 2.0 * std::cos(2.0 * x);
+        double previous = std::sin(static_cast<double>(first - 2) * x);
+        double current = std::sin(static_cast<double>(first) * x);
+        double sum = 0.0;
+
+        for (int n = first; n <= last; n += 2)
+        {
+            sum += current / static_cast<double>(n);
+            const double following = twoCos * current - previous;
+            previous = current;
+            current = following;
+        }
+
+        return sum;
+    }
+
+    double fundamentalPhase = 0.0;
+    double phaseIncrement = 0.0;
+    double halfStep = 0.0;
+    int numOdd = 0, numEven = 0;
+    double evenGain = 1.0;
+
+    double oddSum = 0.0, evenSum = 0.0;
+    KernelPhasors odd, even;
+};
+
+} // namespace synth
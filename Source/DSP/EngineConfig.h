@@ -0,0 +1,48 @@
+/*
+  ==============================================================================
+    EngineConfig.h - Compile-time engine capacities (partials, polyphony, unison)
+  ==============================================================================
+*/
+
+#pragma once
+
+namespace synth
+{
+
+/**
+ * Capacity set the engine, voice and spectral types are instantiated with.
+ * Every fixed-size array is sized from these, so loops over a full capacity
+ * have compile-time bounds and each build only pays for what it can play.
+ */
+template <int Harmonics, int Polyphony, int UnisonVoices>
+struct EngineConfig
+{
+    static_assert(Harmonics > 0 && Polyphony > 0 && UnisonVoices > 0, "Capacities must be positive");
+
+    static constexpr int maxHarmonics = Harmonics;
+    static constexpr int maxPolyphony = Polyphony;
+    static constexpr int maxUnisonVoices = UnisonVoices;
+};
+
+using StandardEngineConfig = EngineConfig<256, 8, 8>;   // the shipping plugin
+using LiteEngineConfig     = EngineConfig<64, 4, 2>;    // low-footprint / embedded
+using HeavyEngineConfig    = EngineConfig<1024, 16, 8>; // dense spectra, big polyphony
+
+/**
+ * The configuration this build uses, chosen with the ADDITIVE_SYNTH_CAPACITY
+ * CMake option (Standard, Lite or Heavy). Other configurations can still be
+ * instantiated alongside it, e.g. by the benchmarks.
+ */
+#if ADDITIVE_SYNTH_CAPACITY_LITE
+using ActiveEngineConfig = LiteEngineConfig;
+#elif ADDITIVE_SYNTH_CAPACITY_HEAVY
+using ActiveEngineConfig = HeavyEngineConfig;
+#else
+using ActiveEngineConfig = StandardEngineConfig;
+#endif
+
+static constexpr int kMaxHarmonics    = ActiveEngineConfig::maxHarmonics;
+static constexpr int kMaxPolyphony    = ActiveEngineConfig::maxPolyphony;
+static constexpr int kMaxUnisonVoices = ActiveEngineConfig::maxUnisonVoices;
+
+} // namespace synth
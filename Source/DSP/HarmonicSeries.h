@@ -6,28 +6,33 @@
 
 #pragma once
 
+#include "EngineConfig.h"
+#include <algorithm>
 #include <array>
 #include <cmath>
 
 namespace synth
 {
 
-static constexpr int kMaxHarmonics = 256;
-
 /**
  * Computes the harmonic amplitude and phase arrays for a blend
  * of sawtooth and square wave, given oscillator parameters.
  *
  * This is recomputed when parameters change, NOT per-sample.
  */
-struct HarmonicData
+template <int NumHarmonics>
+struct BasicHarmonicData
 {
-    std::array<float, kMaxHarmonics> amplitudes{};
-    std::array<float, kMaxHarmonics> phases{};
+    static constexpr int capacity = NumHarmonics;
+    using Spectrum = std::array<float, NumHarmonics>; // one value per harmonic
+
+    Spectrum amplitudes{};
+    Spectrum phases{};
     int activeCount = 0; // number of harmonics below Nyquist
 };
 
-class HarmonicSeries
+template <int NumHarmonics>
+class BasicHarmonicSeries
 {
 public:
     /**
@@ -39,19 +44,31 @@ public:
      * @param noteFreqHz  Fundamental frequency of the note
      * @param sampleRate  Current sample rate
      */
-    static HarmonicData compute(float ratio, float sawPhase, float sqrPhase,
-                                float noteFreqHz, double sampleRate)
+    static BasicHarmonicData<NumHarmonics> compute(float ratio, float sawPhase, float sqrPhase,
+                                                   float noteFreqHz, double sampleRate)
     {
-        HarmonicData data;
         const float nyquist = static_cast<float>(sampleRate) * 0.5f;
+        int count = 0;
+
+        while (count < NumHarmonics && noteFreqHz * static_cast<float>(count + 1) < nyquist)
+            ++count;
+
+        return computePartials(ratio, sawPhase, sqrPhase, count);
+    }
+
+    /**
+     * Same blend for the first `count` partials, with no Nyquist check; for
+     * partials that aren't harmonics, where the caller knows which of them
+     * fit (see PartialRatios).
+     */
+    static BasicHarmonicData<NumHarmonics> computePartials(float ratio, float sawPhase, float sqrPhase, int count)
+    {
+        BasicHarmonicData<NumHarmonics> data;
+        const int last = std::min(count, NumHarmonics);
         int active = 0;
 
-        for (int n = 1; n <= kMaxHarmonics; ++n)
+        for (int n = 1; n <= last; ++n)
         {
-            const float freq = noteFreqHz * static_cast<float>(n);
-            if (freq >= nyquist)
-                break;
-
             // Sawtooth: all harmonics, amplitude = 1/n
             const float sawAmp = 1.0f / static_cast<float>(n);
 
@@ -91,4 +108,7 @@ public:
     }
 };
 
+using HarmonicData   = BasicHarmonicData<kMaxHarmonics>;
+using HarmonicSeries = BasicHarmonicSeries<kMaxHarmonics>;
+
 } // namespace synth
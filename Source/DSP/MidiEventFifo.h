@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+    MidiEventFifo.h - Lock-free single-producer/single-consumer queue of short MIDI events
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+namespace synth
+{
+
+/**
+ * Passes short (up to 3-byte) MIDI messages between one producer thread and
+ * one consumer thread without locking or allocating, e.g. on-screen keyboard
+ * notes to the audio thread, or host notes back to the keyboard display.
+ *
+ * When the queue is full, push() drops the event and returns false.
+ */
+template <int Capacity>
+class MidiEventFifo
+{
+public:
+    MidiEventFifo() = default;
+
+    bool push(const juce::uint8* data, int numBytes) noexcept
+    {
+        if (numBytes <= 0 || numBytes > 3)
+            return false;
+
+        const auto scope = fifo.write(1);
+        if (scope.blockSize1 == 0)
+            return false;
+
+        auto& event = events[static_cast<size_t>(scope.startIndex1)];
+        std::copy_n(data, numBytes, event.bytes.begin());
+        event.numBytes = static_cast<juce::uint8>(numBytes);
+        return true;
+    }
+
+    bool push(const juce::MidiMessage& message) noexcept
+    {
+        return push(message.getRawData(), message.getRawDataSize());
+    }
+
+    /** Pop every queued event, calling fn(const juce::uint8* data, int numBytes) for each. */
+    template <typename Fn>
+    void popAll(Fn&& fn)
+    {
+        const auto scope = fifo.read(fifo.getNumReady());
+        scope.forEach([this, &fn](int index)
+        {
+            const auto& event = events[static_cast<size_t>(index)];
+            fn(event.bytes.data(), static_cast<int>(event.numBytes));
+        });
+    }
+
+    int getNumReady() const noexcept { return fifo.getNumReady(); }
+
+private:
+    struct Event
+    {
+        std::array<juce::uint8, 3> bytes{};
+        juce::uint8 numBytes = 0;
+    };
+
+    juce::AbstractFifo fifo{ Capacity };
+    std::array<Event, Capacity> events{};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiEventFifo)
+};
+
+} // namespace synth
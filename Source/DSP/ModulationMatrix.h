@@ -0,0 +1,358 @@
+/*
+  ==============================================================================
+    ModulationMatrix.h - Control-rate LFOs, mod envelope and routing slots
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <cmath>
+
+namespace synth
+{
+
+/** Where a modulation slot takes its value from. */
+enum class ModSource
+{
+    off,
+    lfo1,        // -1..1
+    lfo2,        // -1..1
+    envelope,    // the mod envelope, 0..1
+    velocity,    // note-on velocity, 0..1
+    aftertouch,  // channel or polyphonic pressure, 0..1
+    modWheel,    // CC 1 on the note's channel, 0..1
+    keyTrack     // note distance from middle C, -1..1 over five octaves
+};
+
+static constexpr int kNumModSources = 8;
+
+/** The voice parameter a modulation slot moves. */
+enum class ModDestination
+{
+    off,
+    pitch,
+    oscRatio,
+    filterCutoff,
+    filterBoost,
+    filterPhase,
+    filterStretch,
+    waveFilterMix,
+    morphAmount,
+    morphPosition,
+    resynthesisSpeed,
+    noiseLevel,
+    unisonDetune,
+    stereoWidth,
+    spectralPanWidth
+};
+
+static constexpr int kNumModDestinations = 15;
+
+enum class LfoShape
+{
+    sine,
+    triangle,
+    saw,
+    square,
+    sampleAndHold
+};
+
+static constexpr int kNumLfoShapes = 5;
+
+/** How a destination takes modulation. */
+struct ModDestinationInfo
+{
+    float span;              // change for a source at 1 with an amount of 1
+    float minimum, maximum;  // the modulated value is held within these
+    bool octaves;            // span is in octaves of the value (scaled), not added to it
+    bool spectral;           // feeds the spectrum, so a change needs a rebuild
+};
+
+inline const ModDestinationInfo& getModDestinationInfo(ModDestination destination) noexcept
+{
+    constexpr float twoPi = juce::MathConstants<float>::twoPi;
+
+    // In the voice parameters' units (see BasicVoiceParams)
+    static constexpr std::array<ModDestinationInfo, kNumModDestinations> info{ {
+        { 0.0f,   0.0f,          0.0f,         false, false }, // off
+        { 12.0f,  -48.0f,        48.0f,        false, false }, // pitch, semitones (added to the bend)
+        { 1.0f,   0.0f,          1.0f,         false, true  }, // oscRatio
+        { 7.0f,   1.0f,          4096.0f,      true,  true  }, // filterCutoff, harmonic number
+        { 24.0f,  0.0f,          24.0f,        false, true  }, // filterBoost, dB
+        { twoPi,  -2.0f * twoPi, 2.0f * twoPi, false, true  }, // filterPhase, radians
+        { 1.5f,   0.5f,          2.0f,         false, true  }, // filterStretch
+        { 1.0f,   0.0f,          1.0f,         false, true  }, // waveFilterMix
+        { 1.0f,   0.0f,          1.0f,         false, true  }, // morphAmount
+        { 1.0f,   0.0f,          1.0f,         false, true  }, // morphPosition
+        { 4.0f,   0.0f,          4.0f,         false, false }, // resynthesisSpeed
+        { 1.0f,   0.0f,          1.0f,         false, false }, // noiseLevel
+        { 100.0f, 0.0f,          100.0f,       false, false }, // unisonDetune, cents
+        { 1.0f,   0.0f,          1.0f,         false, false }, // stereoWidth
+        { 1.0f,   0.0f,          1.0f,         false, true  }, // spectralPanWidth
+    } };
+
+    return info[static_cast<size_t>(destination)];
+}
+
+/**
+ * The modulation routing shared by every voice: two LFOs, one extra
+ * envelope, and kNumSlots slots each adding source * amount * span to one
+ * destination. Several slots may feed the same destination; they add up.
+ */
+struct ModulationSettings
+{
+    static constexpr int kNumSlots = 4;
+    static constexpr int kNumLfos = 2;
+
+    struct Slot
+    {
+        ModSource source = ModSource::off;
+        ModDestination destination = ModDestination::off;
+        float amount = 0.0f;  // -1..1
+
+        bool isActive() const noexcept
+        {
+            return source != ModSource::off && destination != ModDestination::off && amount != 0.0f;
+        }
+    };
+
+    struct Lfo
+    {
+        LfoShape shape = LfoShape::sine;
+        float rateHz = 2.0f;
+    };
+
+    struct Envelope
+    {
+        float attack = 0.01f;   // seconds
+        float decay = 0.3f;     // seconds
+        float sustain = 0.0f;   // 0..1
+        float release = 0.3f;   // seconds
+    };
+
+    std::array<Slot, kNumSlots> slots{};
+    std::array<Lfo, kNumLfos> lfos{};
+    Envelope envelope;
+
+    /** True if any slot moves anything; with none the voice skips modulation entirely. */
+    bool isActive() const noexcept
+    {
+        for (const auto& slot : slots)
+            if (slot.isActive())
+                return true;
+
+        return false;
+    }
+};
+
+/**
+ * The last mod wheel and channel pressure seen on each MIDI channel, kept
+ * by the engine's synthesiser so a note starting later still picks them up.
+ */
+struct ChannelControllers
+{
+    std::array<float, 16> modWheel{};
+    std::array<float, 16> pressure{};
+};
+
+/**
+ * One voice's modulation state: its LFO phases and mod envelope, the value
+ * of every source, and the resulting offset of every destination.
+ *
+ * Evaluated at control rate (once per kControlInterval samples, or per
+ * render span when shorter), never per sample: each advance() fills the
+ * preallocated source and offset arrays for the span ahead. The voice then
+ * reads modulated parameters through apply(), and rebuilds its spectrum
+ * only when advance() reports that a spectral destination moved.
+ */
+class VoiceModulation
+{
+public:
+    /** Longest span evaluated from one control point. */
+    static constexpr int kControlInterval = 64;
+
+    VoiceModulation() = default;
+
+    void setSampleRate(double newSampleRate) noexcept { sampleRate = newSampleRate; }
+
+    /**
+     * Restart the LFOs and envelope for a new note, and evaluate the first
+     * control point. voiceIndex is the voice's slot in the engine.
+     */
+    void noteOn(const ModulationSettings& settings, float velocity, int midiNote, int voiceIndex) noexcept
+    {
+        noteTime = 0.0;
+        released = false;
+        lfoPhases.fill(0.0);
+
+        // Sample-and-hold draws differ from note to note and voice to voice, but
+        // only depend on those: the same note on the same voice draws the same values
+        randomState = (static_cast<juce::uint32>(midiNote + 1) * 0x9e3779b9u)
+                      ^ (static_cast<juce::uint32>(juce::roundToInt(velocity * 127.0f)) * 0x85ebca6bu)
+                      ^ (static_cast<juce::uint32>(voiceIndex + 1) * 0xc2b2ae35u);
+        if (randomState == 0)
+            randomState = 0x2545f491u;
+
+        for (auto& held : heldValues)
+            held = nextRandomBipolar();
+
+        sources[static_cast<size_t>(ModSource::velocity)] = velocity;
+        sources[static_cast<size_t>(ModSource::keyTrack)] = juce::jlimit(-1.0f, 1.0f, (midiNote - 60) / 60.0f);
+
+        evaluate(settings);
+    }
+
+    /** Send the mod envelope into its release from wherever it is. */
+    void noteOff() noexcept
+    {
+        if (released)
+            return;
+
+        releaseLevel = sources[static_cast<size_t>(ModSource::envelope)];
+        releaseStart = noteTime;
+        released = true;
+    }
+
+    /** Latest controller values for the note (0..1); read at the next control point. */
+    void setControllers(float modWheel, float pressure) noexcept
+    {
+        sources[static_cast<size_t>(ModSource::modWheel)] = modWheel;
+        sources[static_cast<size_t>(ModSource::aftertouch)] = pressure;
+    }
+
+    /**
+     * Evaluate the control point for the next numSamples and move past them.
+     * Returns true if any spectral destination's offset changed since the
+     * previous control point.
+     */
+    bool advance(const ModulationSettings& settings, int numSamples) noexcept
+    {
+        const bool spectrumMoved = evaluate(settings);
+        const double seconds = numSamples / sampleRate;
+
+        noteTime += seconds;
+
+        for (size_t i = 0; i < lfoPhases.size(); ++i)
+        {
+            lfoPhases[i] += settings.lfos[i].rateHz * seconds;
+
+            if (lfoPhases[i] >= 1.0)
+            {
+                lfoPhases[i] -= std::floor(lfoPhases[i]);
+                heldValues[i] = nextRandomBipolar();
+            }
+        }
+
+        return spectrumMoved;
+    }
+
+    /** Offset of a destination at the current control point, in its own units (or octaves). */
+    float getOffset(ModDestination destination) const noexcept
+    {
+        return offsets[static_cast<size_t>(destination)];
+    }
+
+    /** A parameter value with this voice's modulation applied. */
+    float apply(ModDestination destination, float value) const noexcept
+    {
+        const float offset = getOffset(destination);
+        if (offset == 0.0f)
+            return value;
+
+        const auto& info = getModDestinationInfo(destination);
+        return juce::jlimit(info.minimum, info.maximum, info.octaves ? value * std::exp2(offset) : value + offset);
+    }
+
+private:
+    double sampleRate = 44100.0;
+    double noteTime = 0.0;
+
+    std::array<double, ModulationSettings::kNumLfos> lfoPhases{};  // 0..1
+    std::array<float, ModulationSettings::kNumLfos> heldValues{};  // sample-and-hold
+    juce::uint32 randomState = 0x9e3779b9u;
+
+    bool released = false;
+    float releaseLevel = 0.0f;
+    double releaseStart = 0.0;
+
+    std::array<float, kNumModSources> sources{};
+    std::array<float, kNumModDestinations> offsets{};
+
+    bool evaluate(const ModulationSettings& settings) noexcept
+    {
+        for (size_t i = 0; i < lfoPhases.size(); ++i)
+            sources[static_cast<size_t>(ModSource::lfo1) + i] = lfoValue(settings.lfos[i].shape, lfoPhases[i], heldValues[i]);
+
+        sources[static_cast<size_t>(ModSource::envelope)] = envelopeValue(settings.envelope);
+
+        std::array<float, kNumModDestinations> next{};
+
+        for (const auto& slot : settings.slots)
+            if (slot.isActive())
+                next[static_cast<size_t>(slot.destination)] += sources[static_cast<size_t>(slot.source)] * slot.amount
+                                                             * getModDestinationInfo(slot.destination).span;
+
+        bool spectrumMoved = false;
+
+        for (int d = 0; d < kNumModDestinations; ++d)
+            if (next[static_cast<size_t>(d)] != offsets[static_cast<size_t>(d)]
+                && getModDestinationInfo(static_cast<ModDestination>(d)).spectral)
+                spectrumMoved = true;
+
+        offsets = next;
+        return spectrumMoved;
+    }
+
+    static float lfoValue(LfoShape shape, double phase, float held) noexcept
+    {
+        const auto p = static_cast<float>(phase);
+
+        switch (shape)
+        {
+            case LfoShape::triangle:      return p < 0.25f ? 4.0f * p : p < 0.75f ? 2.0f - 4.0f * p : 4.0f * p - 4.0f;
+            case LfoShape::saw:           return 2.0f * p - 1.0f;
+            case LfoShape::square:        return p < 0.5f ? 1.0f : -1.0f;
+            case LfoShape::sampleAndHold: return held;
+            case LfoShape::sine:
+            default:                      return std::sin(juce::MathConstants<float>::twoPi * p);
+        }
+    }
+
+    /** Linear attack/decay/sustain in closed form over the note time, then a linear release. */
+    float envelopeValue(const ModulationSettings::Envelope& envelope) const noexcept
+    {
+        const double minTime = 1.0 / sampleRate;
+
+        if (released)
+        {
+            const double fraction = (noteTime - releaseStart) / juce::jmax(minTime, static_cast<double>(envelope.release));
+            return releaseLevel * static_cast<float>(juce::jmax(0.0, 1.0 - fraction));
+        }
+
+        const double attack = juce::jmax(minTime, static_cast<double>(envelope.attack));
+        const double decay = juce::jmax(minTime, static_cast<double>(envelope.decay));
+        const float sustain = juce::jlimit(0.0f, 1.0f, envelope.sustain);
+
+        if (noteTime < attack)
+            return static_cast<float>(noteTime / attack);
+
+        if (noteTime < attack + decay)
+            return 1.0f - (1.0f - sustain) * static_cast<float>((noteTime - attack) / decay);
+
+        return sustain;
+    }
+
+    float nextRandomBipolar() noexcept
+    {
+        randomState ^= randomState << 13;
+        randomState ^= randomState >> 17;
+        randomState ^= randomState << 5;
+        return static_cast<float>(randomState >> 8) * (2.0f / 16777216.0f) - 1.0f;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VoiceModulation)
+};
+
+} // namespace synth
@@ -0,0 +1,606 @@
+/*
+  ==============================================================================
+    PartialAnalysis.h - STFT peak picking and McAulay-Quatieri partial tracking
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "EngineConfig.h"
+#include "PartialDataFile.h"
+#include "PartialTracks.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+namespace synth
+{
+
+/**
+ * Sinusoidal analysis of a sample into a PartialTrackSet:
+ *   1. STFT: Blackman-Harris frames of ~93 ms every eighth of a frame, each
+ *      centred on its time (zero-phase), so peak phases are the phases at
+ *      that time; the window's -92 dB sidelobes don't turn into tracks;
+ *   2. peaks: local maxima above an absolute and a per-frame relative floor,
+ *      with frequency and amplitude refined by a parabola through the log
+ *      magnitudes of the three bins around each;
+ *   3. tracking (McAulay-Quatieri): each track continues to the nearest peak
+ *      in the next frame within a frequency deviation, closest pairs first;
+ *      unmatched tracks die, unmatched peaks are born as new tracks;
+ *   4. tracks shorter than minTrackFrames are dropped as noise and the rest
+ *      packed onto as few lanes as they need, at most maxLanes.
+ *
+ * Frames overhanging either end of the sample have their amplitudes scaled
+ * up by the part of the window that was cut off. Their frequencies and
+ * phases are skewed as well, so tracks at the start take both back from
+ * the first whole frame.
+ *
+ * Frames are independent until tracking, so step 1-2 is split across a
+ * thread pool when one is given; tracking is one cheap sequential pass.
+ */
+class PartialAnalysis
+{
+public:
+    struct Settings
+    {
+        int maxLanes = kMaxHarmonics;
+        int minTrackFrames = 3;
+        float floorDb = -90.0f;          // peaks below this (dBFS) are ignored
+        float relativeFloorDb = -60.0f;  // ... and below this much under the frame's strongest
+        float maxDeviation = 0.03f;      // largest frequency change per frame, relative
+        float minDeviationHz = 8.0f;     // ... but never narrower than this
+    };
+
+    /** Longest sample analysed; the rest is ignored. */
+    static constexpr double kMaxSeconds = 60.0;
+
+    /**
+     * Read an audio file (first channel, at most kMaxSeconds) and analyse it;
+     * nullptr if it can't be read. The arguments after `settings` are as for
+     * analyse().
+     */
+    static PartialTrackSet::Ptr analyseFile(const juce::File& file, const Settings& settings,
+                                            juce::ThreadPool* pool = nullptr,
+                                            const std::function<bool()>& shouldExit = nullptr,
+                                            std::atomic<float>* progress = nullptr)
+    {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+        if (reader == nullptr || reader->lengthInSamples <= 0 || reader->sampleRate <= 0.0)
+            return nullptr;
+
+        const int numSamples = static_cast<int>(juce::jmin<juce::int64>(
+            reader->lengthInSamples, static_cast<juce::int64>(reader->sampleRate * kMaxSeconds)));
+        juce::AudioBuffer<float> buffer(1, numSamples);
+        reader->read(&buffer, 0, numSamples, 0, true, false);
+
+        return analyse(buffer.getReadPointer(0), numSamples, reader->sampleRate, settings, file.getFileName(),
+                       pool, shouldExit, progress);
+    }
+
+    /**
+     * Analyse mono samples. `pool` (may be nullptr) runs the per-frame work;
+     * `shouldExit` is polled between frames and aborts with nullptr;
+     * `progress` (may be nullptr) counts 0..1 over the frames.
+     */
+    static PartialTrackSet::Ptr analyse(const float* samples, int numSamples, double sampleRate,
+                                        const Settings& settings, const juce::String& name,
+                                        juce::ThreadPool* pool = nullptr,
+                                        const std::function<bool()>& shouldExit = nullptr,
+                                        std::atomic<float>* progress = nullptr)
+    {
+        if (numSamples <= 0 || sampleRate <= 0.0)
+            return nullptr;
+
+        // ~93 ms frames whatever the rate (4096 samples at 44.1/48 kHz): the
+        // window's main lobe is 8 bins wide, so this resolves partials ~45 Hz apart
+        const int fftOrder = juce::jlimit(9, 15, juce::roundToInt(std::log2(sampleRate * 0.093)));
+        const int fftSize = 1 << fftOrder;
+        const int hop = fftSize / 8;
+        const int numFrames = numSamples / hop + 1;
+        const int maxPeaks = juce::jmax(1, settings.maxLanes / 2);
+
+        const juce::dsp::FFT fft(fftOrder);
+        std::vector<float> window(static_cast<size_t>(fftSize));
+        for (int i = 0; i < fftSize; ++i)
+        {
+            const double x = juce::MathConstants<double>::twoPi * i / fftSize;
+            window[static_cast<size_t>(i)] = static_cast<float>(kWindow[0] - kWindow[1] * std::cos(x)
+                                                                + kWindow[2] * std::cos(2.0 * x)
+                                                                - kWindow[3] * std::cos(3.0 * x));
+        }
+
+        // --- Peaks, one frame at a time, spread over the pool ---
+        FrameAnalyser frameAnalyser{ samples, numSamples, sampleRate, fft, fftSize, hop, window.data(),
+                                     juce::Decibels::decibelsToGain(settings.floorDb),
+                                     juce::Decibels::decibelsToGain(settings.relativeFloorDb), maxPeaks };
+        std::vector<std::vector<Peak>> framePeaks(static_cast<size_t>(numFrames));
+        std::atomic<int> framesDone{ 0 };
+        std::atomic<bool> aborted{ false };
+
+        const auto analyseFrames = [&](int firstFrame, int stride)
+        {
+            std::vector<float> scratch(static_cast<size_t>(fftSize) * 2);
+
+            for (int frame = firstFrame; frame < numFrames; frame += stride)
+            {
+                if (aborted.load(std::memory_order_relaxed) || (shouldExit && shouldExit()))
+                {
+                    aborted.store(true);
+                    return;
+                }
+
+                frameAnalyser.findPeaks(frame, scratch.data(), framePeaks[static_cast<size_t>(frame)]);
+
+                const int done = ++framesDone;
+                if (progress != nullptr)
+                    progress->store(0.9f * static_cast<float>(done) / static_cast<float>(numFrames));
+            }
+        };
+
+        const int numJobs = pool != nullptr ? juce::jmax(1, pool->getNumThreads()) : 1;
+
+        if (numJobs > 1)
+        {
+            // Interleaved frames, so every job sees a similar mix of loud and quiet ones
+            std::atomic<int> jobsLeft{ numJobs };
+            juce::WaitableEvent finished;
+
+            for (int job = 0; job < numJobs; ++job)
+                pool->addJob([&, job]
+                {
+                    analyseFrames(job, numJobs);
+                    if (--jobsLeft == 0)
+                        finished.signal();
+                });
+
+            finished.wait();
+        }
+        else
+        {
+            analyseFrames(0, 1);
+        }
+
+        if (aborted.load())
+            return nullptr;
+
+        // --- Tracks, then lanes ---
+        auto tracks = trackPeaks(framePeaks, settings);
+        tracks.erase(std::remove_if(tracks.begin(), tracks.end(), [&](const Track& track)
+                                    { return static_cast<int>(track.points.size()) < settings.minTrackFrames; }),
+                     tracks.end());
+
+        const int numLanes = assignLanes(tracks, settings.maxLanes);
+        const double referenceHz = estimateReferenceHz(tracks, numFrames);
+        correctEarlyPhases(tracks, (fftSize / 2 + hop - 1) / hop, hop / sampleRate);
+
+        PartialTrackSet::Ptr set = new PartialTrackSet(numFrames, numLanes, hop / sampleRate, referenceHz, name);
+
+        for (const auto& track : tracks)
+        {
+            if (track.lane < 0)
+                continue;
+
+            for (size_t i = 0; i < track.points.size(); ++i)
+            {
+                const auto& point = track.points[i];
+                set->getFrame(track.start + static_cast<int>(i))[track.lane] = { point.frequency, point.amplitude,
+                                                                                  point.phase };
+            }
+        }
+
+        if (progress != nullptr)
+            progress->store(1.0f);
+
+        return set;
+    }
+
+private:
+    // 4-term Blackman-Harris
+    static constexpr double kWindow[] = { 0.35875, 0.48829, 0.14128, 0.01168 };
+
+    struct Peak
+    {
+        float frequency = 0.0f; // Hz
+        float amplitude = 0.0f; // linear
+        float phase = 0.0f;     // radians, sine phase at the frame centre
+    };
+
+    struct Track
+    {
+        int start = 0;  // first frame
+        int lane = -1;  // -1 = no lane left for it
+        std::vector<Peak> points;
+
+        int getEnd() const noexcept { return start + static_cast<int>(points.size()) - 1; }
+    };
+
+    /** Everything one frame's peak search needs; shared read-only by the pool's jobs. */
+    struct FrameAnalyser
+    {
+        const float* samples;
+        int numSamples;
+        double sampleRate;
+        const juce::dsp::FFT& fft;
+        int fftSize, hop;
+        const float* window;
+        float floorGain, relativeFloorGain;
+        int maxPeaks;
+
+        /** `scratch` holds 2 * fftSize floats. */
+        void findPeaks(int frame, float* scratch, std::vector<Peak>& peaks) const
+        {
+            const int half = fftSize / 2;
+            const int centre = frame * hop;
+
+            // Zero-phase: the frame's centre sample goes to index 0, the first half wraps to the end
+            std::fill(scratch, scratch + 2 * fftSize, 0.0f);
+            double windowInside = 0.0, windowTotal = 0.0;
+            for (int i = -half; i < half; ++i)
+            {
+                const int source = centre + i;
+                windowTotal += window[i + half];
+
+                if (source >= 0 && source < numSamples)
+                {
+                    scratch[(i + fftSize) % fftSize] = samples[source] * window[i + half];
+                    windowInside += window[i + half];
+                }
+            }
+
+            if (windowInside <= 0.0)
+            {
+                peaks.clear();
+                return;
+            }
+
+            fft.performRealOnlyForwardTransform(scratch, true);
+
+            // Magnitudes go into the upper half of the scratch, past the bins in use
+            float* magnitudes = scratch + fftSize + 2;
+            float strongest = 0.0f;
+            for (int k = 0; k <= half - 2; ++k)
+            {
+                magnitudes[k] = std::hypot(scratch[2 * k], scratch[2 * k + 1]);
+                strongest = juce::jmax(strongest, magnitudes[k]);
+            }
+
+            // The window scales a sinusoid of amplitude a to a peak of a * sum(window) / 2,
+            // or of the part of the window over the sample
+            const float amplitudeScale = static_cast<float>(2.0 / windowInside);
+            const float threshold = juce::jmax(floorGain, strongest * amplitudeScale * relativeFloorGain) / amplitudeScale;
+            const double binHz = sampleRate / fftSize;
+
+            peaks.clear();
+
+            for (int k = 1; k < half - 2; ++k)
+            {
+                const float m = magnitudes[k];
+                if (m < threshold || m <= magnitudes[k - 1] || m < magnitudes[k + 1])
+                    continue;
+
+                // Parabola through the log magnitudes of bins k-1, k, k+1
+                const float lower = std::log(juce::jmax(magnitudes[k - 1], 1.0e-20f));
+                const float centreLog = std::log(m);
+                const float upper = std::log(juce::jmax(magnitudes[k + 1], 1.0e-20f));
+                const float curvature = lower - 2.0f * centreLog + upper;
+                const float offset = curvature < 0.0f ? 0.5f * (lower - upper) / curvature : 0.0f;
+
+                Peak peak;
+                peak.frequency = static_cast<float>((k + offset) * binHz);
+                peak.amplitude = std::exp(centreLog - 0.25f * (lower - upper) * offset) * amplitudeScale;
+
+                // Bin phase is the cosine phase; the oscillators run on sines
+                peak.phase = std::atan2(scratch[2 * k + 1], scratch[2 * k]) + juce::MathConstants<float>::halfPi;
+                peaks.push_back(peak);
+            }
+
+            if (static_cast<int>(peaks.size()) > maxPeaks)
+            {
+                std::nth_element(peaks.begin(), peaks.begin() + maxPeaks, peaks.end(),
+                                 [](const Peak& a, const Peak& b) { return a.amplitude > b.amplitude; });
+                peaks.resize(static_cast<size_t>(maxPeaks));
+            }
+
+            std::sort(peaks.begin(), peaks.end(), [](const Peak& a, const Peak& b) { return a.frequency < b.frequency; });
+        }
+    };
+
+    /** McAulay-Quatieri matching, frame by frame; tracks come out in order of their first frame. */
+    static std::vector<Track> trackPeaks(const std::vector<std::vector<Peak>>& framePeaks, const Settings& settings)
+    {
+        struct Candidate
+        {
+            float distance;
+            int track, peak;
+        };
+
+        std::vector<Track> tracks;
+        std::vector<int> active, continuing;
+        std::vector<Candidate> candidates;
+        std::vector<bool> peakTaken, trackTaken;
+
+        for (int frame = 0; frame < static_cast<int>(framePeaks.size()); ++frame)
+        {
+            const auto& peaks = framePeaks[static_cast<size_t>(frame)];
+
+            // Every peak within the deviation of a live track is a candidate continuation
+            candidates.clear();
+            for (const int t : active)
+            {
+                const float previous = tracks[static_cast<size_t>(t)].points.back().frequency;
+                const float deviation = juce::jmax(settings.minDeviationHz, previous * settings.maxDeviation);
+                const auto first = std::lower_bound(peaks.begin(), peaks.end(), previous - deviation,
+                                                    [](const Peak& p, float f) { return p.frequency < f; });
+
+                for (auto p = first; p != peaks.end() && p->frequency <= previous + deviation; ++p)
+                    candidates.push_back({ std::abs(p->frequency - previous), t, static_cast<int>(p - peaks.begin()) });
+            }
+
+            std::sort(candidates.begin(), candidates.end(),
+                      [](const Candidate& a, const Candidate& b) { return a.distance < b.distance; });
+
+            peakTaken.assign(peaks.size(), false);
+            trackTaken.assign(tracks.size(), false);
+            continuing.clear();
+
+            for (const auto& c : candidates)
+            {
+                if (peakTaken[static_cast<size_t>(c.peak)] || trackTaken[static_cast<size_t>(c.track)])
+                    continue;
+
+                peakTaken[static_cast<size_t>(c.peak)] = true;
+                trackTaken[static_cast<size_t>(c.track)] = true;
+                tracks[static_cast<size_t>(c.track)].points.push_back(peaks[static_cast<size_t>(c.peak)]);
+                continuing.push_back(c.track);
+            }
+
+            // Unmatched tracks end here; unmatched peaks start new ones
+            active.swap(continuing);
+
+            for (size_t p = 0; p < peaks.size(); ++p)
+            {
+                if (peakTaken[p])
+                    continue;
+
+                Track track;
+                track.start = frame;
+                track.points.push_back(peaks[p]);
+                active.push_back(static_cast<int>(tracks.size()));
+                tracks.push_back(std::move(track));
+            }
+        }
+
+        return tracks;
+    }
+
+    /**
+     * Greedy interval packing, in order of first frame: each track takes the
+     * lowest lane that has been silent for at least the frame before it
+     * starts. Returns the number of lanes used.
+     */
+    static int assignLanes(std::vector<Track>& tracks, int maxLanes)
+    {
+        std::vector<int> freeFrom; // per lane: first frame a new track may start on it
+        int numLanes = 0;
+
+        for (auto& track : tracks)
+        {
+            for (int lane = 0; lane < numLanes; ++lane)
+                if (freeFrom[static_cast<size_t>(lane)] <= track.start)
+                {
+                    track.lane = lane;
+                    break;
+                }
+
+            if (track.lane < 0 && numLanes < maxLanes)
+            {
+                track.lane = numLanes++;
+                freeFrom.push_back(0);
+            }
+
+            // The frame after the end fades the track out; the next one may fade in after that
+            if (track.lane >= 0)
+                freeFrom[static_cast<size_t>(track.lane)] = track.getEnd() + 2;
+        }
+
+        return numLanes;
+    }
+
+    /**
+     * Give each track's frames before `firstWholeFrame` the frequency it has
+     * there, and its phase there rewound at that frequency; tracks that end
+     * before it keep what was measured.
+     */
+    static void correctEarlyPhases(std::vector<Track>& tracks, int firstWholeFrame, double frameSeconds)
+    {
+        constexpr double twoPi = juce::MathConstants<double>::twoPi;
+
+        for (auto& track : tracks)
+        {
+            const int reference = firstWholeFrame - track.start;
+            if (reference <= 0 || reference >= static_cast<int>(track.points.size()))
+                continue;
+
+            const auto& whole = track.points[static_cast<size_t>(reference)];
+            const double advancePerFrame = twoPi * whole.frequency * frameSeconds;
+
+            for (int i = 0; i < reference; ++i)
+            {
+                auto& point = track.points[static_cast<size_t>(i)];
+                point.frequency = whole.frequency;
+                point.phase = static_cast<float>(std::remainder(whole.phase - advancePerFrame * (reference - i), twoPi));
+            }
+        }
+    }
+
+    /**
+     * The sample's pitch: per frame, the lowest track within 12 dB of that
+     * frame's strongest (the fundamental, for a harmonic sound), and the
+     * median of those over the frames weighted by the frames' levels.
+     * Middle C when nothing is found.
+     */
+    static double estimateReferenceHz(const std::vector<Track>& tracks, int numFrames)
+    {
+        std::vector<float> strongest(static_cast<size_t>(numFrames), 0.0f);
+        for (const auto& track : tracks)
+            for (size_t i = 0; i < track.points.size(); ++i)
+            {
+                auto& level = strongest[static_cast<size_t>(track.start) + i];
+                level = juce::jmax(level, track.points[i].amplitude);
+            }
+
+        std::vector<float> lowest(static_cast<size_t>(numFrames), 0.0f);
+        for (const auto& track : tracks)
+            for (size_t i = 0; i < track.points.size(); ++i)
+            {
+                const size_t frame = static_cast<size_t>(track.start) + i;
+                const auto& point = track.points[i];
+
+                if (point.amplitude >= strongest[frame] * 0.25f && (lowest[frame] == 0.0f || point.frequency < lowest[frame]))
+                    lowest[frame] = point.frequency;
+            }
+
+        std::vector<std::pair<float, float>> weighted; // frequency, weight
+        float totalWeight = 0.0f;
+        for (size_t frame = 0; frame < lowest.size(); ++frame)
+            if (lowest[frame] > 0.0f)
+            {
+                weighted.emplace_back(lowest[frame], strongest[frame]);
+                totalWeight += strongest[frame];
+            }
+
+        if (weighted.empty())
+            return juce::MidiMessage::getMidiNoteInHertz(60);
+
+        std::sort(weighted.begin(), weighted.end());
+
+        float accumulated = 0.0f;
+        for (const auto& [frequency, weight] : weighted)
+        {
+            accumulated += weight;
+            if (accumulated >= 0.5f * totalWeight)
+                return frequency;
+        }
+
+        return weighted.back().first;
+    }
+};
+
+/**
+ * Loads partial tracks on a background thread: a sample is analysed, the
+ * per-frame work spread over a thread pool with one thread per core, into a
+ * one-set library covering the keyboard; a partial data file (see
+ * PartialDataFile.h) is mapped as it is. The message thread starts a load
+ * and later collects the finished PartialLibrary.
+ */
+class PartialTrackLoader : private juce::Thread
+{
+public:
+    PartialTrackLoader() : juce::Thread("Partial Analysis") {}
+
+    ~PartialTrackLoader() override { stopThread(4000); }
+
+    //==========================================================================
+    // Message thread
+
+    /** Start loading a sample or partial data file, abandoning any load in progress. */
+    void start(const juce::File& file, const PartialAnalysis::Settings& analysisSettings = {})
+    {
+        stopThread(4000);
+
+        {
+            const juce::SpinLock::ScopedLockType lock(resultLock);
+            result = nullptr;
+        }
+
+        sourceFile = file;
+        settings = analysisSettings;
+        progress.store(0.0f);
+        failed.store(false);
+        startThread();
+    }
+
+    /** Abandon any load in progress and drop a result not yet taken. */
+    void cancel()
+    {
+        stopThread(4000);
+
+        const juce::SpinLock::ScopedLockType lock(resultLock);
+        result = nullptr;
+        failed.store(false);
+    }
+
+    bool isAnalysing() const noexcept { return isThreadRunning(); }
+    float getProgress() const noexcept { return progress.load(); }
+
+    /** True if the last load couldn't read its file or found nothing to track. */
+    bool hasFailed() const noexcept { return failed.load(); }
+
+    const juce::File& getFile() const noexcept { return sourceFile; }
+
+    /** Block until the load in progress finishes; false if it's still running after timeoutMs (-1: forever). */
+    bool waitUntilFinished(int timeoutMs = -1) const { return waitForThreadToExit(timeoutMs); }
+
+    /** The finished load, once; nullptr while it runs or after it has been taken. */
+    PartialLibrary::Ptr takeResult()
+    {
+        const juce::SpinLock::ScopedLockType lock(resultLock);
+        auto finished = result;
+        result = nullptr;
+        return finished;
+    }
+
+private:
+    juce::File sourceFile;
+    PartialAnalysis::Settings settings;
+    std::atomic<float> progress{ 0.0f };
+    std::atomic<bool> failed{ false };
+
+    PartialLibrary::Ptr result;
+    juce::SpinLock resultLock;
+
+    void run() override
+    {
+        PartialLibrary::Ptr library;
+
+        if (sourceFile.hasFileExtension(PartialDataFile::kFileExtension))
+        {
+            library = PartialDataFile::map(sourceFile);
+        }
+        else
+        {
+            juce::ThreadPool pool(juce::ThreadPoolOptions{}.withThreadName("Partial Analysis Frames")
+                                                            .withNumberOfThreads(juce::SystemStats::getNumCpus()));
+
+            auto set = PartialAnalysis::analyseFile(sourceFile, settings, &pool,
+                                                    [this] { return threadShouldExit(); }, &progress);
+
+            if (set != nullptr && set->getNumLanes() > 0)
+                library = PartialLibrary::fromSets({ set }, sourceFile.getFileName());
+        }
+
+        if (threadShouldExit())
+            return;
+
+        progress.store(1.0f);
+
+        if (library == nullptr || library->getNumEntries() == 0)
+        {
+            failed.store(true);
+            return;
+        }
+
+        const juce::SpinLock::ScopedLockType lock(resultLock);
+        result = library;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PartialTrackLoader)
+};
+
+} // namespace synth
@@ -0,0 +1,400 @@
+/*
+  ==============================================================================
+    PartialDataFile.h - Memory-mapped partial track libraries + page prefetch
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PartialTracks.h"
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace synth
+{
+
+/**
+ * Binary file of a PartialLibrary, laid out so the breakpoints can be played
+ * straight from a memory mapping: mapping a library costs address space, not
+ * RAM, and only the frames voices actually reach are ever paged in.
+ *
+ * Layout (native byte order, checked through byteOrderMark):
+ *   FileHeader     at 0
+ *   IndexEntry[]   at headerBytes, one per note zone, sorted by lowNote
+ *   names          UTF-8, referenced by the index entries
+ *   frame data     per entry, numFrames x numLanes Breakpoints (frame-major),
+ *                  each block starting on a kDataAlignment boundary so no two
+ *                  entries share a page
+ *
+ * A reader accepts any file with the same magic and version whose header
+ * and entry records are at least as large as its own (later minor additions
+ * go at the end of a record). Mapping only reads the header and index:
+ * they are bounds-checked and every per-entry value the voices compute
+ * with must be finite and in range, or the file is rejected. Frame data is
+ * never read at map time (that would page the whole file in); a corrupt
+ * breakpoint plays as a silent one (see PartialTrackSet::read).
+ */
+class PartialDataFile
+{
+public:
+    static constexpr const char* kFileExtension = ".partials";
+    static constexpr std::uint32_t kVersion = 1;
+    static constexpr size_t kDataAlignment = 4096;
+
+    /** Write a library, replacing `file` only once the whole file is written. */
+    static bool write(const juce::File& file, const PartialLibrary& library)
+    {
+        const int numEntries = library.getNumEntries();
+
+        std::vector<IndexEntry> index(static_cast<size_t>(numEntries));
+        juce::MemoryOutputStream names;
+
+        for (int i = 0; i < numEntries; ++i)
+        {
+            const auto& entry = library.getEntry(i);
+            const auto& name = entry.tracks->getName();
+            auto& record = index[static_cast<size_t>(i)];
+
+            record.lowNote = entry.lowNote;
+            record.highNote = entry.highNote;
+            record.numFrames = entry.tracks->getNumFrames();
+            record.numLanes = entry.tracks->getNumLanes();
+            record.frameSeconds = entry.tracks->getFrameSeconds();
+            record.referenceHz = entry.tracks->getReferenceHz();
+            record.nameOffset = static_cast<std::uint64_t>(names.getDataSize());
+            record.nameBytes = static_cast<std::uint32_t>(name.getNumBytesAsUTF8());
+            names.write(name.toRawUTF8(), record.nameBytes);
+        }
+
+        const auto namesStart = sizeof(FileHeader) + sizeof(IndexEntry) * index.size();
+        auto dataOffset = alignUp(namesStart + names.getDataSize());
+
+        for (auto& record : index)
+        {
+            record.nameOffset += namesStart;
+            record.dataOffset = dataOffset;
+            dataOffset = alignUp(dataOffset + dataBytes(record));
+        }
+
+        FileHeader header;
+        header.numEntries = static_cast<std::uint32_t>(numEntries);
+        header.fileBytes = dataOffset;
+
+        juce::TemporaryFile temporary(file);
+        {
+            juce::FileOutputStream out(temporary.getFile());
+            if (!out.openedOk())
+                return false;
+
+            bool ok = out.write(&header, sizeof(header))
+                      && out.write(index.data(), sizeof(IndexEntry) * index.size())
+                      && out.write(names.getData(), names.getDataSize());
+
+            for (int i = 0; ok && i < numEntries; ++i)
+            {
+                const auto& record = index[static_cast<size_t>(i)];
+                const PartialTrackSet& tracks = *library.getEntry(i).tracks;
+                ok = padTo(out, record.dataOffset) && out.write(tracks.getFrame(0), dataBytes(record));
+            }
+
+            if (!(ok && padTo(out, header.fileBytes)))
+                return false;
+
+            out.flush();
+            if (out.getStatus().failed())
+                return false;
+        }
+
+        return temporary.overwriteTargetFileWithTemporary();
+    }
+
+    /**
+     * Map a library file read-only. Its sets are views into the mapping,
+     * which lives as long as any of them. Returns nullptr (and a reason in
+     * `error` if given) for a file that isn't a valid library.
+     */
+    static PartialLibrary::Ptr map(const juce::File& file, juce::String* error = nullptr)
+    {
+        auto fail = [error](const juce::String& reason) -> PartialLibrary::Ptr
+        {
+            if (error != nullptr)
+                *error = reason;
+            return nullptr;
+        };
+
+        juce::ReferenceCountedObjectPtr<MappedData> mapped = new MappedData(file);
+        const auto* base = static_cast<const char*>(mapped->mapping.getData());
+        const auto size = static_cast<std::uint64_t>(mapped->mapping.getSize());
+
+        if (base == nullptr)
+            return fail("Can't map " + file.getFileName());
+
+        FileHeader header;
+        if (size < sizeof(FileHeader))
+            return fail("Not a partial data file");
+
+        std::memcpy(&header, base, sizeof(header));
+
+        if (std::memcmp(header.magic, FileHeader{}.magic, sizeof(header.magic)) != 0)
+            return fail("Not a partial data file");
+        if (header.byteOrderMark != kByteOrderMark)
+            return fail("Partial data file written with another byte order");
+        if (header.version != kVersion)
+            return fail("Unsupported partial data version " + juce::String(header.version));
+        if (header.headerBytes < sizeof(FileHeader) || header.entryBytes < sizeof(IndexEntry)
+            || header.breakpointBytes != sizeof(PartialTrackSet::Breakpoint) || header.fileBytes > size
+            || header.headerBytes + static_cast<std::uint64_t>(header.entryBytes) * header.numEntries > header.fileBytes)
+            return fail("Corrupt partial data header");
+
+        std::vector<PartialLibrary::Entry> entries;
+        entries.reserve(header.numEntries);
+
+        for (std::uint32_t i = 0; i < header.numEntries; ++i)
+        {
+            IndexEntry record;
+            std::memcpy(&record, base + header.headerBytes + static_cast<std::uint64_t>(header.entryBytes) * i,
+                        sizeof(record));
+
+            if (record.numFrames <= 0 || record.numLanes <= 0 || record.numLanes > kMaxLanes
+                || !isInRange(record.frameSeconds, kMinFrameSeconds, kMaxFrameSeconds)
+                || !isInRange(record.referenceHz, kMinReferenceHz, kMaxReferenceHz)
+                || record.lowNote < 0 || record.highNote > 127 || record.lowNote > record.highNote
+                || record.dataOffset % alignof(PartialTrackSet::Breakpoint) != 0
+                || record.dataOffset > header.fileBytes || dataBytes(record) > header.fileBytes - record.dataOffset
+                || record.nameOffset > header.fileBytes || record.nameBytes > header.fileBytes - record.nameOffset)
+                return fail("Corrupt partial data entry " + juce::String(i));
+
+            const auto* frames = reinterpret_cast<const PartialTrackSet::Breakpoint*>(base + record.dataOffset);
+            const auto name = juce::String::fromUTF8(base + record.nameOffset, static_cast<int>(record.nameBytes));
+
+            entries.push_back({ record.lowNote, record.highNote,
+                                new PartialTrackSet(frames, record.numFrames, record.numLanes, record.frameSeconds,
+                                                    record.referenceHz, name, mapped) });
+        }
+
+        return new PartialLibrary(std::move(entries), file.getFileName());
+    }
+
+private:
+    static constexpr std::uint32_t kByteOrderMark = 0x01020304;
+    static constexpr int kMaxLanes = 1 << 16;
+
+    // Accepted frame periods and reference pitches: wide, but far from
+    // anything that overflows the frame and prefetch window arithmetic
+    static constexpr double kMinFrameSeconds = 1.0e-4, kMaxFrameSeconds = 10.0;
+    static constexpr double kMinReferenceHz = 1.0, kMaxReferenceHz = 100000.0;
+
+    struct IndexEntry
+    {
+        std::int32_t lowNote = 0, highNote = 127;
+        std::int32_t numFrames = 0, numLanes = 0;
+        double frameSeconds = 0.0;
+        double referenceHz = 0.0;
+        std::uint64_t dataOffset = 0;
+        std::uint64_t nameOffset = 0;
+        std::uint32_t nameBytes = 0;
+        std::uint32_t reserved = 0;
+    };
+
+    struct FileHeader
+    {
+        char magic[8] = { 'A', 'S', 'P', 'A', 'R', 'T', 'S', '\0' };
+        std::uint32_t byteOrderMark = kByteOrderMark;
+        std::uint32_t version = kVersion;
+        std::uint32_t headerBytes = sizeof(FileHeader);
+        std::uint32_t entryBytes = sizeof(IndexEntry);
+        std::uint32_t breakpointBytes = sizeof(PartialTrackSet::Breakpoint);
+        std::uint32_t numEntries = 0;
+        std::uint64_t fileBytes = 0;
+    };
+
+    static_assert(sizeof(PartialTrackSet::Breakpoint) == 3 * sizeof(float), "Breakpoints must be tightly packed");
+
+    /** Owns the mapping the sets of a mapped library view. */
+    struct MappedData : public juce::ReferenceCountedObject
+    {
+        explicit MappedData(const juce::File& file) : mapping(file, juce::MemoryMappedFile::readOnly) {}
+
+        juce::MemoryMappedFile mapping;
+    };
+
+    static std::uint64_t dataBytes(const IndexEntry& record) noexcept
+    {
+        return static_cast<std::uint64_t>(record.numFrames) * static_cast<std::uint64_t>(record.numLanes)
+               * sizeof(PartialTrackSet::Breakpoint);
+    }
+
+    /** False for NaN, infinities and anything outside [minimum, maximum]. */
+    static bool isInRange(double value, double minimum, double maximum) noexcept
+    {
+        return std::isfinite(value) && value >= minimum && value <= maximum;
+    }
+
+    static std::uint64_t alignUp(std::uint64_t offset) noexcept
+    {
+        return (offset + kDataAlignment - 1) / kDataAlignment * kDataAlignment;
+    }
+
+    static bool padTo(juce::OutputStream& out, std::uint64_t offset)
+    {
+        const auto position = static_cast<std::uint64_t>(out.getPosition());
+        return position <= offset && out.writeRepeatedByte(0, static_cast<size_t>(offset - position));
+    }
+};
+
+//==============================================================================
+/**
+ * Pages the frames of a mapped library into memory ahead of the voices, on
+ * a low-priority background thread, so the audio thread never waits on a
+ * page fault for a frame it reaches in time.
+ *
+ * When a library arrives, the first kWindowSeconds of every set are paged
+ * in, so any note can start without faulting. While a note plays, its voice
+ * asks for the next window before it reaches the end of the current one.
+ * Requests go through a lock-free FIFO the thread polls every couple of
+ * milliseconds; the audio thread never locks or signals anything. A full
+ * FIFO drops the request (the voice then just reads through the fault).
+ *
+ * Sets that own their breakpoints are already in memory and are skipped.
+ */
+class PartialPrefetcher : private juce::Thread
+{
+public:
+    /** How far ahead of a playing note frames are paged in. */
+    static constexpr double kWindowSeconds = 0.5;
+
+    PartialPrefetcher() : juce::Thread("Partial Prefetch") {}
+
+    ~PartialPrefetcher() override { stopThread(1000); }
+
+    //==========================================================================
+    // Message thread
+
+    /** The library voices are about to play (nullptr for none). */
+    void setLibrary(PartialLibrary::Ptr library)
+    {
+        {
+            const juce::SpinLock::ScopedLockType lock(pendingLock);
+            pendingLibrary = std::move(library);
+            libraryChanged = true;
+        }
+
+        if (!isThreadRunning())
+            startThread(juce::Thread::Priority::low);
+    }
+
+    int getNumDroppedRequests() const noexcept { return droppedRequests.load(std::memory_order_relaxed); }
+
+    //==========================================================================
+    // Audio thread
+
+    /**
+     * Page in numFrames frames of `tracks` from firstFrame on. `tracks`
+     * needn't belong to the current library; requests for sets the prefetch
+     * thread doesn't hold are ignored.
+     */
+    void request(const PartialTrackSet& tracks, int firstFrame, int numFrames) noexcept
+    {
+        if (!tracks.isView() || numFrames <= 0)
+            return;
+
+        const auto scope = fifo.write(1);
+        if (scope.blockSize1 > 0)
+            requests[static_cast<size_t>(scope.startIndex1)] = { &tracks, firstFrame, numFrames };
+        else
+            droppedRequests.fetch_add(1, std::memory_order_relaxed);
+    }
+
+private:
+    struct Request
+    {
+        const PartialTrackSet* tracks = nullptr;
+        int firstFrame = 0;
+        int numFrames = 0;
+    };
+
+    static constexpr int kFifoSize = 256;
+    static constexpr size_t kPageBytes = 4096;
+
+    juce::AbstractFifo fifo{ kFifoSize };
+    std::array<Request, kFifoSize> requests{};
+    std::atomic<int> droppedRequests{ 0 };
+
+    juce::SpinLock pendingLock;
+    PartialLibrary::Ptr pendingLibrary;
+    bool libraryChanged = false;
+
+    PartialLibrary::Ptr library;  // prefetch thread; keeps every set it touches alive
+    volatile char touchSink = 0;
+
+    //==========================================================================
+    // Prefetch thread
+
+    void run() override
+    {
+        while (!threadShouldExit())
+        {
+            takePendingLibrary();
+
+            const auto scope = fifo.read(fifo.getNumReady());
+            scope.forEach([this](int index)
+            {
+                const auto& next = requests[static_cast<size_t>(index)];
+                if (library != nullptr && library->contains(next.tracks))
+                    touch(*next.tracks, next.firstFrame, next.numFrames);
+            });
+
+            wait(2);
+        }
+    }
+
+    /** Switch to a newly set library and page in the start of each of its sets. */
+    void takePendingLibrary()
+    {
+        {
+            const juce::SpinLock::ScopedLockType lock(pendingLock);
+            if (!libraryChanged)
+                return;
+
+            library = std::move(pendingLibrary);
+            libraryChanged = false;
+        }
+
+        for (int i = 0; library != nullptr && i < library->getNumEntries() && !threadShouldExit(); ++i)
+        {
+            const auto& tracks = *library->getEntry(i).tracks;
+            touch(tracks, 0, static_cast<int>(std::ceil(kWindowSeconds / tracks.getFrameSeconds())) + 1);
+        }
+    }
+
+    /** Read one byte per page of the frames, so the OS pages them in. */
+    void touch(const PartialTrackSet& tracks, int firstFrame, int numFrames) noexcept
+    {
+        if (!tracks.isView())
+            return;
+
+        firstFrame = juce::jlimit(0, tracks.getNumFrames() - 1, firstFrame);
+        numFrames = juce::jmin(numFrames, tracks.getNumFrames() - firstFrame);
+
+        const auto* begin = reinterpret_cast<const volatile char*>(tracks.getFrame(firstFrame));
+        const size_t bytes = tracks.getFrameBytes() * static_cast<size_t>(numFrames);
+        char sink = 0;
+
+        for (size_t offset = 0; offset < bytes; offset += kPageBytes)
+            sink = static_cast<char>(sink + begin[offset]);
+
+        if (bytes > 0)
+            sink = static_cast<char>(sink + begin[bytes - 1]);
+
+        touchSink = sink;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PartialPrefetcher)
+};
+
+} // namespace synth
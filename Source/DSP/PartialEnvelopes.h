@@ -0,0 +1,127 @@
+/*
+  ==============================================================================
+    PartialEnvelopes.h - Independent attack/decay/sustain level per partial
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "RenderKernels.h"
+#include <array>
+#include <cmath>
+
+namespace synth
+{
+
+/**
+ * One linear attack/decay/sustain envelope per partial, all sharing the
+ * note's attack time and sustain level but not its timing:
+ *   - partial n starts attackDelay * log2(n) seconds late (seconds per octave
+ *     of harmonic number), so upper partials swell in after the fundamental;
+ *   - partial n decays in decay / n^decayTilt seconds, so with a positive tilt
+ *     high partials die first — the classic additive brightness decay.
+ * With both at zero every partial follows the shape of juce::ADSR's
+ * attack/decay/sustain. Release is left to the voice's own ADSR.
+ *
+ * The levels are evaluated at control rate, a whole vector of partials at a
+ * time (RenderKernels::evaluateEnvelopes, closed-form in the note time, so no
+ * per-lane state machine). The voice ramps between consecutive control
+ * points inside the render kernel.
+ */
+template <int MaxPartials>
+class BasicPartialEnvelopes
+{
+public:
+    struct Parameters
+    {
+        float attack = 0.01f;     // seconds
+        float decay = 0.1f;       // seconds, at the fundamental
+        float sustain = 0.8f;     // 0..1
+        float decayTilt = 0.0f;   // decay time exponent over partial number
+        float attackDelay = 0.0f; // seconds per octave of partial number
+
+        bool operator==(const Parameters& other) const noexcept
+        {
+            return attack == other.attack && decay == other.decay && sustain == other.sustain
+                && decayTilt == other.decayTilt && attackDelay == other.attackDelay;
+        }
+    };
+
+    void setSampleRate(double newSampleRate) noexcept
+    {
+        sampleRate = newSampleRate;
+        recalculate();
+    }
+
+    /** Cheap when nothing changed, so it can be called every block. */
+    void setParameters(const Parameters& newParameters) noexcept
+    {
+        if (newParameters == parameters)
+            return;
+
+        parameters = newParameters;
+        recalculate();
+    }
+
+    /** Restart every partial at the beginning of its attack. */
+    void noteOn(const RenderKernels& kernels) noexcept
+    {
+        time = 0.0;
+        evaluate(kernels);
+        previous = current;
+    }
+
+    /** Move the note time on by numSamples and evaluate the new control point. */
+    void advance(int numSamples, const RenderKernels& kernels) noexcept
+    {
+        previous = 1 - previous;
+        current = 1 - current;
+        time += static_cast<double>(numSamples) / sampleRate;
+        evaluate(kernels);
+    }
+
+    /** Levels at the latest control point, and at the one before it. */
+    const float* getLevels() const noexcept { return levels[static_cast<size_t>(current)].data(); }
+    const float* getPreviousLevels() const noexcept { return levels[static_cast<size_t>(previous)].data(); }
+
+private:
+    Parameters parameters;
+    double sampleRate = 44100.0;
+    double time = 0.0;
+
+    float attackTime = 0.0f, attackRate = 0.0f;
+    std::array<float, MaxPartials> delays{}, decayRates{};
+
+    // Double-buffered so advance() doesn't copy the previous control point
+    std::array<std::array<float, MaxPartials>, 2> levels{};
+    int current = 0, previous = 1;
+
+    void recalculate() noexcept
+    {
+        // At least one sample per segment, like juce::ADSR, so the rates stay finite
+        const float minTime = static_cast<float>(1.0 / sampleRate);
+        const float sustain = juce::jlimit(0.0f, 1.0f, parameters.sustain);
+
+        attackTime = juce::jmax(minTime, parameters.attack);
+        attackRate = 1.0f / attackTime;
+
+        for (int n = 0; n < MaxPartials; ++n)
+        {
+            const float harmonic = static_cast<float>(n + 1);
+            const float decayTime = parameters.decay / std::pow(harmonic, parameters.decayTilt);
+
+            delays[static_cast<size_t>(n)] = parameters.attackDelay * std::log2(harmonic);
+            decayRates[static_cast<size_t>(n)] = (1.0f - sustain) / juce::jmax(minTime, decayTime);
+        }
+    }
+
+    void evaluate(const RenderKernels& kernels) noexcept
+    {
+        kernels.evaluateEnvelopes(levels[static_cast<size_t>(current)].data(), delays.data(), decayRates.data(),
+                                  MaxPartials, static_cast<float>(time), attackTime, attackRate,
+                                  juce::jlimit(0.0f, 1.0f, parameters.sustain));
+    }
+};
+
+} // namespace synth
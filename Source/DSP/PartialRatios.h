@@ -0,0 +1,401 @@
+/*
+  ==============================================================================
+    PartialRatios.h - Partial frequency ratios: harmonic, physical models, custom
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "EngineConfig.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace synth
+{
+
+/** Where the partials sit relative to the fundamental (partial ratio 1). */
+enum class PartialTuning
+{
+    harmonic,    // n
+    stiffString, // n * sqrt(1 + B n^2), normalised to the fundamental; B = inharmonicity
+    bar,         // free-free bar: (beta_n / beta_1)^2, beta_n the roots of cos x cosh x = 1
+    bell,        // a typical church bell: hum, prime, tierce, quint, nominal and above
+    membrane,    // ideal circular membrane: Bessel zeros j_mn / j_01
+    custom       // a user table, e.g. loaded from a file or taken from an analysis
+};
+
+static constexpr int kNumPartialTunings = 6;
+
+/**
+ * Frequency ratio of every partial to the fundamental for a PartialTuning,
+ * with the stretch (ratio^stretch) applied on top. The harmonic tuning
+ * stretched this way is the original n^stretch power law.
+ *
+ * The table is rebuilt only when the tuning, stretch, inharmonicity or custom
+ * ratios change; the render paths then get each partial's frequency with one
+ * multiply, whatever the model. Ratios are kept ascending, so the partials
+ * below Nyquist for a note are always a prefix of the table and are counted
+ * with a binary search.
+ *
+ * The bar and membrane models need root finding; their tables are computed
+ * once per process (prepareModelTables) and shared.
+ */
+template <int MaxPartials>
+class BasicPartialRatios
+{
+public:
+    /** Model parameters; customRatios (unsorted, any count) only matter for PartialTuning::custom. */
+    struct Settings
+    {
+        PartialTuning tuning = PartialTuning::harmonic;
+        float stretch = 1.0f;
+        float inharmonicity = 0.0f;
+        const float* customRatios = nullptr;
+        int numCustomRatios = 0;
+    };
+
+    BasicPartialRatios() { rebuild(); }
+
+    /** Rebuild if anything changed; cheap when nothing did, so it can be called every block. */
+    void update(const Settings& newSettings)
+    {
+        const int numCustom = newSettings.tuning == PartialTuning::custom
+                                ? juce::jlimit(0, MaxPartials, newSettings.numCustomRatios) : 0;
+
+        if (newSettings.tuning == settings.tuning && newSettings.stretch == settings.stretch
+            && newSettings.inharmonicity == settings.inharmonicity && numCustom == numCustomSource
+            && std::equal(customSource.begin(), customSource.begin() + numCustom, newSettings.customRatios))
+            return;
+
+        settings = newSettings;
+        numCustomSource = numCustom;
+        std::copy(newSettings.customRatios, newSettings.customRatios + numCustom, customSource.begin());
+        rebuild();
+    }
+
+    /** Ratio of partial n (0 = fundamental) to the fundamental; n < getSize(). */
+    double getRatio(int n) const noexcept { return ratios[static_cast<size_t>(n)]; }
+    const double* getRatios() const noexcept { return ratios.data(); }
+
+    /** Number of partials the tuning defines (the bell and custom tables can be short). */
+    int getSize() const noexcept { return size; }
+
+    /** True when partial n is exactly harmonic n + 1 (no model, no stretch). */
+    bool isHarmonic() const noexcept { return harmonic; }
+
+    /** Number of partials with a ratio strictly below `limit`. */
+    int countBelow(double limit) const noexcept
+    {
+        return static_cast<int>(std::lower_bound(ratios.begin(), ratios.begin() + size, limit) - ratios.begin());
+    }
+
+    /**
+     * Number of partials below Nyquist for a fundamental. Along with the count
+     * it keeps the range of fundamentals the count holds for, so a moving
+     * pitch only pays for a recount when it crosses a partial.
+     */
+    int getCountBelowNyquist(double fundamentalHz, double nyquistHz) noexcept
+    {
+        if (fundamentalHz >= lowHz && fundamentalHz < highHz && nyquistHz == cachedNyquist)
+            return count;
+
+        cachedNyquist = nyquistHz;
+        count = countBelow(nyquistHz / juce::jmax(fundamentalHz, 1.0e-3));
+        highHz = count > 0 ? nyquistHz / ratios[static_cast<size_t>(count - 1)] : std::numeric_limits<double>::infinity();
+        lowHz = count < size ? nyquistHz / ratios[static_cast<size_t>(count)] : 0.0;
+        return count;
+    }
+
+    /**
+     * Parse a ratio list: numbers or fractions (e.g. "2.76" or "11/4"),
+     * separated by whitespace, commas or new lines; '#' and '!' start a
+     * comment. Non-positive entries are skipped. Returns the ratios read,
+     * at most MaxPartials.
+     */
+    static std::vector<float> parseRatios(const juce::String& text)
+    {
+        std::vector<float> result;
+        juce::StringArray lines;
+        lines.addLines(text);
+
+        for (auto line : lines)
+        {
+            line = line.upToFirstOccurrenceOf("#", false, false).upToFirstOccurrenceOf("!", false, false);
+
+            juce::StringArray tokens;
+            tokens.addTokens(line, " \t,;", "");
+
+            for (const auto& token : tokens)
+            {
+                if (token.isEmpty() || static_cast<int>(result.size()) >= MaxPartials)
+                    continue;
+
+                double value = token.upToFirstOccurrenceOf("/", false, false).getDoubleValue();
+                if (token.contains("/"))
+                {
+                    const double denominator = token.fromFirstOccurrenceOf("/", false, false).getDoubleValue();
+                    value = denominator > 0.0 ? value / denominator : 0.0;
+                }
+
+                if (value > 0.0 && std::isfinite(value))
+                    result.push_back(static_cast<float>(value));
+            }
+        }
+
+        return result;
+    }
+
+    /**
+     * Compute the shared bar and membrane tables (tens of milliseconds for
+     * the largest capacity). Done on first use otherwise; the engine calls
+     * this from its constructor so that never happens on the audio thread.
+     */
+    static void prepareModelTables() { getModelTables(); }
+
+private:
+    Settings settings;
+    std::array<float, MaxPartials> customSource{};
+    int numCustomSource = 0;
+
+    std::array<double, MaxPartials> ratios{};
+    int size = 0;
+    bool harmonic = true;
+
+    // getCountBelowNyquist cache: count holds for fundamentals in [lowHz, highHz)
+    int count = 0;
+    double lowHz = 0.0, highHz = -1.0, cachedNyquist = 0.0;
+
+    /** Church bell partials relative to the prime (Rossing's measurements of a typical bell). */
+    static constexpr std::array<double, 11> kBellRatios{ 0.5, 1.0, 1.183, 1.506, 2.0, 2.514,
+                                                          2.662, 3.011, 4.166, 5.433, 6.796 };
+
+    struct ModelTables
+    {
+        std::array<double, MaxPartials> bar{}, membrane{};
+    };
+
+    static const ModelTables& getModelTables()
+    {
+        static const ModelTables tables = []()
+        {
+            ModelTables t;
+            computeBarRatios(t.bar);
+            computeMembraneRatios(t.membrane);
+            return t;
+        }();
+
+        return tables;
+    }
+
+    void rebuild()
+    {
+        const double stretch = static_cast<double>(settings.stretch);
+        const double inharmonicity = juce::jmax(0.0, static_cast<double>(settings.inharmonicity));
+
+        size = MaxPartials;
+
+        switch (settings.tuning)
+        {
+            case PartialTuning::stiffString:
+                for (int n = 0; n < MaxPartials; ++n)
+                {
+                    const double harmonicNumber = static_cast<double>(n + 1);
+                    ratios[static_cast<size_t>(n)] = harmonicNumber
+                                                     * std::sqrt((1.0 + inharmonicity * harmonicNumber * harmonicNumber)
+                                                                 / (1.0 + inharmonicity));
+                }
+                break;
+
+            case PartialTuning::bar:
+                ratios = getModelTables().bar;
+                break;
+
+            case PartialTuning::membrane:
+                ratios = getModelTables().membrane;
+                break;
+
+            case PartialTuning::bell:
+                size = juce::jmin(MaxPartials, static_cast<int>(kBellRatios.size()));
+                std::copy(kBellRatios.begin(), kBellRatios.begin() + size, ratios.begin());
+                break;
+
+            case PartialTuning::custom:
+                if (numCustomSource > 0)
+                {
+                    size = numCustomSource;
+                    for (int n = 0; n < size; ++n)
+                        ratios[static_cast<size_t>(n)] = static_cast<double>(customSource[static_cast<size_t>(n)]);
+
+                    std::sort(ratios.begin(), ratios.begin() + size);
+                    break;
+                }
+
+                // An empty custom table plays harmonic
+                [[fallthrough]];
+
+            case PartialTuning::harmonic:
+                for (int n = 0; n < MaxPartials; ++n)
+                    ratios[static_cast<size_t>(n)] = static_cast<double>(n + 1);
+                break;
+        }
+
+        harmonic = stretch == 1.0 && size == MaxPartials
+                   && (settings.tuning == PartialTuning::harmonic
+                       || (settings.tuning == PartialTuning::custom && numCustomSource == 0)
+                       || (settings.tuning == PartialTuning::stiffString && inharmonicity == 0.0));
+
+        if (stretch != 1.0)
+            for (int n = 0; n < size; ++n)
+                ratios[static_cast<size_t>(n)] = std::pow(ratios[static_cast<size_t>(n)], stretch);
+
+        // Past the end of a short table nothing is ever below Nyquist
+        std::fill(ratios.begin() + size, ratios.end(), std::numeric_limits<double>::infinity());
+
+        highHz = -1.0; // invalidate the Nyquist count
+    }
+
+    /** Free-free bar: the roots of cos x cosh x = 1, by Newton's method from (n + 1/2) pi. */
+    static void computeBarRatios(std::array<double, MaxPartials>& out)
+    {
+        constexpr double pi = juce::MathConstants<double>::pi;
+        double first = 0.0;
+
+        for (int n = 0; n < MaxPartials; ++n)
+        {
+            // cos x - sech x has the same roots and stays finite for large x
+            double x = (static_cast<double>(n + 1) + 0.5) * pi;
+            for (int i = 0; i < 8; ++i)
+            {
+                const double sech = 1.0 / std::cosh(x);
+                x -= (std::cos(x) - sech) / (-std::sin(x) + sech * std::tanh(x));
+            }
+
+            if (n == 0)
+                first = x;
+
+            out[static_cast<size_t>(n)] = (x / first) * (x / first);
+        }
+    }
+
+    /**
+     * J_0(x) .. J_maxOrder(x) by Miller's algorithm: the recurrence
+     * J_{k-1} = (2k / x) J_k - J_{k+1} run downwards (the stable direction)
+     * from well above both maxOrder and x, then normalised with
+     * J_0 + 2 (J_2 + J_4 + ...) = 1. No trig calls, O(maxOrder + x).
+     */
+    static void besselJ(double x, int maxOrder, std::vector<double>& values)
+    {
+        const int reach = juce::jmax(maxOrder, static_cast<int>(x));
+        const int start = 2 * ((reach + 24 + static_cast<int>(std::sqrt(40.0 * reach))) / 2);
+
+        values.assign(static_cast<size_t>(maxOrder + 1), 0.0);
+        double above = 0.0, current = 1.0e-300, sum = 0.0;
+
+        for (int k = start; k >= 0; --k)
+        {
+            if (k <= maxOrder)
+                values[static_cast<size_t>(k)] = current;
+
+            sum += (k == 0 ? 1.0 : (k % 2 == 0 ? 2.0 : 0.0)) * current;
+
+            const double below = 2.0 * k / x * current - above;
+            above = current;
+            current = below;
+
+            // Rescale before the unnormalised values overflow
+            if (std::abs(current) > 1.0e250)
+            {
+                current *= 1.0e-250;
+                above *= 1.0e-250;
+                sum *= 1.0e-250;
+                for (auto& v : values)
+                    v *= 1.0e-250;
+            }
+        }
+
+        for (auto& v : values)
+            v /= sum;
+    }
+
+    /**
+     * Ideal circular membrane: the zeros j_mn of J_m, one partial per (m, n)
+     * (the degenerate cos/sin pair of each m > 0 shares a frequency), sorted
+     * and divided by j_01.
+     *
+     * All orders are evaluated together on a grid of x with steps well under
+     * the zero spacing (about pi); each sign change of J_m is then polished by
+     * Newton's method kept inside its bracket. About X^2/4 zeros lie below X,
+     * so the scan limit starts there and grows if it ever comes up short.
+     */
+    static void computeMembraneRatios(std::array<double, MaxPartials>& out)
+    {
+        constexpr double scanStep = 0.5;
+        std::vector<double> zeros, previous, current;
+
+        for (double limit = 2.0 * std::sqrt(static_cast<double>(MaxPartials)) + 8.0;
+             static_cast<int>(zeros.size()) < MaxPartials; limit *= 1.25)
+        {
+            zeros.clear();
+            const int maxOrder = static_cast<int>(limit);
+            besselJ(scanStep, maxOrder, previous);
+
+            for (double x = 2.0 * scanStep; x <= limit; x += scanStep)
+            {
+                besselJ(x, maxOrder, current);
+
+                // J_m has no zeros below x = m
+                for (int m = 0; m <= maxOrder && m < x; ++m)
+                {
+                    const bool negativeBefore = previous[static_cast<size_t>(m)] < 0.0;
+                    if (negativeBefore != (current[static_cast<size_t>(m)] < 0.0))
+                        zeros.push_back(refineZero(m, x - scanStep, x, negativeBefore));
+                }
+
+                std::swap(previous, current);
+            }
+        }
+
+        std::sort(zeros.begin(), zeros.end());
+
+        for (int n = 0; n < MaxPartials; ++n)
+            out[static_cast<size_t>(n)] = zeros[static_cast<size_t>(n)] / zeros.front();
+    }
+
+    /**
+     * Newton's method on J_m (J_m' = (m / x) J_m - J_{m+1}), falling back to
+     * bisection whenever a step leaves the bracket.
+     */
+    static double refineZero(int m, double low, double high, bool negativeAtLow)
+    {
+        std::vector<double> values;
+        double x = 0.5 * (low + high);
+
+        for (int i = 0; i < 30; ++i)
+        {
+            besselJ(x, m + 1, values);
+            const double value = values[static_cast<size_t>(m)];
+            const double derivative = m / x * value - values[static_cast<size_t>(m + 1)];
+
+            ((value < 0.0) == negativeAtLow ? low : high) = x;
+
+            double next = x - value / derivative;
+            if (!(next > low && next < high))
+                next = 0.5 * (low + high);
+
+            if (std::abs(next - x) < 1.0e-13 * x)
+                return next;
+
+            x = next;
+        }
+
+        return x;
+    }
+};
+
+using PartialRatios = BasicPartialRatios<kMaxHarmonics>;
+
+} // namespace synth
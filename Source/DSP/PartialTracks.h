@@ -0,0 +1,277 @@
+/*
+  ==============================================================================
+    PartialTracks.h - Time-indexed sinusoidal tracks for sample resynthesis
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace synth
+{
+
+/**
+ * The sinusoidal tracks of an analysed sample (see PartialAnalysis.h), laid
+ * out on a fixed number of oscillator lanes so a voice can play them through
+ * its partial bank.
+ *
+ * Frame f holds one Breakpoint per lane, at f * frameSeconds into the
+ * sample. A lane carries one track at a time, with at least one silent frame
+ * between two tracks, so every track fades in and out over one frame. Lane
+ * frequencies are those of the sample; a voice plays them scaled by its
+ * note frequency over getReferenceHz(), the sample's estimated pitch.
+ *
+ * A set either owns its breakpoints (a fresh analysis) or views them in
+ * memory owned by someone else, e.g. a memory-mapped partial data file
+ * (PartialDataFile.h), which it keeps alive through `backing`.
+ *
+ * Immutable once built and shared by reference count. The audio thread only
+ * ever reads a set through a raw pointer; whoever publishes it keeps it
+ * alive until no block can still be reading it.
+ */
+class PartialTrackSet : public juce::ReferenceCountedObject
+{
+public:
+    using Ptr = juce::ReferenceCountedObjectPtr<PartialTrackSet>;
+
+    struct Breakpoint
+    {
+        float frequency = 0.0f; // Hz
+        float amplitude = 0.0f; // linear, 0 = lane silent
+        float phase = 0.0f;     // radians, sine phase at the frame's time
+    };
+
+    /** A set owning zeroed breakpoints, to be filled in through getFrame(). */
+    PartialTrackSet(int framesToAllocate, int lanesToAllocate, double secondsPerFrame,
+                    double referenceFrequencyHz, const juce::String& sourceName)
+        : numFrames(juce::jmax(1, framesToAllocate)),
+          numLanes(juce::jmax(0, lanesToAllocate)),
+          frameSeconds(secondsPerFrame),
+          referenceHz(referenceFrequencyHz),
+          name(sourceName),
+          ownedBreakpoints(static_cast<size_t>(numFrames) * static_cast<size_t>(numLanes)),
+          breakpoints(ownedBreakpoints.data())
+    {
+    }
+
+    /**
+     * A read-only view of numFrames x numLanes breakpoints (frame-major) that
+     * `backing` owns; the set holds a reference to it for as long as it lives.
+     */
+    PartialTrackSet(const Breakpoint* frames, int framesInView, int lanesInView, double secondsPerFrame,
+                    double referenceFrequencyHz, const juce::String& sourceName,
+                    juce::ReferenceCountedObjectPtr<juce::ReferenceCountedObject> backingObject)
+        : numFrames(juce::jmax(1, framesInView)),
+          numLanes(juce::jmax(0, lanesInView)),
+          frameSeconds(secondsPerFrame),
+          referenceHz(referenceFrequencyHz),
+          name(sourceName),
+          breakpoints(frames),
+          backing(std::move(backingObject))
+    {
+    }
+
+    int getNumFrames() const noexcept { return numFrames; }
+    int getNumLanes() const noexcept { return numLanes; }
+    double getFrameSeconds() const noexcept { return frameSeconds; }
+    double getDurationSeconds() const noexcept { return (numFrames - 1) * frameSeconds; }
+
+    /** Pitch the sample is played back at unchanged (a note of this frequency plays it as recorded). */
+    double getReferenceHz() const noexcept { return referenceHz; }
+
+    /** File name (or other label) of the analysed sample. */
+    const juce::String& getName() const noexcept { return name; }
+
+    /** True if the breakpoints live in someone else's memory (e.g. a mapped file). */
+    bool isView() const noexcept { return backing != nullptr; }
+
+    /** Bytes taken by one frame's breakpoints. */
+    size_t getFrameBytes() const noexcept { return sizeof(Breakpoint) * static_cast<size_t>(numLanes); }
+
+    /** The frame playing `seconds` into the sample (held at the last frame past the end). */
+    int frameAt(double seconds) const noexcept
+    {
+        // Clamped before the cast, which is undefined for doubles outside int's range
+        return static_cast<int>(juce::jlimit(0.0, numFrames - 1.0, seconds / frameSeconds));
+    }
+
+    /** The numLanes breakpoints of one frame; writable only on a set that owns them. */
+    Breakpoint* getFrame(int frame) noexcept
+    {
+        jassert(!isView());
+        return ownedBreakpoints.data() + static_cast<size_t>(frame) * numLanes;
+    }
+
+    const Breakpoint* getFrame(int frame) const noexcept
+    {
+        return breakpoints + static_cast<size_t>(frame) * numLanes;
+    }
+
+    /**
+     * The first `count` lanes at `seconds` into the sample (held at the last
+     * frame past the end), interpolated between the frames either side:
+     * amplitude linearly, frequency linearly while the lane sounds on both
+     * sides and from the sounding side while a track fades in or out.
+     * Frequencies come out as ratios to getReferenceHz(). A breakpoint whose
+     * frequency or amplitude isn't a finite, non-negative number plays as a
+     * silent one: mapped files are only checked this lazily, frame by frame.
+     */
+    void read(double seconds, int count, float* amplitudes, double* ratios) const noexcept
+    {
+        const double position = juce::jlimit(0.0, static_cast<double>(numFrames - 1), seconds / frameSeconds);
+        const int frame = juce::jmin(static_cast<int>(position), numFrames - 2);
+        const float fraction = numFrames > 1 ? static_cast<float>(position - frame) : 0.0f;
+
+        const Breakpoint* from = getFrame(juce::jmax(0, frame));
+        const Breakpoint* to = numFrames > 1 ? getFrame(frame + 1) : from;
+        const double invReference = 1.0 / referenceHz;
+
+        for (int n = 0; n < count; ++n)
+        {
+            const float a0 = getSoundingAmplitude(from[n]), a1 = getSoundingAmplitude(to[n]);
+            const float frequency = a0 > 0.0f && a1 > 0.0f ? from[n].frequency + fraction * (to[n].frequency - from[n].frequency)
+                                  : a0 > 0.0f              ? from[n].frequency
+                                                           : to[n].frequency;
+
+            amplitudes[n] = a0 + fraction * (a1 - a0);
+            ratios[n] = frequency * invReference;
+        }
+    }
+
+    /** Phases of the first `count` lanes at the first frame, where every note starts (0 if not finite). */
+    void readStartPhases(int count, float* phases) const noexcept
+    {
+        const Breakpoint* first = getFrame(0);
+
+        for (int n = 0; n < count; ++n)
+            phases[n] = std::isfinite(first[n].phase) ? first[n].phase : 0.0f;
+    }
+
+private:
+    /** The breakpoint's amplitude, or 0 if its frequency or amplitude is unusable. */
+    static float getSoundingAmplitude(const Breakpoint& point) noexcept
+    {
+        return std::isfinite(point.frequency) && point.frequency >= 0.0f
+                       && std::isfinite(point.amplitude) && point.amplitude > 0.0f
+                   ? point.amplitude
+                   : 0.0f;
+    }
+
+    const int numFrames;
+    const int numLanes;
+    const double frameSeconds;
+    const double referenceHz;
+    const juce::String name;
+
+    std::vector<Breakpoint> ownedBreakpoints;  // empty for a view
+    const Breakpoint* breakpoints;             // frame-major
+    juce::ReferenceCountedObjectPtr<juce::ReferenceCountedObject> backing;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PartialTrackSet)
+};
+
+//==============================================================================
+/**
+ * The track sets a voice can play, each over a range of MIDI notes: a
+ * single analysed sample covers the keyboard, a multi-sampled instrument
+ * (typically mapped from a partial data file) one set per zone.
+ *
+ * Entries are sorted by note and don't overlap. Like a single set, a
+ * library is immutable once built and kept alive by whoever publishes it.
+ */
+class PartialLibrary : public juce::ReferenceCountedObject
+{
+public:
+    using Ptr = juce::ReferenceCountedObjectPtr<PartialLibrary>;
+
+    struct Entry
+    {
+        int lowNote = 0;
+        int highNote = 127;
+        PartialTrackSet::Ptr tracks;
+    };
+
+    PartialLibrary(std::vector<Entry> libraryEntries, const juce::String& libraryName)
+        : entries(std::move(libraryEntries)), name(libraryName)
+    {
+        std::sort(entries.begin(), entries.end(),
+                  [](const Entry& a, const Entry& b) { return a.lowNote < b.lowNote; });
+    }
+
+    /**
+     * A library of analysed sets placed on the keyboard by their reference
+     * pitch: each covers the notes nearer its own pitch than its neighbours',
+     * the lowest and highest reaching to the ends of the keyboard.
+     */
+    static Ptr fromSets(std::vector<PartialTrackSet::Ptr> sets, const juce::String& libraryName)
+    {
+        std::sort(sets.begin(), sets.end(), [](const PartialTrackSet::Ptr& a, const PartialTrackSet::Ptr& b)
+                  { return a->getReferenceHz() < b->getReferenceHz(); });
+
+        std::vector<Entry> entries;
+        int lowNote = 0;
+
+        for (size_t i = 0; i < sets.size(); ++i)
+        {
+            int highNote = 127;
+
+            if (i + 1 < sets.size())
+            {
+                const double split = 0.5 * (rootNote(*sets[i]) + rootNote(*sets[i + 1]));
+                highNote = juce::jlimit(lowNote, 127, static_cast<int>(std::floor(split)));
+            }
+
+            entries.push_back({ lowNote, highNote, sets[i] });
+            lowNote = juce::jmin(127, highNote + 1);
+        }
+
+        return new PartialLibrary(std::move(entries), libraryName);
+    }
+
+    int getNumEntries() const noexcept { return static_cast<int>(entries.size()); }
+    const Entry& getEntry(int index) const noexcept { return entries[static_cast<size_t>(index)]; }
+    const juce::String& getName() const noexcept { return name; }
+
+    /** The set for a note: the entry covering it, else the nearest one (nullptr if empty). */
+    const PartialTrackSet* findTracks(int midiNote) const noexcept
+    {
+        if (entries.empty())
+            return nullptr;
+
+        const auto above = std::upper_bound(entries.begin(), entries.end(), midiNote,
+                                            [](int note, const Entry& entry) { return note < entry.lowNote; });
+
+        if (above == entries.begin())
+            return above->tracks.get();
+
+        const auto& below = *(above - 1);
+        if (midiNote <= below.highNote || above == entries.end())
+            return below.tracks.get();
+
+        return midiNote - below.highNote <= above->lowNote - midiNote ? below.tracks.get() : above->tracks.get();
+    }
+
+    /** True if `tracks` is one of this library's sets. */
+    bool contains(const PartialTrackSet* tracks) const noexcept
+    {
+        return std::any_of(entries.begin(), entries.end(),
+                           [tracks](const Entry& entry) { return entry.tracks.get() == tracks; });
+    }
+
+private:
+    std::vector<Entry> entries;
+    const juce::String name;
+
+    static double rootNote(const PartialTrackSet& tracks) noexcept
+    {
+        return 69.0 + 12.0 * std::log2(tracks.getReferenceHz() / 440.0);
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PartialLibrary)
+};
+
+} // namespace synth
@@ -0,0 +1,106 @@
+/*
+  ==============================================================================
+    PitchControl.h - Pitch bend, glide and MPE note pitch
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <cmath>
+
+namespace synth
+{
+
+/** When a new note glides in from the previous one. */
+enum class GlideMode
+{
+    off,
+    always, // every note, from the last note played
+    legato  // only while another key is still held
+};
+
+static constexpr int kNumGlideModes = 3;
+
+/**
+ * What a starting voice needs to know about the notes before it; kept by
+ * the engine's synthesiser, which sees every note-on and note-off.
+ */
+struct NoteHistory
+{
+    int previousNote = -1;   // last note started before this one, -1 if none yet
+    bool keyHeld = false;    // another key was down when this one started
+};
+
+/** Pitch wheel position (0..16383, centre 8192) as a fraction of the bend range, -1..1. */
+inline double pitchWheelToBend(int wheelValue) noexcept
+{
+    return juce::jlimit(-1.0, 1.0, static_cast<double>(wheelValue - 8192) / 8192.0);
+}
+
+/**
+ * A voice's pitch offset from its note — pitch bend, MPE master bend and
+ * glide, all in semitones — turned into a frequency ratio per block.
+ *
+ * The voice never rebuilds anything for a pitch change: advance() yields the
+ * ratio at the start and end of the block, and the render kernels scale
+ * every partial's phase increment by a linear ramp between the two.
+ */
+class VoicePitch
+{
+public:
+    /**
+     * Start a note, optionally gliding in from another one. The glide is
+     * linear in semitones and takes glideSeconds whatever the interval.
+     */
+    void startNote(int midiNote, int glideFromNote, double glideSeconds, double sampleRate) noexcept
+    {
+        glideSemitones = glideFromNote >= 0 ? static_cast<double>(glideFromNote - midiNote) : 0.0;
+        glidePerSample = glideSemitones != 0.0
+                           ? std::abs(glideSemitones) / juce::jmax(1.0, glideSeconds * sampleRate)
+                           : 0.0;
+
+        endRatio = computeRatio();
+        startRatio = endRatio;
+    }
+
+    void setBend(double semitones) noexcept { bendSemitones = semitones; }
+    void setMasterBend(double semitones) noexcept { masterBendSemitones = semitones; }
+
+    /** Move on by one block: the previous end ratio becomes the start ratio. */
+    void advance(int numSamples) noexcept
+    {
+        if (glideSemitones != 0.0)
+        {
+            const double step = glidePerSample * numSamples;
+            glideSemitones = std::abs(glideSemitones) <= step ? 0.0
+                                                              : glideSemitones - std::copysign(step, glideSemitones);
+        }
+
+        startRatio = endRatio;
+        endRatio = computeRatio();
+    }
+
+    double getStartRatio() const noexcept { return startRatio; }
+    double getEndRatio() const noexcept { return endRatio; }
+    double getLowestRatio() const noexcept { return juce::jmin(startRatio, endRatio); }
+    double getHighestRatio() const noexcept { return juce::jmax(startRatio, endRatio); }
+
+    /** True when the pitch doesn't move within the current block. */
+    bool isSteady() const noexcept { return startRatio == endRatio; }
+
+private:
+    double bendSemitones = 0.0;
+    double masterBendSemitones = 0.0;
+    double glideSemitones = 0.0;
+    double glidePerSample = 0.0;
+    double startRatio = 1.0, endRatio = 1.0;
+
+    double computeRatio() const noexcept
+    {
+        const double semitones = bendSemitones + masterBendSemitones + glideSemitones;
+        return semitones == 0.0 ? 1.0 : std::exp2(semitones / 12.0);
+    }
+};
+
+} // namespace synth
@@ -0,0 +1,446 @@
+/*
+  ==============================================================================
+    RenderKernels.h - Hot render loops compiled per x86 ISA, dispatched at runtime
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SineKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+#endif
+
+namespace synth
+{
+
+/**
+ * Instruction-set levels the render kernels are built for. One binary
+ * carries all of them; the best one the CPU supports is picked at startup.
+ */
+enum class SimdLevel
+{
+    scalar, // portable C++, also the reference for the others
+    sse2,   // 4 lanes
+    avx2,   // 8 lanes, FMA, hardware gathers
+    avx512  // 16 lanes (AVX-512F)
+};
+
+static constexpr int kNumSimdLevels = 4;
+
+inline const char* getSimdLevelName(SimdLevel level) noexcept
+{
+    switch (level)
+    {
+        case SimdLevel::scalar: return "scalar";
+        case SimdLevel::sse2:   return "sse2";
+        case SimdLevel::avx2:   return "avx2";
+        case SimdLevel::avx512: return "avx512";
+    }
+
+    return "scalar";
+}
+
+/**
+ * Inputs of the stereo partial kernel: the same per-partial arrays as
+ * accumulatePartials(Ramped), plus a left and a right gain per partial.
+ * amplitudeSteps may be null, for no ramp.
+ */
+struct StereoPartials
+{
+    float* phases = nullptr;
+    const float* increments = nullptr;
+    float incrementScale = 1.0f;
+    const float* amplitudes = nullptr;
+    const float* amplitudeSteps = nullptr;
+    float rampPosition = 0.0f;
+    const float* phaseOffsets = nullptr;
+    const float* gainsLeft = nullptr;
+    const float* gainsRight = nullptr;
+};
+
+struct StereoSum
+{
+    float left = 0.0f, right = 0.0f;
+};
+
+/**
+ * Entry points of one ISA variant. The voice looks its table up once and
+ * calls through it, so the per-call cost is one indirect call.
+ */
+struct RenderKernels
+{
+    SimdLevel level;
+
+    /**
+     * Sum of amplitudes[i] * sin(phases[i] + phaseOffsets[i]) over count
+     * partials, then phases[i] += increments[i] * incrementScale, wrapped to
+     * [0, 2π). The scale is the pitch ratio of the current sample (bend,
+     * glide), one multiply-add per partial like the plain add it replaces.
+     * Indexed by SineKernel; the exact kernel is scalar in every variant.
+     */
+    float (*accumulatePartials[kNumSineKernels])(float* phases, const float* increments, float incrementScale,
+                                                 const float* amplitudes, const float* phaseOffsets,
+                                                 int count) noexcept;
+
+    /**
+     * As accumulatePartials, with each amplitude at amplitudes[i] +
+     * rampPosition * amplitudeSteps[i]: per-sample interpolation between two
+     * control points, shared by every unison voice (nothing is written back).
+     */
+    float (*accumulatePartialsRamped[kNumSineKernels])(float* phases, const float* increments,
+                                                       float incrementScale, const float* amplitudes, const float* amplitudeSteps,
+                                                       float rampPosition, const float* phaseOffsets,
+                                                       int count) noexcept;
+
+    /**
+     * As accumulatePartials(Ramped), with each partial's term summed into
+     * both channels through its own gains: per-partial spectral panning
+     * (see SpectralPan) for the cost of two extra multiply-adds per partial.
+     */
+    StereoSum (*accumulatePartialsStereo[kNumSineKernels])(const StereoPartials& partials, int count) noexcept;
+
+    /**
+     * levels[i] = linear attack/decay/sustain at note time `time`, started
+     * delays[i] late and decaying at decayRates[i] per second (see PartialEnvelopes).
+     */
+    void (*evaluateEnvelopes)(float* levels, const float* delays, const float* decayRates, int count,
+                              float time, float attackTime, float attackRate, float sustain) noexcept;
+
+    /** amplitudes[i] *= sigmoid low-pass x resonant bell for harmonic i + 1 (see SpectralFilter). */
+    void (*shapeSpectrum)(float* amplitudes, int count, float cutoff, float boostLinear) noexcept;
+
+    /**
+     * Move a spectrum `amount` of the way to a target: amplitudes linearly,
+     * phases the shortest way round (their difference wrapped to [-pi, pi)).
+     */
+    void (*morphSpectrum)(float* amplitudes, float* phases, const float* targetAmplitudes,
+                          const float* targetPhases, float amount, int count) noexcept;
+
+    /** output[i] = SineLUT::lookup(phases[i]) */
+    void (*sineBatch)(const float* phases, float* output, int count) noexcept;
+
+    /**
+     * One modulated-delay read (see UnisonProcessor): sample i is history at
+     * position + i * advance, linearly interpolated, added to left[i] and
+     * right[i] through gainLeft and gainRight. Every read position must be
+     * non-negative with its following sample inside history.
+     */
+    void (*accumulateDelayTap)(const float* history, float position, float advance, float gainLeft,
+                               float gainRight, float* left, float* right, int count) noexcept;
+};
+
+namespace simd
+{
+    /** Width-1 operations: the scalar kernels, and the tails of the vector ones. */
+    struct ScalarOps
+    {
+        using V = float;
+        using I = int;
+        using Mask = bool;
+        static constexpr int width = 1;
+
+        static V set1(float x) noexcept { return x; }
+        static V load(const float* p) noexcept { return *p; }
+        static void store(float* p, V v) noexcept { *p = v; }
+        static V add(V a, V b) noexcept { return a + b; }
+        static V sub(V a, V b) noexcept { return a - b; }
+        static V mul(V a, V b) noexcept { return a * b; }
+        static V div(V a, V b) noexcept { return a / b; }
+        static V mulAdd(V a, V b, V c) noexcept { return a * b + c; }
+        static V min(V a, V b) noexcept { return std::min(a, b); }
+        static V max(V a, V b) noexcept { return std::max(a, b); }
+        static V floor(V a) noexcept { return std::floor(a); }
+        static V abs(V a) noexcept { return std::abs(a); }
+        static V copySign(V magnitude, V sign) noexcept { return std::copysign(magnitude, sign); }
+        static Mask greater(V a, V b) noexcept { return a > b; }
+        static Mask greaterEqual(V a, V b) noexcept { return a >= b; }
+        static V select(Mask m, V a, V b) noexcept { return m ? a : b; }
+        static I truncate(V a) noexcept { return static_cast<int>(a); }
+        static V toFloat(I a) noexcept { return static_cast<float>(a); }
+        static I maskBits(I a, int bits) noexcept { return a & bits; }
+        static V gather(const float* table, I index) noexcept { return table[index]; }
+        static float sum(V a) noexcept { return a; }
+    };
+} // namespace simd
+
+//==============================================================================
+// Kernel variants. Each namespace gets its own copy of RenderKernelsBody.h,
+// compiled for that instruction set: GCC and Clang through a target region,
+// MSVC needs nothing as its intrinsics are always available.
+
+#define ADDITIVE_SYNTH_PRAGMA(x) _Pragma(#x)
+
+#if defined(__clang__)
+ #define ADDITIVE_SYNTH_BEGIN_TARGET(isa) ADDITIVE_SYNTH_PRAGMA(clang attribute push(__attribute__((target(isa))), apply_to = function))
+ #define ADDITIVE_SYNTH_END_TARGET        ADDITIVE_SYNTH_PRAGMA(clang attribute pop)
+#elif defined(__GNUC__)
+ #define ADDITIVE_SYNTH_BEGIN_TARGET(isa) ADDITIVE_SYNTH_PRAGMA(GCC push_options) ADDITIVE_SYNTH_PRAGMA(GCC target(isa))
+ #define ADDITIVE_SYNTH_END_TARGET        ADDITIVE_SYNTH_PRAGMA(GCC pop_options)
+#else
+ #define ADDITIVE_SYNTH_BEGIN_TARGET(isa)
+ #define ADDITIVE_SYNTH_END_TARGET
+#endif
+
+namespace simd::scalar
+{
+    using Ops = ScalarOps;
+    static constexpr SimdLevel kLevel = SimdLevel::scalar;
+
+    #include "RenderKernelsBody.h"
+}
+
+#if JUCE_INTEL
+
+ADDITIVE_SYNTH_BEGIN_TARGET("sse2")
+namespace simd::sse2
+{
+    struct Ops
+    {
+        using V = __m128;
+        using I = __m128i;
+        using Mask = __m128;
+        static constexpr int width = 4;
+
+        static V set1(float x) noexcept { return _mm_set1_ps(x); }
+        static V load(const float* p) noexcept { return _mm_loadu_ps(p); }
+        static void store(float* p, V v) noexcept { _mm_storeu_ps(p, v); }
+        static V add(V a, V b) noexcept { return _mm_add_ps(a, b); }
+        static V sub(V a, V b) noexcept { return _mm_sub_ps(a, b); }
+        static V mul(V a, V b) noexcept { return _mm_mul_ps(a, b); }
+        static V div(V a, V b) noexcept { return _mm_div_ps(a, b); }
+        static V mulAdd(V a, V b, V c) noexcept { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+        static V min(V a, V b) noexcept { return _mm_min_ps(a, b); }
+        static V max(V a, V b) noexcept { return _mm_max_ps(a, b); }
+
+        static V floor(V a) noexcept
+        {
+            // No rounding instruction before SSE4.1: truncate, then step down where that rounded up
+            const V truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+            return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, a), _mm_set1_ps(1.0f)));
+        }
+
+        static V abs(V a) noexcept { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+
+        static V copySign(V magnitude, V sign) noexcept
+        {
+            const V signBit = _mm_set1_ps(-0.0f);
+            return _mm_or_ps(_mm_andnot_ps(signBit, magnitude), _mm_and_ps(signBit, sign));
+        }
+
+        static Mask greater(V a, V b) noexcept { return _mm_cmpgt_ps(a, b); }
+        static Mask greaterEqual(V a, V b) noexcept { return _mm_cmpge_ps(a, b); }
+        static V select(Mask m, V a, V b) noexcept { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+        static I truncate(V a) noexcept { return _mm_cvttps_epi32(a); }
+        static V toFloat(I a) noexcept { return _mm_cvtepi32_ps(a); }
+        static I maskBits(I a, int bits) noexcept { return _mm_and_si128(a, _mm_set1_epi32(bits)); }
+        static V pow2(I n) noexcept { return _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23)); }
+
+        static V gather(const float* table, I index) noexcept
+        {
+            alignas(16) int lanes[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(lanes), index);
+            return _mm_setr_ps(table[lanes[0]], table[lanes[1]], table[lanes[2]], table[lanes[3]]);
+        }
+
+        static float sum(V a) noexcept
+        {
+            a = _mm_add_ps(a, _mm_movehl_ps(a, a));
+            a = _mm_add_ss(a, _mm_shuffle_ps(a, a, 1));
+            return _mm_cvtss_f32(a);
+        }
+    };
+
+    static constexpr SimdLevel kLevel = SimdLevel::sse2;
+
+    #include "RenderKernelsBody.h"
+}
+ADDITIVE_SYNTH_END_TARGET
+
+ADDITIVE_SYNTH_BEGIN_TARGET("avx2,fma")
+namespace simd::avx2
+{
+    struct Ops
+    {
+        using V = __m256;
+        using I = __m256i;
+        using Mask = __m256;
+        static constexpr int width = 8;
+
+        static V set1(float x) noexcept { return _mm256_set1_ps(x); }
+        static V load(const float* p) noexcept { return _mm256_loadu_ps(p); }
+        static void store(float* p, V v) noexcept { _mm256_storeu_ps(p, v); }
+        static V add(V a, V b) noexcept { return _mm256_add_ps(a, b); }
+        static V sub(V a, V b) noexcept { return _mm256_sub_ps(a, b); }
+        static V mul(V a, V b) noexcept { return _mm256_mul_ps(a, b); }
+        static V div(V a, V b) noexcept { return _mm256_div_ps(a, b); }
+        static V mulAdd(V a, V b, V c) noexcept { return _mm256_fmadd_ps(a, b, c); }
+        static V min(V a, V b) noexcept { return _mm256_min_ps(a, b); }
+        static V max(V a, V b) noexcept { return _mm256_max_ps(a, b); }
+        static V floor(V a) noexcept { return _mm256_floor_ps(a); }
+        static V abs(V a) noexcept { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+
+        static V copySign(V magnitude, V sign) noexcept
+        {
+            const V signBit = _mm256_set1_ps(-0.0f);
+            return _mm256_or_ps(_mm256_andnot_ps(signBit, magnitude), _mm256_and_ps(signBit, sign));
+        }
+
+        static Mask greater(V a, V b) noexcept { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+        static Mask greaterEqual(V a, V b) noexcept { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+        static V select(Mask m, V a, V b) noexcept { return _mm256_blendv_ps(b, a, m); }
+        static I truncate(V a) noexcept { return _mm256_cvttps_epi32(a); }
+        static V toFloat(I a) noexcept { return _mm256_cvtepi32_ps(a); }
+        static I maskBits(I a, int bits) noexcept { return _mm256_and_si256(a, _mm256_set1_epi32(bits)); }
+        static V pow2(I n) noexcept { return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(n, _mm256_set1_epi32(127)), 23)); }
+        static V gather(const float* table, I index) noexcept { return _mm256_i32gather_ps(table, index, 4); }
+
+        static float sum(V a) noexcept
+        {
+            __m128 s = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+            s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+            s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+            return _mm_cvtss_f32(s);
+        }
+    };
+
+    static constexpr SimdLevel kLevel = SimdLevel::avx2;
+
+    #include "RenderKernelsBody.h"
+}
+ADDITIVE_SYNTH_END_TARGET
+
+// GCC 12's AVX-512 headers trip -Wmaybe-uninitialized on _mm512_undefined_ps()
+#if defined(__GNUC__) && !defined(__clang__)
+ #pragma GCC diagnostic push
+ #pragma GCC diagnostic ignored "-Wuninitialized"
+ #pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+ADDITIVE_SYNTH_BEGIN_TARGET("avx512f,avx2,fma")
+namespace simd::avx512
+{
+    struct Ops
+    {
+        using V = __m512;
+        using I = __m512i;
+        using Mask = __mmask16;
+        static constexpr int width = 16;
+
+        static V set1(float x) noexcept { return _mm512_set1_ps(x); }
+        static V load(const float* p) noexcept { return _mm512_loadu_ps(p); }
+        static void store(float* p, V v) noexcept { _mm512_storeu_ps(p, v); }
+        static V add(V a, V b) noexcept { return _mm512_add_ps(a, b); }
+        static V sub(V a, V b) noexcept { return _mm512_sub_ps(a, b); }
+        static V mul(V a, V b) noexcept { return _mm512_mul_ps(a, b); }
+        static V div(V a, V b) noexcept { return _mm512_div_ps(a, b); }
+        static V mulAdd(V a, V b, V c) noexcept { return _mm512_fmadd_ps(a, b, c); }
+        static V min(V a, V b) noexcept { return _mm512_min_ps(a, b); }
+        static V max(V a, V b) noexcept { return _mm512_max_ps(a, b); }
+        static V floor(V a) noexcept { return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+        static V abs(V a) noexcept { return _mm512_abs_ps(a); }
+
+        static V copySign(V magnitude, V sign) noexcept
+        {
+            // Float and/or need AVX-512DQ, so go through the integer domain
+            const __m512i signBit = _mm512_set1_epi32(static_cast<int>(0x80000000u));
+            return _mm512_castsi512_ps(_mm512_or_si512(_mm512_andnot_si512(signBit, _mm512_castps_si512(magnitude)),
+                                                       _mm512_and_si512(signBit, _mm512_castps_si512(sign))));
+        }
+
+        static Mask greater(V a, V b) noexcept { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+        static Mask greaterEqual(V a, V b) noexcept { return _mm512_cmp_ps_mask(a, b, _CMP_GE_OQ); }
+        static V select(Mask m, V a, V b) noexcept { return _mm512_mask_blend_ps(m, b, a); }
+        static I truncate(V a) noexcept { return _mm512_cvttps_epi32(a); }
+        static V toFloat(I a) noexcept { return _mm512_cvtepi32_ps(a); }
+        static I maskBits(I a, int bits) noexcept { return _mm512_and_si512(a, _mm512_set1_epi32(bits)); }
+        static V pow2(I n) noexcept { return _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_add_epi32(n, _mm512_set1_epi32(127)), 23)); }
+        static V gather(const float* table, I index) noexcept { return _mm512_i32gather_ps(index, table, 4); }
+        static float sum(V a) noexcept { return _mm512_reduce_add_ps(a); }
+    };
+
+    static constexpr SimdLevel kLevel = SimdLevel::avx512;
+
+    #include "RenderKernelsBody.h"
+}
+ADDITIVE_SYNTH_END_TARGET
+
+#if defined(__GNUC__) && !defined(__clang__)
+ #pragma GCC diagnostic pop
+#endif
+
+#endif // JUCE_INTEL
+
+//==============================================================================
+/** Best level this CPU (and OS) supports, from CPUID. */
+inline SimdLevel detectSimdLevel() noexcept
+{
+   #if JUCE_INTEL
+    if (juce::SystemStats::hasAVX512F() && juce::SystemStats::hasAVX2() && juce::SystemStats::hasFMA3())
+        return SimdLevel::avx512;
+    if (juce::SystemStats::hasAVX2() && juce::SystemStats::hasFMA3())
+        return SimdLevel::avx2;
+    if (juce::SystemStats::hasSSE2())
+        return SimdLevel::sse2;
+   #endif
+
+    return SimdLevel::scalar;
+}
+
+/** Kernel table for a level; levels this build has no variant for fall back to scalar. */
+inline const RenderKernels& getRenderKernels(SimdLevel level) noexcept
+{
+   #if JUCE_INTEL
+    switch (level)
+    {
+        case SimdLevel::avx512: return simd::avx512::kernels;
+        case SimdLevel::avx2:   return simd::avx2::kernels;
+        case SimdLevel::sse2:   return simd::sse2::kernels;
+        case SimdLevel::scalar: break;
+    }
+   #else
+    juce::ignoreUnused(level);
+   #endif
+
+    return simd::scalar::kernels;
+}
+
+/**
+ * Level the engine renders with: the detected one, unless the
+ * ADDITIVE_SYNTH_SIMD environment variable (scalar, sse2, avx2 or avx512)
+ * asks for a lower one, e.g. to compare paths or reproduce a report from an
+ * older machine. Requests above what the CPU supports are ignored.
+ * Resolved on first use and fixed for the lifetime of the process.
+ */
+inline SimdLevel getActiveSimdLevel()
+{
+    static const SimdLevel active = []
+    {
+        const auto detected = detectSimdLevel();
+        const auto requested = juce::SystemStats::getEnvironmentVariable("ADDITIVE_SYNTH_SIMD", {}).trim().toLowerCase();
+
+        for (int i = 0; i < kNumSimdLevels; ++i)
+        {
+            const auto level = static_cast<SimdLevel>(i);
+            if (requested == getSimdLevelName(level))
+                return juce::jmin(level, detected);
+        }
+
+        return detected;
+    }();
+
+    return active;
+}
+
+inline const RenderKernels& getActiveRenderKernels()
+{
+    return getRenderKernels(getActiveSimdLevel());
+}
+
+} // namespace synth
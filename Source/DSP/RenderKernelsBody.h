@@ -0,0 +1,339 @@
+/*
+  ==============================================================================
+    RenderKernelsBody.h - Kernel bodies, compiled once per instruction set
+
+    Not a standalone header: RenderKernels.h includes it inside each
+    simd::<isa> namespace, after defining that namespace's Ops and kLevel,
+    so it deliberately has no include guard.
+  ==============================================================================
+*/
+
+// Lane i holds i; numbers the harmonics across a vector
+alignas(64) static constexpr float kLaneIndices[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+
+/** Same arithmetic as SineLUT::lookup, with the two table reads as gathers. */
+template <typename O>
+inline typename O::V tableSine(typename O::V phase) noexcept
+{
+    constexpr int mask = SineLUT::kTableSize - 1;
+    const float* table = SineLUT::data();
+
+    auto normalized = O::mul(phase, O::set1(1.0f / SineLUT::kTwoPi));
+    normalized = O::sub(normalized, O::floor(normalized));
+
+    const auto index = O::mul(normalized, O::set1(static_cast<float>(SineLUT::kTableSize)));
+    const auto whole = O::truncate(index);
+    const auto frac = O::sub(index, O::toFloat(whole));
+    const auto idx0 = O::maskBits(whole, mask);
+
+    const auto a = O::gather(table, idx0);
+    const auto b = O::gather(table + 1, idx0); // the guard entry makes idx0 + 1 always valid
+    return O::mulAdd(frac, O::sub(b, a), a);
+}
+
+/** Same fold and coefficients as detail::polynomialSine. */
+template <typename O, int Order>
+inline typename O::V polynomialSine(typename O::V phase) noexcept
+{
+    using Poly = detail::SinePolynomial<Order>;
+    constexpr int numTerms = (Order + 1) / 2;
+
+    auto x = O::mul(phase, O::set1(static_cast<float>(1.0 / 6.283185307179586)));
+    x = O::sub(x, O::floor(O::add(x, O::set1(0.5f))));
+    const auto folded = O::sub(O::copySign(O::set1(0.5f), x), x);
+    x = O::select(O::greater(O::abs(x), O::set1(0.25f)), folded, x);
+
+    const auto x2 = O::mul(x, x);
+    auto sum = O::set1(static_cast<float>(Poly::c[numTerms - 1]));
+    for (int k = numTerms - 2; k >= 0; --k)
+        sum = O::mulAdd(sum, x2, O::set1(static_cast<float>(Poly::c[k])));
+
+    return O::mul(sum, x);
+}
+
+template <typename O, SineKernel Kernel>
+inline typename O::V sine(typename O::V phase) noexcept
+{
+    if constexpr (O::width == 1 || Kernel == SineKernel::exact)
+        return evaluateSine<Kernel>(phase);
+    else if constexpr (Kernel == SineKernel::table)
+        return tableSine<O>(phase);
+    else if constexpr (Kernel == SineKernel::poly3)
+        return polynomialSine<O, 3>(phase);
+    else if constexpr (Kernel == SineKernel::poly5)
+        return polynomialSine<O, 5>(phase);
+    else
+        return polynomialSine<O, 7>(phase);
+}
+
+/**
+ * exp(): std::exp for the scalar variant; otherwise Cody-Waite reduction to
+ * [-ln2/2, ln2/2] and the Cephes expf polynomial, within 2 ulp of std::exp.
+ */
+template <typename O>
+inline typename O::V exponential(typename O::V x) noexcept
+{
+    if constexpr (O::width == 1)
+    {
+        return std::exp(x);
+    }
+    else
+    {
+        x = O::min(O::max(x, O::set1(-87.3f)), O::set1(88.7f));
+
+        const auto n = O::floor(O::mulAdd(x, O::set1(1.44269504088896341f), O::set1(0.5f)));
+        x = O::sub(x, O::mul(n, O::set1(0.693359375f)));
+        x = O::add(x, O::mul(n, O::set1(2.12194440e-4f)));
+
+        auto p = O::set1(1.9875691500e-4f);
+        p = O::mulAdd(p, x, O::set1(1.3981999507e-3f));
+        p = O::mulAdd(p, x, O::set1(8.3334519073e-3f));
+        p = O::mulAdd(p, x, O::set1(4.1665795894e-2f));
+        p = O::mulAdd(p, x, O::set1(1.6666665459e-1f));
+        p = O::mulAdd(p, x, O::set1(5.0000001201e-1f));
+        p = O::mulAdd(p, O::mul(x, x), O::add(x, O::set1(1.0f)));
+
+        return O::mul(p, O::pow2(O::truncate(n)));
+    }
+}
+
+//==============================================================================
+/**
+ * One vector of partials: sum amplitude * sine into left (and, for Stereo,
+ * through the per-partial gains into left and right), then advance the phases.
+ */
+template <typename O, SineKernel Kernel, bool Ramped, bool Stereo>
+inline void partialStep(const StereoPartials& p, int i, typename O::V& left, typename O::V& right) noexcept
+{
+    const auto twoPi = O::set1(SineLUT::kTwoPi);
+    const auto phase = O::load(p.phases + i);
+
+    auto amplitude = O::load(p.amplitudes + i);
+    if constexpr (Ramped)
+        amplitude = O::mulAdd(O::load(p.amplitudeSteps + i), O::set1(p.rampPosition), amplitude);
+
+    const auto value = sine<O, Kernel>(O::add(phase, O::load(p.phaseOffsets + i)));
+
+    if constexpr (Stereo)
+    {
+        const auto term = O::mul(amplitude, value);
+        left = O::mulAdd(O::load(p.gainsLeft + i), term, left);
+        right = O::mulAdd(O::load(p.gainsRight + i), term, right);
+    }
+    else
+    {
+        left = O::mulAdd(amplitude, value, left);
+    }
+
+    const auto next = O::mulAdd(O::load(p.increments + i), O::set1(p.incrementScale), phase);
+    O::store(p.phases + i, O::select(O::greaterEqual(next, twoPi), O::sub(next, twoPi), next));
+}
+
+template <SineKernel Kernel, bool Ramped, bool Stereo>
+inline StereoSum accumulate(const StereoPartials& partials, int count) noexcept
+{
+    int i = 0;
+    StereoSum total;
+
+    if constexpr (Ops::width > 1 && Kernel != SineKernel::exact)
+    {
+        auto left = Ops::set1(0.0f), right = Ops::set1(0.0f);
+        for (; i + Ops::width <= count; i += Ops::width)
+            partialStep<Ops, Kernel, Ramped, Stereo>(partials, i, left, right);
+
+        total.left = Ops::sum(left);
+        if constexpr (Stereo)
+            total.right = Ops::sum(right);
+    }
+
+    for (; i < count; ++i)
+        partialStep<ScalarOps, Kernel, Ramped, Stereo>(partials, i, total.left, total.right);
+
+    return total;
+}
+
+template <SineKernel Kernel>
+inline float accumulatePartials(float* phases, const float* increments, float incrementScale,
+                                const float* amplitudes, const float* phaseOffsets, int count) noexcept
+{
+    return accumulate<Kernel, false, false>({ phases, increments, incrementScale, amplitudes, nullptr, 0.0f,
+                                              phaseOffsets, nullptr, nullptr }, count).left;
+}
+
+template <SineKernel Kernel>
+inline float accumulatePartialsRamped(float* phases, const float* increments, float incrementScale,
+                                      const float* amplitudes, const float* amplitudeSteps, float rampPosition,
+                                      const float* phaseOffsets, int count) noexcept
+{
+    return accumulate<Kernel, true, false>({ phases, increments, incrementScale, amplitudes, amplitudeSteps,
+                                             rampPosition, phaseOffsets, nullptr, nullptr }, count).left;
+}
+
+template <SineKernel Kernel>
+inline StereoSum accumulatePartialsStereo(const StereoPartials& partials, int count) noexcept
+{
+    return partials.amplitudeSteps != nullptr ? accumulate<Kernel, true, true>(partials, count)
+                                              : accumulate<Kernel, false, true>(partials, count);
+}
+
+//==============================================================================
+template <typename O>
+inline void shapeSpectrumStep(float* amplitudes, int i, float cutoff, float boostLinear) noexcept
+{
+    constexpr float smoothness = 2.0f;
+    constexpr float bellWidth = 3.0f;
+
+    const auto n = O::add(O::load(kLaneIndices), O::set1(static_cast<float>(i + 1)));
+    const auto dist = O::sub(n, O::set1(cutoff));
+
+    // Cutoff: sigmoid low-pass
+    const auto one = O::set1(1.0f);
+    const auto sigmoidGain = O::div(one, O::add(one, exponential<O>(O::div(dist, O::set1(smoothness)))));
+
+    // Boost: bell curve at cutoff
+    const auto bell = exponential<O>(O::div(O::mul(O::set1(-0.5f), O::mul(dist, dist)),
+                                            O::set1(bellWidth * bellWidth)));
+    const auto bellGain = O::add(one, O::mul(O::set1(boostLinear - 1.0f), bell));
+
+    O::store(amplitudes + i, O::mul(O::load(amplitudes + i), O::mul(sigmoidGain, bellGain)));
+}
+
+inline void shapeSpectrum(float* amplitudes, int count, float cutoff, float boostLinear) noexcept
+{
+    int i = 0;
+
+    if constexpr (Ops::width > 1)
+        for (; i + Ops::width <= count; i += Ops::width)
+            shapeSpectrumStep<Ops>(amplitudes, i, cutoff, boostLinear);
+
+    for (; i < count; ++i)
+        shapeSpectrumStep<ScalarOps>(amplitudes, i, cutoff, boostLinear);
+}
+
+//==============================================================================
+template <typename O>
+inline void morphStep(float* amplitudes, float* phases, const float* targetAmplitudes,
+                      const float* targetPhases, int i, float amount) noexcept
+{
+    const auto t = O::set1(amount);
+
+    const auto amplitude = O::load(amplitudes + i);
+    O::store(amplitudes + i, O::mulAdd(t, O::sub(O::load(targetAmplitudes + i), amplitude), amplitude));
+
+    const auto phase = O::load(phases + i);
+    const auto difference = O::sub(O::load(targetPhases + i), phase);
+    const auto turns = O::floor(O::mulAdd(difference, O::set1(1.0f / SineLUT::kTwoPi), O::set1(0.5f)));
+    const auto wrapped = O::sub(difference, O::mul(turns, O::set1(SineLUT::kTwoPi)));
+    O::store(phases + i, O::mulAdd(t, wrapped, phase));
+}
+
+inline void morphSpectrum(float* amplitudes, float* phases, const float* targetAmplitudes,
+                          const float* targetPhases, float amount, int count) noexcept
+{
+    int i = 0;
+
+    if constexpr (Ops::width > 1)
+        for (; i + Ops::width <= count; i += Ops::width)
+            morphStep<Ops>(amplitudes, phases, targetAmplitudes, targetPhases, i, amount);
+
+    for (; i < count; ++i)
+        morphStep<ScalarOps>(amplitudes, phases, targetAmplitudes, targetPhases, i, amount);
+}
+
+//==============================================================================
+template <typename O>
+inline void envelopeStep(float* levels, const float* delays, const float* decayRates, int i,
+                         float time, float attackTime, float attackRate, float sustain) noexcept
+{
+    const auto elapsed = O::sub(O::set1(time), O::load(delays + i));
+
+    // The attack line is below the decay line until attackTime and above it after,
+    // so the envelope is simply the lower of the two, floored at sustain and zero
+    const auto attack = O::mul(elapsed, O::set1(attackRate));
+    const auto decay = O::sub(O::set1(1.0f), O::mul(O::sub(elapsed, O::set1(attackTime)), O::load(decayRates + i)));
+
+    O::store(levels + i, O::max(O::set1(0.0f), O::min(attack, O::max(decay, O::set1(sustain)))));
+}
+
+inline void evaluateEnvelopes(float* levels, const float* delays, const float* decayRates, int count,
+                              float time, float attackTime, float attackRate, float sustain) noexcept
+{
+    int i = 0;
+
+    if constexpr (Ops::width > 1)
+        for (; i + Ops::width <= count; i += Ops::width)
+            envelopeStep<Ops>(levels, delays, decayRates, i, time, attackTime, attackRate, sustain);
+
+    for (; i < count; ++i)
+        envelopeStep<ScalarOps>(levels, delays, decayRates, i, time, attackTime, attackRate, sustain);
+}
+
+//==============================================================================
+inline void sineBatch(const float* phases, float* output, int count) noexcept
+{
+    int i = 0;
+
+    if constexpr (Ops::width > 1)
+        for (; i + Ops::width <= count; i += Ops::width)
+            Ops::store(output + i, tableSine<Ops>(Ops::load(phases + i)));
+
+    for (; i < count; ++i)
+        output[i] = SineLUT::lookup(phases[i]);
+}
+
+//==============================================================================
+template <typename O>
+inline void delayTapStep(const float* history, float position, float advance, float gainLeft, float gainRight,
+                         float* left, float* right, int i) noexcept
+{
+    const auto n = O::add(O::load(kLaneIndices), O::set1(static_cast<float>(i)));
+    const auto at = O::mulAdd(n, O::set1(advance), O::set1(position));
+
+    // Positions are non-negative, so truncation is floor
+    const auto whole = O::truncate(at);
+    const auto fraction = O::sub(at, O::toFloat(whole));
+    const auto a = O::gather(history, whole);
+    const auto b = O::gather(history + 1, whole);
+    const auto sample = O::mulAdd(fraction, O::sub(b, a), a);
+
+    O::store(left + i, O::mulAdd(sample, O::set1(gainLeft), O::load(left + i)));
+    O::store(right + i, O::mulAdd(sample, O::set1(gainRight), O::load(right + i)));
+}
+
+inline void accumulateDelayTap(const float* history, float position, float advance, float gainLeft,
+                               float gainRight, float* left, float* right, int count) noexcept
+{
+    int i = 0;
+
+    if constexpr (Ops::width > 1)
+        for (; i + Ops::width <= count; i += Ops::width)
+            delayTapStep<Ops>(history, position, advance, gainLeft, gainRight, left, right, i);
+
+    for (; i < count; ++i)
+        delayTapStep<ScalarOps>(history, position, advance, gainLeft, gainRight, left, right, i);
+}
+
+//==============================================================================
+inline constexpr RenderKernels kernels{
+    kLevel,
+    { &accumulatePartials<SineKernel::table>,   // indexed by SineKernel
+      &accumulatePartials<SineKernel::poly3>,
+      &accumulatePartials<SineKernel::poly5>,
+      &accumulatePartials<SineKernel::poly7>,
+      &accumulatePartials<SineKernel::exact> },
+    { &accumulatePartialsRamped<SineKernel::table>,
+      &accumulatePartialsRamped<SineKernel::poly3>,
+      &accumulatePartialsRamped<SineKernel::poly5>,
+      &accumulatePartialsRamped<SineKernel::poly7>,
+      &accumulatePartialsRamped<SineKernel::exact> },
+    { &accumulatePartialsStereo<SineKernel::table>,
+      &accumulatePartialsStereo<SineKernel::poly3>,
+      &accumulatePartialsStereo<SineKernel::poly5>,
+      &accumulatePartialsStereo<SineKernel::poly7>,
+      &accumulatePartialsStereo<SineKernel::exact> },
+    &evaluateEnvelopes,
+    &shapeSpectrum,
+    &morphSpectrum,
+    &sineBatch,
+    &accumulateDelayTap
+};
@@ -0,0 +1,274 @@
+/*
+  ==============================================================================
+    ResidualNoise.h - Shared stochastic residual, synthesised by inverse FFT
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace synth
+{
+
+/**
+ * The noise half of a sines-plus-noise model: breath, bow and air that a
+ * partial bank can't make, as filtered noise mixed under every voice.
+ *
+ * The noise spectrum is a smooth curve: a tilt in dB per octave around
+ * each voice's note, optionally times a spectral envelope (the imported
+ * waveform's). A tilt is a power law, so a voice's curve factors into a
+ * per-voice scalar (its level, and its note to the power of the tilt) and
+ * one curve over frequency shared by all voices. Voices therefore only add
+ * a number each to a shared sum; the engine then synthesises the whole
+ * layer once per block:
+ *   - per hop (a quarter frame, ~2.7 ms), one frame of random-phase bins
+ *     shaped by the shared curve and the summed voice level;
+ *   - one inverse real FFT, a Hann window, overlap-add (4x overlap, whose
+ *     squared-window sum is constant, so the noise is stationary).
+ * The cost is one ~512-point IFFT per hop whatever the number of voices.
+ *
+ * The layer is mono, added equally to every output channel. A block's
+ * spectrum is fixed for the frames it finishes; levels follow the voices
+ * at block rate, with up to a hop of latency.
+ */
+class ResidualNoise
+{
+public:
+    /** Frame length (512 samples at 48 kHz, scaled to the sample rate). */
+    static constexpr double kFrameSeconds = 512.0 / 48000.0;
+    static constexpr int kOverlap = 4;
+
+    /** Frequency the shared curve's tilt pivots on (each voice's own pivot is its note). */
+    static constexpr double kReferenceHz = 1000.0;
+
+    /** Most spectral envelope bands beginBlock takes; more are ignored. */
+    static constexpr int kMaxEnvelopeBands = 1024;
+
+    /** Message thread: size the FFT and buffers for a sample rate and block size. */
+    void prepare(double sampleRate, int maximumBlockSize)
+    {
+        fftOrder = juce::jlimit(8, 12, juce::roundToInt(std::log2(sampleRate * kFrameSeconds)));
+        fftSize = 1 << fftOrder;
+        hop = fftSize / kOverlap;
+        numBins = fftSize / 2 + 1;
+        binHz = sampleRate / fftSize;
+        nyquistHz = sampleRate * 0.5;
+
+        fft = std::make_unique<juce::dsp::FFT>(fftOrder);
+        frame.assign(static_cast<size_t>(2 * fftSize), 0.0f);
+        overlap.assign(static_cast<size_t>(fftSize), 0.0f);
+        ready.assign(static_cast<size_t>(maximumBlockSize + hop), 0.0f);
+        curve.assign(static_cast<size_t>(numBins), 0.0f);
+        curveEnvelopeCopy.assign(static_cast<size_t>(kMaxEnvelopeBands), 0.0f);
+
+        // Periodic Hann: shifted copies kOverlap apart sum (squared) to a constant
+        window.resize(static_cast<size_t>(fftSize));
+        for (int n = 0; n < fftSize; ++n)
+            window[static_cast<size_t>(n)] = static_cast<float>(
+                0.5 - 0.5 * std::cos(juce::MathConstants<double>::twoPi * n / fftSize));
+
+        // White noise of unit curve at full band has RMS 1: JUCE's inverse
+        // transform scales by 1/N, a frame's variance is then |m|^2 / N, and
+        // the overlapping squared windows add up to 3/8 * kOverlap
+        magnitudeScale = static_cast<float>(std::sqrt(fftSize / (0.375 * kOverlap)));
+
+        for (size_t i = 0; i < phaseTable.size(); ++i)
+        {
+            const double angle = juce::MathConstants<double>::twoPi * static_cast<double>(i) / phaseTable.size();
+            phaseTable[i] = { static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle)) };
+        }
+
+        curveTilt = std::nan("");
+        reset();
+    }
+
+    /**
+     * Silence everything in flight and restart the noise sequence and hop
+     * alignment, so the noise after a reset doesn't depend on what came before.
+     */
+    void reset() noexcept
+    {
+        std::fill(overlap.begin(), overlap.end(), 0.0f);
+        readyCount = 0;
+        randomState = kSeed;
+        voicePower = 0.0;
+        silentFrames = kOverlap;
+    }
+
+    //==========================================================================
+    // Audio thread
+
+    /**
+     * Start a block of numSamples: set the shared curve's tilt and spectral
+     * envelope (numBands bands spread evenly over 0..Nyquist, or nullptr for
+     * flat), and clear the voice sum.
+     */
+    void beginBlock(int numSamples, float tiltDbPerOctave, const float* envelope, int numBands) noexcept
+    {
+        blockSamples = juce::jmax(1, numSamples);
+        voicePower = 0.0;
+        numBands = envelope != nullptr ? juce::jlimit(0, kMaxEnvelopeBands, numBands) : 0;
+
+        if (fft != nullptr
+            && (tiltDbPerOctave != curveTilt || envelope != curveEnvelope || numBands != curveBands
+                || (envelope != nullptr && !std::equal(envelope, envelope + numBands, curveEnvelopeCopy.begin()))))
+            updateCurve(tiltDbPerOctave, envelope, numBands);
+    }
+
+    /**
+     * Add a voice for numSamples of the block: noise at `amplitude` (RMS of
+     * a flat unit curve), its tilt pivoting on frequencyHz.
+     */
+    void addVoice(double amplitude, double frequencyHz, int numSamples) noexcept
+    {
+        if (amplitude <= 0.0 || frequencyHz <= 0.0)
+            return;
+
+        const double gain = amplitude * std::pow(frequencyHz / kReferenceHz, -tiltExponent);
+        voicePower += gain * gain * numSamples / blockSamples;
+    }
+
+    /** True while any voice added noise this block, or a tail is still fading out. */
+    bool isActive() const noexcept { return voicePower > 0.0 || silentFrames < kOverlap; }
+
+    /** Add the block's noise to every channel of `buffer`. */
+    template <typename SampleType>
+    void render(juce::AudioBuffer<SampleType>& buffer, int numSamples) noexcept
+    {
+        if (fft == nullptr || !isActive())
+            return;
+
+        // Blocks larger than prepared for are done in pieces ready can hold
+        const int capacity = static_cast<int>(ready.size()) - hop;
+
+        for (int start = 0; start < numSamples;)
+        {
+            const int count = juce::jmin(numSamples - start, capacity);
+
+            while (readyCount < count)
+                synthesiseFrame();
+
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            {
+                auto* out = buffer.getWritePointer(channel, start);
+                for (int i = 0; i < count; ++i)
+                    out[i] += static_cast<SampleType>(ready[static_cast<size_t>(i)]);
+            }
+
+            readyCount -= count;
+            std::memmove(ready.data(), ready.data() + count, sizeof(float) * static_cast<size_t>(readyCount));
+            start += count;
+        }
+    }
+
+private:
+    int fftOrder = 0, fftSize = 0, hop = 0, numBins = 0;
+    double binHz = 0.0, nyquistHz = 0.0;
+    float magnitudeScale = 1.0f;
+
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::vector<float> frame;    // 2 * fftSize: interleaved bins in, samples out
+    std::vector<float> overlap;  // fftSize: overlap-add accumulator
+    std::vector<float> ready;    // finished samples not yet output
+    std::vector<float> window;
+    int readyCount = 0;
+
+    // Shared curve (amplitude per bin) and what it was built from
+    std::vector<float> curve;
+    double curveTilt = 0.0;
+    double tiltExponent = 0.0;   // tilt as a power of frequency
+    const float* curveEnvelope = nullptr;
+    int curveBands = 0;
+    std::vector<float> curveEnvelopeCopy;  // kMaxEnvelopeBands
+
+    double voicePower = 0.0;
+    int blockSamples = 1;
+    int silentFrames = kOverlap; // consecutive silent frames; kOverlap means the tail has died out
+
+    std::array<std::pair<float, float>, 1024> phaseTable{};
+    static constexpr juce::uint32 kSeed = 0x9e3779b9u;
+    juce::uint32 randomState = kSeed;
+
+    void updateCurve(float tiltDbPerOctave, const float* envelope, int numBands) noexcept
+    {
+        curveTilt = tiltDbPerOctave;
+        tiltExponent = tiltDbPerOctave / (20.0 * std::log10(2.0));
+        curveEnvelope = envelope;
+        curveBands = numBands;
+
+        if (envelope != nullptr)
+            std::copy(envelope, envelope + numBands, curveEnvelopeCopy.begin());
+
+        curve[0] = 0.0f; // no DC
+
+        for (int k = 1; k < numBins; ++k)
+        {
+            const double frequency = k * binHz;
+            double gain = std::pow(frequency / kReferenceHz, tiltExponent);
+
+            if (envelope != nullptr && numBands > 0)
+            {
+                const double band = juce::jlimit(0.0, numBands - 1.0, frequency / nyquistHz * numBands - 0.5);
+                const int lower = static_cast<int>(band);
+                const int upper = juce::jmin(lower + 1, numBands - 1);
+                const double fraction = band - lower;
+                gain *= envelope[lower] + fraction * (envelope[upper] - envelope[lower]);
+            }
+
+            curve[static_cast<size_t>(k)] = static_cast<float>(gain);
+        }
+    }
+
+    juce::uint32 nextRandom() noexcept
+    {
+        randomState ^= randomState << 13;
+        randomState ^= randomState >> 17;
+        randomState ^= randomState << 5;
+        return randomState;
+    }
+
+    /** Overlap-add one frame and move the next hop of finished samples to `ready`. */
+    void synthesiseFrame() noexcept
+    {
+        const float level = static_cast<float>(std::sqrt(voicePower)) * magnitudeScale;
+
+        if (level > 0.0f)
+        {
+            for (int k = 0; k < numBins; ++k)
+            {
+                const auto& rotation = phaseTable[nextRandom() >> 22];
+                const float magnitude = level * curve[static_cast<size_t>(k)];
+                frame[static_cast<size_t>(2 * k)] = magnitude * rotation.first;
+                frame[static_cast<size_t>(2 * k + 1)] = magnitude * rotation.second;
+            }
+
+            frame[1] = 0.0f;                                     // DC and Nyquist are real
+            frame[static_cast<size_t>(2 * (numBins - 1) + 1)] = 0.0f;
+
+            fft->performRealOnlyInverseTransform(frame.data());
+
+            for (int n = 0; n < fftSize; ++n)
+                overlap[static_cast<size_t>(n)] += frame[static_cast<size_t>(n)] * window[static_cast<size_t>(n)];
+
+            silentFrames = 0;
+        }
+        else
+        {
+            silentFrames = juce::jmin(silentFrames + 1, kOverlap);
+        }
+
+        std::copy(overlap.begin(), overlap.begin() + hop, ready.begin() + readyCount);
+        readyCount += hop;
+
+        std::memmove(overlap.data(), overlap.data() + hop, sizeof(float) * static_cast<size_t>(fftSize - hop));
+        std::fill(overlap.end() - hop, overlap.end(), 0.0f);
+    }
+};
+
+} // namespace synth
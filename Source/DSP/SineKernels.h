@@ -0,0 +1,160 @@
+/*
+  ==============================================================================
+    SineKernels.h - Selectable-accuracy sine kernels (table, minimax polynomials, exact)
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "SineLUT.h"
+#include <cmath>
+#include <type_traits>
+
+namespace synth
+{
+
+/**
+ * How the voice evaluates sin() of each partial. Chosen separately for the
+ * real-time and offline render paths (see BasicVoiceParams).
+ *
+ * Worst-case error against std::sin, in dB relative to full scale, with
+ * double phases (float phases bottom out around -110 dB):
+ *   table  4096-point table, linear interpolation    ~ -130 dB
+ *   poly3  3rd-order minimax polynomial              ~  -47 dB
+ *   poly5  5th-order minimax polynomial              ~  -83 dB
+ *   poly7  7th-order minimax polynomial              ~ -125 dB
+ *   exact  std::sin
+ *
+ * The polynomials are pure arithmetic (no table gather), so they vectorize
+ * well; DSPBenchmarks measures speed and error for each option.
+ */
+enum class SineKernel
+{
+    table,
+    poly3,
+    poly5,
+    poly7,
+    exact
+};
+
+static constexpr int kNumSineKernels = 5;
+
+inline const char* getSineKernelName(SineKernel kernel) noexcept
+{
+    switch (kernel)
+    {
+        case SineKernel::table: return "table";
+        case SineKernel::poly3: return "poly3";
+        case SineKernel::poly5: return "poly5";
+        case SineKernel::poly7: return "poly7";
+        case SineKernel::exact: return "exact";
+    }
+
+    return "table";
+}
+
+/** Parse a kernel name as printed by getSineKernelName(); returns false if unknown. */
+inline bool parseSineKernel(const char* name, SineKernel& kernel) noexcept
+{
+    for (int i = 0; i < kNumSineKernels; ++i)
+    {
+        const auto candidate = static_cast<SineKernel>(i);
+        const char* expected = getSineKernelName(candidate);
+        int c = 0;
+        while (name[c] != 0 && name[c] == expected[c])
+            ++c;
+
+        if (name[c] == 0 && expected[c] == 0)
+        {
+            kernel = candidate;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+namespace detail
+{
+    /**
+     * Odd minimax coefficients for sin(2πx) on x ∈ [0, 0.25] (Remez exchange,
+     * equiripple absolute error): c1·x + c3·x³ + c5·x⁵ + …
+     */
+    template <int Order> struct SinePolynomial;
+
+    template <> struct SinePolynomial<3>
+    {
+        static constexpr double c[] = { 6.1922647445e+00, -3.5363706941e+01 };
+    };
+
+    template <> struct SinePolynomial<5>
+    {
+        static constexpr double c[] = { 6.2812800766e+00, -4.1095242689e+01, 7.3585514754e+01 };
+    };
+
+    template <> struct SinePolynomial<7>
+    {
+        static constexpr double c[] = { 6.2831640443e+00, -4.1337142371e+01, 8.1340768889e+01, -7.0993433283e+01 };
+    };
+
+    /**
+     * sin(phase) by range reduction to a quarter cycle and an odd polynomial.
+     * Branch-free: the fold is a floor, a compare-select and a copysign.
+     */
+    template <int Order, typename T>
+    inline T polynomialSine(T phase) noexcept
+    {
+        using Poly = SinePolynomial<Order>;
+        constexpr int numTerms = (Order + 1) / 2;
+        constexpr T invTwoPi = static_cast<T>(1.0 / 6.283185307179586);
+
+        // Cycles in [-0.5, 0.5), then mirror |x| > 0.25 around the quarter-cycle peak
+        T x = phase * invTwoPi;
+        x -= std::floor(x + T(0.5));
+        const T folded = std::copysign(T(0.5), x) - x;
+        x = std::abs(x) > T(0.25) ? folded : x;
+
+        const T x2 = x * x;
+        T sum = static_cast<T>(Poly::c[numTerms - 1]);
+        for (int k = numTerms - 2; k >= 0; --k)
+            sum = sum * x2 + static_cast<T>(Poly::c[k]);
+
+        return sum * x;
+    }
+} // namespace detail
+
+/** sin(phase) (radians, any range) evaluated with the given kernel. */
+template <SineKernel Kernel, typename T>
+inline T evaluateSine(T phase) noexcept
+{
+    if constexpr (Kernel == SineKernel::table)
+        return SineLUT::lookup(phase);
+    else if constexpr (Kernel == SineKernel::poly3)
+        return detail::polynomialSine<3>(phase);
+    else if constexpr (Kernel == SineKernel::poly5)
+        return detail::polynomialSine<5>(phase);
+    else if constexpr (Kernel == SineKernel::poly7)
+        return detail::polynomialSine<7>(phase);
+    else
+        return std::sin(phase);
+}
+
+/**
+ * Call fn(std::integral_constant<SineKernel, K>{}) for the runtime kernel, so
+ * a render loop can be instantiated per kernel and dispatched once per block.
+ */
+template <typename Function>
+inline decltype(auto) dispatchSineKernel(SineKernel kernel, Function&& fn)
+{
+    switch (kernel)
+    {
+        case SineKernel::poly3: return fn(std::integral_constant<SineKernel, SineKernel::poly3>{});
+        case SineKernel::poly5: return fn(std::integral_constant<SineKernel, SineKernel::poly5>{});
+        case SineKernel::poly7: return fn(std::integral_constant<SineKernel, SineKernel::poly7>{});
+        case SineKernel::exact: return fn(std::integral_constant<SineKernel, SineKernel::exact>{});
+        case SineKernel::table:
+        default:                return fn(std::integral_constant<SineKernel, SineKernel::table>{});
+    }
+}
+
+} // namespace synth
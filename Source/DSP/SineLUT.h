@@ -12,24 +12,74 @@
 namespace synth
 {
 
+namespace detail
+{
+    /** sin and cos of a small angle by Taylor series, usable in constant expressions. */
+    constexpr double constexprSin(double x)
+    {
+        double term = x, sum = x;
+        for (int k = 1; k < 12; ++k)
+        {
+            term *= -x * x / static_cast<double>((2 * k) * (2 * k + 1));
+            sum += term;
+        }
+        return sum;
+    }
+
+    constexpr double constexprCos(double x)
+    {
+        double term = 1.0, sum = 1.0;
+        for (int k = 1; k < 12; ++k)
+        {
+            term *= -x * x / static_cast<double>((2 * k - 1) * (2 * k));
+            sum += term;
+        }
+        return sum;
+    }
+
+    /**
+     * One full cycle plus the interpolation guard point, generated at compile
+     * time by rotating a unit phasor in double precision (drift < 1e-12).
+     */
+    template <int Size>
+    constexpr std::array<float, Size + 1> makeSineTable()
+    {
+        constexpr double step = 6.283185307179586 / static_cast<double>(Size);
+        const double sinStep = constexprSin(step);
+        const double cosStep = constexprCos(step);
+
+        std::array<float, Size + 1> table{};
+        double s = 0.0, c = 1.0;
+
+        for (int i = 0; i <= Size; ++i)
+        {
+            table[static_cast<size_t>(i)] = static_cast<float>(s);
+            const double next = s * cosStep + c * sinStep;
+            c = c * cosStep - s * sinStep;
+            s = next;
+        }
+
+        return table;
+    }
+} // namespace detail
+
 /**
  * Static sine lookup table with linear interpolation.
- * 4096-point table for ~16-bit precision, much faster than std::sin().
+ * The table lives in read-only data, built by the compiler: no start-up cost
+ * and no function-local static guard on the render path.
+ * The default 4096-point table gives ~16-bit precision, much faster than std::sin().
  */
-class SineLUT
+template <int TableSize>
+class BasicSineTable
 {
 public:
-    static constexpr int kTableSize = 4096;
-    static constexpr float kTwoPi = 6.283185307179586f;
+    static_assert(TableSize > 0 && (TableSize & (TableSize - 1)) == 0, "Table size must be a power of two");
 
-    static SineLUT& getInstance()
-    {
-        static SineLUT instance;
-        return instance;
-    }
+    static constexpr int kTableSize = TableSize;
+    static constexpr float kTwoPi = 6.283185307179586f;
 
-    /** Look up sin(phase) where phase is in radians [0, 2π). */
-    [[nodiscard]] float lookup(float phase) const noexcept
+    /** Look up sin(phase) where phase is in radians (wrapped to [0, 2π)). */
+    [[nodiscard]] static float lookup(float phase) noexcept
     {
         // Normalize phase to [0, 1)
         float normalized = phase * kInvTwoPi;
@@ -43,8 +93,36 @@ public:
         return table[idx0 & kTableMask] + frac * (table[idx1] - table[idx0 & kTableMask]);
     }
 
-    /** Batch compute: output[i] = sin(phases[i]) */
-    void lookupBatch(const float* phases, float* output, int count) const noexcept
+    /**
+     * Double-precision lookup for the 64-bit render path: the phase is wrapped
+     * and interpolated in double, so large phases don't lose resolution.
+     */
+    [[nodiscard]] static double lookup(double phase) noexcept
+    {
+        double normalized = phase * kInvTwoPiDouble;
+        normalized -= std::floor(normalized); // wrap to [0, 1)
+
+        const double index = normalized * static_cast<double>(kTableSize);
+        const int idx0 = static_cast<int>(index) & kTableMask;
+        const double frac = index - std::floor(index);
+
+        return table[idx0] + frac * (static_cast<double>(table[idx0 + 1]) - table[idx0]);
+    }
+
+    /** Nearest-entry lookup without interpolation (for accuracy comparisons). */
+    [[nodiscard]] static float lookupNearest(float phase) noexcept
+    {
+        float normalized = phase * kInvTwoPi;
+        normalized -= std::floor(normalized);
+
+        return table[static_cast<int>(normalized * static_cast<float>(kTableSize) + 0.5f) & kTableMask];
+    }
+
+    /** The kTableSize + 1 entries (last = first), for the vectorized lookups in RenderKernels. */
+    [[nodiscard]] static constexpr const float* data() noexcept { return table.data(); }
+
+    /** Batch compute: output[i] = sin(phases[i]); see RenderKernels::sineBatch for the SIMD version. */
+    static void lookupBatch(const float* phases, float* output, int count) noexcept
     {
         for (int i = 0; i < count; ++i)
             output[i] = lookup(phases[i]);
@@ -53,17 +131,11 @@ public:
 private:
     static constexpr int kTableMask = kTableSize - 1;
     static constexpr float kInvTwoPi = 1.0f / kTwoPi;
+    static constexpr double kInvTwoPiDouble = 1.0 / 6.283185307179586;
 
-    std::array<float, kTableSize + 1> table{}; // +1 for interpolation guard
-
-    SineLUT()
-    {
-        for (int i = 0; i <= kTableSize; ++i)
-            table[i] = std::sin(static_cast<float>(i) / static_cast<float>(kTableSize) * kTwoPi);
-    }
-
-    SineLUT(const SineLUT&) = delete;
-    SineLUT& operator=(const SineLUT&) = delete;
+    static constexpr std::array<float, kTableSize + 1> table = detail::makeSineTable<kTableSize>(); // +1 for interpolation guard
 };
 
+using SineLUT = BasicSineTable<4096>;
+
 } // namespace synth
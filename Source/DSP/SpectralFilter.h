@@ -7,6 +7,8 @@
 #pragma once
 
 #include "HarmonicSeries.h"
+#include "PartialRatios.h"
+#include "RenderKernels.h"
 #include <cmath>
 #include <algorithm>
 
@@ -18,7 +20,8 @@ namespace synth
  *   - Cutoff: sigmoid low-pass in harmonic domain
  *   - Boost:  resonant peak near cutoff
  *   - Phase:  per-harmonic phase rotation
- *   - Stretch: harmonic frequency remapping f_n = n^stretch * f0
+ *   - Partials a PartialRatios table puts at or above Nyquist are dropped
+ *     (stretch and inharmonic tunings live in the table)
  */
 class SpectralFilter
 {
@@ -27,68 +30,48 @@ public:
      * Apply spectral filter in-place on HarmonicData.
      *
      * @param data        HarmonicData to modify
-     * @param cutoff      Cutoff harmonic number (1..256)
+     * @param cutoff      Cutoff harmonic number (1..NumHarmonics)
      * @param boostDb     Boost amount at cutoff in dB (0..24)
      * @param phaseRot    Phase rotation amount in radians
-     * @param stretch     Harmonic stretch factor (0.5..2.0, 1.0 = normal)
+     * @param ratios      Frequency ratio of each partial to the fundamental
      * @param noteFreqHz  Fundamental frequency
      * @param sampleRate  Current sample rate
+     * @param kernels     ISA variant for the amplitude shaping (see RenderKernels)
      */
-    static void apply(HarmonicData& data, float cutoff, float boostDb,
-                      float phaseRot, float stretch,
-                      float noteFreqHz, double sampleRate)
+    template <int NumHarmonics>
+    static void apply(BasicHarmonicData<NumHarmonics>& data, float cutoff, float boostDb,
+                      float phaseRot, const BasicPartialRatios<NumHarmonics>& ratios,
+                      float noteFreqHz, double sampleRate,
+                      const RenderKernels& kernels = getActiveRenderKernels())
     {
-        const float nyquist = static_cast<float>(sampleRate) * 0.5f;
         const float boostLinear = std::pow(10.0f, boostDb / 20.0f);
-        constexpr float smoothness = 2.0f; // sigmoid smoothness factor
-        int newActive = 0;
 
-        for (int n = 1; n <= data.activeCount; ++n)
-        {
-            const int idx = n - 1;
-
-            // --- Stretch: remap harmonic frequency ---
-            const float stretchedN = std::pow(static_cast<float>(n), stretch);
-            const float stretchedFreq = noteFreqHz * stretchedN;
-
-            // Nyquist cutoff for stretched harmonics
-            if (stretchedFreq >= nyquist)
-            {
-                data.amplitudes[idx] = 0.0f;
-                continue;
-            }
-
-            // --- Cutoff: sigmoid low-pass ---
-            const float x = (static_cast<float>(n) - cutoff) / smoothness;
-            const float sigmoidGain = 1.0f / (1.0f + std::exp(x));
+        // Ratios ascend, so the partials below Nyquist are a prefix
+        const int newActive = juce::jmin(data.activeCount, ratios.countBelow(sampleRate * 0.5 / noteFreqHz));
 
-            // --- Boost: bell curve at cutoff ---
-            const float dist = static_cast<float>(n) - cutoff;
-            constexpr float bellWidth = 3.0f;
-            const float bellGain = 1.0f + (boostLinear - 1.0f)
-                                   * std::exp(-0.5f * (dist * dist) / (bellWidth * bellWidth));
+        for (int n = newActive; n < data.activeCount; ++n)
+            data.amplitudes[n] = 0.0f;
 
-            // Apply amplitude modifications
-            data.amplitudes[idx] *= sigmoidGain * bellGain;
-
-            // --- Phase rotation ---
-            data.phases[idx] += phaseRot * static_cast<float>(n);
-
-            newActive = n;
-        }
+        // --- Phase rotation ---
+        for (int n = 1; n <= newActive; ++n)
+            data.phases[n - 1] += phaseRot * static_cast<float>(n);
 
         data.activeCount = newActive;
+
+        // --- Cutoff (sigmoid low-pass) and boost (bell at cutoff), vectorized ---
+        kernels.shapeSpectrum(data.amplitudes.data(), newActive, cutoff, boostLinear);
     }
 
     /**
      * Apply imported waveform spectral envelope as a multiplicative filter.
      *
      * @param data             HarmonicData to modify
-     * @param spectralEnvelope Normalized spectral envelope (256 floats, 0..1)
+     * @param spectralEnvelope Normalized spectral envelope (one value per harmonic, 0..1)
      * @param mix              Dry/Wet mix (0 = dry/bypass, 1 = full wet)
      */
-    static void applyWaveformFilter(HarmonicData& data,
-                                     const std::array<float, kMaxHarmonics>& spectralEnvelope,
+    template <int NumHarmonics>
+    static void applyWaveformFilter(BasicHarmonicData<NumHarmonics>& data,
+                                     const typename BasicHarmonicData<NumHarmonics>::Spectrum& spectralEnvelope,
                                      float mix)
     {
         if (mix <= 0.0f)
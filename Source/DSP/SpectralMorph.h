@@ -0,0 +1,215 @@
+/*
+  ==============================================================================
+    SpectralMorph.h - Stored spectra (slots A-D) and the morph between them
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "HarmonicSeries.h"
+#include "RenderKernels.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace synth
+{
+
+/**
+ * Up to four stored spectra and the morph through them.
+ *
+ * The morph position sweeps the filled slots in order (A, B, C, D, skipping
+ * empty ones): with two filled slots 0 is the first and 1 the second, with
+ * four each third of the range crosses one pair. The morph amount then blends
+ * the voice's own spectrum towards that point, so amount 0 leaves the voice
+ * untouched and amount 1 plays the stored spectrum outright.
+ *
+ * Both steps are one RenderKernels::morphSpectrum pass over the partials
+ * below Nyquist, evaluated at control rate in the voice's spectral pipeline:
+ * a morph costs a couple of vector lerps per rebuild instead of a second
+ * synth to crossfade with.
+ *
+ * A slot holds amplitudes and phase offsets per partial index, in the same
+ * form as HarmonicData; the tuning still decides where the partials sit.
+ */
+template <int NumPartials>
+class BasicMorphSlots
+{
+public:
+    static constexpr int kNumSlots = 4;
+
+    using Spectrum = BasicHarmonicData<NumPartials>;
+
+    /** Store a spectrum (its first activeCount partials; the rest are silent). */
+    void setSlot(int slot, const Spectrum& spectrum) noexcept
+    {
+        auto& stored = slots[static_cast<size_t>(slot)];
+        stored = {};
+
+        for (int n = 0; n < spectrum.activeCount; ++n)
+        {
+            stored.amplitudes[static_cast<size_t>(n)] = spectrum.amplitudes[static_cast<size_t>(n)];
+            stored.phases[static_cast<size_t>(n)] = spectrum.phases[static_cast<size_t>(n)];
+        }
+
+        stored.activeCount = spectrum.activeCount;
+        filled[static_cast<size_t>(slot)] = true;
+    }
+
+    void clearSlot(int slot) noexcept
+    {
+        slots[static_cast<size_t>(slot)] = {};
+        filled[static_cast<size_t>(slot)] = false;
+    }
+
+    bool isFilled(int slot) const noexcept { return filled[static_cast<size_t>(slot)]; }
+    const Spectrum& getSlot(int slot) const noexcept { return slots[static_cast<size_t>(slot)]; }
+
+    int getNumFilled() const noexcept
+    {
+        return static_cast<int>(std::count(filled.begin(), filled.end(), true));
+    }
+
+    /**
+     * Morph `data` (its first activeCount partials) towards the filled slots.
+     * `scratch` holds the point between two slots when the position falls
+     * between them; it belongs to the caller so the slots stay shareable.
+     */
+    void apply(Spectrum& data, float position, float amount, Spectrum& scratch,
+               const RenderKernels& kernels) const noexcept
+    {
+        std::array<int, kNumSlots> order{};
+        int numFilled = 0;
+
+        for (int slot = 0; slot < kNumSlots; ++slot)
+            if (filled[static_cast<size_t>(slot)])
+                order[static_cast<size_t>(numFilled++)] = slot;
+
+        if (numFilled == 0 || amount <= 0.0f)
+            return;
+
+        const int count = data.activeCount;
+        const float scaled = juce::jlimit(0.0f, 1.0f, position) * static_cast<float>(numFilled - 1);
+        const int lower = juce::jmin(static_cast<int>(scaled), juce::jmax(0, numFilled - 2));
+        const float fraction = scaled - static_cast<float>(lower);
+
+        const Spectrum* target = &slots[static_cast<size_t>(order[static_cast<size_t>(lower)])];
+
+        if (numFilled > 1 && fraction > 0.0f)
+        {
+            const auto& upper = slots[static_cast<size_t>(order[static_cast<size_t>(lower + 1)])];
+
+            std::copy(target->amplitudes.begin(), target->amplitudes.begin() + count, scratch.amplitudes.begin());
+            std::copy(target->phases.begin(), target->phases.begin() + count, scratch.phases.begin());
+            kernels.morphSpectrum(scratch.amplitudes.data(), scratch.phases.data(),
+                                  upper.amplitudes.data(), upper.phases.data(), fraction, count);
+            target = &scratch;
+        }
+
+        kernels.morphSpectrum(data.amplitudes.data(), data.phases.data(),
+                              target->amplitudes.data(), target->phases.data(), juce::jmin(amount, 1.0f), count);
+    }
+
+    /**
+     * Spectrum of one period of a waveform (numSamples samples, e.g. a
+     * single-cycle wavetable), by direct DFT: partial n gets amplitude and
+     * phase offset such that the period is sum a_n sin(n theta + phi_n).
+     */
+    static Spectrum analyseCycle(const float* samples, int numSamples)
+    {
+        Spectrum spectrum;
+        const int numPartials = juce::jmin(NumPartials, numSamples / 2);
+        const double step = juce::MathConstants<double>::twoPi / numSamples;
+
+        for (int n = 1; n <= numPartials; ++n)
+        {
+            // e^{-i n theta_j}, advanced by rotation
+            const double rotateRe = std::cos(n * step), rotateIm = -std::sin(n * step);
+            double re = 1.0, im = 0.0, sumRe = 0.0, sumIm = 0.0;
+
+            for (int j = 0; j < numSamples; ++j)
+            {
+                sumRe += samples[j] * re;
+                sumIm += samples[j] * im;
+
+                const double nextRe = re * rotateRe - im * rotateIm;
+                im = re * rotateIm + im * rotateRe;
+                re = nextRe;
+            }
+
+            // a sin(n theta + phi) puts (a N / 2) e^{i (phi - pi/2)} in bin n
+            spectrum.amplitudes[static_cast<size_t>(n - 1)] = static_cast<float>(2.0 * std::hypot(sumRe, sumIm) / numSamples);
+            spectrum.phases[static_cast<size_t>(n - 1)] = static_cast<float>(std::atan2(sumIm, sumRe)
+                                                                             + juce::MathConstants<double>::halfPi);
+        }
+
+        spectrum.activeCount = numPartials;
+        return spectrum;
+    }
+
+    /**
+     * Read an audio file as one period (first channel, whole file, at most
+     * kMaxCycleSamples) and analyse it. Message thread.
+     */
+    static bool loadCycleFile(const juce::File& file, Spectrum& spectrum)
+    {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+        if (reader == nullptr || reader->lengthInSamples < 2)
+            return false;
+
+        const int numSamples = static_cast<int>(juce::jmin<juce::int64>(reader->lengthInSamples, kMaxCycleSamples));
+        juce::AudioBuffer<float> buffer(1, numSamples);
+        reader->read(&buffer, 0, numSamples, 0, true, false);
+
+        spectrum = analyseCycle(buffer.getReadPointer(0), numSamples);
+        return true;
+    }
+
+    /** Longest file loadCycleFile reads as a single period. */
+    static constexpr int kMaxCycleSamples = 65536;
+
+    /** A filled slot as text for saving with the plugin state (empty for an empty slot). */
+    juce::String slotToString(int slot) const
+    {
+        if (!isFilled(slot))
+            return {};
+
+        const auto& stored = getSlot(slot);
+        juce::MemoryBlock block;
+        block.append(stored.amplitudes.data(), sizeof(float) * static_cast<size_t>(stored.activeCount));
+        block.append(stored.phases.data(), sizeof(float) * static_cast<size_t>(stored.activeCount));
+        return block.toBase64Encoding();
+    }
+
+    /** Restore a slot from slotToString's text; empty or malformed text clears it. */
+    void slotFromString(int slot, const juce::String& text)
+    {
+        constexpr size_t bytesPerPartial = 2 * sizeof(float);
+        juce::MemoryBlock block;
+
+        if (text.isEmpty() || !block.fromBase64Encoding(text) || block.getSize() % bytesPerPartial != 0)
+        {
+            clearSlot(slot);
+            return;
+        }
+
+        const int stored = static_cast<int>(block.getSize() / bytesPerPartial);
+        const auto* values = static_cast<const float*>(block.getData());
+
+        Spectrum spectrum;
+        spectrum.activeCount = juce::jmin(NumPartials, stored);
+        std::copy(values, values + spectrum.activeCount, spectrum.amplitudes.begin());
+        std::copy(values + stored, values + stored + spectrum.activeCount, spectrum.phases.begin());
+        setSlot(slot, spectrum);
+    }
+
+private:
+    std::array<Spectrum, kNumSlots> slots{};
+    std::array<bool, kNumSlots> filled{};
+};
+
+} // namespace synth
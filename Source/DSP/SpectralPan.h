@@ -0,0 +1,114 @@
+/*
+  ==============================================================================
+    SpectralPan.h - Per-partial stereo positions and their channel gains
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <cmath>
+
+namespace synth
+{
+
+/** How partials are spread across the stereo field. */
+enum class SpectralPanMode
+{
+    off,       // every partial centred
+    alternate, // odd-numbered overtones left, even-numbered right; fundamental centred
+    frequency, // swept from left (fundamental) to right (the note's top partial), log-spaced
+    random     // a fixed pseudo-random position per partial, chosen by the seed
+};
+
+static constexpr int kNumSpectralPanModes = 4;
+
+/**
+ * Left/right gains per partial for a SpectralPanMode.
+ *
+ * The pan law is constant power normalised to unity at the centre (both
+ * gains 1, hard left sqrt(2)/0), so a width of zero leaves the output
+ * exactly as without spectral panning and the summed power never changes.
+ * The gains depend on mode, width and seed, and in frequency mode on how
+ * many partials the note plays (so every note spans the whole field, in
+ * any build capacity); they are recomputed only when one of those changes.
+ */
+template <int NumPartials>
+class BasicSpectralPan
+{
+public:
+    /**
+     * Recompute the gains if mode, width, seed or (in frequency mode) the
+     * note's partial count changed; returns true when panning is in effect.
+     */
+    bool update(SpectralPanMode newMode, float newWidth, int newSeed, int numActivePartials) noexcept
+    {
+        newWidth = juce::jlimit(0.0f, 1.0f, newWidth);
+        numActivePartials = juce::jlimit(1, NumPartials, numActivePartials);
+
+        if (newMode != mode || newWidth != width || newSeed != seed
+            || (newMode == SpectralPanMode::frequency && numActivePartials != activeCount))
+        {
+            mode = newMode;
+            width = newWidth;
+            seed = newSeed;
+            activeCount = numActivePartials;
+            recalculate();
+        }
+
+        return isActive();
+    }
+
+    bool isActive() const noexcept { return mode != SpectralPanMode::off && width > 0.0f; }
+
+    const float* getLeftGains() const noexcept { return gainsLeft.data(); }
+    const float* getRightGains() const noexcept { return gainsRight.data(); }
+
+    /** Position of partial index n (0 = fundamental) of `count` in [-1, 1], before width. */
+    static float getPosition(SpectralPanMode mode, int n, int count, juce::Random& random) noexcept
+    {
+        switch (mode)
+        {
+            case SpectralPanMode::alternate:
+                return n == 0 ? 0.0f : (n % 2 == 1 ? -1.0f : 1.0f);
+
+            case SpectralPanMode::frequency:
+                return count > 1 ? juce::jmin(1.0f, 2.0f * std::log2(static_cast<float>(n + 1))
+                                                           / std::log2(static_cast<float>(count)) - 1.0f)
+                                 : 0.0f;
+
+            case SpectralPanMode::random:
+                return random.nextFloat() * 2.0f - 1.0f;
+
+            case SpectralPanMode::off:
+                break;
+        }
+
+        return 0.0f;
+    }
+
+private:
+    SpectralPanMode mode = SpectralPanMode::off;
+    float width = 0.0f;
+    int seed = 0;
+    int activeCount = NumPartials;
+
+    std::array<float, NumPartials> gainsLeft{}, gainsRight{};
+
+    void recalculate() noexcept
+    {
+        juce::Random random(static_cast<juce::int64>(seed));
+
+        for (int n = 0; n < NumPartials; ++n)
+        {
+            const float position = width * getPosition(mode, n, activeCount, random);
+            const float angle = (position + 1.0f) * juce::MathConstants<float>::pi * 0.25f;
+
+            gainsLeft[static_cast<size_t>(n)] = juce::MathConstants<float>::sqrt2 * std::cos(angle);
+            gainsRight[static_cast<size_t>(n)] = juce::MathConstants<float>::sqrt2 * std::sin(angle);
+        }
+    }
+};
+
+} // namespace synth
@@ -0,0 +1,347 @@
+/*
+  ==============================================================================
+    TraceRecorder.h - Lock-free audio-thread event tracing to Chrome-trace JSON
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <vector>
+
+namespace synth
+{
+
+/** Kinds of events recorded on the audio thread. */
+enum class TraceEventType : juce::uint8
+{
+    block,       // one processBlock call (duration)
+    voiceStart,  // note started on a voice (instant)
+    voiceStop,   // note released / voice cleared (instant)
+    rebuild,     // harmonic rebuild (duration)
+    renderSlice, // one renderNextBlock call on a voice (duration)
+    midi         // incoming MIDI event (instant)
+};
+
+/** Fixed-size POD record pushed through the ring buffer. */
+struct TraceEvent
+{
+    juce::int64 startTicks = 0;
+    juce::int64 durationTicks = -1; // < 0 for instant events
+    TraceEventType type = TraceEventType::block;
+    int track = 0;                  // Chrome-trace "tid"
+    int arg0 = 0;
+    int arg1 = 0;
+};
+
+/**
+ * Records audio-thread events into a preallocated lock-free ring buffer and
+ * streams them to a Chrome-trace / Perfetto JSON file from a background thread.
+ *
+ * The audio thread only ever reads a clock and copies a TraceEvent into the
+ * FIFO: no allocation, locking or I/O. When the FIFO is full, events are
+ * dropped and counted instead of blocking.
+ *
+ * Tracks: 0 = audio blocks, 1 = MIDI, 2.. = one per voice (see voiceTrack()).
+ */
+class TraceRecorder : private juce::Thread
+{
+public:
+    static constexpr int kCapacity = 1 << 16; // events buffered between flushes
+    static constexpr int kBlockTrack = 0;
+    static constexpr int kMidiTrack = 1;
+
+    /** Environment variable that enables tracing: a file path, or "1" for the default file. */
+    static constexpr const char* kEnvironmentVariable = "ADDITIVE_SYNTH_TRACE";
+
+    TraceRecorder() : juce::Thread("Trace Writer"), fifo(kCapacity) {}
+
+    ~TraceRecorder() override { stop(); }
+
+    static constexpr int voiceTrack(int voiceIndex) noexcept { return 2 + voiceIndex; }
+
+    static juce::int64 now() noexcept { return juce::Time::getHighResolutionTicks(); }
+
+    /** Default output location: ~/Documents/AdditiveSynthesizer/trace-<time>.json */
+    static juce::File getDefaultOutputFile()
+    {
+        return juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+            .getChildFile("AdditiveSynthesizer")
+            .getChildFile("trace-" + juce::Time::getCurrentTime().formatted("%Y%m%d-%H%M%S") + ".json")
+            .getNonexistentSibling();
+    }
+
+    /**
+     * Output file requested through ADDITIVE_SYNTH_TRACE, or an invalid File
+     * when the variable is unset.
+     */
+    static juce::File getFileFromEnvironment()
+    {
+        const auto value = juce::SystemStats::getEnvironmentVariable(kEnvironmentVariable, {}).trim();
+
+        if (value.isEmpty() || value == "0")
+            return {};
+
+        if (value == "1")
+            return getDefaultOutputFile();
+
+        return juce::File::isAbsolutePath(value)
+                   ? juce::File(value)
+                   : juce::File::getCurrentWorkingDirectory().getChildFile(value);
+    }
+
+    //==========================================================================
+    // Message thread
+
+    /** Open the output file and start recording. Returns false if the file can't be written. */
+    bool start(const juce::File& file, int numVoices)
+    {
+        stop();
+
+        file.getParentDirectory().createDirectory();
+        auto stream = std::make_unique<juce::FileOutputStream>(file);
+        if (!stream->openedOk())
+            return false;
+
+        stream->truncate();
+        output = std::move(stream);
+        outputFile = file;
+        firstEventWritten = false;
+
+        if (events.empty())
+            events.resize(static_cast<size_t>(kCapacity));
+
+        writeHeader(numVoices);
+
+        // Anything still sitting in the FIFO from a previous session is discarded
+        // by the writer, which ignores events older than startTicks.
+        startTicks = now();
+        droppedEvents.store(0, std::memory_order_relaxed);
+        recording.store(true, std::memory_order_release);
+
+        startThread();
+        return true;
+    }
+
+    /** Stop recording, flush the remaining events and close the file. */
+    void stop()
+    {
+        if (!recording.exchange(false, std::memory_order_acq_rel))
+            return;
+
+        stopThread(2000);
+        drain();
+        writeFooter();
+        output.reset();
+    }
+
+    bool isRecording() const noexcept { return recording.load(std::memory_order_acquire); }
+    const juce::File& getOutputFile() const noexcept { return outputFile; }
+    int getNumDroppedEvents() const noexcept { return droppedEvents.load(std::memory_order_relaxed); }
+
+    //==========================================================================
+    // Audio thread
+
+    void instant(TraceEventType type, int track, int arg0 = 0, int arg1 = 0) noexcept
+    {
+        if (isRecording())
+            push({ now(), -1, type, track, arg0, arg1 });
+    }
+
+    void complete(TraceEventType type, int track, juce::int64 beginTicks,
+                  int arg0 = 0, int arg1 = 0) noexcept
+    {
+        if (isRecording())
+            push({ beginTicks, now() - beginTicks, type, track, arg0, arg1 });
+    }
+
+    /** Records a duration event covering its own lifetime. */
+    class ScopedEvent
+    {
+    public:
+        ScopedEvent(TraceRecorder* recorderToUse, TraceEventType eventType, int eventTrack,
+                    int firstArg = 0, int secondArg = 0) noexcept
+            : recorder(recorderToUse != nullptr && recorderToUse->isRecording() ? recorderToUse : nullptr),
+              type(eventType), track(eventTrack), arg0(firstArg), arg1(secondArg),
+              begin(recorder != nullptr ? now() : 0)
+        {
+        }
+
+        ~ScopedEvent() noexcept
+        {
+            if (recorder != nullptr)
+                recorder->complete(type, track, begin, arg0, arg1);
+        }
+
+        /** Update the second argument before the event is emitted (e.g. a result count). */
+        void setSecondArg(int value) noexcept { arg1 = value; }
+
+    private:
+        TraceRecorder* recorder;
+        TraceEventType type;
+        int track, arg0, arg1;
+        juce::int64 begin;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedEvent)
+    };
+
+    /** Pack a short MIDI message into a single event argument. */
+    static int packMidi(const juce::uint8* data, int numBytes) noexcept
+    {
+        int packed = 0;
+        for (int i = 0; i < 3; ++i)
+            packed = (packed << 8) | (i < numBytes ? data[i] : 0);
+        return packed;
+    }
+
+private:
+    juce::AbstractFifo fifo;
+    std::vector<TraceEvent> events;
+    std::atomic<bool> recording{ false };
+    std::atomic<int> droppedEvents{ 0 };
+    juce::int64 startTicks = 0;
+
+    std::unique_ptr<juce::FileOutputStream> output;
+    juce::File outputFile;
+    bool firstEventWritten = false;
+
+    void push(const TraceEvent& event) noexcept
+    {
+        const auto scope = fifo.write(1);
+        if (scope.blockSize1 > 0)
+            events[static_cast<size_t>(scope.startIndex1)] = event;
+        else
+            droppedEvents.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    //==========================================================================
+    // Writer thread
+
+    void run() override
+    {
+        while (!threadShouldExit())
+        {
+            wait(50);
+            drain();
+        }
+    }
+
+    void drain()
+    {
+        const auto scope = fifo.read(fifo.getNumReady());
+        scope.forEach([this](int index)
+        {
+            const auto& event = events[static_cast<size_t>(index)];
+            if (event.startTicks >= startTicks)
+                writeEvent(event);
+        });
+
+        if (output != nullptr)
+            output->flush();
+    }
+
+    double ticksToMicroseconds(juce::int64 ticks) const noexcept
+    {
+        return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e6;
+    }
+
+    void writeRecord(const juce::String& json)
+    {
+        if (output == nullptr)
+            return;
+
+        *output << (firstEventWritten ? ",\n" : "\n") << json;
+        firstEventWritten = true;
+    }
+
+    void writeThreadName(int track, const juce::String& name, int sortIndex)
+    {
+        writeRecord("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + juce::String(track)
+                    + ",\"args\":{\"name\":\"" + name + "\"}},\n"
+                    + "{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":" + juce::String(track)
+                    + ",\"args\":{\"sort_index\":" + juce::String(sortIndex) + "}}");
+    }
+
+    void writeHeader(int numVoices)
+    {
+        *output << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+        writeRecord("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"AdditiveSynthesizer\"}}");
+        writeThreadName(kBlockTrack, "Audio blocks", 0);
+        writeThreadName(kMidiTrack, "MIDI", 1);
+
+        for (int v = 0; v < numVoices; ++v)
+            writeThreadName(voiceTrack(v), "Voice " + juce::String(v + 1), voiceTrack(v));
+    }
+
+    void writeFooter()
+    {
+        if (output == nullptr)
+            return;
+
+        writeRecord("{\"name\":\"dropped_events\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":0"
+                    ",\"args\":{\"count\":" + juce::String(getNumDroppedEvents()) + "}}");
+        *output << "\n]}\n";
+        output->flush();
+    }
+
+    static juce::String describeMidi(int packed)
+    {
+        const int status = (packed >> 16) & 0xff;
+        const int data1 = (packed >> 8) & 0xff;
+        const int data2 = packed & 0xff;
+        const juce::uint8 bytes[] = { static_cast<juce::uint8>(status),
+                                      static_cast<juce::uint8>(data1),
+                                      static_cast<juce::uint8>(data2) };
+        return juce::MidiMessage(bytes, 3).getDescription();
+    }
+
+    void writeEvent(const TraceEvent& event)
+    {
+        juce::String name, category, args;
+
+        switch (event.type)
+        {
+            case TraceEventType::block:
+                name = "processBlock";  category = "engine";
+                args = "\"samples\":" + juce::String(event.arg0) + ",\"activeVoices\":" + juce::String(event.arg1);
+                break;
+            case TraceEventType::voiceStart:
+                name = "noteOn";        category = "voice";
+                args = "\"note\":" + juce::String(event.arg0) + ",\"velocity\":" + juce::String(event.arg1);
+                break;
+            case TraceEventType::voiceStop:
+                name = event.arg1 != 0 ? "noteOff" : "voiceEnd"; category = "voice";
+                args = "\"note\":" + juce::String(event.arg0) + ",\"tailOff\":" + juce::String(event.arg1);
+                break;
+            case TraceEventType::rebuild:
+                name = "rebuildHarmonics"; category = "voice";
+                args = "\"note\":" + juce::String(event.arg0) + ",\"activeCount\":" + juce::String(event.arg1);
+                break;
+            case TraceEventType::renderSlice:
+                name = "render";        category = "voice";
+                args = "\"startSample\":" + juce::String(event.arg0) + ",\"samples\":" + juce::String(event.arg1);
+                break;
+            case TraceEventType::midi:
+                name = describeMidi(event.arg0).replace("\"", "'"); category = "midi";
+                args = "\"samplePosition\":" + juce::String(event.arg1);
+                break;
+        }
+
+        const auto ts = juce::String(ticksToMicroseconds(event.startTicks - startTicks), 3);
+        juce::String json = "{\"name\":\"" + name + "\",\"cat\":\"" + category + "\",\"pid\":1,\"tid\":"
+                            + juce::String(event.track) + ",\"ts\":" + ts;
+
+        if (event.durationTicks >= 0)
+            json += ",\"ph\":\"X\",\"dur\":" + juce::String(ticksToMicroseconds(event.durationTicks), 3);
+        else
+            json += ",\"ph\":\"i\",\"s\":\"t\"";
+
+        writeRecord(json + ",\"args\":{" + args + "}}");
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TraceRecorder)
+};
+
+} // namespace synth
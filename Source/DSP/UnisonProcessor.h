@@ -1,145 +1,149 @@
 /*
   ==============================================================================
-    UnisonProcessor.h - Unison stacking with detuning and stereo spread
+    UnisonProcessor.h - Post-mix unison: a stack of modulated-delay copies
   ==============================================================================
 */
 
 #pragma once
 
 #include <JuceHeader.h>
+#include "EngineConfig.h"
+#include "RenderKernels.h"
 #include <array>
 #include <cmath>
+#include <cstring>
+#include <vector>
 
 namespace synth
 {
 
+/** Where unison copies are made. */
+enum class UnisonMode
+{
+    perVoice, // every voice renders each unison copy through its partial bank
+    economy   // voices render once; UnisonProcessor stacks detuned copies of the mix
+};
+
+static constexpr int kNumUnisonModes = 2;
+
 /**
- * Processes a mono signal into stereo by stacking detuned copies
- * with pan spread for stereo width.
+ * Economy unison: turns the mixed output of all voices into a stereo stack
+ * of detuned copies, a chorus, instead of rendering every partial of every
+ * voice once per unison copy. The cost is O(copies) per sample, whatever
+ * the number of voices and partials.
+ *
+ * Each copy reads the mix through its own modulated delay,
+ *   delay(t) = depth * (1 + sin(rate * t)),
+ * which bends its pitch by up to ±depth * rate. The depth is set so that
+ * peak matches the copy's detune (the same spread across ±detune cents as
+ * per-voice unison), so copies sweep through their detune rather than
+ * holding it: the usual chorus trade-off against the exact per-voice mode.
+ * Copies are panned like per-voice unison and normalised by 1/sqrt(count).
+ *
+ * The inner loop is RenderKernels::accumulateDelayTap, dispatched per
+ * instruction set like the partial kernels; it reads with gathers and has
+ * no branches:
+ *   - one shared delay line holds the mix, kept linear (the history is
+ *     moved down once per block) so reads never wrap or take a modulo;
+ *   - each copy's LFO is a rotating phasor evaluated once per
+ *     kControlInterval samples (no per-sample std::sin), and its delay is
+ *     ramped linearly between control points, so a span's read positions
+ *     are an arithmetic sequence;
+ *   - truncation stands in for std::floor, as read positions are positive.
  *
- * Uses pitch-shifting via resampling (fractional delay) for detuning.
- * For simplicity, Unison here operates at the output stage by applying
- * micro-delays and subtle pitch offsets via allpass interpolation.
+ * The stack is fed the mid signal of the buffer, so it collapses per-partial
+ * panning; per-voice modulation of detune and width doesn't apply to it.
  *
- * Simpler approach: since additive synthesis gives us explicit control,
- * we duplicate the mono input with slight phase/pitch modulation.
+ * Sized by Config like the voices, so both unison modes allow the same
+ * number of copies.
  */
-class UnisonProcessor
+template <typename Config>
+class BasicUnisonProcessor
 {
 public:
-    static constexpr int kMaxUnisonVoices = 8;
+    static constexpr int kMaxUnisonVoices = Config::maxUnisonVoices;
 
-    UnisonProcessor() = default;
+    /** Samples between LFO evaluations; the delay is ramped between them. */
+    static constexpr int kControlInterval = 32;
 
-    void prepareToPlay(double sampleRate, int /*samplesPerBlock*/)
+    /** Slowest copy LFO; the depth a detune needs grows as the rate falls. */
+    static constexpr double kBaseRateHz = 0.5;
+
+    /** Largest detune the delay line is sized for, in cents. */
+    static constexpr double kMaxDetuneCents = 100.0;
+
+    BasicUnisonProcessor() = default;
+
+    /** Message thread: size the delay line for a sample rate and the largest block. */
+    void prepareToPlay(double sampleRate, int samplesPerBlock)
     {
         currentSampleRate = sampleRate;
+        maxBlockSize = juce::jmax(1, samplesPerBlock);
 
-        // Initialize delay lines for each unison voice (for chorus-like effect)
-        for (auto& dl : delayLines)
+        // The deepest delay (slowest copy at the widest detune) plus room to interpolate
+        historyLength = static_cast<int>(std::ceil(2.0 * depthForDetune(kMaxDetuneCents, kBaseRateHz))) + 4;
+        line.assign(static_cast<size_t>(historyLength + maxBlockSize + 1), 0.0f); // +1: interpolation partner
+        left.assign(static_cast<size_t>(maxBlockSize), 0.0f);
+        right.assign(static_cast<size_t>(maxBlockSize), 0.0f);
+
+        reset();
+    }
+
+    /** Clear the delay line and restart the LFOs. */
+    void reset() noexcept
+    {
+        std::fill(line.begin(), line.end(), 0.0f);
+
+        // Copies detuned downwards start half a cycle round, so the stack sweeps in opposite directions
+        for (int v = 0; v < kMaxUnisonVoices; ++v)
         {
-            dl.resize(static_cast<size_t>(sampleRate * 0.05), 0.0f); // 50ms max delay
-            dl.assign(dl.size(), 0.0f);
+            phasorCos[static_cast<size_t>(v)] = (v % 2 == 0) ? 1.0f : -1.0f;
+            phasorSin[static_cast<size_t>(v)] = 0.0f;
         }
-        for (auto& idx : writeIndices)
-            idx = 0;
-        for (auto& phase : lfoPhases)
-            phase = 0.0f;
+
+        delays.fill(0.0f);
+        delaySteps.fill(0.0f);
+        samplesToControlPoint = 0;
+
+        configuredCount = 0;
     }
 
+    //==========================================================================
+    // Audio thread
+
     /**
-     * Process mono input buffer into stereo output buffer.
-     * Applies unison stacking with detuning and stereo spread.
+     * Replace the first numSamples of a stereo buffer with the unison stack
+     * of its mid signal. Mono buffers are left untouched, and so is the
+     * buffer with a single copy; its mid signal still goes into the delay
+     * line, so copies added later read the recent mix rather than stale history.
      */
-    void process(const juce::AudioBuffer<float>& monoInput,
-                 juce::AudioBuffer<float>& stereoOutput)
+    template <typename SampleType>
+    void process(juce::AudioBuffer<SampleType>& buffer, int numSamples) noexcept
     {
-        const int numSamples = monoInput.getNumSamples();
-        const int numOutChannels = stereoOutput.getNumChannels();
-        const float* monoData = monoInput.getReadPointer(0);
-
-        stereoOutput.clear();
-
-        if (voiceCount <= 1 || numOutChannels < 2)
-        {
-            // No unison: just copy mono to both channels
-            for (int ch = 0; ch < numOutChannels; ++ch)
-                stereoOutput.copyFrom(ch, 0, monoInput, 0, 0, numSamples);
+        if (buffer.getNumChannels() < 2 || line.empty())
             return;
-        }
 
-        const float gainPerVoice = 1.0f / std::sqrt(static_cast<float>(voiceCount));
+        if (voiceCount > 1)
+            updateCopies();
 
-        for (int sample = 0; sample < numSamples; ++sample)
+        for (int start = 0; start < numSamples; start += maxBlockSize)
         {
-            const float input = monoData[sample];
-            float leftSum = 0.0f;
-            float rightSum = 0.0f;
+            const int count = juce::jmin(maxBlockSize, numSamples - start);
 
-            for (int v = 0; v < voiceCount; ++v)
-            {
-                // Apply chorus-like detuning via modulated delay
-                float detuned = input;
-                if (v > 0)
-                {
-                    // LFO-modulated micro delay for detuning effect
-                    const float lfoRate = 0.5f + static_cast<float>(v) * 0.2f; // Hz
-                    const float lfoDepth = detuneAmount * 0.0001f
-                                           * static_cast<float>(currentSampleRate);
-                    lfoPhases[v] += lfoRate / static_cast<float>(currentSampleRate);
-                    if (lfoPhases[v] >= 1.0f) lfoPhases[v] -= 1.0f;
-
-                    const float sign = (v % 2 == 0) ? 1.0f : -1.0f;
-                    const float delayMs = 0.5f + sign * lfoDepth
-                                          * std::sin(lfoPhases[v] * 6.283185f);
-                    const float delaySamples = std::max(0.1f,
-                        delayMs * static_cast<float>(currentSampleRate) / 1000.0f);
-
-                    // Write to delay line
-                    auto& dl = delayLines[v];
-                    const int dlSize = static_cast<int>(dl.size());
-                    dl[writeIndices[v] % dlSize] = input;
-                    writeIndices[v] = (writeIndices[v] + 1) % dlSize;
-
-                    // Read from delay line with linear interpolation
-                    const float readPos = static_cast<float>(writeIndices[v]) - delaySamples;
-                    int readIdx0 = static_cast<int>(std::floor(readPos));
-                    while (readIdx0 < 0) readIdx0 += dlSize;
-                    const int readIdx1 = (readIdx0 + 1) % dlSize;
-                    const float frac = readPos - std::floor(readPos);
-
-                    detuned = dl[readIdx0 % dlSize] * (1.0f - frac)
-                            + dl[readIdx1] * frac;
-                }
-
-                // Stereo panning based on voice index and width
-                // Voices spread from center to edges based on stereoWidth
-                float pan = 0.5f; // center
-                if (voiceCount > 1)
-                {
-                    const float spread = static_cast<float>(v) / static_cast<float>(voiceCount - 1);
-                    pan = 0.5f + stereoWidth * (spread - 0.5f);
-                }
-                pan = juce::jlimit(0.0f, 1.0f, pan);
-
-                // Constant-power panning
-                const float leftGain = std::cos(pan * juce::MathConstants<float>::halfPi);
-                const float rightGain = std::sin(pan * juce::MathConstants<float>::halfPi);
-
-                leftSum += detuned * leftGain * gainPerVoice;
-                rightSum += detuned * rightGain * gainPerVoice;
-            }
-
-            stereoOutput.setSample(0, sample, leftSum);
-            if (numOutChannels >= 2)
-                stereoOutput.setSample(1, sample, rightSum);
+            if (voiceCount <= 1)
+                feedHistory(buffer.getReadPointer(0, start), buffer.getReadPointer(1, start), count);
+            else
+                processChunk(buffer.getWritePointer(0, start), buffer.getWritePointer(1, start), count);
         }
     }
 
     void setVoiceCount(int count) { voiceCount = juce::jlimit(1, kMaxUnisonVoices, count); }
-    void setDetuneAmount(float cents) { detuneAmount = cents; }
+    void setDetuneAmount(float cents) { detuneAmount = juce::jlimit(0.0f, static_cast<float>(kMaxDetuneCents), cents); }
     void setStereoWidth(float width) { stereoWidth = juce::jlimit(0.0f, 1.0f, width); }
 
+    /** Render with a specific instruction-set variant instead of the active one; for benchmarks and A/B tests. */
+    void setSimdLevel(SimdLevel level) noexcept { renderKernels = &getRenderKernels(level); }
+
     int getVoiceCount() const { return voiceCount; }
     float getDetuneAmount() const { return detuneAmount; }
     float getStereoWidth() const { return stereoWidth; }
@@ -149,13 +153,162 @@ private:
     float detuneAmount = 10.0f;   // cents
     float stereoWidth = 0.5f;     // 0..1
     double currentSampleRate = 44100.0;
+    int maxBlockSize = 0;
+    const RenderKernels* renderKernels = &getActiveRenderKernels();
+
+    // Delay line: historyLength samples of past input, then the current chunk
+    std::vector<float> line;
+    int historyLength = 0;
+    std::vector<float> left, right;
+
+    // Per copy: LFO phasor and its rotation per control interval, delay depth,
+    // the delay now and its step per sample towards the next control point, pan gains
+    std::array<float, kMaxUnisonVoices> phasorCos{}, phasorSin{};
+    std::array<float, kMaxUnisonVoices> stepCos{}, stepSin{};
+    std::array<float, kMaxUnisonVoices> depths{};
+    std::array<float, kMaxUnisonVoices> delays{}, delaySteps{};
+    int samplesToControlPoint = 0;
+    std::array<float, kMaxUnisonVoices> gainsLeft{}, gainsRight{};
+
+    // What the per-copy values above were computed for
+    int configuredCount = 0;
+    float configuredDetune = -1.0f, configuredWidth = -1.0f;
+
+    /** Delay depth (samples) whose sinusoidal sweep at rateHz bends pitch by up to `cents`. */
+    double depthForDetune(double cents, double rateHz) const noexcept
+    {
+        const double pitchDeviation = std::exp2(cents / 1200.0) - 1.0;
+        return pitchDeviation / (juce::MathConstants<double>::twoPi * rateHz / currentSampleRate);
+    }
+
+    /** Recompute the per-copy rates, depths and pans when the settings move. */
+    void updateCopies() noexcept
+    {
+        if (voiceCount == configuredCount && detuneAmount == configuredDetune && stereoWidth == configuredWidth)
+            return;
+
+        const float gainPerCopy = 1.0f / std::sqrt(static_cast<float>(voiceCount));
+
+        for (int v = 0; v < voiceCount; ++v)
+        {
+            const auto index = static_cast<size_t>(v);
+            const double spread = static_cast<double>(v) / (voiceCount - 1) * 2.0 - 1.0;
+
+            // Slightly different rates keep the copies from sweeping in lockstep
+            const double rateHz = kBaseRateHz + 0.2 * v;
+            const double step = juce::MathConstants<double>::twoPi * rateHz * kControlInterval / currentSampleRate;
+            stepCos[index] = static_cast<float>(std::cos(step));
+            stepSin[index] = static_cast<float>(std::sin(step));
+            depths[index] = static_cast<float>(depthForDetune(std::abs(detuneAmount * spread), rateHz));
+
+            const double pan = juce::jlimit(0.0, 1.0, 0.5 + stereoWidth * spread * 0.5);
+            gainsLeft[index] = gainPerCopy * static_cast<float>(std::cos(pan * juce::MathConstants<double>::halfPi));
+            gainsRight[index] = gainPerCopy * static_cast<float>(std::sin(pan * juce::MathConstants<double>::halfPi));
+        }
 
-    // Delay lines for chorus-based detuning
-    std::array<std::vector<float>, kMaxUnisonVoices> delayLines;
-    std::array<int, kMaxUnisonVoices> writeIndices{};
-    std::array<float, kMaxUnisonVoices> lfoPhases{};
+        configuredCount = voiceCount;
+        configuredDetune = detuneAmount;
+        configuredWidth = stereoWidth;
+    }
+
+    /** Write a chunk's mid signal after the history, scaled back up to the level of a centred voice. */
+    template <typename SampleType>
+    void writeInput(const SampleType* inLeft, const SampleType* inRight, int numSamples) noexcept
+    {
+        constexpr float midGain = 0.70710678f;
+        float* input = line.data() + historyLength;
+
+        for (int i = 0; i < numSamples; ++i)
+            input[i] = static_cast<float>(inLeft[i] + inRight[i]) * midGain;
+    }
+
+    /** Keep the newest historyLength samples at the front for the next chunk. */
+    void shiftHistory(int numSamples) noexcept
+    {
+        std::memmove(line.data(), line.data() + numSamples, sizeof(float) * static_cast<size_t>(historyLength));
+    }
+
+    /** A single copy: the buffer stays as it is, only the delay line follows it. */
+    template <typename SampleType>
+    void feedHistory(const SampleType* inLeft, const SampleType* inRight, int numSamples) noexcept
+    {
+        writeInput(inLeft, inRight, numSamples);
+        shiftHistory(numSamples);
+    }
+
+    template <typename SampleType>
+    void processChunk(SampleType* outLeft, SampleType* outRight, int numSamples) noexcept
+    {
+        writeInput(outLeft, outRight, numSamples);
+
+        std::fill(left.begin(), left.begin() + numSamples, 0.0f);
+        std::fill(right.begin(), right.begin() + numSamples, 0.0f);
+
+        // Control points fall every kControlInterval samples, whatever the block boundaries
+        for (int start = 0; start < numSamples;)
+        {
+            if (samplesToControlPoint == 0)
+            {
+                advanceControlPoint();
+                samplesToControlPoint = kControlInterval;
+            }
+
+            const int count = juce::jmin(samplesToControlPoint, numSamples - start);
+
+            for (int v = 0; v < voiceCount; ++v)
+                accumulateCopy(v, start, count);
 
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(UnisonProcessor)
+            samplesToControlPoint -= count;
+            start += count;
+        }
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            outLeft[i] = static_cast<SampleType>(left[static_cast<size_t>(i)]);
+            outRight[i] = static_cast<SampleType>(right[static_cast<size_t>(i)]);
+        }
+
+        shiftHistory(numSamples);
+    }
+
+    /** Rotate every copy's LFO to the next control point and ramp its delay towards it. */
+    void advanceControlPoint() noexcept
+    {
+        for (int v = 0; v < voiceCount; ++v)
+        {
+            const auto index = static_cast<size_t>(v);
+            const float c = phasorCos[index], s = phasorSin[index];
+            const float nextCos = c * stepCos[index] - s * stepSin[index];
+            const float nextSin = c * stepSin[index] + s * stepCos[index];
+
+            // Renormalise so rounding doesn't grow or shrink the phasor over time
+            const float norm = 1.5f - 0.5f * (nextCos * nextCos + nextSin * nextSin);
+            phasorCos[index] = nextCos * norm;
+            phasorSin[index] = nextSin * norm;
+
+            const float target = juce::jmax(0.0f, depths[index] * (1.0f + phasorSin[index]));
+            delaySteps[index] = (target - delays[index]) / static_cast<float>(kControlInterval);
+        }
+    }
+
+    /** Add samples [start, start + count) of one copy's delayed, panned read to left/right. */
+    void accumulateCopy(int v, int start, int count) noexcept
+    {
+        const auto index = static_cast<size_t>(v);
+        const float delay = delays[index];
+        const float delayStep = delaySteps[index];
+
+        // Read position of sample i: historyLength + start + i - (delay + i * delayStep), never negative
+        renderKernels->accumulateDelayTap(line.data(), static_cast<float>(historyLength + start) - delay,
+                                          1.0f - delayStep, gainsLeft[index], gainsRight[index],
+                                          left.data() + start, right.data() + start, count);
+
+        delays[index] = delay + delayStep * static_cast<float>(count);
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BasicUnisonProcessor)
 };
 
+using UnisonProcessor = BasicUnisonProcessor<ActiveEngineConfig>;
+
 } // namespace synth
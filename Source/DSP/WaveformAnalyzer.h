@@ -61,6 +61,15 @@ public:
         return true;
     }
 
+    /**
+     * Analyze samples already in memory (e.g. a generated test signal).
+     * Only the first kFFTSize samples are used.
+     */
+    void analyzeSamples(const float* data, int numSamples)
+    {
+        analyze(data, std::min(numSamples, kFFTSize));
+    }
+
     /** Get the extracted spectral envelope (256 bins). */
     const std::array<float, kMaxHarmonics>& getSpectralEnvelope() const
     {
@@ -21,7 +21,9 @@ public:
               { "Attack",  "s", "envAttack" },
               { "Decay",   "s", "envDecay" },
               { "Sustain", "",  "envSustain" },
-              { "Release", "s", "envRelease" }
+              { "Release", "s", "envRelease" },
+              { "Tilt",    "",  "partialDecayTilt" },
+              { "Spread",  "s", "partialAttackDelay" }
           })
     {
         addAndMakeVisible(adsrDisplay);
@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+    ModulationSection.h - LFO, mod envelope and modulation slot controls
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SectionBase.h"
+
+namespace gui
+{
+
+/**
+ * Two rows of knobs: the modulation sources (two LFOs and the mod envelope)
+ * on top, and below them the routing slots, each a source, a destination
+ * and an amount.
+ */
+class ModulationSection : public SectionBase
+{
+public:
+    static constexpr int kNumSlots = 4;
+
+    ModulationSection(juce::AudioProcessorValueTreeState& apvts)
+        : SectionBase("MODULATION", apvts, {
+              { "LFO1",    "Hz", "lfo1Rate" },
+              { "Shape1",  "",   "lfo1Shape" },
+              { "LFO2",    "Hz", "lfo2Rate" },
+              { "Shape2",  "",   "lfo2Shape" },
+              { "M.Att",   "s",  "modEnvAttack" },
+              { "M.Dec",   "s",  "modEnvDecay" },
+              { "M.Sus",   "",   "modEnvSustain" },
+              { "M.Rel",   "s",  "modEnvRelease" }
+          })
+    {
+        std::vector<KnobDescriptor> slotKnobs;
+
+        for (int i = 1; i <= kNumSlots; ++i)
+        {
+            const juce::String prefix = "mod" + juce::String(i);
+            slotKnobs.push_back({ "Src" + juce::String(i), "", prefix + "Source" });
+            slotKnobs.push_back({ "Dst" + juce::String(i), "", prefix + "Dest" });
+            slotKnobs.push_back({ "Amt" + juce::String(i), "", prefix + "Amount" });
+        }
+
+        slotStrip.init(apvts, slotKnobs);
+        addAndMakeVisible(slotStrip);
+    }
+
+protected:
+    void resizeContent(juce::Rectangle<int> area) override
+    {
+        slotStrip.setBounds(area);
+    }
+
+private:
+    KnobStrip slotStrip;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ModulationSection)
+};
+
+} // namespace gui
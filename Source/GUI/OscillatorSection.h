@@ -1,6 +1,6 @@
 /*
   ==============================================================================
-    OscillatorSection.h - Oscillator controls (Ratio, Saw Phase, Sqr Phase)
+    OscillatorSection.h - Oscillator controls (Ratio, Saw/Sqr Phase, Glide, Bend, Morph)
   ==============================================================================
 */
 
@@ -9,21 +9,50 @@
 #include <JuceHeader.h>
 #include "SectionBase.h"
 #include "WaveformDisplay.h"
+#include <array>
+#include <functional>
 
 namespace gui
 {
 
+/** What the morph slot buttons do; slots are numbered 0..3 (A..D). */
+struct MorphSlotActions
+{
+    std::function<void(int)> store;                           // capture the current spectrum
+    std::function<bool(int, const juce::File&)> load;         // analyse a single-cycle file
+    std::function<void(int)> clear;
+    std::function<bool(int)> isFilled;
+};
+
 class OscillatorSection : public SectionBase
 {
 public:
-    OscillatorSection(juce::AudioProcessorValueTreeState& apvts)
+    static constexpr int kNumMorphSlots = 4;
+
+    OscillatorSection(juce::AudioProcessorValueTreeState& apvts, MorphSlotActions actions = {})
         : SectionBase("OSCILLATOR", apvts, {
               { "Ratio",  "",  "oscRatio" },
               { juce::String(juce::CharPointer_UTF8("Saw \xcf\x86")), "", "sawPhase" },
-              { juce::String(juce::CharPointer_UTF8("Sqr \xcf\x86")), "", "sqrPhase" }
-          })
+              { juce::String(juce::CharPointer_UTF8("Sqr \xcf\x86")), "", "sqrPhase" },
+              { "Glide",  "s",  "glideTime" },
+              { "Bend",   "st", "pitchBendRange" },
+              { "Morph",  "",   "morphAmount" },
+              { "M.Pos",  "",   "morphPosition" }
+          }),
+          morphActions(std::move(actions))
     {
         addAndMakeVisible(waveformDisplay);
+
+        for (int slot = 0; slot < kNumMorphSlots; ++slot)
+        {
+            auto& button = morphSlotButtons[static_cast<size_t>(slot)];
+            button.setButtonText(juce::String::charToString(static_cast<juce::juce_wchar>('A' + slot)));
+            button.setTooltip("Morph slot: store the current spectrum or load a single-cycle waveform");
+            button.onClick = [this, slot]() { showMorphSlotMenu(slot); };
+            addAndMakeVisible(button);
+        }
+
+        refreshMorphSlots();
     }
 
     void setVisualizationBuffer(const juce::AudioBuffer<float>* buffer)
@@ -31,15 +60,69 @@ public:
         waveformDisplay.setBuffer(buffer);
     }
 
+    /** Light the buttons of filled slots (they can also change with a preset load). */
+    void refreshMorphSlots()
+    {
+        for (int slot = 0; slot < kNumMorphSlots; ++slot)
+            morphSlotButtons[static_cast<size_t>(slot)].setToggleState(
+                morphActions.isFilled && morphActions.isFilled(slot), juce::dontSendNotification);
+    }
+
 protected:
     void resizeContent(juce::Rectangle<int> area) override
     {
+        auto slotRow = area.removeFromBottom(24);
+        area.removeFromBottom(4);
         waveformDisplay.setBounds(area);
+
+        const int slotWidth = slotRow.getWidth() / kNumMorphSlots;
+        for (auto& button : morphSlotButtons)
+            button.setBounds(slotRow.removeFromLeft(slotWidth).reduced(2, 2));
     }
 
 private:
     WaveformDisplay waveformDisplay;
 
+    MorphSlotActions morphActions;
+    std::array<juce::TextButton, kNumMorphSlots> morphSlotButtons;
+    std::unique_ptr<juce::FileChooser> fileChooser;
+
+    void showMorphSlotMenu(int slot)
+    {
+        const bool filled = morphActions.isFilled && morphActions.isFilled(slot);
+
+        juce::PopupMenu menu;
+        menu.addItem("Store current spectrum", morphActions.store != nullptr, false,
+                     [this, slot]() { morphActions.store(slot); refreshMorphSlots(); });
+        menu.addItem("Load single-cycle waveform...", morphActions.load != nullptr, false,
+                     [this, slot]() { loadMorphSlotFile(slot); });
+        menu.addItem("Clear", filled && morphActions.clear != nullptr, false,
+                     [this, slot]() { morphActions.clear(slot); refreshMorphSlots(); });
+        menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(
+            &morphSlotButtons[static_cast<size_t>(slot)]));
+    }
+
+    void loadMorphSlotFile(int slot)
+    {
+        fileChooser = std::make_unique<juce::FileChooser>(
+            "Select a single-cycle waveform",
+            juce::File{},
+            "*.wav;*.aiff;*.flac");
+
+        fileChooser->launchAsync(
+            juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+            [this, slot](const juce::FileChooser& fc)
+            {
+                auto file = fc.getResult();
+                auto& button = morphSlotButtons[static_cast<size_t>(slot)];
+
+                if (file.existsAsFile())
+                    button.setTooltip(morphActions.load(slot, file) ? "Slot loaded from " + file.getFileName()
+                                                                    : "Could not read " + file.getFileName());
+                refreshMorphSlots();
+            });
+    }
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OscillatorSection)
 };
 
@@ -1,6 +1,6 @@
 /*
   ==============================================================================
-    SpectralFilterSection.h - Spectral filter controls + waveform import
+    SpectralFilterSection.h - Spectral filter controls, partial tuning, resynthesis + file import
   ==============================================================================
 */
 
@@ -15,7 +15,7 @@ namespace gui
 {
 
 /**
- * Callback type for loading a waveform file.
+ * Callback type for loading a file (waveform, partial ratio table, or sample or library to resynthesise).
  * Returns true if the file was loaded successfully.
  */
 using FileLoadCallback = std::function<bool(const juce::File&)>;
@@ -24,23 +24,42 @@ class SpectralFilterSection : public SectionBase
 {
 public:
     SpectralFilterSection(juce::AudioProcessorValueTreeState& apvts,
-                          FileLoadCallback loadCallback = nullptr)
+                          FileLoadCallback loadCallback = nullptr,
+                          FileLoadCallback ratiosLoadCallback = nullptr,
+                          FileLoadCallback resynthesisLoadCallback = nullptr)
         : SectionBase("SPECTRAL FILTER", apvts, {
               { "Cutoff",  "",                                                           "filterCutoff" },
               { "Boost",   "dB",                                                         "filterBoost" },
               { "Phase",   juce::String(juce::CharPointer_UTF8("\xc2\xb0")),             "filterPhase" },
               { "Stretch", "",                                                           "filterStretch" },
-              { "Wet/Dry", "",                                                           "waveFilterMix" }
+              { "Tuning",  "",                                                           "partialTuning" },
+              { "Inharm",  "",                                                           "stringInharmonicity" },
+              { "Wet/Dry", "",                                                           "waveFilterMix" },
+              { "Source",  "",                                                           "oscSource" },
+              { "Speed",   "x",                                                          "resynthesisSpeed" }
           }),
-          onFileLoad(std::move(loadCallback))
+          onFileLoad(std::move(loadCallback)),
+          onRatiosLoad(std::move(ratiosLoadCallback)),
+          onResynthesisLoad(std::move(resynthesisLoadCallback))
     {
         addAndMakeVisible(spectrumDisplay);
         addAndMakeVisible(loadButton);
+        addAndMakeVisible(ratiosButton);
+        addAndMakeVisible(resynthesisButton);
         addAndMakeVisible(fileLabel);
 
         loadButton.setButtonText("Load Waveform");
         loadButton.onClick = [this]() { loadWaveformFile(); };
 
+        ratiosButton.setButtonText("Load Partials");
+        ratiosButton.setTooltip("Partial frequency ratios for the Custom tuning (text, one ratio or fraction per entry)");
+        ratiosButton.onClick = [this]() { loadRatiosFile(); };
+
+        resynthesisButton.setButtonText("Resynth");
+        resynthesisButton.setTooltip("Analyse a sample into partial tracks, or open a partial library (.partials), "
+                                     "played when Source is Resynthesis");
+        resynthesisButton.onClick = [this]() { loadResynthesisFile(); };
+
         fileLabel.setText("No file loaded", juce::dontSendNotification);
         fileLabel.setColour(juce::Label::textColourId, Colors::textDim);
         fileLabel.setFont(juce::FontOptions(10.0f));
@@ -48,6 +67,13 @@ public:
 
     SpectrumDisplay& getSpectrumDisplay() { return spectrumDisplay; }
 
+    /** Show a status line in the file label (e.g. analysis progress); `ok` picks the colour. */
+    void setFileStatus(const juce::String& text, bool ok)
+    {
+        fileLabel.setText(text, juce::dontSendNotification);
+        fileLabel.setColour(juce::Label::textColourId, ok ? Colors::waveformGreen : Colors::accent);
+    }
+
 protected:
     void resizeContent(juce::Rectangle<int> content) override
     {
@@ -58,16 +84,20 @@ protected:
         auto loadRow = content;
         loadButton.setBounds(loadRow.removeFromLeft(110).reduced(0, 2));
         loadRow.removeFromLeft(4);
+        ratiosButton.setBounds(loadRow.removeFromLeft(100).reduced(0, 2));
+        loadRow.removeFromLeft(4);
+        resynthesisButton.setBounds(loadRow.removeFromLeft(70).reduced(0, 2));
+        loadRow.removeFromLeft(4);
         fileLabel.setBounds(loadRow.reduced(4, 2));
     }
 
 private:
     SpectrumDisplay spectrumDisplay;
 
-    juce::TextButton loadButton;
+    juce::TextButton loadButton, ratiosButton, resynthesisButton;
     juce::Label fileLabel;
 
-    FileLoadCallback onFileLoad;
+    FileLoadCallback onFileLoad, onRatiosLoad, onResynthesisLoad;
 
     void loadWaveformFile()
     {
@@ -76,23 +106,43 @@ private:
             juce::File{},
             "*.wav;*.aiff;*.flac;*.mp3;*.ogg");
 
+        launchChooser(onFileLoad);
+    }
+
+    void loadRatiosFile()
+    {
+        fileChooser = std::make_unique<juce::FileChooser>(
+            "Select a partial ratio table",
+            juce::File{},
+            "*.txt;*.csv");
+
+        launchChooser(onRatiosLoad);
+    }
+
+    void loadResynthesisFile()
+    {
+        fileChooser = std::make_unique<juce::FileChooser>(
+            "Select a sample or partial library to resynthesise",
+            juce::File{},
+            "*.wav;*.aiff;*.flac;*.mp3;*.ogg;*.partials");
+
+        launchChooser(onResynthesisLoad);
+    }
+
+    /** Open fileChooser and show the outcome of `load` in the file label. */
+    void launchChooser(const FileLoadCallback& load)
+    {
         fileChooser->launchAsync(
             juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
-            [this](const juce::FileChooser& fc)
+            [this, &load](const juce::FileChooser& fc)
             {
                 auto file = fc.getResult();
-                if (file.existsAsFile() && onFileLoad)
+                if (file.existsAsFile() && load)
                 {
-                    if (onFileLoad(file))
-                    {
-                        fileLabel.setText(file.getFileName(), juce::dontSendNotification);
-                        fileLabel.setColour(juce::Label::textColourId, Colors::waveformGreen);
-                    }
+                    if (load(file))
+                        setFileStatus(file.getFileName(), true);
                     else
-                    {
-                        fileLabel.setText("Failed to load", juce::dontSendNotification);
-                        fileLabel.setColour(juce::Label::textColourId, Colors::accent);
-                    }
+                        setFileStatus("Failed to load", false);
                 }
             });
     }
@@ -1,6 +1,6 @@
 /*
   ==============================================================================
-    UnisonOutputSection.h - Unison + stereo width + master gain controls
+    UnisonOutputSection.h - Unison + stereo width + noise + master gain controls
   ==============================================================================
 */
 
@@ -20,6 +20,12 @@ public:
               { "Voices", "",   "unisonCount" },
               { "Detune", "ct", "unisonDetune" },
               { "Width",  "",   "stereoWidth" },
+              { "U.Mode", "",   "unisonMode" },
+              { "Sp.Pan", "",   "spectralPanMode" },
+              { "Sp.Wid", "",   "spectralPanWidth" },
+              { "Noise",  "",   "noiseLevel" },
+              { "N.Tilt", "dB", "noiseTilt" },
+              { "N.Shp",  "",   "noiseSource" },
               { "Gain",   "dB", "masterGain" }
           }, 0) // knobHeight=0: knobs fill the entire content area
     {
@@ -12,20 +12,28 @@ AdditiveSynthesizerAudioProcessorEditor::AdditiveSynthesizerAudioProcessorEditor
     AdditiveSynthesizerAudioProcessor& p)
     : AudioProcessorEditor(&p),
       audioProcessor(p),
-      oscillatorSection(p.getAPVTS()),
+      oscillatorSection(p.getAPVTS(), {
+          [&p](int slot) { p.storeMorphSlot(slot); },
+          [&p](int slot, const juce::File& f) { return p.loadMorphSlot(slot, f); },
+          [&p](int slot) { p.clearMorphSlot(slot); },
+          [&p](int slot) { return p.isMorphSlotFilled(slot); } }),
       spectralFilterSection(p.getAPVTS(),
-          [&p](const juce::File& f) { return p.getWaveformAnalyzer().loadFile(f); }),
+          [&p](const juce::File& f) { return p.getWaveformAnalyzer().loadFile(f); },
+          [&p](const juce::File& f) { return p.loadPartialRatios(f); },
+          [&p](const juce::File& f) { return p.loadResynthesisSample(f); }),
       envelopeSection(p.getAPVTS()),
       unisonOutputSection(p.getAPVTS()),
+      modulationSection(p.getAPVTS()),
       midiKeyboard(p.getKeyboardState(), juce::MidiKeyboardComponent::horizontalKeyboard)
 {
     setLookAndFeel(&customLookAndFeel);
-    setSize(900, 680);
+    setSize(900, 870);
 
     addAndMakeVisible(oscillatorSection);
     addAndMakeVisible(spectralFilterSection);
     addAndMakeVisible(envelopeSection);
     addAndMakeVisible(unisonOutputSection);
+    addAndMakeVisible(modulationSection);
     addAndMakeVisible(midiKeyboard);
 
     // Style the keyboard to match the dark theme
@@ -42,6 +50,20 @@ AdditiveSynthesizerAudioProcessorEditor::AdditiveSynthesizerAudioProcessorEditor
     // Set up visualization
     oscillatorSection.setVisualizationBuffer(&p.getVisualizationBuffer());
 
+    // Trace capture toggle (the plugin formats use ADDITIVE_SYNTH_TRACE instead)
+    if (p.wrapperType == juce::AudioProcessor::wrapperType_Standalone)
+    {
+        traceButton.setButtonText("TRACE");
+        traceButton.setTooltip("Record an audio-thread timeline (Chrome trace JSON)");
+        traceButton.onClick = [this]() { toggleTrace(); };
+        addAndMakeVisible(traceButton);
+
+        recordButton.setButtonText("REC");
+        recordButton.setTooltip("Record the output to a WAV or FLAC file");
+        recordButton.onClick = [this]() { toggleRecording(); };
+        addAndMakeVisible(recordButton);
+    }
+
     startTimerHz(20);
 }
 
@@ -70,6 +92,20 @@ void AdditiveSynthesizerAudioProcessorEditor::paint(juce::Graphics& g)
     g.drawText("Poly: 8  |  v0.1", headerBounds.reduced(12.0f, 0.0f),
                juce::Justification::centredRight);
 
+    if (shownRecordingStatus.isNotEmpty())
+    {
+        g.setColour(gui::Colors::accent);
+        g.drawText(shownRecordingStatus, headerBounds.reduced(170.0f, 0.0f),
+                   juce::Justification::centredLeft);
+    }
+
+    if (shownOverruns > 0)
+    {
+        g.setColour(gui::Colors::accent);
+        g.drawText("Overruns: " + juce::String(shownOverruns), headerBounds.reduced(260.0f, 0.0f),
+                   juce::Justification::centredRight);
+    }
+
     // Subtle separator line
     g.setColour(gui::Colors::panelBorder.withAlpha(0.4f));
     g.drawHorizontalLine(30, 0.0f, static_cast<float>(getWidth()));
@@ -78,7 +114,14 @@ void AdditiveSynthesizerAudioProcessorEditor::paint(juce::Graphics& g)
 void AdditiveSynthesizerAudioProcessorEditor::resized()
 {
     auto bounds = getLocalBounds();
-    bounds.removeFromTop(32); // Header
+
+    auto headerBounds = bounds.removeFromTop(30);
+    headerBounds.removeFromRight(110); // "Poly | version" text
+    traceButton.setBounds(headerBounds.removeFromRight(64).reduced(0, 5));
+    headerBounds.removeFromRight(4);
+    recordButton.setBounds(headerBounds.removeFromRight(52).reduced(0, 5));
+
+    bounds.removeFromTop(2); // Header separator
 
     // MIDI Keyboard at the bottom — scale key width to fill entire width
     auto keyboardBounds = bounds.removeFromBottom(50);
@@ -89,6 +132,10 @@ void AdditiveSynthesizerAudioProcessorEditor::resized()
 
     bounds = bounds.reduced(6);
 
+    // Modulation row above the keyboard: sources on top, routing slots below
+    modulationSection.setBounds(bounds.removeFromBottom(190).reduced(2));
+    bounds.removeFromBottom(2);
+
     // Top half: Oscillator (left) | Spectral Filter (right)
     auto topHalf = bounds.removeFromTop(bounds.getHeight() * 55 / 100);
     const int topSplit = topHalf.getWidth() * 38 / 100; // 38% for oscillator
@@ -104,8 +151,106 @@ void AdditiveSynthesizerAudioProcessorEditor::resized()
     unisonOutputSection.setBounds(bottomHalf.reduced(2));
 }
 
+void AdditiveSynthesizerAudioProcessorEditor::toggleTrace()
+{
+    auto& recorder = audioProcessor.getSynthEngine().getTraceRecorder();
+
+    if (recorder.isRecording())
+    {
+        recorder.stop();
+        traceButton.setTooltip("Last trace: " + recorder.getOutputFile().getFullPathName());
+    }
+    else if (!recorder.start(synth::TraceRecorder::getDefaultOutputFile(), synth::kMaxPolyphony))
+    {
+        traceButton.setTooltip("Could not open the trace file for writing");
+    }
+}
+
+void AdditiveSynthesizerAudioProcessorEditor::toggleRecording()
+{
+    auto& recorder = audioProcessor.getRecorder();
+
+    if (recorder.isRecording())
+    {
+        recorder.stop();
+        recordButton.setTooltip("Last take: " + recorder.getOutputFile().getFullPathName());
+        return;
+    }
+
+    juce::PopupMenu menu;
+    menu.addItem("Record WAV (24-bit)", [this]() { startRecording("wav"); });
+    menu.addItem("Record FLAC (24-bit)", [this]() { startRecording("flac"); });
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&recordButton));
+}
+
+void AdditiveSynthesizerAudioProcessorEditor::startRecording(const juce::String& extension)
+{
+    const auto file = synth::AudioRecorder::getDefaultOutputFile(extension);
+
+    if (!audioProcessor.getRecorder().start(file, audioProcessor.getSampleRate(),
+                                            audioProcessor.getTotalNumOutputChannels()))
+        recordButton.setTooltip("Could not open " + file.getFullPathName() + " for writing");
+}
+
+juce::String AdditiveSynthesizerAudioProcessorEditor::getRecordingStatus() const
+{
+    const auto& recorder = audioProcessor.getRecorder();
+    if (!recorder.isRecording())
+        return {};
+
+    const int seconds = static_cast<int>(recorder.getRecordedSeconds());
+    juce::String status = "REC " + juce::String(seconds / 60).paddedLeft('0', 2) + ":"
+                          + juce::String(seconds % 60).paddedLeft('0', 2);
+
+    if (const auto dropped = recorder.getNumDroppedBlocks(); dropped > 0)
+        status << "  (dropped " << dropped << " blocks)";
+
+    return status;
+}
+
 void AdditiveSynthesizerAudioProcessorEditor::timerCallback()
 {
+    traceButton.setToggleState(audioProcessor.getSynthEngine().getTraceRecorder().isRecording(),
+                               juce::dontSendNotification);
+    recordButton.setToggleState(audioProcessor.getRecorder().isRecording(), juce::dontSendNotification);
+    oscillatorSection.refreshMorphSlots();
+
+    if (const auto status = getRecordingStatus(); status != shownRecordingStatus)
+    {
+        shownRecordingStatus = status;
+        repaint(getLocalBounds().removeFromTop(30));
+    }
+
+    // Surface deadline misses: counter in the header, full snapshot in the log
+    auto& deadlineMonitor = audioProcessor.getSynthEngine().getDeadlineMonitor();
+    if (deadlineMonitor.retrieve(overrunSnapshot))
+        juce::Logger::writeToLog(overrunSnapshot.describe());
+
+    const auto overruns = deadlineMonitor.getStats().overruns;
+    if (overruns != shownOverruns)
+    {
+        shownOverruns = overruns;
+        repaint(getLocalBounds().removeFromTop(30));
+    }
+
+    // Resynthesis analysis runs in the background; report its progress and outcome
+    const auto& partialTrackLoader = audioProcessor.getPartialTrackLoader();
+    if (partialTrackLoader.isAnalysing())
+    {
+        shownAnalysing = true;
+        spectralFilterSection.setFileStatus("Analysing " + partialTrackLoader.getFile().getFileName() + " "
+                                                + juce::String(juce::roundToInt(partialTrackLoader.getProgress() * 100.0f)) + "%",
+                                            true);
+    }
+    else if (shownAnalysing)
+    {
+        shownAnalysing = false;
+        spectralFilterSection.setFileStatus(partialTrackLoader.hasFailed()
+                                                ? "Analysis failed"
+                                                : partialTrackLoader.getFile().getFileName() + " (resynthesis)",
+                                            !partialTrackLoader.hasFailed());
+    }
+
     // Update spectrum display with current harmonic data
     const auto* harmonicData = audioProcessor.getSynthEngine().getActiveHarmonicData();
 
@@ -13,6 +13,7 @@
 #include "GUI/SpectralFilterSection.h"
 #include "GUI/EnvelopeSection.h"
 #include "GUI/UnisonOutputSection.h"
+#include "GUI/ModulationSection.h"
 // Note: Section classes now use SectionBase (see GUI/SectionBase.h & GUI/KnobStrip.h)
 
 class AdditiveSynthesizerAudioProcessorEditor : public juce::AudioProcessorEditor,
@@ -35,9 +36,30 @@ private:
     gui::SpectralFilterSection  spectralFilterSection;
     gui::EnvelopeSection        envelopeSection;
     gui::UnisonOutputSection    unisonOutputSection;
+    gui::ModulationSection      modulationSection;
 
     juce::MidiKeyboardComponent midiKeyboard;
 
+    // Standalone only: start/stop a Chrome-trace capture of the audio thread
+    juce::TextButton traceButton;
+
+    void toggleTrace();
+
+    // Standalone only: record the output to disk (WAV or FLAC, chosen from a menu)
+    juce::TextButton recordButton;
+    juce::String shownRecordingStatus;
+
+    void toggleRecording();
+    void startRecording(const juce::String& extension);
+    juce::String getRecordingStatus() const;
+
+    // Deadline misses reported in the header; snapshots go to the JUCE logger
+    juce::int64 shownOverruns = 0;
+    synth::EngineSnapshot overrunSnapshot;
+
+    // Whether the file label is showing resynthesis analysis progress
+    bool shownAnalysing = false;
+
     // Preview harmonic data for spectrum display when no note is active
     synth::HarmonicData previewHarmonics;
 
@@ -5,11 +5,22 @@
 */
 
 #include "PluginProcessor.h"
-#include "PluginEditor.h"
+
+// Command-line tools build the processor without its editor (and GUI sources)
+#ifndef ADDITIVE_SYNTH_HEADLESS
+ #define ADDITIVE_SYNTH_HEADLESS 0
+#endif
+
+#if ! ADDITIVE_SYNTH_HEADLESS
+ #include "PluginEditor.h"
+#endif
 
 //==============================================================================
 static constexpr float kDegreesToRadians = juce::MathConstants<float>::twoPi / 360.0f;
 
+/** State properties holding morph slots A-D. */
+static const char* const kMorphSlotProperties[] = { "morphSlotA", "morphSlotB", "morphSlotC", "morphSlotD" };
+
 //==============================================================================
 AdditiveSynthesizerAudioProcessor::AdditiveSynthesizerAudioProcessor()
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -24,10 +35,73 @@ AdditiveSynthesizerAudioProcessor::AdditiveSynthesizerAudioProcessor()
       apvts(*this, nullptr, "Parameters", createParameterLayout())
 #endif
 {
+    parameters.oscRatio      = apvts.getRawParameterValue("oscRatio");
+    parameters.sawPhase      = apvts.getRawParameterValue("sawPhase");
+    parameters.sqrPhase      = apvts.getRawParameterValue("sqrPhase");
+    parameters.pitchBendRange    = apvts.getRawParameterValue("pitchBendRange");
+    parameters.glideMode         = apvts.getRawParameterValue("glideMode");
+    parameters.glideTime         = apvts.getRawParameterValue("glideTime");
+    parameters.mpeEnabled        = apvts.getRawParameterValue("mpeEnabled");
+    parameters.mpePitchBendRange = apvts.getRawParameterValue("mpePitchBendRange");
+    parameters.filterCutoff  = apvts.getRawParameterValue("filterCutoff");
+    parameters.filterBoost   = apvts.getRawParameterValue("filterBoost");
+    parameters.filterPhase   = apvts.getRawParameterValue("filterPhase");
+    parameters.filterStretch = apvts.getRawParameterValue("filterStretch");
+    parameters.partialTuning       = apvts.getRawParameterValue("partialTuning");
+    parameters.stringInharmonicity = apvts.getRawParameterValue("stringInharmonicity");
+    parameters.waveFilterMix = apvts.getRawParameterValue("waveFilterMix");
+    parameters.morphAmount   = apvts.getRawParameterValue("morphAmount");
+    parameters.morphPosition = apvts.getRawParameterValue("morphPosition");
+    parameters.oscSource        = apvts.getRawParameterValue("oscSource");
+    parameters.resynthesisSpeed = apvts.getRawParameterValue("resynthesisSpeed");
+    parameters.noiseLevel    = apvts.getRawParameterValue("noiseLevel");
+    parameters.noiseTilt     = apvts.getRawParameterValue("noiseTilt");
+    parameters.noiseSource   = apvts.getRawParameterValue("noiseSource");
+    parameters.unisonCount   = apvts.getRawParameterValue("unisonCount");
+    parameters.unisonDetune  = apvts.getRawParameterValue("unisonDetune");
+    parameters.stereoWidth   = apvts.getRawParameterValue("stereoWidth");
+    parameters.unisonMode    = apvts.getRawParameterValue("unisonMode");
+    parameters.spectralPanMode  = apvts.getRawParameterValue("spectralPanMode");
+    parameters.spectralPanWidth = apvts.getRawParameterValue("spectralPanWidth");
+    parameters.spectralPanSeed  = apvts.getRawParameterValue("spectralPanSeed");
+    parameters.envAttack     = apvts.getRawParameterValue("envAttack");
+    parameters.envDecay      = apvts.getRawParameterValue("envDecay");
+    parameters.envSustain    = apvts.getRawParameterValue("envSustain");
+    parameters.envRelease    = apvts.getRawParameterValue("envRelease");
+    parameters.partialDecayTilt   = apvts.getRawParameterValue("partialDecayTilt");
+    parameters.partialAttackDelay = apvts.getRawParameterValue("partialAttackDelay");
+    for (int i = 0; i < synth::ModulationSettings::kNumLfos; ++i)
+    {
+        const juce::String prefix = "lfo" + juce::String(i + 1);
+        parameters.lfoRate[static_cast<size_t>(i)]  = apvts.getRawParameterValue(prefix + "Rate");
+        parameters.lfoShape[static_cast<size_t>(i)] = apvts.getRawParameterValue(prefix + "Shape");
+    }
+    parameters.modEnvAttack  = apvts.getRawParameterValue("modEnvAttack");
+    parameters.modEnvDecay   = apvts.getRawParameterValue("modEnvDecay");
+    parameters.modEnvSustain = apvts.getRawParameterValue("modEnvSustain");
+    parameters.modEnvRelease = apvts.getRawParameterValue("modEnvRelease");
+    for (int i = 0; i < synth::ModulationSettings::kNumSlots; ++i)
+    {
+        const juce::String prefix = "mod" + juce::String(i + 1);
+        parameters.modSource[static_cast<size_t>(i)]      = apvts.getRawParameterValue(prefix + "Source");
+        parameters.modDestination[static_cast<size_t>(i)] = apvts.getRawParameterValue(prefix + "Dest");
+        parameters.modAmount[static_cast<size_t>(i)]      = apvts.getRawParameterValue(prefix + "Amount");
+    }
+    parameters.masterGain    = apvts.getRawParameterValue("masterGain");
+
+    keyboardState.addListener(this);
+    startTimerHz(30);
+
+    // Tracing can be requested without any UI (e.g. inside a host) via the environment
+    const auto traceFile = synth::TraceRecorder::getFileFromEnvironment();
+    if (traceFile != juce::File())
+        synthEngine.getTraceRecorder().start(traceFile, synth::kMaxPolyphony);
 }
 
 AdditiveSynthesizerAudioProcessor::~AdditiveSynthesizerAudioProcessor()
 {
+    stopTimer();
+    keyboardState.removeListener(this);
 }
 
 //==============================================================================
@@ -49,10 +123,31 @@ AdditiveSynthesizerAudioProcessor::createParameterLayout()
         juce::ParameterID{ "sqrPhase", 1 }, "Square Phase",
         juce::NormalisableRange<float>(0.0f, 360.0f, 0.1f), 0.0f));
 
+    // --- Pitch: bend, glide, MPE (member channels bend their own note) ---
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ "pitchBendRange", 1 }, "Pitch Bend Range",
+        juce::NormalisableRange<float>(0.0f, 24.0f, 1.0f), 2.0f));
+
+    params.push_back(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID{ "glideMode", 1 }, "Glide",
+        juce::StringArray{ "Off", "Always", "Legato" }, 0));
+
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ "glideTime", 1 }, "Glide Time",
+        juce::NormalisableRange<float>(0.0f, 2.0f, 0.001f, 0.4f), 0.1f));
+
+    params.push_back(std::make_unique<juce::AudioParameterBool>(
+        juce::ParameterID{ "mpeEnabled", 1 }, "MPE", false));
+
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ "mpePitchBendRange", 1 }, "MPE Bend Range",
+        juce::NormalisableRange<float>(1.0f, 96.0f, 1.0f), 48.0f));
+
     // --- Spectral Filter ---
     params.push_back(std::make_unique<juce::AudioParameterFloat>(
         juce::ParameterID{ "filterCutoff", 1 }, "Spectral Cutoff",
-        juce::NormalisableRange<float>(1.0f, 256.0f, 0.1f, 0.5f), 128.0f));
+        juce::NormalisableRange<float>(1.0f, static_cast<float>(synth::kMaxHarmonics), 0.1f, 0.5f),
+        static_cast<float>(synth::kMaxHarmonics) * 0.5f));
 
     params.push_back(std::make_unique<juce::AudioParameterFloat>(
         juce::ParameterID{ "filterBoost", 1 }, "Boost",
@@ -66,14 +161,54 @@ AdditiveSynthesizerAudioProcessor::createParameterLayout()
         juce::ParameterID{ "filterStretch", 1 }, "Harmonic Stretch",
         juce::NormalisableRange<float>(0.5f, 2.0f, 0.01f), 1.0f));
 
+    // Partial frequency model; the stretch above applies on top of it
+    params.push_back(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID{ "partialTuning", 1 }, "Partial Tuning",
+        juce::StringArray{ "Harmonic", "Stiff String", "Bar", "Bell", "Membrane", "Custom" }, 0));
+
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ "stringInharmonicity", 1 }, "String Inharmonicity",
+        juce::NormalisableRange<float>(0.0f, 0.02f, 0.00001f, 0.3f), 0.001f));
+
     // --- Waveform Filter ---
     params.push_back(std::make_unique<juce::AudioParameterFloat>(
         juce::ParameterID{ "waveFilterMix", 1 }, "Waveform Filter Mix",
         juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.0f));
 
+    // --- Spectral Morph (slots A-D are stored with the state, not as parameters) ---
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ "morphAmount", 1 }, "Morph Amount",
+        juce::NormalisableRange<float>(0.0f, 1.0f, 0.001f), 0.0f));
+
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ "morphPosition", 1 }, "Morph Position",
+        juce::NormalisableRange<float>(0.0f, 1.0f, 0.001f), 0.0f));
+
+    // --- Resynthesis (the analysed sample is stored with the state, not as a parameter) ---
+    params.push_back(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID{ "oscSource", 1 }, "Source",
+        juce::StringArray{ "Oscillator", "Resynthesis" }, 0));
+
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ "resynthesisSpeed", 1 }, "Resynthesis Speed",
+        juce::NormalisableRange<float>(0.0f, 4.0f, 0.01f, 0.5f), 1.0f));
+
+    // --- Residual Noise ---
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ "noiseLevel", 1 }, "Noise Level",
+        juce::NormalisableRange<float>(0.0f, 1.0f, 0.001f, 0.5f), 0.0f));
+
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ "noiseTilt", 1 }, "Noise Tilt",
+        juce::NormalisableRange<float>(-12.0f, 12.0f, 0.1f), -3.0f));
+
+    params.push_back(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID{ "noiseSource", 1 }, "Noise Shape",
+        juce::StringArray{ "Tilt", "Waveform" }, 0));
+
     // --- Unison ---
     params.push_back(std::make_unique<juce::AudioParameterInt>(
-        juce::ParameterID{ "unisonCount", 1 }, "Unison Voices", 1, 8, 1));
+        juce::ParameterID{ "unisonCount", 1 }, "Unison Voices", 1, synth::kMaxUnisonVoices, 1));
 
     params.push_back(std::make_unique<juce::AudioParameterFloat>(
         juce::ParameterID{ "unisonDetune", 1 }, "Detune",
@@ -83,6 +218,23 @@ AdditiveSynthesizerAudioProcessor::createParameterLayout()
         juce::ParameterID{ "stereoWidth", 1 }, "Stereo Width",
         juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.5f));
 
+    // Economy renders each voice once and stacks chorused copies of the mix
+    params.push_back(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID{ "unisonMode", 1 }, "Unison Mode",
+        juce::StringArray{ "Per Voice", "Economy" }, 0));
+
+    // --- Spectral panning (per-partial stereo position) ---
+    params.push_back(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID{ "spectralPanMode", 1 }, "Spectral Pan",
+        juce::StringArray{ "Off", "Alternate", "Frequency", "Random" }, 0));
+
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ "spectralPanWidth", 1 }, "Spectral Pan Width",
+        juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 1.0f));
+
+    params.push_back(std::make_unique<juce::AudioParameterInt>(
+        juce::ParameterID{ "spectralPanSeed", 1 }, "Spectral Pan Seed", 1, 1000, 1));
+
     // --- ADSR ---
     params.push_back(std::make_unique<juce::AudioParameterFloat>(
         juce::ParameterID{ "envAttack", 1 }, "Attack",
@@ -100,6 +252,64 @@ AdditiveSynthesizerAudioProcessor::createParameterLayout()
         juce::ParameterID{ "envRelease", 1 }, "Release",
         juce::NormalisableRange<float>(0.001f, 10.0f, 0.001f, 0.3f), 0.3f));
 
+    // Per-partial envelopes: decay time falls as 1/n^tilt, attack starts later per octave
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ "partialDecayTilt", 1 }, "Decay Tilt",
+        juce::NormalisableRange<float>(0.0f, 2.0f, 0.01f), 0.0f));
+
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ "partialAttackDelay", 1 }, "Attack Spread",
+        juce::NormalisableRange<float>(0.0f, 0.25f, 0.001f, 0.5f), 0.0f));
+
+    // --- Modulation: two LFOs, a mod envelope, and slots routing sources to voice parameters ---
+    for (int i = 1; i <= synth::ModulationSettings::kNumLfos; ++i)
+    {
+        params.push_back(std::make_unique<juce::AudioParameterFloat>(
+            juce::ParameterID{ "lfo" + juce::String(i) + "Rate", 1 }, "LFO " + juce::String(i) + " Rate",
+            juce::NormalisableRange<float>(0.01f, 30.0f, 0.01f, 0.3f), 2.0f));
+
+        params.push_back(std::make_unique<juce::AudioParameterChoice>(
+            juce::ParameterID{ "lfo" + juce::String(i) + "Shape", 1 }, "LFO " + juce::String(i) + " Shape",
+            juce::StringArray{ "Sine", "Triangle", "Saw", "Square", "S&H" }, 0));
+    }
+
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ "modEnvAttack", 1 }, "Mod Env Attack",
+        juce::NormalisableRange<float>(0.001f, 5.0f, 0.001f, 0.3f), 0.01f));
+
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ "modEnvDecay", 1 }, "Mod Env Decay",
+        juce::NormalisableRange<float>(0.001f, 5.0f, 0.001f, 0.3f), 0.3f));
+
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ "modEnvSustain", 1 }, "Mod Env Sustain",
+        juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.0f));
+
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ "modEnvRelease", 1 }, "Mod Env Release",
+        juce::NormalisableRange<float>(0.001f, 10.0f, 0.001f, 0.3f), 0.3f));
+
+    // Same order as synth::ModSource and synth::ModDestination
+    const juce::StringArray modSources{ "Off", "LFO 1", "LFO 2", "Mod Env", "Velocity", "Aftertouch", "Mod Wheel", "Key" };
+    const juce::StringArray modDestinations{ "Off", "Pitch", "Saw/Square", "Cutoff", "Boost", "Phase", "Stretch",
+                                             "Wave Mix", "Morph", "Morph Pos", "Resynth Speed", "Noise",
+                                             "Detune", "Width", "Spectral Width" };
+
+    for (int i = 1; i <= synth::ModulationSettings::kNumSlots; ++i)
+    {
+        const juce::String name = "Mod " + juce::String(i);
+
+        params.push_back(std::make_unique<juce::AudioParameterChoice>(
+            juce::ParameterID{ "mod" + juce::String(i) + "Source", 1 }, name + " Source", modSources, 0));
+
+        params.push_back(std::make_unique<juce::AudioParameterChoice>(
+            juce::ParameterID{ "mod" + juce::String(i) + "Dest", 1 }, name + " Destination", modDestinations, 0));
+
+        params.push_back(std::make_unique<juce::AudioParameterFloat>(
+            juce::ParameterID{ "mod" + juce::String(i) + "Amount", 1 }, name + " Amount",
+            juce::NormalisableRange<float>(-1.0f, 1.0f, 0.001f), 0.0f));
+    }
+
     // --- Master ---
     params.push_back(std::make_unique<juce::AudioParameterFloat>(
         juce::ParameterID{ "masterGain", 1 }, "Master Gain",
@@ -113,32 +323,110 @@ void AdditiveSynthesizerAudioProcessor::updateSynthParameters()
 {
     auto& vp = synthEngine.getVoiceParams();
 
-    vp.oscRatio      = apvts.getRawParameterValue("oscRatio")->load();
-    vp.sawPhase      = apvts.getRawParameterValue("sawPhase")->load() * kDegreesToRadians;
-    vp.sqrPhase      = apvts.getRawParameterValue("sqrPhase")->load() * kDegreesToRadians;
+    vp.oscRatio      = parameters.oscRatio->load();
+    vp.sawPhase      = parameters.sawPhase->load() * kDegreesToRadians;
+    vp.sqrPhase      = parameters.sqrPhase->load() * kDegreesToRadians;
 
-    vp.filterCutoff  = apvts.getRawParameterValue("filterCutoff")->load();
-    vp.filterBoost   = apvts.getRawParameterValue("filterBoost")->load();
-    vp.filterPhase   = apvts.getRawParameterValue("filterPhase")->load() * kDegreesToRadians;
-    vp.filterStretch = apvts.getRawParameterValue("filterStretch")->load();
+    vp.pitchBendRange    = parameters.pitchBendRange->load();
+    vp.glideMode         = static_cast<synth::GlideMode>(juce::roundToInt(parameters.glideMode->load()));
+    vp.glideTime         = parameters.glideTime->load();
+    vp.mpeEnabled        = parameters.mpeEnabled->load() >= 0.5f;
+    vp.mpePitchBendRange = parameters.mpePitchBendRange->load();
 
-    vp.waveFilterMix     = apvts.getRawParameterValue("waveFilterMix")->load();
+    vp.filterCutoff  = parameters.filterCutoff->load();
+    vp.filterBoost   = parameters.filterBoost->load();
+    vp.filterPhase   = parameters.filterPhase->load() * kDegreesToRadians;
+    vp.filterStretch = parameters.filterStretch->load();
+
+    vp.partialTuning       = static_cast<synth::PartialTuning>(juce::roundToInt(parameters.partialTuning->load()));
+    vp.stringInharmonicity = parameters.stringInharmonicity->load();
+    if (vp.partialTuning == synth::PartialTuning::custom)
+    {
+        const juce::SpinLock::ScopedTryLockType lock(customPartialRatiosLock);
+        if (lock.isLocked())
+        {
+            vp.numCustomPartialRatios = static_cast<int>(customPartialRatios.size());
+            std::copy(customPartialRatios.begin(), customPartialRatios.end(), vp.customPartialRatios.begin());
+        }
+    }
+
+    vp.waveFilterMix     = parameters.waveFilterMix->load();
     vp.waveFilterEnabled = waveformAnalyzer.isFileLoaded();
     if (vp.waveFilterEnabled)
         vp.waveFilterSpectrum = waveformAnalyzer.getSpectralEnvelope();
 
-    vp.envAttack  = apvts.getRawParameterValue("envAttack")->load();
-    vp.envDecay   = apvts.getRawParameterValue("envDecay")->load();
-    vp.envSustain = apvts.getRawParameterValue("envSustain")->load();
-    vp.envRelease = apvts.getRawParameterValue("envRelease")->load();
+    vp.resynthesisEnabled = parameters.oscSource->load() >= 0.5f;
+    vp.resynthesisSpeed   = parameters.resynthesisSpeed->load();
+    if (const int version = partialLibraryVersion.load(); version != partialLibraryVersionApplied)
+    {
+        const juce::SpinLock::ScopedTryLockType lock(partialLibraryLock);
+        if (lock.isLocked())
+        {
+            // The retained list still holds the previous library, so this never frees it here
+            livePartialLibrary = publishedPartialLibrary;
+            partialLibraryVersionApplied = version;
+        }
+    }
+    vp.partialLibrary = livePartialLibrary.get();
+    vp.partialPrefetcher = &partialPrefetcher;
+
+    vp.noiseLevel        = parameters.noiseLevel->load();
+    vp.noiseTilt         = parameters.noiseTilt->load();
+    vp.noiseFromWaveform = parameters.noiseSource->load() >= 0.5f;
+
+    vp.morphAmount   = parameters.morphAmount->load();
+    vp.morphPosition = parameters.morphPosition->load();
+    if (const int version = morphSlotsVersion.load(); version != morphSlotsVersionApplied)
+    {
+        const juce::SpinLock::ScopedTryLockType lock(morphSlotsLock);
+        if (lock.isLocked())
+        {
+            vp.morphSlots = morphSlots;
+            morphSlotsVersionApplied = version;
+        }
+    }
+
+    vp.envAttack  = parameters.envAttack->load();
+    vp.envDecay   = parameters.envDecay->load();
+    vp.envSustain = parameters.envSustain->load();
+    vp.envRelease = parameters.envRelease->load();
+    vp.partialDecayTilt   = parameters.partialDecayTilt->load();
+    vp.partialAttackDelay = parameters.partialAttackDelay->load();
+
+    // Modulation matrix, evaluated per voice at control rate
+    auto& modulation = vp.modulation;
+    for (size_t i = 0; i < modulation.lfos.size(); ++i)
+    {
+        modulation.lfos[i].rateHz = parameters.lfoRate[i]->load();
+        modulation.lfos[i].shape  = static_cast<synth::LfoShape>(juce::roundToInt(parameters.lfoShape[i]->load()));
+    }
+    modulation.envelope = { parameters.modEnvAttack->load(), parameters.modEnvDecay->load(),
+                            parameters.modEnvSustain->load(), parameters.modEnvRelease->load() };
+    for (size_t i = 0; i < modulation.slots.size(); ++i)
+    {
+        auto& slot = modulation.slots[i];
+        slot.source      = static_cast<synth::ModSource>(juce::roundToInt(parameters.modSource[i]->load()));
+        slot.destination = static_cast<synth::ModDestination>(juce::roundToInt(parameters.modDestination[i]->load()));
+        slot.amount      = parameters.modAmount[i]->load();
+    }
 
     // Unison (rendered per-voice, not post-processed)
-    vp.unisonCount  = static_cast<int>(apvts.getRawParameterValue("unisonCount")->load());
-    vp.unisonDetune = apvts.getRawParameterValue("unisonDetune")->load();
-    vp.stereoWidth  = apvts.getRawParameterValue("stereoWidth")->load();
+    vp.unisonCount  = static_cast<int>(parameters.unisonCount->load());
+    vp.unisonDetune = parameters.unisonDetune->load();
+    vp.stereoWidth  = parameters.stereoWidth->load();
+    vp.unisonMode   = static_cast<synth::UnisonMode>(juce::roundToInt(parameters.unisonMode->load()));
+
+    vp.spectralPanMode  = static_cast<synth::SpectralPanMode>(juce::roundToInt(parameters.spectralPanMode->load()));
+    vp.spectralPanWidth = parameters.spectralPanWidth->load();
+    vp.spectralPanSeed  = juce::roundToInt(parameters.spectralPanSeed->load());
+
+    // Bounces and exports take the exact render path
+    vp.highQuality = isNonRealtime();
+    vp.realtimeSineKernel = realtimeSineKernel.load();
+    vp.offlineSineKernel  = offlineSineKernel.load();
 
     // Master
-    synthEngine.setMasterGain(apvts.getRawParameterValue("masterGain")->load());
+    synthEngine.setMasterGain(parameters.masterGain->load());
 }
 
 //==============================================================================
@@ -206,9 +494,22 @@ void AdditiveSynthesizerAudioProcessor::changeProgramName(int /*index*/,
 //==============================================================================
 void AdditiveSynthesizerAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
+    // A take can't change sample rate midway: a device restart ends it
+    if (recorder.isRecording() && sampleRate != recorder.getRecordingSampleRate())
+        recorder.stop();
+
     synthEngine.prepareToPlay(sampleRate, samplesPerBlock);
-    vizBuffer.setSize(2, samplesPerBlock);
+
+    // Everything the audio thread writes to is sized here, never in processBlock
+    vizCapacity = samplesPerBlock;
+    vizBuffer.setSize(2, vizCapacity);
     vizBuffer.clear();
+    mergedMidi.ensureSize(kMidiBufferBytes);
+}
+
+void AdditiveSynthesizerAudioProcessor::reset()
+{
+    synthEngine.reset();
 }
 
 void AdditiveSynthesizerAudioProcessor::releaseResources()
@@ -239,43 +540,140 @@ bool AdditiveSynthesizerAudioProcessor::isBusesLayoutSupported(const BusesLayout
 
 void AdditiveSynthesizerAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer,
                                                       juce::MidiBuffer& midiMessages)
+{
+    processSamples(buffer, midiMessages);
+}
+
+void AdditiveSynthesizerAudioProcessor::processBlock(juce::AudioBuffer<double>& buffer,
+                                                      juce::MidiBuffer& midiMessages)
+{
+    processSamples(buffer, midiMessages);
+}
+
+template <typename SampleType>
+void AdditiveSynthesizerAudioProcessor::processSamples(juce::AudioBuffer<SampleType>& buffer,
+                                                       juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
 
     // Clear buffer (synth output only, no input passthrough)
     buffer.clear();
 
-    // Merge on-screen keyboard MIDI events into the incoming buffer
-    keyboardState.processNextMidiBuffer(midiMessages, 0, buffer.getNumSamples(), true);
+    const int numSamples = buffer.getNumSamples();
+
+    // Mirror host notes to the on-screen keyboard (drained by timerCallback)
+    for (const auto metadata : midiMessages)
+    {
+        const int status = metadata.numBytes > 0 ? (metadata.data[0] & 0xf0) : 0;
+        if (status == 0x80 || status == 0x90 || (status == 0xb0 && metadata.numBytes > 1 && metadata.data[1] >= 120))
+            displayEvents.push(metadata.data, metadata.numBytes);
+    }
+
+    // Merge on-screen keyboard notes without taking the keyboard state's lock
+    juce::MidiBuffer* midiToRender = &midiMessages;
+    if (keyboardEvents.getNumReady() > 0)
+    {
+        mergedMidi.clear();
+        mergedMidi.addEvents(midiMessages, 0, numSamples, 0);
+        keyboardEvents.popAll([this](const juce::uint8* data, int numBytes)
+                              { mergedMidi.addEvent(data, numBytes, 0); });
+        midiToRender = &mergedMidi;
+    }
 
     // Update parameters from APVTS
     updateSynthParameters();
 
     // Render synth
-    synthEngine.processBlock(buffer, midiMessages);
+    synthEngine.processBlock(buffer, *midiToRender);
 
-    // Copy output for visualization
-    const int numSamples = buffer.getNumSamples();
-    vizBuffer.setSize(buffer.getNumChannels(), numSamples, false, false, true);
-    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
-        vizBuffer.copyFrom(ch, 0, buffer, ch, 0, numSamples);
+    // Copy output for visualization (within the capacity reserved in prepareToPlay)
+    const int numVizChannels = juce::jmin(buffer.getNumChannels(), 2);
+    const int numVizSamples = juce::jmin(numSamples, vizCapacity);
+    vizBuffer.setSize(numVizChannels, numVizSamples, false, false, true);
+    for (int ch = 0; ch < numVizChannels; ++ch)
+    {
+        if constexpr (std::is_same_v<SampleType, float>)
+        {
+            vizBuffer.copyFrom(ch, 0, buffer, ch, 0, numVizSamples);
+        }
+        else
+        {
+            const auto* source = buffer.getReadPointer(ch);
+            auto* dest = vizBuffer.getWritePointer(ch);
+            for (int i = 0; i < numVizSamples; ++i)
+                dest[i] = static_cast<float>(source[i]);
+        }
+    }
+
+    recorder.push(buffer, numSamples);
+}
+
+//==============================================================================
+void AdditiveSynthesizerAudioProcessor::handleNoteOn(juce::MidiKeyboardState*, int midiChannel,
+                                                     int midiNoteNumber, float velocity)
+{
+    if (!applyingDisplayEvents)
+        keyboardEvents.push(juce::MidiMessage::noteOn(midiChannel, midiNoteNumber, velocity));
+}
+
+void AdditiveSynthesizerAudioProcessor::handleNoteOff(juce::MidiKeyboardState*, int midiChannel,
+                                                      int midiNoteNumber, float velocity)
+{
+    if (!applyingDisplayEvents)
+        keyboardEvents.push(juce::MidiMessage::noteOff(midiChannel, midiNoteNumber, velocity));
+}
+
+void AdditiveSynthesizerAudioProcessor::timerCallback()
+{
+    // Updating the state notifies our own listener too; don't echo these back as input
+    const juce::ScopedValueSetter<bool> applying(applyingDisplayEvents, true);
+
+    displayEvents.popAll([this](const juce::uint8* data, int numBytes)
+                         { keyboardState.processNextMidiEvent(juce::MidiMessage(data, numBytes)); });
+
+    if (auto library = partialTrackLoader.takeResult())
+        publishPartialLibrary(std::move(library));
+
+    releaseRetiredPartialLibraries();
 }
 
 //==============================================================================
 bool AdditiveSynthesizerAudioProcessor::hasEditor() const
 {
-    return true;
+    return ! ADDITIVE_SYNTH_HEADLESS;
 }
 
 juce::AudioProcessorEditor* AdditiveSynthesizerAudioProcessor::createEditor()
 {
+#if ADDITIVE_SYNTH_HEADLESS
+    return nullptr;
+#else
     return new AdditiveSynthesizerAudioProcessorEditor(*this);
+#endif
 }
 
 //==============================================================================
 void AdditiveSynthesizerAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
     auto state = apvts.copyState();
+
+    {
+        const juce::SpinLock::ScopedLockType lock(customPartialRatiosLock);
+        juce::StringArray ratios;
+        for (const float ratio : customPartialRatios)
+            ratios.add(juce::String(ratio, 6));
+
+        state.setProperty("customPartialRatios", ratios.joinIntoString(" "), nullptr);
+    }
+
+    {
+        const juce::SpinLock::ScopedLockType lock(morphSlotsLock);
+        for (int slot = 0; slot < MorphSlots::kNumSlots; ++slot)
+            state.setProperty(kMorphSlotProperties[slot], morphSlots.slotToString(slot), nullptr);
+    }
+
+    state.setProperty("resynthesisFile", resynthesisFile.getFullPathName(), nullptr);
+
     std::unique_ptr<juce::XmlElement> xml(state.createXml());
     copyXmlToBinary(*xml, destData);
 }
@@ -286,8 +684,139 @@ void AdditiveSynthesizerAudioProcessor::setStateInformation(const void* data, in
     if (xmlState != nullptr)
     {
         if (xmlState->hasTagName(apvts.state.getType()))
+        {
             apvts.replaceState(juce::ValueTree::fromXml(*xmlState));
+            setCustomPartialRatios(synth::PartialRatios::parseRatios(
+                apvts.state.getProperty("customPartialRatios").toString()));
+
+            editMorphSlots([this](MorphSlots& slots)
+            {
+                for (int slot = 0; slot < MorphSlots::kNumSlots; ++slot)
+                    slots.slotFromString(slot, apvts.state.getProperty(kMorphSlotProperties[slot]).toString());
+            });
+
+            // A state without a (still existing) sample must not keep playing the previous one
+            const auto samplePath = apvts.state.getProperty("resynthesisFile").toString();
+            if (!(samplePath.isNotEmpty() && juce::File::isAbsolutePath(samplePath)
+                  && loadResynthesisSample(juce::File(samplePath))))
+                clearResynthesisSample();
+        }
+    }
+}
+
+bool AdditiveSynthesizerAudioProcessor::loadPartialRatios(const juce::File& file)
+{
+    auto ratios = synth::PartialRatios::parseRatios(file.loadFileAsString());
+    if (ratios.empty())
+        return false;
+
+    setCustomPartialRatios(std::move(ratios));
+    return true;
+}
+
+void AdditiveSynthesizerAudioProcessor::setCustomPartialRatios(std::vector<float> ratios)
+{
+    // parseRatios caps the count at the engine's partial capacity
+    jassert(ratios.size() <= static_cast<size_t>(synth::kMaxHarmonics));
+
+    const juce::SpinLock::ScopedLockType lock(customPartialRatiosLock);
+    customPartialRatios = std::move(ratios);
+}
+
+template <typename Function>
+void AdditiveSynthesizerAudioProcessor::editMorphSlots(Function&& edit)
+{
+    {
+        const juce::SpinLock::ScopedLockType lock(morphSlotsLock);
+        edit(morphSlots);
+    }
+
+    ++morphSlotsVersion;
+}
+
+void AdditiveSynthesizerAudioProcessor::storeMorphSlot(int slot)
+{
+    const auto spectrum = synthEngine.computeSpectrumSnapshot();
+    editMorphSlots([&](MorphSlots& slots) { slots.setSlot(slot, spectrum); });
+}
+
+bool AdditiveSynthesizerAudioProcessor::loadMorphSlot(int slot, const juce::File& file)
+{
+    MorphSlots::Spectrum spectrum;
+    if (!MorphSlots::loadCycleFile(file, spectrum))
+        return false;
+
+    editMorphSlots([&](MorphSlots& slots) { slots.setSlot(slot, spectrum); });
+    return true;
+}
+
+void AdditiveSynthesizerAudioProcessor::clearMorphSlot(int slot)
+{
+    editMorphSlots([slot](MorphSlots& slots) { slots.clearSlot(slot); });
+}
+
+bool AdditiveSynthesizerAudioProcessor::isMorphSlotFilled(int slot) const
+{
+    const juce::SpinLock::ScopedLockType lock(morphSlotsLock);
+    return morphSlots.isFilled(slot);
+}
+
+bool AdditiveSynthesizerAudioProcessor::loadResynthesisSample(const juce::File& file)
+{
+    if (!file.existsAsFile())
+        return false;
+
+    resynthesisFile = file;
+    partialTrackLoader.start(file);
+    return true;
+}
+
+void AdditiveSynthesizerAudioProcessor::clearResynthesisSample()
+{
+    resynthesisFile = juce::File();
+    partialTrackLoader.cancel();
+    publishPartialLibrary(nullptr);
+}
+
+bool AdditiveSynthesizerAudioProcessor::waitForResynthesisSample(int timeoutMs)
+{
+    if (!partialTrackLoader.waitUntilFinished(timeoutMs))
+        return false;
+
+    if (auto library = partialTrackLoader.takeResult())
+        publishPartialLibrary(std::move(library));
+
+    return !partialTrackLoader.hasFailed();
+}
+
+juce::String AdditiveSynthesizerAudioProcessor::getResynthesisSampleName() const
+{
+    const juce::SpinLock::ScopedLockType lock(partialLibraryLock);
+    return publishedPartialLibrary != nullptr ? publishedPartialLibrary->getName() : juce::String();
+}
+
+void AdditiveSynthesizerAudioProcessor::publishPartialLibrary(synth::PartialLibrary::Ptr library)
+{
+    if (library != nullptr)
+        retainedPartialLibraries.push_back(library);
+
+    partialPrefetcher.setLibrary(library);
+
+    {
+        const juce::SpinLock::ScopedLockType lock(partialLibraryLock);
+        publishedPartialLibrary = std::move(library);
     }
+
+    ++partialLibraryVersion;
+}
+
+void AdditiveSynthesizerAudioProcessor::releaseRetiredPartialLibraries()
+{
+    // A count of one is the retained list alone: neither published nor live on the audio thread
+    retainedPartialLibraries.erase(std::remove_if(retainedPartialLibraries.begin(), retainedPartialLibraries.end(),
+                                                  [](const synth::PartialLibrary::Ptr& library)
+                                                  { return library->getReferenceCount() == 1; }),
+                                   retainedPartialLibraries.end());
 }
 
 //==============================================================================
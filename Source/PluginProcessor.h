@@ -9,8 +9,13 @@
 #include <JuceHeader.h>
 #include "DSP/AdditiveSynthEngine.h"
 #include "DSP/WaveformAnalyzer.h"
+#include "DSP/PartialAnalysis.h"
+#include "DSP/MidiEventFifo.h"
+#include "DSP/AudioRecorder.h"
 
-class AdditiveSynthesizerAudioProcessor : public juce::AudioProcessor
+class AdditiveSynthesizerAudioProcessor : public juce::AudioProcessor,
+                                          private juce::MidiKeyboardState::Listener,
+                                          private juce::Timer
 {
 public:
     AdditiveSynthesizerAudioProcessor();
@@ -18,12 +23,15 @@ public:
 
     void prepareToPlay(double sampleRate, int samplesPerBlock) override;
     void releaseResources() override;
+    void reset() override;
 
 #ifndef JucePlugin_PreferredChannelConfigurations
     bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
 #endif
 
     void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock(juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override { return true; }
 
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override;
@@ -53,24 +61,202 @@ public:
     synth::WaveformAnalyzer& getWaveformAnalyzer() { return waveformAnalyzer; }
     const synth::WaveformAnalyzer& getWaveformAnalyzer() const { return waveformAnalyzer; }
 
-    /** Thread-safe snapshot of the last rendered output for visualization. */
+    /**
+     * Last rendered output for visualization. Allocated in prepareToPlay;
+     * larger blocks than announced there are truncated rather than reallocated.
+     */
     const juce::AudioBuffer<float>& getVisualizationBuffer() const { return vizBuffer; }
 
-    /** Keyboard state shared between editor and audio thread. */
+    /**
+     * Sine evaluation for live playback and for offline (non-realtime) renders;
+     * see synth::SineKernel for the accuracy of each. Defaults: table / exact.
+     * Safe to call from any thread; applied at the start of the next block.
+     */
+    void setSineKernels(synth::SineKernel realtime, synth::SineKernel offline) noexcept
+    {
+        realtimeSineKernel.store(realtime);
+        offlineSineKernel.store(offline);
+    }
+
+    /**
+     * Load a partial ratio table for the Custom tuning (see
+     * synth::PartialRatios::parseRatios for the text format). Message thread;
+     * returns false if the file holds no usable ratio. Saved with the state.
+     */
+    bool loadPartialRatios(const juce::File& file);
+
+    /**
+     * Morph slots (0..3 = A..D, see synth::BasicMorphSlots). Store the
+     * current oscillator and filter spectrum, or the spectrum of a
+     * single-cycle audio file, in a slot; or empty it. Message thread; the
+     * slots are saved with the state.
+     */
+    void storeMorphSlot(int slot);
+    bool loadMorphSlot(int slot, const juce::File& file);
+    void clearMorphSlot(int slot);
+    bool isMorphSlotFilled(int slot) const;
+
+    /**
+     * Load partial tracks for resynthesis on a background thread: a sample
+     * is analysed (see synth::PartialAnalysis), a partial data library
+     * (synth::PartialDataFile::kFileExtension) memory-mapped. The voices
+     * switch to the new tracks when it finishes. Message thread; returns
+     * false if the file doesn't exist. The file is remembered with the state
+     * and loaded again when the state is restored.
+     */
+    bool loadResynthesisSample(const juce::File& file);
+
+    /** Stop resynthesising: abandon any load and switch the voices to no tracks. Message thread. */
+    void clearResynthesisSample();
+
+    /**
+     * Wait for a resynthesis load in progress, then switch the voices to its
+     * tracks. The timer normally does this; headless tools, which run no
+     * message loop, call it after restoring a state. Message thread; returns
+     * false if the load failed or was still running after timeoutMs.
+     */
+    bool waitForResynthesisSample(int timeoutMs = -1);
+
+    /** The loader, for progress and failure reporting. */
+    const synth::PartialTrackLoader& getPartialTrackLoader() const { return partialTrackLoader; }
+
+    /** Name of the sample or library the voices resynthesise, empty if none. */
+    juce::String getResynthesisSampleName() const;
+
+    /** Direct-to-disk recorder fed with every output block; start/stop it from the message thread. */
+    synth::AudioRecorder& getRecorder() { return recorder; }
+
+    /**
+     * Keyboard state for the on-screen keyboard. Only touched on the message
+     * thread: its notes reach the audio thread through a lock-free FIFO, and
+     * host notes are mirrored back into it by a timer.
+     */
     juce::MidiKeyboardState& getKeyboardState() { return keyboardState; }
 
 private:
+    static constexpr int kKeyboardFifoSize = 512;
+    static constexpr int kMidiBufferBytes = 8192; // merged MIDI capacity reserved in prepareToPlay
+
+    /** Cached APVTS value pointers, so the audio thread never looks parameters up by name. */
+    struct ParameterPointers
+    {
+        std::atomic<float>* oscRatio = nullptr;
+        std::atomic<float>* sawPhase = nullptr;
+        std::atomic<float>* sqrPhase = nullptr;
+        std::atomic<float>* pitchBendRange = nullptr;
+        std::atomic<float>* glideMode = nullptr;
+        std::atomic<float>* glideTime = nullptr;
+        std::atomic<float>* mpeEnabled = nullptr;
+        std::atomic<float>* mpePitchBendRange = nullptr;
+        std::atomic<float>* filterCutoff = nullptr;
+        std::atomic<float>* filterBoost = nullptr;
+        std::atomic<float>* filterPhase = nullptr;
+        std::atomic<float>* filterStretch = nullptr;
+        std::atomic<float>* partialTuning = nullptr;
+        std::atomic<float>* stringInharmonicity = nullptr;
+        std::atomic<float>* waveFilterMix = nullptr;
+        std::atomic<float>* morphAmount = nullptr;
+        std::atomic<float>* morphPosition = nullptr;
+        std::atomic<float>* oscSource = nullptr;
+        std::atomic<float>* resynthesisSpeed = nullptr;
+        std::atomic<float>* noiseLevel = nullptr;
+        std::atomic<float>* noiseTilt = nullptr;
+        std::atomic<float>* noiseSource = nullptr;
+        std::atomic<float>* unisonCount = nullptr;
+        std::atomic<float>* unisonDetune = nullptr;
+        std::atomic<float>* stereoWidth = nullptr;
+        std::atomic<float>* unisonMode = nullptr;
+        std::atomic<float>* spectralPanMode = nullptr;
+        std::atomic<float>* spectralPanWidth = nullptr;
+        std::atomic<float>* spectralPanSeed = nullptr;
+        std::atomic<float>* envAttack = nullptr;
+        std::atomic<float>* envDecay = nullptr;
+        std::atomic<float>* envSustain = nullptr;
+        std::atomic<float>* envRelease = nullptr;
+        std::atomic<float>* partialDecayTilt = nullptr;
+        std::atomic<float>* partialAttackDelay = nullptr;
+        std::array<std::atomic<float>*, synth::ModulationSettings::kNumLfos> lfoRate{}, lfoShape{};
+        std::atomic<float>* modEnvAttack = nullptr;
+        std::atomic<float>* modEnvDecay = nullptr;
+        std::atomic<float>* modEnvSustain = nullptr;
+        std::atomic<float>* modEnvRelease = nullptr;
+        std::array<std::atomic<float>*, synth::ModulationSettings::kNumSlots> modSource{}, modDestination{}, modAmount{};
+        std::atomic<float>* masterGain = nullptr;
+    };
+
     juce::AudioProcessorValueTreeState apvts;
+    ParameterPointers parameters;
     juce::MidiKeyboardState keyboardState;
     synth::AdditiveSynthEngine synthEngine;
     synth::WaveformAnalyzer waveformAnalyzer;
+
+    // Custom tuning table; the audio thread only try-locks, keeping its last copy if contended
+    std::vector<float> customPartialRatios;
+    juce::SpinLock customPartialRatiosLock;
+
+    // Morph slots, copied to the voices when the version moves on (same try-lock rule)
+    using MorphSlots = synth::BasicMorphSlots<synth::kMaxHarmonics>;
+    MorphSlots morphSlots;
+    mutable juce::SpinLock morphSlotsLock;
+    std::atomic<int> morphSlotsVersion{ 0 };
+    int morphSlotsVersionApplied = -1; // audio thread
+
+    // Resynthesis tracks. The message thread publishes a library under the
+    // lock; the audio thread takes its own reference when the version moves
+    // on. Every published library stays in retainedPartialLibraries until only
+    // that list refers to it, so the audio thread never drops the last
+    // reference. The prefetcher holds one too while it pages a library in.
+    synth::PartialTrackLoader partialTrackLoader;
+    synth::PartialPrefetcher partialPrefetcher;
+    juce::File resynthesisFile;
+    synth::PartialLibrary::Ptr publishedPartialLibrary;
+    mutable juce::SpinLock partialLibraryLock;
+    std::atomic<int> partialLibraryVersion{ 0 };
+    synth::PartialLibrary::Ptr livePartialLibrary;  // audio thread
+    int partialLibraryVersionApplied = -1;          // audio thread
+    std::vector<synth::PartialLibrary::Ptr> retainedPartialLibraries;
+
     juce::AudioBuffer<float> vizBuffer;
+    int vizCapacity = 0;
+    synth::AudioRecorder recorder;
+    std::atomic<synth::SineKernel> realtimeSineKernel{ synth::SineKernel::table };
+    std::atomic<synth::SineKernel> offlineSineKernel{ synth::SineKernel::exact };
+
+    synth::MidiEventFifo<kKeyboardFifoSize> keyboardEvents; // message thread -> audio thread
+    synth::MidiEventFifo<kKeyboardFifoSize> displayEvents;  // audio thread -> keyboard display
+    juce::MidiBuffer mergedMidi;
+    bool applyingDisplayEvents = false;
 
     /** Create APVTS parameter layout. */
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
 
+    /** Replace the custom tuning table (message thread). */
+    void setCustomPartialRatios(std::vector<float> ratios);
+
+    /** Edit the morph slots under their lock and publish the change (message thread). */
+    template <typename Function>
+    void editMorphSlots(Function&& edit);
+
+    /** Hand a finished load to the voices, and free libraries nothing uses any more (message thread). */
+    void publishPartialLibrary(synth::PartialLibrary::Ptr tracks);
+    void releaseRetiredPartialLibraries();
+
     /** Pull APVTS parameter values and push them to the synth engine. */
     void updateSynthParameters();
 
+    /** Body of both processBlock overloads; the engine renders natively in SampleType. */
+    template <typename SampleType>
+    void processSamples(juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages);
+
+    // MidiKeyboardState::Listener (message thread)
+    void handleNoteOn(juce::MidiKeyboardState*, int midiChannel, int midiNoteNumber, float velocity) override;
+    void handleNoteOff(juce::MidiKeyboardState*, int midiChannel, int midiNoteNumber, float velocity) override;
+
+    /**
+     * Mirror host note events queued by the audio thread into the keyboard
+     * display, and collect finished resynthesis analyses.
+     */
+    void timerCallback() override;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AdditiveSynthesizerAudioProcessor)
 };
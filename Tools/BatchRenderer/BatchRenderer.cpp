@@ -0,0 +1,383 @@
+/*
+  ==============================================================================
+    BatchRenderer.cpp - Parallel multisample export for sample libraries
+
+    Usage:
+      AdditiveSynthBatchRender --out=<directory> [--state=<preset>]
+                               [--notes=21-108] [--step=1] [--velocities=32,64,100,127]
+                               [--hold=2.0] [--max-tail=10] [--threshold=-90]
+                               [--rate=48000] [--block=512] [--bits=24] [--format=wav|flac]
+                               [--threads=<n>] [--writers=2] [--prefix=AdditiveSynth]
+
+    Renders one file per note x velocity. Each render thread owns its own
+    processor instance and takes jobs from a shared counter; finished renders
+    are handed to a small pool of writer threads so disk I/O never stalls
+    rendering (at most 2 finished renders per render thread wait in memory).
+
+    Each note is held for --hold seconds, then rendered until every voice has
+    finished its release or --max-tail seconds pass. The file is trimmed after
+    the last sample above --threshold dBFS (plus 10 ms); a tail cut short by
+    --max-tail gets a 10 ms fade-out.
+
+    Every job resets its processor and starts at a block boundary, so the
+    files are bit-identical whatever the thread count or job order.
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "Common/ProcessorHarness.h"
+
+#include <iostream>
+
+namespace
+{
+
+struct Settings
+{
+    double sampleRate = 48000.0;
+    int blockSize = 512;
+    int bitsPerSample = 24;
+    double holdSeconds = 2.0;
+    double maxTailSeconds = 10.0;
+    float threshold = juce::Decibels::decibelsToGain(-90.0f);
+};
+
+struct Job
+{
+    int note = 60;
+    int velocity = 100;
+    juce::File file;
+};
+
+//==============================================================================
+/**
+ * Writes finished renders on background threads. submit() blocks only when
+ * `maxPending` renders are already waiting, which bounds memory use.
+ */
+class WriterPool
+{
+public:
+    WriterPool(int numThreads, int maxPendingRenders)
+        : pool(juce::ThreadPoolOptions{}.withThreadName("Sample Writer").withNumberOfThreads(numThreads)),
+          maxPending(maxPendingRenders)
+    {
+    }
+
+    ~WriterPool() { waitUntilDone(); }
+
+    void submit(const juce::File& file, std::shared_ptr<juce::AudioBuffer<float>> audio,
+                const Settings& settings)
+    {
+        while (pending.load() >= maxPending)
+            slotFreed.wait(20);
+
+        ++pending;
+
+        pool.addJob([this, file, audio, sampleRate = settings.sampleRate, bits = settings.bitsPerSample]
+        {
+            auto writer = tools::createAudioFileWriter(file, sampleRate, audio->getNumChannels(), bits);
+            if (writer == nullptr || !writer->writeFromAudioSampleBuffer(*audio, 0, audio->getNumSamples()))
+                ++failures;
+
+            writer.reset();
+            --pending;
+            slotFreed.signal();
+        });
+    }
+
+    void waitUntilDone()
+    {
+        while (pending.load() > 0)
+            slotFreed.wait(20);
+    }
+
+    int getNumFailures() const noexcept { return failures.load(); }
+
+private:
+    juce::ThreadPool pool;
+    const int maxPending;
+    std::atomic<int> pending{ 0 };
+    std::atomic<int> failures{ 0 };
+    juce::WaitableEvent slotFreed;
+};
+
+//==============================================================================
+/** Render one note from a freshly reset processor; leaves the processor idle again. */
+std::shared_ptr<juce::AudioBuffer<float>> renderJob(AdditiveSynthesizerAudioProcessor& processor,
+                                                    const Job& job, const Settings& settings)
+{
+    // Nothing from the thread's earlier jobs (noise sequence, note history, controllers) may leak in
+    processor.reset();
+
+    const int blockSize = settings.blockSize;
+    const auto noteOffSample = static_cast<juce::int64>(settings.holdSeconds * settings.sampleRate);
+    const auto maxLength = noteOffSample + static_cast<juce::int64>(settings.maxTailSeconds * settings.sampleRate);
+    const auto isIdle = [&processor] { return processor.getSynthEngine().getNumActiveVoices() == 0; };
+
+    auto output = std::make_shared<juce::AudioBuffer<float>>(2, static_cast<int>(noteOffSample) + blockSize);
+    juce::AudioBuffer<float> block(2, blockSize);
+    juce::MidiBuffer midi;
+
+    juce::int64 position = 0;
+    juce::int64 lastAudible = -1;
+
+    while (position < maxLength)
+    {
+        midi.clear();
+        if (position == 0)
+            midi.addEvent(juce::MidiMessage::noteOn(1, job.note, static_cast<juce::uint8>(job.velocity)), 0);
+        if (noteOffSample >= position && noteOffSample < position + blockSize)
+            midi.addEvent(juce::MidiMessage::noteOff(1, job.note), static_cast<int>(noteOffSample - position));
+
+        processor.processBlock(block, midi);
+
+        if (position + blockSize > output->getNumSamples())
+            output->setSize(2, output->getNumSamples() * 2, true, true);
+
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            output->copyFrom(ch, static_cast<int>(position), block, ch, 0, blockSize);
+
+            const float* data = block.getReadPointer(ch);
+            for (int i = blockSize; --i >= 0;)
+                if (std::abs(data[i]) > settings.threshold)
+                {
+                    lastAudible = juce::jmax(lastAudible, position + i);
+                    break;
+                }
+        }
+
+        position += blockSize;
+
+        if (position > noteOffSample && isIdle())
+            break;
+    }
+
+    const bool cutShort = !isIdle();
+
+    // Let a tail cut short by --max-tail finish, so the next job starts from silence
+    while (!isIdle())
+    {
+        midi.clear();
+        processor.processBlock(block, midi);
+    }
+
+    const auto margin = static_cast<juce::int64>(0.01 * settings.sampleRate);
+    const auto length = static_cast<int>(juce::jmin(position, juce::jmax(noteOffSample, lastAudible + 1 + margin)));
+    output->setSize(2, length, true, true, true);
+
+    if (cutShort)
+    {
+        const int fadeLength = juce::jmin(length, static_cast<int>(margin));
+        output->applyGainRamp(length - fadeLength, fadeLength, 1.0f, 0.0f);
+    }
+
+    return output;
+}
+
+//==============================================================================
+class RenderWorker : public juce::Thread
+{
+public:
+    RenderWorker(int index, std::unique_ptr<AdditiveSynthesizerAudioProcessor> processorToUse,
+                 const std::vector<Job>& jobsToRender, std::atomic<int>& sharedNextJob,
+                 WriterPool& writerPool, const Settings& renderSettings)
+        : juce::Thread("Render Worker " + juce::String(index)),
+          processor(std::move(processorToUse)), jobs(jobsToRender), nextJob(sharedNextJob),
+          writers(writerPool), settings(renderSettings)
+    {
+    }
+
+    ~RenderWorker() override { stopThread(-1); }
+
+    void run() override
+    {
+        for (;;)
+        {
+            const int index = nextJob.fetch_add(1);
+            if (index >= static_cast<int>(jobs.size()) || threadShouldExit())
+                break;
+
+            const auto& job = jobs[static_cast<size_t>(index)];
+            auto audio = renderJob(*processor, job, settings);
+
+            renderedSamples += audio->getNumSamples();
+            ++renderedJobs;
+            writers.submit(job.file, std::move(audio), settings);
+        }
+    }
+
+    juce::int64 getRenderedSamples() const noexcept { return renderedSamples; }
+    int getRenderedJobs() const noexcept { return renderedJobs; }
+
+private:
+    std::unique_ptr<AdditiveSynthesizerAudioProcessor> processor;
+    const std::vector<Job>& jobs;
+    std::atomic<int>& nextJob;
+    WriterPool& writers;
+    const Settings& settings;
+
+    juce::int64 renderedSamples = 0;
+    int renderedJobs = 0;
+};
+
+//==============================================================================
+bool parseNoteRange(const juce::String& text, int& low, int& high)
+{
+    if (text.isEmpty())
+        return true;
+
+    low = text.upToFirstOccurrenceOf("-", false, false).getIntValue();
+    high = text.containsChar('-') ? text.fromFirstOccurrenceOf("-", false, false).getIntValue() : low;
+    return juce::isPositiveAndBelow(low, 128) && juce::isPositiveAndBelow(high, 128) && low <= high;
+}
+
+juce::String getOption(const juce::ArgumentList& args, const char* option, const char* fallback)
+{
+    const auto value = args.getValueForOption(option);
+    return value.isNotEmpty() ? value : juce::String(fallback);
+}
+
+} // namespace
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    const juce::ArgumentList args(argc, argv);
+
+    if (!args.containsOption("--out"))
+    {
+        std::cout << "Usage: AdditiveSynthBatchRender --out=<directory> [--state=<preset>] [--notes=21-108]"
+                     " [--step=1] [--velocities=32,64,100,127] [--hold=2.0] [--max-tail=10]"
+                     " [--threshold=-90] [--rate=48000] [--block=512] [--bits=24] [--format=wav|flac]"
+                     " [--threads=<n>] [--writers=2] [--prefix=AdditiveSynth]"
+                  << std::endl;
+        return 1;
+    }
+
+    Settings settings;
+    settings.sampleRate = getOption(args, "--rate", "48000").getDoubleValue();
+    settings.blockSize = getOption(args, "--block", "512").getIntValue();
+    settings.bitsPerSample = getOption(args, "--bits", "24").getIntValue();
+    settings.holdSeconds = getOption(args, "--hold", "2.0").getDoubleValue();
+    settings.maxTailSeconds = getOption(args, "--max-tail", "10").getDoubleValue();
+    settings.threshold = juce::Decibels::decibelsToGain(getOption(args, "--threshold", "-90").getFloatValue());
+
+    if (settings.sampleRate <= 0.0 || settings.blockSize <= 0 || settings.holdSeconds < 0.0)
+    {
+        std::cerr << "Invalid rate, block size or hold time" << std::endl;
+        return 1;
+    }
+
+    int lowNote = 21, highNote = 108;
+    if (!parseNoteRange(args.getValueForOption("--notes"), lowNote, highNote))
+    {
+        std::cerr << "Invalid --notes range (expected e.g. 21-108)" << std::endl;
+        return 1;
+    }
+
+    const int step = juce::jmax(1, getOption(args, "--step", "1").getIntValue());
+    const auto format = getOption(args, "--format", "wav").toLowerCase();
+    const auto prefix = getOption(args, "--prefix", "AdditiveSynth");
+    const auto outDir = args.getFileForOption("--out");
+
+    std::vector<int> velocities;
+    for (const auto& token : juce::StringArray::fromTokens(getOption(args, "--velocities", "32,64,100,127"), ",", {}))
+        if (token.trim().isNotEmpty())
+            velocities.push_back(juce::jlimit(1, 127, token.trim().getIntValue()));
+
+    std::vector<Job> jobs;
+    for (int note = lowNote; note <= highNote; note += step)
+        for (int velocity : velocities)
+        {
+            Job job;
+            job.note = note;
+            job.velocity = velocity;
+            job.file = outDir.getChildFile(prefix + "_" + juce::String(note).paddedLeft('0', 3) + "_"
+                                           + juce::MidiMessage::getMidiNoteName(note, true, true, 4)
+                                           + "_v" + juce::String(velocity).paddedLeft('0', 3) + "." + format);
+            jobs.push_back(job);
+        }
+
+    if (jobs.empty())
+    {
+        std::cerr << "Nothing to render: check --notes and --velocities" << std::endl;
+        return 1;
+    }
+
+    const auto threadsText = args.getValueForOption("--threads");
+    const int requestedThreads = threadsText.isNotEmpty() ? threadsText.getIntValue() : juce::SystemStats::getNumCpus();
+    const int numThreads = juce::jlimit(1, static_cast<int>(jobs.size()), requestedThreads);
+    const int numWriters = juce::jmax(1, getOption(args, "--writers", "2").getIntValue());
+
+    if (!outDir.createDirectory())
+    {
+        std::cerr << "Could not create " << outDir.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    // Processors are set up here, on the message thread, then handed to the workers
+    std::vector<std::unique_ptr<AdditiveSynthesizerAudioProcessor>> processors;
+    for (int i = 0; i < numThreads; ++i)
+    {
+        auto processor = tools::createProcessor(settings.sampleRate, settings.blockSize, true);
+
+        if (args.containsOption("--state") && !tools::loadStateFile(*processor, args.getFileForOption("--state")))
+        {
+            std::cerr << "Could not load state from " << args.getFileForOption("--state").getFullPathName() << std::endl;
+            return 1;
+        }
+
+        processors.push_back(std::move(processor));
+    }
+
+    std::cout << "Rendering " << jobs.size() << " samples (" << (highNote - lowNote) / step + 1 << " notes x "
+              << velocities.size() << " velocities) on " << numThreads << " threads, "
+              << numWriters << " writers" << std::endl;
+
+    WriterPool writers(numWriters, numThreads * 2);
+    std::atomic<int> nextJob{ 0 };
+
+    std::vector<std::unique_ptr<RenderWorker>> workers;
+    for (int i = 0; i < numThreads; ++i)
+        workers.push_back(std::make_unique<RenderWorker>(i, std::move(processors[static_cast<size_t>(i)]),
+                                                         jobs, nextJob, writers, settings));
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    for (auto& worker : workers)
+        worker->startThread();
+
+    for (auto& worker : workers)
+        while (worker->isThreadRunning())
+            juce::Thread::sleep(10);
+
+    writers.waitUntilDone();
+
+    const double wallSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+    juce::int64 totalSamples = 0;
+    for (auto& worker : workers)
+    {
+        totalSamples += worker->getRenderedSamples();
+        std::cout << "  " << worker->getThreadName() << ": " << worker->getRenderedJobs() << " samples" << std::endl;
+    }
+
+    const double audioSeconds = static_cast<double>(totalSamples) / settings.sampleRate;
+    std::cout << "Rendered " << juce::String(audioSeconds, 1) << " s of audio in " << juce::String(wallSeconds, 2)
+              << " s (" << juce::String(audioSeconds / juce::jmax(wallSeconds, 1.0e-9), 1) << "x real time)"
+              << std::endl;
+
+    if (writers.getNumFailures() > 0)
+    {
+        std::cerr << writers.getNumFailures() << " files could not be written to " << outDir.getFullPathName()
+                  << std::endl;
+        return 1;
+    }
+
+    std::cout << "Written to " << outDir.getFullPathName() << std::endl;
+    return 0;
+}
@@ -0,0 +1,1130 @@
+/*
+  ==============================================================================
+    DSPBenchmarks.cpp - Microbenchmarks for the DSP kernels
+
+    Usage:
+      AdditiveSynthBenchmarks [--quick] [--filter=<substring>]
+                              [--out=<results.json>]
+                              [--baseline=<baseline.json>] [--tolerance=<percent>]
+
+    Every case reports the median and minimum time per item over several
+    runs. With --baseline, cases are matched by name and any case slower than
+    the baseline by more than --tolerance percent (default 10) is flagged as a
+    regression and the process exits with code 1.
+
+    Voice and engine rendering is measured in both sample precisions; the
+    64-bit cases carry a /precision=double suffix.
+
+    The sine.* cases compare table size, interpolation and polynomial order;
+    each records its worst-case error against std::sin as params.maxErrorDb.
+
+    The kernels.* and /isa= cases run every instruction-set variant this CPU
+    supports (scalar, sse2, avx2, avx512), whatever ADDITIVE_SYNTH_SIMD says.
+
+    The /path= cases render the same held saw through the partial bank and
+    through the closed-form oscillator (DsfOscillator.h); the /envelopes=
+    cases compare one shared ADSR with per-partial envelopes; the /stereo=
+    cases compare spectral panning with unison as a source of width; the
+    /pitch= cases hold the wheel still, then move it every block; the
+    /tuning= cases play the same note under different partial tunings; the
+    /morph= cases play it plain, then halfway between two stored spectra;
+    the /modulation= cases play it unmodulated, then with an LFO on the
+    cutoff (filter stage rebuilt every control period), on the saw/square
+    ratio (whole spectrum rebuilt) and on pitch (no rebuild);
+    the /source= cases play the same partials from the oscillator, from a
+    set of analysed partial tracks in memory and from the same tracks mapped
+    from a partial data file. analysis.partialTracks times the resynthesis
+    analysis on one thread and on a thread pool. noise.render times the
+    residual noise layer for 1 to 64 voices, to set against the voice cases.
+    The engine /mode= cases play eight-voice unison chords per voice and
+    through the post-mix economy stack; unison.process times the stack alone,
+    and kernels.accumulateDelayTap its inner read per instruction set.
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "DSP/SineLUT.h"
+#include "DSP/SineKernels.h"
+#include "DSP/RenderKernels.h"
+#include "DSP/HarmonicSeries.h"
+#include "DSP/SpectralFilter.h"
+#include "DSP/AdditiveVoice.h"
+#include "DSP/AdditiveSynthEngine.h"
+#include "DSP/WaveformAnalyzer.h"
+#include "DSP/PartialAnalysis.h"
+#include "DSP/PartialDataFile.h"
+#include "DSP/ResidualNoise.h"
+#include "DSP/UnisonProcessor.h"
+
+#include <iostream>
+
+namespace
+{
+
+constexpr double kBenchSampleRate = 48000.0;
+
+// Results are folded into this so the optimiser can't discard the work
+volatile float benchmarkSink = 0.0f;
+
+//==============================================================================
+/**
+ * Times a callable that processes `itemsPerCall` items per invocation.
+ * The call count per run is calibrated so that each run lasts at least
+ * `targetRunSeconds`; the median over `numRuns` runs is reported.
+ */
+class BenchmarkRunner
+{
+public:
+    BenchmarkRunner(bool quickMode, juce::String nameFilter)
+        : quick(quickMode), filter(std::move(nameFilter))
+    {
+    }
+
+    bool isQuick() const noexcept { return quick; }
+
+    template <typename Body>
+    void run(const juce::String& name, juce::DynamicObject::Ptr params,
+             double itemsPerCall, const juce::String& unit, Body&& body)
+    {
+        if (filter.isNotEmpty() && !name.contains(filter))
+            return;
+
+        const double targetRunSeconds = quick ? 0.005 : 0.02;
+        const int numRuns = quick ? 5 : 11;
+
+        // Warm up caches / lazy statics, then find a call count long enough to time
+        body();
+        int callsPerRun = 1;
+        while (timeCalls(body, callsPerRun) < targetRunSeconds && callsPerRun < (1 << 24))
+            callsPerRun *= 2;
+
+        std::vector<double> nsPerItem;
+        for (int r = 0; r < numRuns; ++r)
+        {
+            const double seconds = timeCalls(body, callsPerRun);
+            nsPerItem.push_back(seconds * 1.0e9 / (itemsPerCall * callsPerRun));
+        }
+
+        std::sort(nsPerItem.begin(), nsPerItem.end());
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty("name", name);
+        result->setProperty("unit", "ns/" + unit);
+        result->setProperty("median", nsPerItem[nsPerItem.size() / 2]);
+        result->setProperty("min", nsPerItem.front());
+        result->setProperty("runs", numRuns);
+        result->setProperty("callsPerRun", callsPerRun);
+        result->setProperty("params", params.get());
+
+        // Rendering cases also report their share of the real-time budget
+        if (unit == "sample")
+            result->setProperty("realtimeLoad", nsPerItem[nsPerItem.size() / 2] * kBenchSampleRate * 1.0e-9);
+
+        std::cout << name.paddedRight(' ', 56) << juce::String(nsPerItem[nsPerItem.size() / 2], 2).paddedLeft(' ', 12)
+                  << " ns/" << unit << "  (min " << juce::String(nsPerItem.front(), 2) << ")" << std::endl;
+
+        results.add(juce::var(result));
+    }
+
+    juce::var toJson() const
+    {
+        auto* meta = new juce::DynamicObject();
+        meta->setProperty("juceVersion", juce::SystemStats::getJUCEVersion());
+        meta->setProperty("cpu", juce::SystemStats::getCpuModel());
+        meta->setProperty("os", juce::SystemStats::getOperatingSystemName());
+        meta->setProperty("time", juce::Time::getCurrentTime().toISO8601(true));
+        meta->setProperty("quick", quick);
+        meta->setProperty("simdDetected", synth::getSimdLevelName(synth::detectSimdLevel()));
+        meta->setProperty("simdActive", synth::getSimdLevelName(synth::getActiveSimdLevel()));
+       #if JUCE_DEBUG
+        meta->setProperty("build", "Debug");
+       #else
+        meta->setProperty("build", "Release");
+       #endif
+
+        auto* root = new juce::DynamicObject();
+        root->setProperty("meta", juce::var(meta));
+        root->setProperty("results", results);
+        return juce::var(root);
+    }
+
+private:
+    bool quick;
+    juce::String filter;
+    juce::Array<juce::var> results;
+
+    template <typename Body>
+    static double timeCalls(Body& body, int calls)
+    {
+        const auto start = juce::Time::getHighResolutionTicks();
+        for (int i = 0; i < calls; ++i)
+            body();
+        return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+    }
+};
+
+juce::DynamicObject::Ptr makeParams(std::initializer_list<std::pair<const char*, juce::var>> values)
+{
+    juce::DynamicObject::Ptr params = new juce::DynamicObject();
+    for (const auto& [key, value] : values)
+        params->setProperty(key, value);
+    return params;
+}
+
+/** Lowest fundamental whose harmonic series has exactly `partials` partials below Nyquist. */
+float frequencyForPartialCount(int partials)
+{
+    return static_cast<float>(kBenchSampleRate * 0.5) / (static_cast<float>(partials) + 0.5f);
+}
+
+/** MIDI note whose frequency gives (roughly) the requested partial count. */
+int noteForPartialCount(int partials)
+{
+    const double freq = frequencyForPartialCount(partials);
+    return juce::jlimit(0, 127, juce::roundToInt(69.0 + 12.0 * std::log2(freq / 440.0)));
+}
+
+/**
+ * Parameters that keep every partial audible (no spectral roll-off) with a held
+ * envelope. The closed-form shortcut is off so the partial bank is what's measured.
+ */
+template <typename Params>
+void setBenchmarkParams(Params& params, int unison)
+{
+    params.allowClosedForm = false;
+    params.oscRatio = 1.0f;
+    params.filterCutoff = static_cast<float>(params.waveFilterSpectrum.size());
+    params.filterBoost = 0.0f;
+    params.filterStretch = 1.0f;
+    params.unisonCount = unison;
+    params.unisonDetune = 10.0f;
+    params.stereoWidth = 0.5f;
+    params.envAttack = 0.001f;
+    params.envDecay = 0.001f;
+    params.envSustain = 1.0f;
+    params.envRelease = 0.3f;
+}
+
+/** Name suffix and JSON value for the render precision; float cases keep their original names. */
+template <typename SampleType>
+juce::String precisionSuffix()
+{
+    return std::is_same_v<SampleType, double> ? "/precision=double" : "";
+}
+
+template <typename SampleType>
+const char* precisionName()
+{
+    return std::is_same_v<SampleType, double> ? "double" : "float";
+}
+
+//==============================================================================
+void benchmarkSineLUT(BenchmarkRunner& runner)
+{
+    juce::Random random(1);
+    std::vector<float> phases(4096), output(4096);
+    for (auto& p : phases)
+        p = random.nextFloat() * synth::SineLUT::kTwoPi;
+
+    runner.run("sineLUT.lookup", makeParams({ { "count", 4096 } }), 4096.0, "lookup", [&]()
+    {
+        float sum = 0.0f;
+        for (const float p : phases)
+            sum += synth::SineLUT::lookup(p);
+        benchmarkSink = benchmarkSink + sum;
+    });
+
+    for (const int block : { 64, 256, 1024, 4096 })
+    {
+        runner.run("sineLUT.lookupBatch/count=" + juce::String(block),
+                   makeParams({ { "count", block } }), block, "lookup", [&, block]()
+        {
+            synth::SineLUT::lookupBatch(phases.data(), output.data(), block);
+            benchmarkSink = benchmarkSink + output[static_cast<size_t>(block - 1)];
+        });
+    }
+}
+
+/** Worst-case |sine(x) - sin(x)| over a dense sweep of one cycle, in dB. */
+template <typename Sine>
+double measureSineErrorDb(Sine&& sine)
+{
+    constexpr int numPoints = 1 << 18;
+    double maxError = 0.0;
+
+    for (int i = 0; i < numPoints; ++i)
+    {
+        const float phase = static_cast<float>(juce::MathConstants<double>::twoPi * i / numPoints);
+        const double error = std::abs(static_cast<double>(sine(phase)) - std::sin(static_cast<double>(phase)));
+        maxError = juce::jmax(maxError, error);
+    }
+
+    return juce::Decibels::gainToDecibels(maxError, -200.0);
+}
+
+/**
+ * Speed/accuracy matrix for every way of evaluating a partial's sine:
+ * table size x interpolation, minimax polynomial order, and std::sin.
+ * Each case's params carry its worst-case error against double-precision sin.
+ */
+void benchmarkSineAccuracy(BenchmarkRunner& runner)
+{
+    juce::Random random(1);
+    std::vector<float> phases(4096);
+    for (auto& p : phases)
+        p = random.nextFloat() * synth::SineLUT::kTwoPi;
+
+    auto runCase = [&](const juce::String& name, juce::DynamicObject::Ptr params, auto sine)
+    {
+        params->setProperty("maxErrorDb", measureSineErrorDb(sine));
+
+        runner.run("sine." + name, params, static_cast<double>(phases.size()), "lookup", [&phases, sine]()
+        {
+            float sum = 0.0f;
+            for (const float p : phases)
+                sum += sine(p);
+            benchmarkSink = benchmarkSink + sum;
+        });
+    };
+
+    auto runTable = [&](auto table)
+    {
+        using Table = decltype(table);
+        const juce::String size(Table::kTableSize);
+
+        runCase("table/size=" + size + "/interp=linear",
+                makeParams({ { "kernel", "table" }, { "tableSize", Table::kTableSize }, { "interpolation", "linear" } }),
+                [](float p) { return Table::lookup(p); });
+        runCase("table/size=" + size + "/interp=nearest",
+                makeParams({ { "kernel", "table" }, { "tableSize", Table::kTableSize }, { "interpolation", "nearest" } }),
+                [](float p) { return Table::lookupNearest(p); });
+    };
+
+    runTable(synth::BasicSineTable<256>{});
+    runTable(synth::BasicSineTable<1024>{});
+    runTable(synth::BasicSineTable<4096>{});
+
+    auto runKernel = [&](auto kernel)
+    {
+        constexpr auto k = decltype(kernel)::value;
+        runCase(juce::String("kernel=") + synth::getSineKernelName(k),
+                makeParams({ { "kernel", synth::getSineKernelName(k) } }),
+                [](float p) { return synth::evaluateSine<k>(p); });
+    };
+
+    for (int i = 0; i < synth::kNumSineKernels; ++i)
+        synth::dispatchSineKernel(static_cast<synth::SineKernel>(i), runKernel);
+}
+
+void benchmarkSpectralPipeline(BenchmarkRunner& runner)
+{
+    const std::vector<int> partialCounts = runner.isQuick() ? std::vector<int>{ 16, 64, 256 }
+                                                            : std::vector<int>{ 8, 32, 64, 128, 256 };
+
+    std::array<float, synth::kMaxHarmonics> envelope{};
+    for (size_t i = 0; i < envelope.size(); ++i)
+        envelope[i] = 1.0f / (1.0f + 0.05f * static_cast<float>(i));
+
+    for (const int partials : partialCounts)
+    {
+        const float freq = frequencyForPartialCount(partials);
+        const auto params = [partials]() { return makeParams({ { "partials", partials } }); };
+
+        runner.run("harmonicSeries.compute/partials=" + juce::String(partials), params(), 1.0, "call", [&]()
+        {
+            const auto data = synth::HarmonicSeries::compute(0.5f, 0.3f, 0.7f, freq, kBenchSampleRate);
+            benchmarkSink = benchmarkSink + data.amplitudes[0];
+        });
+
+        const auto source = synth::HarmonicSeries::compute(0.5f, 0.3f, 0.7f, freq, kBenchSampleRate);
+        synth::PartialRatios ratios;
+        ratios.update({ synth::PartialTuning::harmonic, 1.02f });
+
+        runner.run("spectralFilter.apply/partials=" + juce::String(partials), params(), 1.0, "call", [&]()
+        {
+            auto data = source;
+            synth::SpectralFilter::apply(data, 40.0f, 6.0f, 0.2f, ratios, freq, kBenchSampleRate);
+            benchmarkSink = benchmarkSink + data.amplitudes[0];
+        });
+
+        runner.run("spectralFilter.applyWaveformFilter/partials=" + juce::String(partials), params(), 1.0, "call", [&]()
+        {
+            auto data = source;
+            synth::SpectralFilter::applyWaveformFilter(data, envelope, 0.7f);
+            benchmarkSink = benchmarkSink + data.amplitudes[0];
+        });
+    }
+}
+
+/** Does nothing; the default for benchmarkHeldVoice's hooks. */
+struct NoHook
+{
+    template <typename... Args>
+    void operator()(Args&&...) const noexcept {}
+};
+
+/**
+ * Times one held note on a single voice built from `params`: a one-voice
+ * Synthesiser drives renderNextBlock, one `block`-sample buffer per call.
+ * The voice's active partial count is added to caseParams. prepareVoice(voice)
+ * runs before the note starts, beforeBlock(synthesiser) before every block.
+ */
+template <typename SampleType = float, typename Config, typename PrepareVoice = NoHook, typename BeforeBlock = NoHook>
+void benchmarkHeldVoice(BenchmarkRunner& runner, const juce::String& name, const synth::BasicVoiceParams<Config>& params,
+                        int note, int block, juce::DynamicObject::Ptr caseParams,
+                        PrepareVoice&& prepareVoice = {}, BeforeBlock&& beforeBlock = {})
+{
+    juce::Synthesiser synthesiser;
+    synthesiser.addSound(new synth::AdditiveSound());
+    auto* voice = new synth::BasicAdditiveVoice<Config>(params);
+    prepareVoice(*voice);
+    synthesiser.addVoice(voice);
+    synthesiser.setCurrentPlaybackSampleRate(kBenchSampleRate);
+    voice->prepareToPlay(kBenchSampleRate, block);
+    synthesiser.noteOn(1, note, 0.8f);
+
+    juce::AudioBuffer<SampleType> buffer(2, block);
+    const juce::MidiBuffer noMidi;
+    caseParams->setProperty("partials", voice->getHarmonicData().activeCount);
+
+    runner.run(name, caseParams, block, "sample", [&]()
+    {
+        beforeBlock(synthesiser);
+        buffer.clear();
+        synthesiser.renderNextBlock(buffer, noMidi, 0, block);
+        benchmarkSink = benchmarkSink + static_cast<float>(buffer.getSample(0, block - 1) + buffer.getSample(1, block - 1));
+    });
+}
+
+template <typename SampleType>
+void benchmarkVoiceRender(BenchmarkRunner& runner)
+{
+    const bool quick = runner.isQuick();
+    const std::vector<int> partialCounts = quick ? std::vector<int>{ 16, 64, 256 } : std::vector<int>{ 8, 32, 64, 128, 256 };
+    const std::vector<int> unisonCounts  = quick ? std::vector<int>{ 1, 4, 8 }     : std::vector<int>{ 1, 2, 3, 4, 5, 6, 7, 8 };
+    const std::vector<int> blockSizes    = quick ? std::vector<int>{ 256 }         : std::vector<int>{ 32, 128, 512, 2048 };
+
+    for (const int partials : partialCounts)
+    {
+        for (const int unison : unisonCounts)
+        {
+            for (const int block : blockSizes)
+            {
+                synth::AdditiveVoiceParams params;
+                setBenchmarkParams(params, unison);
+
+                benchmarkHeldVoice<SampleType>(runner,
+                    "voice.render/partials=" + juce::String(partials) + "/unison=" + juce::String(unison)
+                        + "/block=" + juce::String(block) + precisionSuffix<SampleType>(),
+                    params, noteForPartialCount(partials), block,
+                    makeParams({ { "unison", unison }, { "block", block }, { "precision", precisionName<SampleType>() } }));
+            }
+        }
+    }
+}
+
+/** One held 64-partial note rendered with each real-time sine kernel (see SineKernels.h). */
+void benchmarkVoiceSineKernels(BenchmarkRunner& runner)
+{
+    constexpr int partials = 64;
+    constexpr int block = 256;
+
+    for (int i = 0; i < synth::kNumSineKernels; ++i)
+    {
+        const auto kernel = static_cast<synth::SineKernel>(i);
+
+        synth::AdditiveVoiceParams params;
+        setBenchmarkParams(params, 1);
+        params.realtimeSineKernel = kernel;
+
+        benchmarkHeldVoice(runner,
+            "voice.render/partials=" + juce::String(partials) + "/unison=1/block=" + juce::String(block)
+                + "/sine=" + synth::getSineKernelName(kernel),
+            params, noteForPartialCount(partials), block,
+            makeParams({ { "unison", 1 }, { "block", block }, { "sine", synth::getSineKernelName(kernel) } }));
+    }
+}
+
+/** The dispatched render kernels (RenderKernels.h), once per supported instruction set. */
+void benchmarkRenderKernels(BenchmarkRunner& runner)
+{
+    constexpr int partials = 256;
+    const int maxLevel = static_cast<int>(synth::detectSimdLevel());
+
+    juce::Random random(1);
+    std::vector<float> phases(partials), increments(partials), amplitudes(partials), offsets(partials), output(partials);
+    std::vector<float> outputRight(partials);
+    for (int i = 0; i < partials; ++i)
+    {
+        increments[static_cast<size_t>(i)] = random.nextFloat() * 0.5f;
+        amplitudes[static_cast<size_t>(i)] = 1.0f / static_cast<float>(i + 1);
+        offsets[static_cast<size_t>(i)] = random.nextFloat() * synth::SineLUT::kTwoPi;
+    }
+
+    for (int level = 0; level <= maxLevel; ++level)
+    {
+        const auto& kernels = synth::getRenderKernels(static_cast<synth::SimdLevel>(level));
+        const juce::String isa = synth::getSimdLevelName(kernels.level);
+
+        for (int k = 0; k < synth::kNumSineKernels; ++k)
+        {
+            const auto accumulate = kernels.accumulatePartials[k];
+            const juce::String sine = synth::getSineKernelName(static_cast<synth::SineKernel>(k));
+
+            runner.run("kernels.accumulatePartials/isa=" + isa + "/sine=" + sine + "/partials=" + juce::String(partials),
+                       makeParams({ { "isa", isa }, { "sine", sine }, { "partials", partials } }),
+                       partials, "partial", [&, accumulate]()
+            {
+                benchmarkSink = benchmarkSink + accumulate(phases.data(), increments.data(), 1.0f, amplitudes.data(),
+                                                           offsets.data(), partials);
+            });
+        }
+
+        runner.run("kernels.shapeSpectrum/isa=" + isa + "/partials=" + juce::String(partials),
+                   makeParams({ { "isa", isa }, { "partials", partials } }), partials, "partial", [&]()
+        {
+            std::fill(output.begin(), output.end(), 1.0f);
+            kernels.shapeSpectrum(output.data(), partials, 64.0f, 4.0f);
+            benchmarkSink = benchmarkSink + output[static_cast<size_t>(partials / 2)];
+        });
+
+        runner.run("kernels.morphSpectrum/isa=" + isa + "/partials=" + juce::String(partials),
+                   makeParams({ { "isa", isa }, { "partials", partials } }), partials, "partial", [&]()
+        {
+            std::copy(amplitudes.begin(), amplitudes.end(), output.begin());
+            kernels.morphSpectrum(output.data(), phases.data(), increments.data(), offsets.data(), 0.25f, partials);
+            benchmarkSink = benchmarkSink + output[static_cast<size_t>(partials / 2)];
+        });
+
+        runner.run("kernels.sineBatch/isa=" + isa + "/count=" + juce::String(partials),
+                   makeParams({ { "isa", isa }, { "count", partials } }), partials, "lookup", [&]()
+        {
+            kernels.sineBatch(offsets.data(), output.data(), partials);
+            benchmarkSink = benchmarkSink + output[static_cast<size_t>(partials - 1)];
+        });
+
+        // One unison copy's read of a block: history positions advancing by just under a sample
+        runner.run("kernels.accumulateDelayTap/isa=" + isa + "/count=" + juce::String(partials),
+                   makeParams({ { "isa", isa }, { "count", partials } }), partials, "sample", [&]()
+        {
+            kernels.accumulateDelayTap(amplitudes.data(), 0.5f, 0.99f, 0.7f, 0.7f, output.data(),
+                                       outputRight.data(), partials - 4);
+            benchmarkSink = benchmarkSink + output[static_cast<size_t>(partials / 2)];
+        });
+    }
+}
+
+/** A held 256-partial, 4-voice-unison note rendered by each supported instruction set. */
+void benchmarkVoiceIsa(BenchmarkRunner& runner)
+{
+    constexpr int partials = 256;
+    constexpr int unison = 4;
+    constexpr int block = 256;
+    const int maxLevel = static_cast<int>(synth::detectSimdLevel());
+
+    for (int level = 0; level <= maxLevel; ++level)
+    {
+        const auto simdLevel = static_cast<synth::SimdLevel>(level);
+
+        synth::AdditiveVoiceParams params;
+        setBenchmarkParams(params, unison);
+
+        benchmarkHeldVoice(runner,
+            "voice.render/partials=" + juce::String(partials) + "/unison=" + juce::String(unison)
+                + "/block=" + juce::String(block) + "/isa=" + synth::getSimdLevelName(simdLevel),
+            params, noteForPartialCount(partials), block,
+            makeParams({ { "unison", unison }, { "block", block }, { "isa", synth::getSimdLevelName(simdLevel) } }),
+            [simdLevel](synth::AdditiveVoice& voice) { voice.setSimdLevel(simdLevel); });
+    }
+}
+
+/** A held note through the partial bank and through the closed-form oscillator, at growing partial counts. */
+void benchmarkVoiceClosedForm(BenchmarkRunner& runner)
+{
+    constexpr int unison = 1;
+    constexpr int block = 256;
+
+    for (const int partials : { 64, 128, 200 })
+    {
+        for (const bool closedForm : { false, true })
+        {
+            synth::AdditiveVoiceParams params;
+            setBenchmarkParams(params, unison);
+            params.allowClosedForm = closedForm;
+
+            const char* path = closedForm ? "closedForm" : "partials";
+            benchmarkHeldVoice(runner,
+                "voice.render/partials=" + juce::String(partials) + "/unison=" + juce::String(unison)
+                    + "/block=" + juce::String(block) + "/path=" + path,
+                params, noteForPartialCount(partials), block,
+                makeParams({ { "unison", unison }, { "block", block }, { "path", path } }));
+        }
+    }
+}
+
+/** A held 256-partial note with one shared envelope, then with per-partial envelopes. */
+void benchmarkVoicePartialEnvelopes(BenchmarkRunner& runner)
+{
+    constexpr int partials = 256;
+    constexpr int unison = 1;
+    constexpr int block = 256;
+
+    for (const bool perPartial : { false, true })
+    {
+        synth::AdditiveVoiceParams params;
+        setBenchmarkParams(params, unison);
+        params.envDecay = 2.0f;
+        params.envSustain = 0.2f;
+        params.partialDecayTilt = perPartial ? 1.0f : 0.0f;
+
+        const char* envelopes = perPartial ? "partial" : "shared";
+        benchmarkHeldVoice(runner,
+            "voice.render/partials=" + juce::String(partials) + "/unison=" + juce::String(unison)
+                + "/block=" + juce::String(block) + "/envelopes=" + envelopes,
+            params, noteForPartialCount(partials), block,
+            makeParams({ { "unison", unison }, { "block", block }, { "envelopes", envelopes } }));
+    }
+}
+
+/**
+ * Three ways to a wide held note: mono, spectral panning on one voice, and
+ * the widest unison the build allows.
+ */
+void benchmarkVoiceStereo(BenchmarkRunner& runner)
+{
+    constexpr int partials = 256;
+    constexpr int block = 256;
+
+    struct Case { const char* name; int unison; bool spectralPan; };
+    const Case cases[] = { { "mono", 1, false },
+                           { "spectral", 1, true },
+                           { "unison", synth::kMaxUnisonVoices, false } };
+
+    for (const auto& c : cases)
+    {
+        synth::AdditiveVoiceParams params;
+        setBenchmarkParams(params, c.unison);
+        params.stereoWidth = 1.0f;
+        params.spectralPanMode = c.spectralPan ? synth::SpectralPanMode::random : synth::SpectralPanMode::off;
+        params.spectralPanWidth = 1.0f;
+
+        benchmarkHeldVoice(runner,
+            "voice.render/partials=" + juce::String(partials) + "/unison=" + juce::String(c.unison)
+                + "/block=" + juce::String(block) + "/stereo=" + c.name,
+            params, noteForPartialCount(partials), block,
+            makeParams({ { "unison", c.unison }, { "block", block }, { "stereo", c.name } }));
+    }
+}
+
+/**
+ * A held low note under several partial tunings. Every tuning reads its
+ * frequencies from the same precomputed ratio table, so the cost per sample
+ * should only follow the number of partials below Nyquist (params.partials).
+ */
+void benchmarkVoiceTuning(BenchmarkRunner& runner)
+{
+    constexpr int unison = 1;
+    constexpr int block = 256;
+
+    struct Case { const char* name; synth::PartialTuning tuning; float stretch; };
+    const Case cases[] = { { "harmonic", synth::PartialTuning::harmonic, 1.0f },
+                           { "stretched", synth::PartialTuning::harmonic, 1.01f },
+                           { "stiffString", synth::PartialTuning::stiffString, 1.0f },
+                           { "membrane", synth::PartialTuning::membrane, 1.0f } };
+
+    for (const auto& c : cases)
+    {
+        synth::AdditiveVoiceParams params;
+        setBenchmarkParams(params, unison);
+        params.partialTuning = c.tuning;
+        params.filterStretch = c.stretch;
+        params.stringInharmonicity = 1.0e-5f;
+
+        benchmarkHeldVoice(runner,
+            "voice.render/unison=" + juce::String(unison) + "/block=" + juce::String(block) + "/tuning=" + c.name,
+            params, noteForPartialCount(256), block,
+            makeParams({ { "unison", unison }, { "block", block }, { "tuning", c.name } }));
+    }
+}
+
+/**
+ * A held 256-partial note without morphing, then morphed halfway towards the
+ * point halfway between two stored spectra (the spectral pipeline reruns
+ * every block, so the morph is paid for on each one).
+ */
+void benchmarkVoiceMorph(BenchmarkRunner& runner)
+{
+    constexpr int unison = 1;
+    constexpr int block = 256;
+
+    for (const bool morphing : { false, true })
+    {
+        synth::AdditiveVoiceParams params;
+        setBenchmarkParams(params, unison);
+
+        if (morphing)
+        {
+            params.morphSlots.setSlot(0, synth::HarmonicSeries::computePartials(0.0f, 0.0f, 0.0f, synth::kMaxHarmonics));
+            params.morphSlots.setSlot(1, synth::HarmonicSeries::computePartials(1.0f, 0.0f, 0.0f, synth::kMaxHarmonics));
+            params.morphAmount = 0.5f;
+            params.morphPosition = 0.5f;
+        }
+
+        const char* morph = morphing ? "on" : "off";
+        benchmarkHeldVoice(runner,
+            "voice.render/unison=" + juce::String(unison) + "/block=" + juce::String(block) + "/morph=" + morph,
+            params, noteForPartialCount(256), block,
+            makeParams({ { "unison", unison }, { "block", block }, { "morph", morph } }));
+    }
+}
+
+/**
+ * One held 256-partial note with the modulation matrix off, then with an
+ * LFO routed to the cutoff, to the oscillator shape and to pitch. The first
+ * two rebuild the spectrum every control period, the cutoff reusing the
+ * oscillator series; pitch only moves the increments.
+ */
+void benchmarkVoiceModulation(BenchmarkRunner& runner)
+{
+    constexpr int unison = 1;
+    constexpr int block = 256;
+
+    const std::pair<const char*, synth::ModDestination> cases[] = {
+        { "off", synth::ModDestination::off },
+        { "cutoff", synth::ModDestination::filterCutoff },
+        { "ratio", synth::ModDestination::oscRatio },
+        { "pitch", synth::ModDestination::pitch },
+    };
+
+    for (const auto& [name, destination] : cases)
+    {
+        synth::AdditiveVoiceParams params;
+        setBenchmarkParams(params, unison);
+        params.modulation.lfos[0] = { synth::LfoShape::sine, 5.0f };
+        params.modulation.slots[0] = { synth::ModSource::lfo1, destination, 0.1f };
+
+        benchmarkHeldVoice(runner,
+            "voice.render/unison=" + juce::String(unison) + "/block=" + juce::String(block) + "/modulation=" + name,
+            params, noteForPartialCount(256), block,
+            makeParams({ { "unison", unison }, { "block", block }, { "modulation", name } }));
+    }
+}
+
+/**
+ * A held 256-partial note from the oscillator, then from 256 partial tracks
+ * with a slow vibrato, so every block reads and interpolates the tracks:
+ * first from memory, then zero-copy from a mapped partial data file with
+ * the prefetcher paging ahead.
+ */
+void benchmarkVoiceResynthesis(BenchmarkRunner& runner)
+{
+    constexpr int partials = 256;
+    constexpr int unison = 1;
+    constexpr int block = 256;
+    constexpr int frames = 400;
+    constexpr double referenceHz = 100.0;
+
+    synth::PartialTrackSet::Ptr tracks = new synth::PartialTrackSet(frames, partials, 0.01, referenceHz, "bench");
+    for (int f = 0; f < frames; ++f)
+    {
+        const double vibrato = 1.0 + 0.01 * std::sin(0.05 * f);
+        auto* frame = tracks->getFrame(f);
+
+        for (int n = 0; n < partials; ++n)
+            frame[n] = { static_cast<float>(referenceHz * (n + 1) * vibrato), 0.5f / static_cast<float>(n + 1), 0.0f };
+    }
+
+    const auto inMemory = synth::PartialLibrary::fromSets({ tracks }, "bench");
+
+    const juce::TemporaryFile libraryFile(juce::String(synth::PartialDataFile::kFileExtension));
+    if (!synth::PartialDataFile::write(libraryFile.getFile(), *inMemory))
+    {
+        std::cerr << "Could not write " << libraryFile.getFile().getFullPathName() << std::endl;
+        return;
+    }
+
+    const auto mapped = synth::PartialDataFile::map(libraryFile.getFile());
+    synth::PartialPrefetcher prefetcher;
+    prefetcher.setLibrary(mapped);
+
+    const std::pair<const char*, const synth::PartialLibrary*> sources[] = {
+        { "oscillator", nullptr }, { "resynthesis", inMemory.get() }, { "mapped", mapped.get() }
+    };
+
+    for (const auto& [source, library] : sources)
+    {
+        synth::AdditiveVoiceParams params;
+        setBenchmarkParams(params, unison);
+        params.resynthesisEnabled = library != nullptr;
+        params.partialLibrary = library;
+        params.partialPrefetcher = &prefetcher;
+
+        benchmarkHeldVoice(runner,
+            "voice.render/unison=" + juce::String(unison) + "/block=" + juce::String(block) + "/source=" + source,
+            params, noteForPartialCount(partials), block,
+            makeParams({ { "unison", unison }, { "block", block }, { "source", source } }));
+    }
+}
+
+/**
+ * A held 256-partial note with the pitch wheel at rest, then moved every
+ * block, so each block renders a phase-increment ramp.
+ */
+void benchmarkVoicePitch(BenchmarkRunner& runner)
+{
+    constexpr int partials = 256;
+    constexpr int unison = 1;
+    constexpr int block = 256;
+
+    for (const bool bending : { false, true })
+    {
+        synth::AdditiveVoiceParams params;
+        setBenchmarkParams(params, unison);
+
+        const char* pitch = bending ? "bending" : "static";
+        int wheel = 8192;
+
+        benchmarkHeldVoice(runner,
+            "voice.render/partials=" + juce::String(partials) + "/unison=" + juce::String(unison)
+                + "/block=" + juce::String(block) + "/pitch=" + pitch,
+            params, noteForPartialCount(partials), block,
+            makeParams({ { "unison", unison }, { "block", block }, { "pitch", pitch } }), NoHook{},
+            [&](juce::Synthesiser& synthesiser)
+            {
+                // Step down through one semitone and back, so the partial count stays put
+                if (bending)
+                {
+                    wheel = wheel <= 4096 ? 8192 : wheel - 64;
+                    synthesiser.handlePitchWheel(1, wheel);
+                }
+            });
+    }
+}
+
+/** One held 64-partial note through voices built for each capacity preset (see EngineConfig.h). */
+template <typename Config>
+void benchmarkVoiceCapacity(BenchmarkRunner& runner, const juce::String& configName)
+{
+    constexpr int block = 256;
+    constexpr int partials = 64;
+
+    synth::BasicVoiceParams<Config> params;
+    setBenchmarkParams(params, 1);
+
+    benchmarkHeldVoice(runner,
+        "voice.render/capacity=" + configName + "/partials=" + juce::String(partials) + "/block=" + juce::String(block),
+        params, noteForPartialCount(partials), block,
+        makeParams({ { "capacity", configName }, { "maxHarmonics", Config::maxHarmonics },
+                     { "maxUnison", Config::maxUnisonVoices },
+                     { "voiceBytes", static_cast<int>(sizeof(synth::BasicAdditiveVoice<Config>)) },
+                     { "block", block } }));
+}
+
+template <typename SampleType>
+void benchmarkEngine(BenchmarkRunner& runner)
+{
+    const bool quick = runner.isQuick();
+    const std::vector<int> polyphonies = quick ? std::vector<int>{ 1, 4, 8 } : std::vector<int>{ 1, 2, 3, 4, 5, 6, 7, 8 };
+    const std::vector<int> unisonCounts = quick ? std::vector<int>{ 1, 8 } : std::vector<int>{ 1, 4, 8 };
+    constexpr int block = 512;
+    constexpr int partials = 64;
+
+    for (const int polyphony : polyphonies)
+    {
+        for (const int unison : unisonCounts)
+        {
+            synth::AdditiveSynthEngine engine;
+            setBenchmarkParams(engine.getVoiceParams(), unison);
+            engine.prepareToPlay(kBenchSampleRate, block);
+
+            juce::AudioBuffer<SampleType> buffer(2, block);
+            juce::MidiBuffer midi;
+            for (int n = 0; n < polyphony; ++n)
+                midi.addEvent(juce::MidiMessage::noteOn(1, noteForPartialCount(partials) + n, 0.8f), 0);
+            engine.processBlock(buffer, midi);
+
+            juce::MidiBuffer noMidi;
+            runner.run("engine.process/polyphony=" + juce::String(polyphony) + "/unison=" + juce::String(unison)
+                           + "/block=" + juce::String(block) + precisionSuffix<SampleType>(),
+                       makeParams({ { "polyphony", polyphony }, { "unison", unison },
+                                    { "partials", partials }, { "block", block },
+                                    { "precision", precisionName<SampleType>() } }),
+                       block, "sample", [&]()
+            {
+                engine.processBlock(buffer, noMidi);
+                benchmarkSink = benchmarkSink + buffer.getSample(0, block - 1);
+            });
+        }
+    }
+}
+
+/**
+ * Chords with eight-voice unison, rendered per voice (every partial once per
+ * copy) and in economy mode (every partial once, copies stacked from the mix).
+ */
+void benchmarkEngineUnisonMode(BenchmarkRunner& runner)
+{
+    constexpr int block = 512;
+    constexpr int partials = 64;
+    constexpr int unison = 8;
+
+    for (const int polyphony : { 1, 8 })
+    {
+        for (const auto mode : { synth::UnisonMode::perVoice, synth::UnisonMode::economy })
+        {
+            synth::AdditiveSynthEngine engine;
+            setBenchmarkParams(engine.getVoiceParams(), unison);
+            engine.getVoiceParams().unisonMode = mode;
+            engine.prepareToPlay(kBenchSampleRate, block);
+
+            juce::AudioBuffer<float> buffer(2, block);
+            juce::MidiBuffer midi;
+            for (int n = 0; n < polyphony; ++n)
+                midi.addEvent(juce::MidiMessage::noteOn(1, noteForPartialCount(partials) + n, 0.8f), 0);
+            engine.processBlock(buffer, midi);
+
+            const juce::String modeName = mode == synth::UnisonMode::economy ? "economy" : "voice";
+            juce::MidiBuffer noMidi;
+            runner.run("engine.process/polyphony=" + juce::String(polyphony) + "/unison=" + juce::String(unison)
+                           + "/mode=" + modeName,
+                       makeParams({ { "polyphony", polyphony }, { "unison", unison },
+                                    { "partials", partials }, { "block", block }, { "mode", modeName } }),
+                       block, "sample", [&]()
+            {
+                engine.processBlock(buffer, noMidi);
+                benchmarkSink = benchmarkSink + buffer.getSample(0, block - 1);
+            });
+        }
+    }
+}
+
+/** The economy unison stack on its own, for 2 to 8 copies of a stereo block. */
+void benchmarkUnisonProcessor(BenchmarkRunner& runner)
+{
+    constexpr int block = 256;
+
+    for (const int copies : { 2, 4, 8 })
+    {
+        synth::UnisonProcessor unisonProcessor;
+        unisonProcessor.prepareToPlay(kBenchSampleRate, block);
+        unisonProcessor.setVoiceCount(copies);
+        unisonProcessor.setDetuneAmount(20.0f);
+        unisonProcessor.setStereoWidth(1.0f);
+
+        juce::AudioBuffer<float> buffer(2, block);
+
+        runner.run("unison.process/copies=" + juce::String(copies),
+                   makeParams({ { "copies", copies }, { "block", block } }), block, "sample", [&]()
+        {
+            for (int i = 0; i < block; ++i)
+            {
+                const float sample = 0.1f * static_cast<float>((i % 100) - 50) / 50.0f;
+                buffer.setSample(0, i, sample);
+                buffer.setSample(1, i, sample);
+            }
+
+            unisonProcessor.process(buffer, block);
+            benchmarkSink = benchmarkSink + buffer.getSample(0, block - 1);
+        });
+    }
+}
+
+void benchmarkWaveformAnalyzer(BenchmarkRunner& runner)
+{
+    // A bright two-tone test signal, long enough to fill the analysis window
+    std::vector<float> signal(synth::WaveformAnalyzer::kFFTSize);
+    for (size_t i = 0; i < signal.size(); ++i)
+    {
+        const float t = static_cast<float>(i) / static_cast<float>(kBenchSampleRate);
+        signal[i] = std::sin(synth::SineLUT::kTwoPi * 220.0f * t) + 0.3f * std::sin(synth::SineLUT::kTwoPi * 1870.0f * t);
+    }
+
+    synth::WaveformAnalyzer analyzer;
+
+    runner.run("waveformAnalyzer.analyze/fft=" + juce::String(synth::WaveformAnalyzer::kFFTSize),
+               makeParams({ { "fftSize", synth::WaveformAnalyzer::kFFTSize } }), 1.0, "call", [&]()
+    {
+        analyzer.analyzeSamples(signal.data(), static_cast<int>(signal.size()));
+        benchmarkSink = benchmarkSink + analyzer.getSpectralEnvelope()[1];
+    });
+}
+
+/**
+ * The shared noise layer for a block of voices at different notes: the
+ * per-voice cost is one addVoice, so the cases should differ by little.
+ */
+void benchmarkResidualNoise(BenchmarkRunner& runner)
+{
+    constexpr int block = 256;
+
+    for (const int voices : { 1, 16, 64 })
+    {
+        synth::ResidualNoise noise;
+        noise.prepare(kBenchSampleRate, block);
+
+        juce::AudioBuffer<float> buffer(2, block);
+
+        runner.run("noise.render/voices=" + juce::String(voices),
+                   makeParams({ { "voices", voices }, { "block", block } }), block, "sample", [&]()
+        {
+            buffer.clear();
+            noise.beginBlock(block, -3.0f, nullptr, 0);
+
+            for (int v = 0; v < voices; ++v)
+                noise.addVoice(0.05, 110.0 * (1 + v % 24), block);
+
+            noise.render(buffer, block);
+            benchmarkSink = benchmarkSink + buffer.getSample(0, block - 1);
+        });
+    }
+}
+
+/**
+ * Partial-track analysis of two seconds of a 40-harmonic tone with vibrato,
+ * with the spectral frames on the calling thread, then spread over a pool.
+ */
+void benchmarkPartialAnalysis(BenchmarkRunner& runner)
+{
+    const int numSamples = static_cast<int>(2.0 * kBenchSampleRate);
+    std::vector<float> signal(static_cast<size_t>(numSamples));
+    double phase = 0.0;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const double t = i / kBenchSampleRate;
+        phase += juce::MathConstants<double>::twoPi * 220.0 * (1.0 + 0.005 * std::sin(juce::MathConstants<double>::twoPi * 5.0 * t))
+                 / kBenchSampleRate;
+
+        double sample = 0.0;
+        for (int n = 1; n <= 40; ++n)
+            sample += std::sin(n * phase) / n;
+        signal[static_cast<size_t>(i)] = static_cast<float>(0.3 * sample);
+    }
+
+    const int numCpus = juce::SystemStats::getNumCpus();
+    juce::ThreadPool pool(juce::ThreadPoolOptions{}.withThreadName("Benchmark Analysis").withNumberOfThreads(numCpus));
+
+    for (const bool pooled : { false, true })
+    {
+        const int threads = pooled ? numCpus : 1;
+
+        runner.run("analysis.partialTracks/threads=" + juce::String(threads),
+                   makeParams({ { "seconds", 2 }, { "threads", threads } }), 1.0, "call", [&]()
+        {
+            const auto tracks = synth::PartialAnalysis::analyse(signal.data(), numSamples, kBenchSampleRate, {}, "bench",
+                                                                pooled ? &pool : nullptr);
+            benchmarkSink = benchmarkSink + static_cast<float>(tracks->getReferenceHz());
+        });
+    }
+}
+
+//==============================================================================
+/** Returns the number of regressions found. */
+int compareWithBaseline(const juce::var& current, const juce::File& baselineFile, double tolerancePercent)
+{
+    const auto baseline = juce::JSON::parse(baselineFile);
+    const auto* baselineResults = baseline["results"].getArray();
+
+    if (baselineResults == nullptr)
+    {
+        std::cerr << "Could not read baseline results from " << baselineFile.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    std::map<juce::String, double> baselineMedians;
+    for (const auto& result : *baselineResults)
+        baselineMedians[result["name"].toString()] = static_cast<double>(result["median"]);
+
+    int regressions = 0;
+    std::cout << "\nComparison with " << baselineFile.getFileName() << " (tolerance "
+              << tolerancePercent << "%)\n";
+
+    for (const auto& result : *current["results"].getArray())
+    {
+        const auto name = result["name"].toString();
+        const auto found = baselineMedians.find(name);
+        if (found == baselineMedians.end() || found->second <= 0.0)
+            continue;
+
+        const double deltaPercent = (static_cast<double>(result["median"]) / found->second - 1.0) * 100.0;
+        juce::String verdict;
+
+        if (deltaPercent > tolerancePercent)
+        {
+            verdict = "REGRESSION";
+            ++regressions;
+        }
+        else if (deltaPercent < -tolerancePercent)
+        {
+            verdict = "improved";
+        }
+
+        std::cout << name.paddedRight(' ', 56)
+                  << ((deltaPercent >= 0.0 ? "+" : "") + juce::String(deltaPercent, 1) + "%").paddedLeft(' ', 9)
+                  << "  " << verdict << "\n";
+    }
+
+    std::cout << regressions << " regression(s)" << std::endl;
+    return regressions;
+}
+
+} // namespace
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    const juce::ArgumentList args(argc, argv);
+
+    BenchmarkRunner runner(args.containsOption("--quick"), args.getValueForOption("--filter"));
+
+    benchmarkSineLUT(runner);
+    benchmarkSineAccuracy(runner);
+    benchmarkSpectralPipeline(runner);
+    benchmarkWaveformAnalyzer(runner);
+    benchmarkPartialAnalysis(runner);
+    benchmarkVoiceRender<float>(runner);
+    benchmarkVoiceRender<double>(runner);
+    benchmarkVoiceSineKernels(runner);
+    benchmarkRenderKernels(runner);
+    benchmarkVoiceIsa(runner);
+    benchmarkVoiceClosedForm(runner);
+    benchmarkVoicePartialEnvelopes(runner);
+    benchmarkVoiceStereo(runner);
+    benchmarkVoicePitch(runner);
+    benchmarkVoiceTuning(runner);
+    benchmarkVoiceMorph(runner);
+    benchmarkVoiceModulation(runner);
+    benchmarkVoiceResynthesis(runner);
+    benchmarkResidualNoise(runner);
+    benchmarkVoiceCapacity<synth::LiteEngineConfig>(runner, "lite");
+    benchmarkVoiceCapacity<synth::StandardEngineConfig>(runner, "standard");
+    benchmarkVoiceCapacity<synth::HeavyEngineConfig>(runner, "heavy");
+    benchmarkEngine<float>(runner);
+    benchmarkEngine<double>(runner);
+    benchmarkEngineUnisonMode(runner);
+    benchmarkUnisonProcessor(runner);
+
+    const auto json = runner.toJson();
+
+    if (args.containsOption("--out"))
+    {
+        const juce::File outFile = args.getFileForOption("--out");
+        if (!outFile.replaceWithText(juce::JSON::toString(json)))
+        {
+            std::cerr << "Could not write " << outFile.getFullPathName() << std::endl;
+            return 1;
+        }
+        std::cout << "Results written to " << outFile.getFullPathName() << std::endl;
+    }
+
+    if (args.containsOption("--baseline"))
+    {
+        const auto toleranceText = args.getValueForOption("--tolerance");
+        const double tolerance = toleranceText.isNotEmpty() ? toleranceText.getDoubleValue() : 10.0;
+
+        if (compareWithBaseline(json, args.getFileForOption("--baseline"), tolerance) > 0)
+            return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,190 @@
+/*
+  ==============================================================================
+    ProcessorHarness.h - Helpers for driving the plugin processor without a host
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+namespace tools
+{
+
+/** Set a parameter by ID from its plain (denormalised) value, as a host would. */
+inline void setParameter(AdditiveSynthesizerAudioProcessor& processor,
+                         const juce::String& parameterId, float plainValue)
+{
+    if (auto* parameter = processor.getAPVTS().getParameter(parameterId))
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(plainValue));
+    else
+        jassertfalse; // unknown parameter ID
+}
+
+/** Create a stereo processor prepared the way a host would before playback. */
+inline std::unique_ptr<AdditiveSynthesizerAudioProcessor> createProcessor(double sampleRate,
+                                                                          int blockSize,
+                                                                          bool nonRealtime)
+{
+    auto processor = std::make_unique<AdditiveSynthesizerAudioProcessor>();
+    processor->setNonRealtime(nonRealtime);
+    processor->setRateAndBufferSizeDetails(sampleRate, blockSize);
+    processor->prepareToPlay(sampleRate, blockSize);
+    return processor;
+}
+
+/**
+ * Read a Standard MIDI File and merge all tracks into one sequence whose
+ * timestamps are in seconds. Returns false if the file can't be parsed.
+ */
+inline bool loadMidiFile(const juce::File& file, juce::MidiMessageSequence& result)
+{
+    juce::FileInputStream stream(file);
+    if (!stream.openedOk())
+        return false;
+
+    juce::MidiFile midiFile;
+    if (!midiFile.readFrom(stream))
+        return false;
+
+    midiFile.convertTimestampTicksToSeconds();
+
+    result.clear();
+    for (int track = 0; track < midiFile.getNumTracks(); ++track)
+        result.addSequence(*midiFile.getTrack(track), 0.0);
+
+    result.updateMatchedPairs();
+    return true;
+}
+
+/**
+ * Load a preset into the processor: either APVTS state XML or the binary
+ * plugin state a host saves (getStateInformation). Restored the way a host
+ * restores it, with the custom ratios, morph slots and resynthesis sample it
+ * references; waits for the sample's analysis, since no message loop runs to
+ * publish it. Returns false on failure.
+ */
+inline bool loadStateFile(AdditiveSynthesizerAudioProcessor& processor, const juce::File& file)
+{
+    juce::MemoryBlock data;
+    if (!file.loadFileAsData(data) || data.getSize() == 0)
+        return false;
+
+    auto xml = juce::parseXML(data.toString());
+    if (xml == nullptr)
+        xml = juce::AudioProcessor::getXmlFromBinary(data.getData(), static_cast<int>(data.getSize()));
+
+    auto& apvts = processor.getAPVTS();
+    if (xml == nullptr || !xml->hasTagName(apvts.state.getType()))
+        return false;
+
+    juce::MemoryBlock state;
+    juce::AudioProcessor::copyXmlToBinary(*xml, state);
+    processor.setStateInformation(state.getData(), static_cast<int>(state.getSize()));
+
+    return processor.waitForResynthesisSample();
+}
+
+/**
+ * Create a writer for a new WAV or FLAC file (chosen by extension), replacing
+ * any existing file. 32 bits means floating point, which FLAC doesn't support.
+ */
+inline std::unique_ptr<juce::AudioFormatWriter> createAudioFileWriter(const juce::File& file, double sampleRate,
+                                                                      int numChannels, int bitsPerSample)
+{
+    const bool flac = file.hasFileExtension("flac");
+    if (flac && bitsPerSample > 24)
+        return {};
+
+    file.getParentDirectory().createDirectory();
+    file.deleteFile();
+
+    auto fileStream = std::make_unique<juce::FileOutputStream>(file);
+    if (!fileStream->openedOk())
+        return {};
+
+    const auto options = juce::AudioFormatWriterOptions{}
+                             .withSampleRate(sampleRate)
+                             .withNumChannels(numChannels)
+                             .withBitsPerSample(bitsPerSample)
+                             .withSampleFormat(bitsPerSample == 32
+                                                   ? juce::AudioFormatWriterOptions::SampleFormat::floatingPoint
+                                                   : juce::AudioFormatWriterOptions::SampleFormat::integral);
+
+    std::unique_ptr<juce::OutputStream> stream = std::move(fileStream);
+
+    if (flac)
+        return juce::FlacAudioFormat().createWriterFor(stream, options);
+
+    return juce::WavAudioFormat().createWriterFor(stream, options);
+}
+
+/** Write a buffer as a 32-bit float WAV file, replacing any existing file. */
+inline bool writeWavFile(const juce::File& file, const juce::AudioBuffer<float>& buffer, double sampleRate)
+{
+    auto writer = createAudioFileWriter(file, sampleRate, buffer.getNumChannels(), 32);
+    return writer != nullptr && writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples());
+}
+
+/** Read a whole audio file into `buffer`. Returns false if it can't be decoded. */
+inline bool readAudioFile(const juce::File& file, juce::AudioBuffer<float>& buffer, double& sampleRate)
+{
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+    if (reader == nullptr)
+        return false;
+
+    buffer.setSize(static_cast<int>(reader->numChannels), static_cast<int>(reader->lengthInSamples));
+    reader->read(&buffer, 0, buffer.getNumSamples(), 0, true, true);
+    sampleRate = reader->sampleRate;
+    return true;
+}
+
+//==============================================================================
+/**
+ * Feeds a sequence (timestamps in seconds) to the processor block by block,
+ * converting each event to a sample offset inside the block it falls in.
+ */
+class SequencePlayer
+{
+public:
+    SequencePlayer(const juce::MidiMessageSequence& sequenceToPlay, double sampleRateToUse)
+        : sequence(sequenceToPlay), sampleRate(sampleRateToUse)
+    {
+    }
+
+    /** Replace `midi` with the events falling in [blockStart, blockStart + numSamples). */
+    void fillBlock(juce::MidiBuffer& midi, juce::int64 blockStart, int numSamples)
+    {
+        midi.clear();
+
+        const juce::int64 blockEnd = blockStart + numSamples;
+        for (; nextEvent < sequence.getNumEvents(); ++nextEvent)
+        {
+            const auto& message = sequence.getEventPointer(nextEvent)->message;
+            const auto position = static_cast<juce::int64>(message.getTimeStamp() * sampleRate);
+            if (position >= blockEnd)
+                break;
+
+            if (!message.isMetaEvent())
+                midi.addEvent(message, static_cast<int>(juce::jmax(position - blockStart, juce::int64(0))));
+        }
+    }
+
+    bool isFinished() const noexcept { return nextEvent >= sequence.getNumEvents(); }
+
+    /** Timestamp of the last event in seconds. */
+    double getLengthSeconds() const { return sequence.getEndTime(); }
+
+private:
+    const juce::MidiMessageSequence& sequence;
+    double sampleRate;
+    int nextEvent = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(SequencePlayer)
+};
+
+} // namespace tools
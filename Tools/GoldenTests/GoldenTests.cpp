@@ -0,0 +1,697 @@
+/*
+  ==============================================================================
+    GoldenTests.cpp - Golden-output regression harness for the DSP
+
+    Usage:
+      AdditiveSynthGoldenTests [--references=<dir>] [--report=<dir>]
+                               [--filter=<substring>] [--record]
+                               [--require-references]
+
+    Renders a fixed set of deterministic scenarios (patch x notes x unison x
+    sample rate) through the plugin processor, offline and without an audio
+    device, and compares each against a stored 32-bit float WAV reference:
+
+      - RMS error: level of (render - reference) relative to the reference,
+        in dB. Must stay below the scenario's rmsToleranceDb.
+      - Spectral difference: largest per-bin difference of the long-term
+        average magnitude spectra, in dB, over bins within 90 dB of the
+        reference peak. Must stay below the scenario's spectralToleranceDb.
+
+    Failing scenarios get a text report plus the render and the difference
+    signal as WAVs in the report directory, for listening and plotting.
+
+    The reference matrix renders through the real-time path, which is the one
+    performance work keeps changing. The offline path a host uses for bounces
+    (isNonRealtime) is checked separately by the bounce_* scenarios, against
+    an exact double-precision evaluation of the same partials computed here:
+
+      - the bounce must be within kBounceToleranceDb (-120 dB) of it, far
+        tighter than anything asked of the real-time path;
+      - toggling isNonRealtime every few blocks during a note must not make
+        the peak error worse than real-time rendering alone, i.e. the
+        switch between paths is seamless.
+
+    Only --record writes to the references directory: it re-renders every
+    reference, which is for intentional sound changes, and the new files
+    are then committed. A missing reference is reported as NEW with its
+    render written to the report directory instead (exit code 0), or as
+    MISSING (exit code 1) with --require-references, which ctest passes.
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "Common/ProcessorHarness.h"
+
+#include <iostream>
+
+#ifndef ADDITIVE_SYNTH_GOLDEN_DIR
+ #define ADDITIVE_SYNTH_GOLDEN_DIR "GoldenReferences"
+#endif
+
+namespace
+{
+
+constexpr int kRenderBlockSize = 256;
+constexpr double kNoteSeconds = 0.6;
+constexpr double kRenderSeconds = 1.0; // note + release tail
+constexpr double kStaggerSeconds = 0.08; // between note-ons of an expressive patch
+
+constexpr double kBounceToleranceDb = -120.0;  // offline render vs exact reference
+constexpr double kBounceSampleRate = 48000.0;
+constexpr double kSwitchPeakMargin = 1.5;      // peak error when toggling vs real-time only
+constexpr int kModeSwitchInterval = 7;         // blocks between isNonRealtime() toggles
+
+constexpr int kSpectrumOrder = 12;
+constexpr int kSpectrumSize = 1 << kSpectrumOrder;
+constexpr double kSpectrumFloorDb = -90.0; // relative to the reference peak
+
+//==============================================================================
+struct Patch
+{
+    const char* name;
+    std::vector<std::pair<const char*, float>> parameters;
+    bool importWaveform = false;
+    bool expressive = false; // MPE-style: staggered notes, one member channel each, with bends
+};
+
+struct NoteSet
+{
+    const char* name;
+    std::vector<int> notes;
+    double spectralToleranceDb; // partials near Nyquist are more sensitive to rounding
+};
+
+struct Scenario
+{
+    juce::String name;
+    const Patch* patch = nullptr;
+    const NoteSet* notes = nullptr;
+    int unison = 1;
+    double sampleRate = 44100.0;
+    double rmsToleranceDb = -60.0;
+    double spectralToleranceDb = 0.5;
+};
+
+const std::vector<Patch>& getPatches()
+{
+    static const std::vector<Patch> patches = {
+        { "init", {} },
+        { "bright", { { "oscRatio", 1.0f }, { "filterCutoff", 256.0f }, { "filterBoost", 12.0f } } },
+        { "square", { { "oscRatio", 0.0f }, { "sqrPhase", 90.0f }, { "filterCutoff", 64.0f } } },
+        { "inharmonic", { { "filterStretch", 1.37f }, { "filterPhase", 120.0f }, { "sawPhase", 45.0f } } },
+        { "imported", { { "waveFilterMix", 1.0f } }, true },
+        { "modulated", { { "lfo1Rate", 5.0f }, { "lfo2Rate", 9.0f }, { "lfo2Shape", 4.0f },
+                         { "mod1Source", 1.0f }, { "mod1Dest", 3.0f }, { "mod1Amount", 0.6f },
+                         { "mod2Source", 3.0f }, { "mod2Dest", 6.0f }, { "mod2Amount", 0.3f },
+                         { "mod3Source", 2.0f }, { "mod3Dest", 1.0f }, { "mod3Amount", 0.1f } } },
+        { "glide_mpe", { { "glideMode", 1.0f }, { "glideTime", 0.15f }, { "mpeEnabled", 1.0f } }, false, true },
+        { "noise", { { "noiseLevel", 0.3f }, { "noiseTilt", -6.0f } } },
+        { "economy", { { "unisonMode", 1.0f }, { "unisonDetune", 30.0f } } },
+    };
+    return patches;
+}
+
+const std::vector<NoteSet>& getNoteSets()
+{
+    static const std::vector<NoteSet> noteSets = {
+        { "low", { 36 }, 0.5 },
+        { "high", { 96 }, 1.0 },
+        { "chord", { 48, 55, 60, 64, 71 }, 0.5 },
+    };
+    return noteSets;
+}
+
+std::vector<Scenario> buildScenarios()
+{
+    std::vector<Scenario> scenarios;
+
+    for (const auto& patch : getPatches())
+        for (const auto& notes : getNoteSets())
+            for (int unison : { 1, 5 })
+                for (double sampleRate : { 44100.0, 96000.0 })
+                {
+                    Scenario s;
+                    s.patch = &patch;
+                    s.notes = &notes;
+                    s.unison = unison;
+                    s.sampleRate = sampleRate;
+                    s.spectralToleranceDb = notes.spectralToleranceDb;
+                    s.name = juce::String(patch.name) + "_" + notes.name + "_u" + juce::String(unison)
+                             + "_" + juce::String(juce::roundToInt(sampleRate));
+                    scenarios.push_back(s);
+                }
+
+    return scenarios;
+}
+
+/** Offline-path accuracy checks; unison 3 exercises detune and panning in double precision. */
+std::vector<Scenario> buildBounceScenarios()
+{
+    std::vector<Scenario> scenarios;
+
+    for (const auto& patch : getPatches())
+    {
+        if (juce::String(patch.name) != "init" && juce::String(patch.name) != "inharmonic"
+            && juce::String(patch.name) != "imported")
+            continue;
+
+        for (const auto& notes : getNoteSets())
+        {
+            if (juce::String(notes.name) == "chord")
+                continue;
+
+            for (int unison : { 1, 3 })
+            {
+                Scenario s;
+                s.patch = &patch;
+                s.notes = &notes;
+                s.unison = unison;
+                s.sampleRate = kBounceSampleRate;
+                s.rmsToleranceDb = kBounceToleranceDb;
+                s.name = "bounce_" + juce::String(patch.name) + "_" + notes.name + "_u" + juce::String(unison)
+                         + "_" + juce::String(juce::roundToInt(kBounceSampleRate));
+                scenarios.push_back(s);
+            }
+        }
+    }
+
+    return scenarios;
+}
+
+//==============================================================================
+/** One cycle of a bright asymmetric waveform, imported through the normal file path. */
+bool loadTestWaveform(AdditiveSynthesizerAudioProcessor& processor)
+{
+    constexpr int kCycleLength = 2048;
+    juce::AudioBuffer<float> cycle(1, kCycleLength);
+
+    for (int i = 0; i < kCycleLength; ++i)
+    {
+        const double phase = juce::MathConstants<double>::twoPi * i / kCycleLength;
+        double value = 0.0;
+        for (int n = 1; n <= 24; ++n)
+            value += std::sin(n * phase + 0.3 * n) / (n % 3 == 0 ? 1.0 : n);
+        cycle.setSample(0, i, static_cast<float>(0.2 * value));
+    }
+
+    const auto file = juce::File::createTempFile(".wav");
+    const bool loaded = tools::writeWavFile(file, cycle, 48000.0)
+                        && processor.getWaveformAnalyzer().loadFile(file);
+    file.deleteFile();
+    return loaded;
+}
+
+enum class RenderMode
+{
+    realtime,  // what a host gets while playing live
+    offline,   // bounce/export: isNonRealtime() is set throughout
+    toggling   // isNonRealtime() flips every kModeSwitchInterval blocks
+};
+
+struct RenderResult
+{
+    juce::AudioBuffer<float> audio;
+    synth::AdditiveVoiceParams voiceParams; // as the engine saw them, for the exact reference
+    float masterGain = 1.0f;
+};
+
+/** Add the events of a block: every note at once on channel 1, or staggered and bent for expressive patches. */
+void addNoteEvents(juce::MidiBuffer& midi, const Patch& patch, const std::vector<int>& notes, double sampleRate,
+                   int position, int numSamples, int noteOffSample)
+{
+    const auto addAt = [&](int sample, const juce::MidiMessage& message)
+    {
+        if (sample >= position && sample < position + numSamples)
+            midi.addEvent(message, sample - position);
+    };
+
+    if (!patch.expressive)
+    {
+        for (int note : notes)
+        {
+            addAt(0, juce::MidiMessage::noteOn(1, note, 0.8f));
+            addAt(noteOffSample, juce::MidiMessage::noteOff(1, note));
+        }
+
+        return;
+    }
+
+    // Each later note glides from the one before; member channels bend on their own, the master channel all of them
+    const int stagger = static_cast<int>(kStaggerSeconds * sampleRate);
+    for (size_t i = 0; i < notes.size(); ++i)
+    {
+        const int channel = 2 + static_cast<int>(i);
+        const int start = stagger * static_cast<int>(i);
+        addAt(start, juce::MidiMessage::noteOn(channel, notes[i], 0.6f + 0.05f * static_cast<float>(i)));
+        addAt(start + stagger / 2, juce::MidiMessage::pitchWheel(channel, i % 2 == 0 ? 10240 : 6144));
+        addAt(noteOffSample, juce::MidiMessage::noteOff(channel, notes[i]));
+    }
+
+    addAt(noteOffSample / 2, juce::MidiMessage::pitchWheel(1, 9216));
+}
+
+RenderResult renderScenario(const Scenario& scenario, RenderMode mode = RenderMode::realtime)
+{
+    auto processor = tools::createProcessor(scenario.sampleRate, kRenderBlockSize, mode == RenderMode::offline);
+
+    for (const auto& [parameterId, value] : scenario.patch->parameters)
+        tools::setParameter(*processor, parameterId, value);
+
+    tools::setParameter(*processor, "unisonCount", static_cast<float>(scenario.unison));
+
+    if (scenario.patch->importWaveform && !loadTestWaveform(*processor))
+        std::cerr << "  warning: could not import test waveform for " << scenario.name << std::endl;
+
+    const int totalSamples = static_cast<int>(kRenderSeconds * scenario.sampleRate);
+    const int noteOffSample = static_cast<int>(kNoteSeconds * scenario.sampleRate);
+
+    juce::AudioBuffer<float> output(2, totalSamples);
+    juce::AudioBuffer<float> block(2, kRenderBlockSize);
+    juce::MidiBuffer midi;
+
+    for (int position = 0; position < totalSamples; position += kRenderBlockSize)
+    {
+        const int numSamples = juce::jmin(kRenderBlockSize, totalSamples - position);
+        block.setSize(2, numSamples, false, false, true);
+        midi.clear();
+
+        if (mode == RenderMode::toggling && (position / kRenderBlockSize) % kModeSwitchInterval == 0 && position > 0)
+            processor->setNonRealtime(!processor->isNonRealtime());
+
+        addNoteEvents(midi, *scenario.patch, scenario.notes->notes, scenario.sampleRate, position, numSamples,
+                      noteOffSample);
+
+        processor->processBlock(block, midi);
+
+        for (int ch = 0; ch < 2; ++ch)
+            output.copyFrom(ch, position, block, ch, 0, numSamples);
+    }
+
+    RenderResult result;
+    result.audio = std::move(output);
+    result.voiceParams = processor->getSynthEngine().getVoiceParams();
+    result.masterGain = juce::Decibels::decibelsToGain(processor->getAPVTS().getRawParameterValue("masterGain")->load());
+    return result;
+}
+
+/**
+ * What the voices are meant to produce, evaluated directly: every partial's
+ * phase computed from the sample index in double precision with std::sin,
+ * using the same harmonic tables, envelope, detune and pan laws as the voice.
+ */
+juce::AudioBuffer<float> renderExactReference(const Scenario& scenario, const RenderResult& rendered)
+{
+    const auto& vp = rendered.voiceParams;
+    const double sampleRate = scenario.sampleRate;
+    const int totalSamples = static_cast<int>(kRenderSeconds * sampleRate);
+    const int noteOffSample = static_cast<int>(kNoteSeconds * sampleRate);
+    const int unison = juce::jlimit(1, 8, vp.unisonCount);
+
+    constexpr double twoPi = juce::MathConstants<double>::twoPi;
+    constexpr double pi = juce::MathConstants<double>::pi;
+
+    std::vector<double> left(static_cast<size_t>(totalSamples), 0.0), right(left.size(), 0.0);
+    std::vector<double> noteLeft(left.size()), noteRight(left.size());
+
+    for (int note : scenario.notes->notes)
+    {
+        std::fill(noteLeft.begin(), noteLeft.end(), 0.0);
+        std::fill(noteRight.begin(), noteRight.end(), 0.0);
+
+        const double noteHz = juce::MidiMessage::getMidiNoteInHertz(note);
+        const double noteGain = juce::MidiMessage::noteOn(1, note, 0.8f).getFloatVelocity() * 0.25;
+
+        // The scenarios are harmonic; the reference keeps its own n^stretch below
+        synth::PartialRatios ratios;
+        ratios.update({ synth::PartialTuning::harmonic, vp.filterStretch });
+
+        auto harmonics = synth::HarmonicSeries::computePartials(vp.oscRatio, vp.sawPhase, vp.sqrPhase,
+                                                                ratios.countBelow(sampleRate * 0.5 / noteHz));
+        synth::SpectralFilter::apply(harmonics, vp.filterCutoff, vp.filterBoost, vp.filterPhase,
+                                     ratios, static_cast<float>(noteHz), sampleRate);
+        if (vp.waveFilterEnabled && vp.waveFilterMix > 0.0f)
+            synth::SpectralFilter::applyWaveformFilter(harmonics, vp.waveFilterSpectrum, vp.waveFilterMix);
+
+        juce::ADSR adsr;
+        adsr.setSampleRate(sampleRate);
+        adsr.setParameters({ vp.envAttack, vp.envDecay, vp.envSustain, vp.envRelease });
+        adsr.noteOn();
+
+        for (int u = 0; u < unison; ++u)
+        {
+            double spread = 0.0, panPos = 0.5;
+            if (unison > 1)
+            {
+                spread = static_cast<double>(u) / (unison - 1) * 2.0 - 1.0;
+                panPos = juce::jlimit(0.0, 1.0, 0.5 + static_cast<double>(vp.stereoWidth) * spread * 0.5);
+            }
+
+            const double freqMul = std::pow(2.0, static_cast<double>(vp.unisonDetune) * spread / 1200.0);
+            const double gain = 1.0 / std::sqrt(static_cast<double>(unison));
+            const double panL = std::cos(panPos * juce::MathConstants<double>::halfPi) * gain;
+            const double panR = std::sin(panPos * juce::MathConstants<double>::halfPi) * gain;
+
+            for (int n = 0; n < harmonics.activeCount; ++n)
+            {
+                const double increment = twoPi * noteHz * std::pow(n + 1.0, static_cast<double>(vp.filterStretch))
+                                         * freqMul / sampleRate;
+                if (increment >= pi || harmonics.amplitudes[n] == 0.0f)
+                    continue;
+
+                for (int i = 0; i < totalSamples; ++i)
+                {
+                    const double value = harmonics.amplitudes[n]
+                                         * std::sin(std::fmod(increment * i, twoPi) + harmonics.phases[n]);
+                    noteLeft[static_cast<size_t>(i)] += value * panL;
+                    noteRight[static_cast<size_t>(i)] += value * panR;
+                }
+            }
+        }
+
+        // Envelope last: the voice applies it to the summed partials
+        for (int i = 0; i < totalSamples; ++i)
+        {
+            if (i == noteOffSample)
+                adsr.noteOff();
+
+            const double envelope = adsr.getNextSample() * noteGain;
+            if (!adsr.isActive())
+                break;
+
+            left[static_cast<size_t>(i)] += noteLeft[static_cast<size_t>(i)] * envelope;
+            right[static_cast<size_t>(i)] += noteRight[static_cast<size_t>(i)] * envelope;
+        }
+    }
+
+    juce::AudioBuffer<float> output(2, totalSamples);
+    for (int i = 0; i < totalSamples; ++i)
+    {
+        output.setSample(0, i, static_cast<float>(left[static_cast<size_t>(i)]) * rendered.masterGain);
+        output.setSample(1, i, static_cast<float>(right[static_cast<size_t>(i)]) * rendered.masterGain);
+    }
+    return output;
+}
+
+//==============================================================================
+/** Long-term average magnitude spectrum in dB (Hann-windowed, 50% overlap, channels summed). */
+std::vector<double> averageSpectrumDb(const juce::AudioBuffer<float>& buffer)
+{
+    juce::dsp::FFT fft(kSpectrumOrder);
+    juce::dsp::WindowingFunction<float> window(kSpectrumSize, juce::dsp::WindowingFunction<float>::hann, false);
+
+    std::vector<float> frame(static_cast<size_t>(kSpectrumSize * 2));
+    std::vector<double> sum(static_cast<size_t>(kSpectrumSize / 2 + 1), 0.0);
+    int numFrames = 0;
+
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+    {
+        for (int start = 0; start + kSpectrumSize <= buffer.getNumSamples(); start += kSpectrumSize / 2)
+        {
+            std::fill(frame.begin(), frame.end(), 0.0f);
+            std::copy_n(buffer.getReadPointer(ch, start), kSpectrumSize, frame.begin());
+            window.multiplyWithWindowingTable(frame.data(), static_cast<size_t>(kSpectrumSize));
+            fft.performFrequencyOnlyForwardTransform(frame.data(), true);
+
+            for (size_t bin = 0; bin < sum.size(); ++bin)
+                sum[bin] += frame[bin];
+            ++numFrames;
+        }
+    }
+
+    std::vector<double> db(sum.size());
+    for (size_t bin = 0; bin < sum.size(); ++bin)
+        db[bin] = 20.0 * std::log10(sum[bin] / juce::jmax(1, numFrames) + 1.0e-12);
+    return db;
+}
+
+struct Comparison
+{
+    bool lengthMismatch = false;
+    double referenceRms = 0.0;
+    double errorRms = 0.0;
+    double rmsErrorDb = -300.0;   // error level relative to the reference
+    double peakError = 0.0;
+    int peakErrorSample = 0;
+    int firstDivergentSample = -1; // first sample whose error exceeds the RMS tolerance level
+    double spectralDiffDb = 0.0;
+    double spectralDiffHz = 0.0;
+    double referenceDbAtWorst = 0.0, renderDbAtWorst = 0.0;
+    juce::AudioBuffer<float> difference;
+};
+
+Comparison compare(const juce::AudioBuffer<float>& render, const juce::AudioBuffer<float>& reference,
+                   const Scenario& scenario)
+{
+    Comparison c;
+
+    if (render.getNumChannels() != reference.getNumChannels()
+        || render.getNumSamples() != reference.getNumSamples())
+    {
+        c.lengthMismatch = true;
+        return c;
+    }
+
+    const int numChannels = render.getNumChannels();
+    const int numSamples = render.getNumSamples();
+    c.difference.setSize(numChannels, numSamples);
+
+    double referenceEnergy = 0.0, errorEnergy = 0.0;
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const float* r = render.getReadPointer(ch);
+        const float* ref = reference.getReadPointer(ch);
+        float* diff = c.difference.getWritePointer(ch);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            diff[i] = r[i] - ref[i];
+            referenceEnergy += static_cast<double>(ref[i]) * ref[i];
+            errorEnergy += static_cast<double>(diff[i]) * diff[i];
+
+            if (std::abs(diff[i]) > c.peakError)
+            {
+                c.peakError = std::abs(diff[i]);
+                c.peakErrorSample = i;
+            }
+        }
+    }
+
+    const double count = static_cast<double>(numChannels) * numSamples;
+    c.referenceRms = std::sqrt(referenceEnergy / count);
+    c.errorRms = std::sqrt(errorEnergy / count);
+
+    if (c.errorRms > 0.0)
+        c.rmsErrorDb = 20.0 * std::log10(c.errorRms / juce::jmax(c.referenceRms, 1.0e-9));
+
+    const double divergenceLevel = c.referenceRms * std::pow(10.0, scenario.rmsToleranceDb / 20.0);
+    for (int i = 0; i < numSamples && c.firstDivergentSample < 0; ++i)
+        for (int ch = 0; ch < numChannels; ++ch)
+            if (std::abs(c.difference.getSample(ch, i)) > divergenceLevel)
+            {
+                c.firstDivergentSample = i;
+                break;
+            }
+
+    const auto renderDb = averageSpectrumDb(render);
+    const auto referenceDb = averageSpectrumDb(reference);
+    const double peakDb = *std::max_element(referenceDb.begin(), referenceDb.end());
+
+    for (size_t bin = 0; bin < referenceDb.size(); ++bin)
+    {
+        if (referenceDb[bin] < peakDb + kSpectrumFloorDb && renderDb[bin] < peakDb + kSpectrumFloorDb)
+            continue;
+
+        const double diff = std::abs(renderDb[bin] - referenceDb[bin]);
+        if (diff > c.spectralDiffDb)
+        {
+            c.spectralDiffDb = diff;
+            c.spectralDiffHz = static_cast<double>(bin) * scenario.sampleRate / kSpectrumSize;
+            c.referenceDbAtWorst = referenceDb[bin] - peakDb;
+            c.renderDbAtWorst = renderDb[bin] - peakDb;
+        }
+    }
+
+    return c;
+}
+
+bool passes(const Comparison& c, const Scenario& scenario)
+{
+    return !c.lengthMismatch
+           && c.rmsErrorDb <= scenario.rmsToleranceDb
+           && c.spectralDiffDb <= scenario.spectralToleranceDb;
+}
+
+juce::String describe(const Comparison& c, const Scenario& scenario)
+{
+    if (c.lengthMismatch)
+        return "render and reference differ in length or channel count";
+
+    juce::String text;
+    text << "scenario:            " << scenario.name << "\n"
+         << "patch / notes:       " << scenario.patch->name << " / " << scenario.notes->name
+         << ", unison " << scenario.unison << ", " << juce::roundToInt(scenario.sampleRate) << " Hz\n"
+         << "RMS error:           " << juce::String(c.rmsErrorDb, 2) << " dB (tolerance "
+         << juce::String(scenario.rmsToleranceDb, 1) << " dB)\n"
+         << "reference RMS:       " << juce::String(c.referenceRms, 6) << "\n"
+         << "peak error:          " << juce::String(c.peakError, 6) << " at sample " << c.peakErrorSample
+         << " (" << juce::String(c.peakErrorSample / scenario.sampleRate, 4) << " s)\n"
+         << "first divergence:    "
+         << (c.firstDivergentSample >= 0 ? "sample " + juce::String(c.firstDivergentSample)
+                                               + " (" + juce::String(c.firstDivergentSample / scenario.sampleRate, 4) + " s)"
+                                         : juce::String("none"))
+         << "\n"
+         << "spectral difference: " << juce::String(c.spectralDiffDb, 2) << " dB at "
+         << juce::String(c.spectralDiffHz, 1) << " Hz (tolerance "
+         << juce::String(scenario.spectralToleranceDb, 2) << " dB)\n"
+         << "  reference / render at that bin: " << juce::String(c.referenceDbAtWorst, 1) << " / "
+         << juce::String(c.renderDbAtWorst, 1) << " dB re. reference peak\n";
+    return text;
+}
+
+} // namespace
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    const juce::ArgumentList args(argc, argv);
+
+    const juce::File referenceDir = args.containsOption("--references")
+                                        ? args.getFileForOption("--references")
+                                        : juce::File(ADDITIVE_SYNTH_GOLDEN_DIR);
+    const juce::File reportDir = args.containsOption("--report")
+                                     ? args.getFileForOption("--report")
+                                     : juce::File::getCurrentWorkingDirectory().getChildFile("golden-report");
+
+    const bool record = args.containsOption("--record");
+    const bool requireReferences = args.containsOption("--require-references");
+    const auto filter = args.getValueForOption("--filter");
+
+    std::cout << "References: " << referenceDir.getFullPathName() << std::endl;
+
+    int passed = 0, failed = 0, recorded = 0, missing = 0;
+
+    for (const auto& scenario : buildScenarios())
+    {
+        if (filter.isNotEmpty() && !scenario.name.contains(filter))
+            continue;
+
+        const auto render = renderScenario(scenario).audio;
+        const auto referenceFile = referenceDir.getChildFile(scenario.name + ".wav");
+        const auto label = scenario.name.paddedRight(' ', 32);
+
+        if (record || !referenceFile.existsAsFile())
+        {
+            // Never write into the references from a plain run: only --record changes them
+            const auto target = record ? referenceFile : reportDir.getChildFile(scenario.name + "-new.wav");
+            target.getParentDirectory().createDirectory();
+
+            if (!tools::writeWavFile(target, render, scenario.sampleRate))
+            {
+                std::cout << label << "ERROR writing " << target.getFullPathName() << std::endl;
+                ++failed;
+                continue;
+            }
+
+            if (record)
+            {
+                std::cout << label << "RECORDED" << std::endl;
+                ++recorded;
+            }
+            else
+            {
+                std::cout << label << (requireReferences ? "MISSING" : "NEW") << " (render in "
+                          << target.getFullPathName() << ")" << std::endl;
+                ++(requireReferences ? missing : recorded);
+            }
+
+            continue;
+        }
+
+        juce::AudioBuffer<float> reference;
+        double referenceRate = 0.0;
+        if (!tools::readAudioFile(referenceFile, reference, referenceRate))
+        {
+            std::cout << label << "ERROR reading " << referenceFile.getFullPathName() << std::endl;
+            ++failed;
+            continue;
+        }
+
+        const auto comparison = compare(render, reference, scenario);
+
+        if (passes(comparison, scenario))
+        {
+            std::cout << label << "ok    rms " << juce::String(comparison.rmsErrorDb, 1).paddedLeft(' ', 7)
+                      << " dB  spectral " << juce::String(comparison.spectralDiffDb, 2) << " dB" << std::endl;
+            ++passed;
+            continue;
+        }
+
+        ++failed;
+        const auto report = describe(comparison, scenario);
+        std::cout << label << "FAIL" << std::endl << report;
+
+        reportDir.createDirectory();
+        reportDir.getChildFile(scenario.name + ".txt").replaceWithText(report);
+        tools::writeWavFile(reportDir.getChildFile(scenario.name + "-render.wav"), render, scenario.sampleRate);
+        if (!comparison.lengthMismatch)
+            tools::writeWavFile(reportDir.getChildFile(scenario.name + "-diff.wav"),
+                                comparison.difference, scenario.sampleRate);
+    }
+
+    for (const auto& scenario : buildBounceScenarios())
+    {
+        if (filter.isNotEmpty() && !scenario.name.contains(filter))
+            continue;
+
+        const auto offline = renderScenario(scenario, RenderMode::offline);
+        const auto exact = renderExactReference(scenario, offline);
+        const auto realtime = renderScenario(scenario, RenderMode::realtime);
+        const auto toggling = renderScenario(scenario, RenderMode::toggling);
+
+        const auto bounce = compare(offline.audio, exact, scenario);
+        const auto live = compare(realtime.audio, exact, scenario);
+        const auto switched = compare(toggling.audio, exact, scenario);
+
+        const bool accurate = !bounce.lengthMismatch && bounce.rmsErrorDb <= scenario.rmsToleranceDb;
+        const bool seamless = !switched.lengthMismatch
+                              && switched.peakError <= live.peakError * kSwitchPeakMargin + 1.0e-6;
+
+        std::cout << scenario.name.paddedRight(' ', 32) << (accurate && seamless ? "ok  " : "FAIL")
+                  << "  offline rms " << juce::String(bounce.rmsErrorDb, 1) << " dB, real-time rms "
+                  << juce::String(live.rmsErrorDb, 1) << " dB, switching peak "
+                  << juce::String(switched.peakError, 7) << " (real-time " << juce::String(live.peakError, 7)
+                  << ")" << std::endl;
+
+        if (accurate && seamless)
+        {
+            ++passed;
+            continue;
+        }
+
+        ++failed;
+        juce::String report = describe(bounce, scenario);
+        report << "switching peak error: " << juce::String(switched.peakError, 7) << " at sample "
+               << switched.peakErrorSample << " (real-time only: " << juce::String(live.peakError, 7)
+               << ", allowed x" << kSwitchPeakMargin << ")\n";
+        std::cout << report;
+
+        reportDir.createDirectory();
+        reportDir.getChildFile(scenario.name + ".txt").replaceWithText(report);
+        tools::writeWavFile(reportDir.getChildFile(scenario.name + "-render.wav"), offline.audio, scenario.sampleRate);
+        tools::writeWavFile(reportDir.getChildFile(scenario.name + "-switching.wav"), toggling.audio, scenario.sampleRate);
+        if (!bounce.lengthMismatch)
+            tools::writeWavFile(reportDir.getChildFile(scenario.name + "-diff.wav"),
+                                bounce.difference, scenario.sampleRate);
+    }
+
+    std::cout << std::endl << passed << " passed, " << failed << " failed, "
+              << recorded << (record ? " recorded, " : " new, ") << missing << " missing" << std::endl;
+
+    if (failed > 0)
+        std::cout << "Diff reports written to " << reportDir.getFullPathName() << std::endl;
+
+    return (failed > 0 || missing > 0) ? 1 : 0;
+}
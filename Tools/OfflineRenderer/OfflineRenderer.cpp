@@ -0,0 +1,191 @@
+/*
+  ==============================================================================
+    OfflineRenderer.cpp - Headless MIDI-to-audio renderer
+
+    Usage:
+      AdditiveSynthRender <input.mid> --out=<output.wav|.flac>
+                          [--state=<preset.xml|state.bin>] [--rate=48000]
+                          [--block=512] [--bits=24] [--tail=<max seconds>]
+                          [--sine=<exact|poly7|poly5|poly3|table>] [--no-write]
+
+    Plays a Standard MIDI File through the plugin processor in non-realtime
+    mode, so the voices use their exact offline render path (double-precision
+    phase, exact sine), as fast as the machine allows, and writes the result with an
+    AudioFormatWriter (WAV, or FLAC by extension; --bits=32 writes float WAV).
+    --sine swaps the offline path's std::sin for a cheaper kernel, to trade
+    accuracy for render speed (see DSP/SineKernels.h).
+    After the last MIDI event rendering continues until the output has been
+    silent for 100 ms, or for at most --tail seconds (default 10).
+
+    Prints the real-time factor (audio duration / wall-clock time). With
+    --no-write the file isn't written, so only the render itself is timed,
+    for CPU comparisons between builds.
+
+    No audio device or editor is involved.
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "Common/ProcessorHarness.h"
+
+#include <iostream>
+
+namespace
+{
+
+constexpr double kSilenceThreshold = 1.0e-5; // -100 dBFS
+constexpr double kSilenceSeconds = 0.1;
+
+int getIntOption(const juce::ArgumentList& args, const juce::String& option, int fallback)
+{
+    const auto text = args.getValueForOption(option);
+    return text.isNotEmpty() ? text.getIntValue() : fallback;
+}
+
+void printUsage()
+{
+    std::cout << "Usage: AdditiveSynthRender <input.mid> --out=<output.wav|.flac> [--state=<preset>]"
+                 " [--rate=48000] [--block=512] [--bits=24] [--tail=<seconds>]"
+                 " [--sine=<exact|poly7|poly5|poly3|table>] [--no-write]"
+              << std::endl;
+}
+
+} // namespace
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    const juce::ArgumentList args(argc, argv);
+
+    if (args.size() == 0 || args.containsOption("--help|-h"))
+    {
+        printUsage();
+        return args.size() == 0 ? 1 : 0;
+    }
+
+    const auto midiFile = args[0].resolveAsFile();
+    const bool writeOutput = !args.containsOption("--no-write");
+
+    if (writeOutput && !args.containsOption("--out"))
+    {
+        printUsage();
+        return 1;
+    }
+
+    const double sampleRate = getIntOption(args, "--rate", 48000);
+    const int blockSize = getIntOption(args, "--block", 512);
+    const int bitsPerSample = getIntOption(args, "--bits", 24);
+    const auto tailText = args.getValueForOption("--tail");
+    const double maxTailSeconds = tailText.isNotEmpty() ? tailText.getDoubleValue() : 10.0;
+
+    if (sampleRate <= 0.0 || blockSize <= 0)
+    {
+        std::cerr << "Sample rate and block size must be positive" << std::endl;
+        return 1;
+    }
+
+    juce::MidiMessageSequence sequence;
+    if (!tools::loadMidiFile(midiFile, sequence))
+    {
+        std::cerr << "Could not read MIDI file " << midiFile.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    auto processor = tools::createProcessor(sampleRate, blockSize, true);
+
+    if (args.containsOption("--state"))
+    {
+        const auto stateFile = args.getFileForOption("--state");
+        if (!tools::loadStateFile(*processor, stateFile))
+        {
+            std::cerr << "Could not load state from " << stateFile.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+
+    if (args.containsOption("--sine"))
+    {
+        const auto sineName = args.getValueForOption("--sine");
+        auto kernel = synth::SineKernel::exact;
+        if (!synth::parseSineKernel(sineName.toRawUTF8(), kernel))
+        {
+            std::cerr << "Unknown sine kernel " << sineName << std::endl;
+            return 1;
+        }
+        processor->setSineKernels(synth::SineKernel::table, kernel);
+    }
+
+    std::unique_ptr<juce::AudioFormatWriter> writer;
+    juce::File outFile;
+    if (writeOutput)
+    {
+        outFile = args.getFileForOption("--out");
+        writer = tools::createAudioFileWriter(outFile, sampleRate, 2, bitsPerSample);
+        if (writer == nullptr)
+        {
+            std::cerr << "Could not create " << outFile.getFullPathName() << " (" << bitsPerSample
+                      << "-bit)" << std::endl;
+            return 1;
+        }
+    }
+
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    juce::MidiBuffer midi;
+    tools::SequencePlayer player(sequence, sampleRate);
+
+    const auto endOfMidi = static_cast<juce::int64>(sequence.getEndTime() * sampleRate);
+    const auto maxLength = endOfMidi + static_cast<juce::int64>(maxTailSeconds * sampleRate);
+    const auto silenceNeeded = static_cast<juce::int64>(kSilenceSeconds * sampleRate);
+
+    juce::int64 position = 0;
+    juce::int64 silentSamples = 0;
+    double renderSeconds = 0.0;
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    while (position < maxLength)
+    {
+        player.fillBlock(midi, position, blockSize);
+
+        const auto blockStart = juce::Time::getHighResolutionTicks();
+        processor->processBlock(buffer, midi);
+        renderSeconds += juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - blockStart);
+
+        if (writer != nullptr && !writer->writeFromAudioSampleBuffer(buffer, 0, blockSize))
+        {
+            std::cerr << "Write failed: " << outFile.getFullPathName() << std::endl;
+            return 1;
+        }
+
+        position += blockSize;
+
+        // Stop once the release tails have died away after the last event
+        if (position > endOfMidi && player.isFinished())
+        {
+            const bool silent = buffer.getMagnitude(0, blockSize) < kSilenceThreshold;
+            silentSamples = silent ? silentSamples + blockSize : 0;
+            if (silentSamples >= silenceNeeded)
+                break;
+        }
+    }
+
+    writer.reset(); // flush and close before timing stops
+
+    const double wallSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    const double audioSeconds = static_cast<double>(position) / sampleRate;
+
+    std::cout << "Rendered " << juce::String(audioSeconds, 2) << " s at " << juce::roundToInt(sampleRate)
+              << " Hz, block " << blockSize << std::endl
+              << "Render time " << juce::String(renderSeconds, 3) << " s (real-time factor "
+              << juce::String(audioSeconds / juce::jmax(renderSeconds, 1.0e-9), 1) << "x)" << std::endl
+              << "Wall time   " << juce::String(wallSeconds, 3) << " s (real-time factor "
+              << juce::String(audioSeconds / juce::jmax(wallSeconds, 1.0e-9), 1) << "x)" << std::endl;
+
+    if (writeOutput)
+        std::cout << "Written to " << outFile.getFullPathName() << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,143 @@
+/*
+  ==============================================================================
+    PartialLibraryBuilder.cpp - Analyse samples into a partial data library
+
+    Usage:
+      AdditiveSynthPartialLibrary --out=<library.partials> [--threads=<n>]
+                                  [--max-lanes=256] [--min-frames=3]
+                                  [--floor=-90] [--relative-floor=-60]
+                                  <sample or directory>...
+
+    Analyses every sample (directories are searched for .wav, .aiff, .flac,
+    .mp3 and .ogg files, not recursively) into partial tracks, places each
+    on the keyboard by its estimated pitch and writes the lot as one
+    memory-mappable partial data file (see DSP/PartialDataFile.h) that the
+    plugin's Resynth button opens without re-analysing anything.
+
+    Samples are analysed one after another, the frames of each spread over
+    --threads threads (default: one per core).
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "DSP/PartialAnalysis.h"
+#include "DSP/PartialDataFile.h"
+
+#include <iostream>
+
+namespace
+{
+
+juce::String getOption(const juce::ArgumentList& args, const juce::String& option, const juce::String& fallback)
+{
+    const auto value = args.getValueForOption(option);
+    return value.isNotEmpty() ? value : fallback;
+}
+
+/** The samples named on the command line, directories expanded (sorted by name). */
+juce::Array<juce::File> collectSamples(const juce::ArgumentList& args)
+{
+    const juce::String wildcard = "*.wav;*.aiff;*.aif;*.flac;*.mp3;*.ogg";
+    juce::Array<juce::File> samples;
+
+    for (const auto& argument : args.arguments)
+    {
+        if (argument.isLongOption() || argument.isShortOption())
+            continue;
+
+        const auto file = argument.resolveAsFile();
+
+        if (file.isDirectory())
+        {
+            auto found = file.findChildFiles(juce::File::findFiles, false, wildcard);
+            found.sort();
+            samples.addArray(found);
+        }
+        else
+        {
+            samples.add(file);
+        }
+    }
+
+    return samples;
+}
+
+} // namespace
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    const juce::ArgumentList args(argc, argv);
+    const auto samples = collectSamples(args);
+
+    if (!args.containsOption("--out") || samples.isEmpty())
+    {
+        std::cout << "Usage: AdditiveSynthPartialLibrary --out=<library.partials> [--threads=<n>]"
+                     " [--max-lanes=256] [--min-frames=3] [--floor=-90] [--relative-floor=-60]"
+                     " <sample or directory>..."
+                  << std::endl;
+        return 1;
+    }
+
+    synth::PartialAnalysis::Settings settings;
+    settings.maxLanes = juce::jlimit(1, synth::kMaxHarmonics,
+                                     getOption(args, "--max-lanes", juce::String(settings.maxLanes)).getIntValue());
+    settings.minTrackFrames = juce::jmax(1, getOption(args, "--min-frames", juce::String(settings.minTrackFrames)).getIntValue());
+    settings.floorDb = getOption(args, "--floor", juce::String(settings.floorDb)).getFloatValue();
+    settings.relativeFloorDb = getOption(args, "--relative-floor", juce::String(settings.relativeFloorDb)).getFloatValue();
+
+    const auto threadsText = args.getValueForOption("--threads");
+    const int numThreads = juce::jmax(1, threadsText.isNotEmpty() ? threadsText.getIntValue()
+                                                                   : juce::SystemStats::getNumCpus());
+    juce::ThreadPool pool(juce::ThreadPoolOptions{}.withThreadName("Partial Analysis Frames")
+                                                    .withNumberOfThreads(numThreads));
+
+    std::vector<synth::PartialTrackSet::Ptr> sets;
+
+    for (const auto& sample : samples)
+    {
+        const auto tracks = synth::PartialAnalysis::analyseFile(sample, settings, &pool);
+
+        if (tracks == nullptr || tracks->getNumLanes() == 0)
+        {
+            std::cerr << "Skipping " << sample.getFullPathName() << ": nothing to track" << std::endl;
+            continue;
+        }
+
+        std::cout << sample.getFileName() << ": " << tracks->getNumLanes() << " lanes, "
+                  << tracks->getNumFrames() << " frames, "
+                  << juce::String(tracks->getReferenceHz(), 1) << " Hz" << std::endl;
+        sets.push_back(tracks);
+    }
+
+    if (sets.empty())
+    {
+        std::cerr << "No sample could be analysed" << std::endl;
+        return 1;
+    }
+
+    auto outFile = args.getFileForOption("--out");
+    if (!outFile.hasFileExtension(synth::PartialDataFile::kFileExtension))
+        outFile = outFile.withFileExtension(synth::PartialDataFile::kFileExtension);
+
+    const auto library = synth::PartialLibrary::fromSets(std::move(sets), outFile.getFileName());
+
+    for (int i = 0; i < library->getNumEntries(); ++i)
+    {
+        const auto& entry = library->getEntry(i);
+        std::cout << "  " << juce::MidiMessage::getMidiNoteName(entry.lowNote, true, true, 4) << " - "
+                  << juce::MidiMessage::getMidiNoteName(entry.highNote, true, true, 4) << ": "
+                  << entry.tracks->getName() << std::endl;
+    }
+
+    if (!synth::PartialDataFile::write(outFile, *library))
+    {
+        std::cerr << "Could not write " << outFile.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    std::cout << "Wrote " << outFile.getFullPathName() << " (" << outFile.getSize() / 1024 << " KiB)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,379 @@
+/*
+  ==============================================================================
+    AuditHooks.cpp - glibc allocation and pthread locking interposition
+
+    The definitions below take precedence over the C library's for the whole
+    process. Allocations forward to glibc's __libc_* entry points; locking
+    functions forward to the next definition found with dlsym(RTLD_NEXT).
+
+    Recording never allocates: stacks are captured with backtrace() into a
+    fixed table and only symbolised in getCallSites(), outside audited regions.
+  ==============================================================================
+*/
+
+#include "AuditHooks.h"
+
+#if !defined(__linux__) || !defined(__GLIBC__)
+ #error "The real-time audit hooks require Linux with glibc"
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+extern "C"
+{
+void* __libc_malloc(size_t);
+void __libc_free(void*);
+void* __libc_calloc(size_t, size_t);
+void* __libc_realloc(void*, size_t);
+void* __libc_memalign(size_t, size_t);
+}
+
+namespace audit
+{
+namespace
+{
+
+constexpr int kMaxSites = 512;
+constexpr int kMaxFrames = 32;
+constexpr int kHookFrames = 2; // record() and the interposed function
+
+struct SiteSlot
+{
+    std::uint64_t hash = 0; // 0 = free
+    CallKind kind = CallKind::allocation;
+    int numFrames = 0;
+    void* frames[kMaxFrames] = {};
+    long long count = 0;
+};
+
+// Only the audited (real-time) thread writes these; they are read after it stops
+std::array<SiteSlot, kMaxSites> sites;
+std::array<long long, static_cast<size_t>(CallKind::numKinds)> totals{};
+long long unrecordedSites = 0;
+
+thread_local int auditDepth = 0;
+thread_local bool insideHook = false;
+
+std::uint64_t hashStack(void* const* frames, int numFrames, CallKind kind) noexcept
+{
+    std::uint64_t hash = 1469598103934665603ull ^ static_cast<std::uint64_t>(kind);
+    for (int i = 0; i < numFrames; ++i)
+    {
+        hash ^= reinterpret_cast<std::uintptr_t>(frames[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash == 0 ? 1 : hash;
+}
+
+bool shouldRecord() noexcept
+{
+    return auditDepth > 0 && !insideHook;
+}
+
+void record(CallKind kind) noexcept
+{
+    insideHook = true;
+    ++totals[static_cast<size_t>(kind)];
+
+    void* frames[kMaxFrames];
+    const int numFrames = backtrace(frames, kMaxFrames);
+    const auto hash = hashStack(frames + kHookFrames, std::max(0, numFrames - kHookFrames), kind);
+
+    bool stored = false;
+    for (int probe = 0; probe < kMaxSites && !stored; ++probe)
+    {
+        auto& slot = sites[static_cast<size_t>((hash + static_cast<std::uint64_t>(probe)) % kMaxSites)];
+
+        if (slot.hash == hash)
+        {
+            ++slot.count;
+            stored = true;
+        }
+        else if (slot.hash == 0)
+        {
+            slot.hash = hash;
+            slot.kind = kind;
+            slot.numFrames = numFrames;
+            std::copy_n(frames, numFrames, slot.frames);
+            slot.count = 1;
+            stored = true;
+        }
+    }
+
+    if (!stored)
+        ++unrecordedSites;
+
+    insideHook = false;
+}
+
+//==============================================================================
+template <typename Fn>
+Fn resolveNext(const char* name) noexcept
+{
+    return reinterpret_cast<Fn>(dlsym(RTLD_NEXT, name));
+}
+
+using MutexFn = int (*)(pthread_mutex_t*);
+using RwLockFn = int (*)(pthread_rwlock_t*);
+using CondWaitFn = int (*)(pthread_cond_t*, pthread_mutex_t*);
+using CondTimedWaitFn = int (*)(pthread_cond_t*, pthread_mutex_t*, const timespec*);
+using SemFn = int (*)(sem_t*);
+
+struct RealFunctions
+{
+    MutexFn mutexLock = nullptr, mutexTryLock = nullptr;
+    RwLockFn rdLock = nullptr, tryRdLock = nullptr, wrLock = nullptr, tryWrLock = nullptr;
+    CondWaitFn condWait = nullptr;
+    CondTimedWaitFn condTimedWait = nullptr;
+    SemFn semWait = nullptr;
+
+    void resolve() noexcept
+    {
+        if (mutexLock != nullptr)
+            return;
+
+        mutexTryLock  = resolveNext<MutexFn>("pthread_mutex_trylock");
+        rdLock        = resolveNext<RwLockFn>("pthread_rwlock_rdlock");
+        tryRdLock     = resolveNext<RwLockFn>("pthread_rwlock_tryrdlock");
+        wrLock        = resolveNext<RwLockFn>("pthread_rwlock_wrlock");
+        tryWrLock     = resolveNext<RwLockFn>("pthread_rwlock_trywrlock");
+        condWait      = resolveNext<CondWaitFn>("pthread_cond_wait");
+        condTimedWait = resolveNext<CondTimedWaitFn>("pthread_cond_timedwait");
+        semWait       = resolveNext<SemFn>("sem_wait");
+        mutexLock     = resolveNext<MutexFn>("pthread_mutex_lock");
+    }
+};
+
+RealFunctions& real() noexcept
+{
+    static RealFunctions functions;
+    functions.resolve();
+    return functions;
+}
+
+/** Try first, so an audited lock is classified as contended only if it would have blocked. */
+template <typename Lock, typename TryFn, typename LockFn>
+int auditedLock(Lock* lock, TryFn tryLock, LockFn blockingLock) noexcept
+{
+    if (shouldRecord())
+    {
+        if (tryLock(lock) == 0)
+        {
+            record(CallKind::uncontendedLock);
+            return 0;
+        }
+
+        record(CallKind::contendedLock);
+    }
+
+    return blockingLock(lock);
+}
+
+std::string describeFrame(const char* symbol)
+{
+    // glibc format: "binary(mangled+0x1a) [0xaddress]"
+    std::string text(symbol);
+    const auto open = text.find('(');
+    const auto plus = text.find('+', open);
+
+    if (open == std::string::npos || plus == std::string::npos || plus == open + 1)
+        return text;
+
+    const auto mangled = text.substr(open + 1, plus - open - 1);
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(mangled.c_str(), nullptr, nullptr, &status);
+
+    std::string result = status == 0 && demangled != nullptr ? demangled : mangled;
+    std::free(demangled);
+    return result;
+}
+
+} // namespace
+
+//==============================================================================
+const char* getKindName(CallKind kind) noexcept
+{
+    switch (kind)
+    {
+        case CallKind::allocation:      return "allocation";
+        case CallKind::deallocation:    return "deallocation";
+        case CallKind::contendedLock:   return "blocking lock";
+        case CallKind::uncontendedLock: return "uncontended lock";
+        case CallKind::wait:            return "wait";
+        case CallKind::numKinds:        break;
+    }
+    return "unknown";
+}
+
+void initialise()
+{
+    real();
+
+    // The first backtrace() loads the unwinder, which allocates
+    void* frames[4];
+    backtrace(frames, 4);
+}
+
+ScopedAuditedRegion::ScopedAuditedRegion() noexcept { ++auditDepth; }
+ScopedAuditedRegion::~ScopedAuditedRegion() noexcept { --auditDepth; }
+
+long long getCount(CallKind kind) noexcept
+{
+    return totals[static_cast<size_t>(kind)];
+}
+
+long long getNumUnrecordedSites() noexcept
+{
+    return unrecordedSites;
+}
+
+std::vector<CallSite> getCallSites()
+{
+    std::vector<CallSite> result;
+
+    for (const auto& slot : sites)
+    {
+        if (slot.hash == 0)
+            continue;
+
+        CallSite site;
+        site.kind = slot.kind;
+        site.count = slot.count;
+
+        const int numFrames = slot.numFrames - kHookFrames;
+        if (numFrames > 0)
+        {
+            char** symbols = backtrace_symbols(slot.frames + kHookFrames, numFrames);
+            for (int i = 0; i < numFrames && symbols != nullptr; ++i)
+                site.frames.push_back(describeFrame(symbols[i]));
+            std::free(symbols);
+        }
+
+        result.push_back(std::move(site));
+    }
+
+    std::sort(result.begin(), result.end(),
+              [](const CallSite& a, const CallSite& b) { return a.count > b.count; });
+    return result;
+}
+
+void reset() noexcept
+{
+    sites.fill({});
+    totals.fill(0);
+    unrecordedSites = 0;
+}
+
+} // namespace audit
+
+//==============================================================================
+// Interposed C library functions
+
+using audit::CallKind;
+
+extern "C"
+{
+
+void* malloc(size_t size)
+{
+    if (audit::shouldRecord())
+        audit::record(CallKind::allocation);
+    return __libc_malloc(size);
+}
+
+void free(void* pointer)
+{
+    if (pointer != nullptr && audit::shouldRecord())
+        audit::record(CallKind::deallocation);
+    __libc_free(pointer);
+}
+
+void* calloc(size_t count, size_t size)
+{
+    if (audit::shouldRecord())
+        audit::record(CallKind::allocation);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, size_t size)
+{
+    if (audit::shouldRecord())
+        audit::record(CallKind::allocation);
+    return __libc_realloc(pointer, size);
+}
+
+void* memalign(size_t alignment, size_t size)
+{
+    if (audit::shouldRecord())
+        audit::record(CallKind::allocation);
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+    return memalign(alignment, size);
+}
+
+int posix_memalign(void** result, size_t alignment, size_t size)
+{
+    if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0)
+        return EINVAL;
+
+    void* pointer = memalign(alignment, size);
+    if (pointer == nullptr)
+        return ENOMEM;
+
+    *result = pointer;
+    return 0;
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex)
+{
+    auto& fns = audit::real();
+    return audit::auditedLock(mutex, fns.mutexTryLock, fns.mutexLock);
+}
+
+int pthread_rwlock_rdlock(pthread_rwlock_t* lock)
+{
+    auto& fns = audit::real();
+    return audit::auditedLock(lock, fns.tryRdLock, fns.rdLock);
+}
+
+int pthread_rwlock_wrlock(pthread_rwlock_t* lock)
+{
+    auto& fns = audit::real();
+    return audit::auditedLock(lock, fns.tryWrLock, fns.wrLock);
+}
+
+int pthread_cond_wait(pthread_cond_t* condition, pthread_mutex_t* mutex)
+{
+    if (audit::shouldRecord())
+        audit::record(CallKind::wait);
+    return audit::real().condWait(condition, mutex);
+}
+
+int pthread_cond_timedwait(pthread_cond_t* condition, pthread_mutex_t* mutex, const timespec* timeout)
+{
+    if (audit::shouldRecord())
+        audit::record(CallKind::wait);
+    return audit::real().condTimedWait(condition, mutex, timeout);
+}
+
+int sem_wait(sem_t* semaphore)
+{
+    if (audit::shouldRecord())
+        audit::record(CallKind::wait);
+    return audit::real().semWait(semaphore);
+}
+
+} // extern "C"
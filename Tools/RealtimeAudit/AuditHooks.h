@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+    AuditHooks.h - Interposed allocation / locking calls for real-time audits
+
+    AuditHooks.cpp replaces malloc & co. and the pthread locking primitives
+    for the whole process (Linux / glibc). Every call made by a thread while
+    it is inside a ScopedAuditedRegion is recorded with its call stack; calls
+    outside audited regions go straight to the C library.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace audit
+{
+
+enum class CallKind
+{
+    allocation,      // malloc, calloc, realloc, memalign, operator new...
+    deallocation,    // free, operator delete
+    contendedLock,   // mutex / rwlock that was held by another thread: the caller blocked
+    uncontendedLock, // mutex / rwlock acquired without waiting
+    wait,            // condition variable or semaphore wait
+    numKinds
+};
+
+const char* getKindName(CallKind kind) noexcept;
+
+/** Uncontended locks are allowed unless auditing strictly; everything else is a violation. */
+inline bool isViolation(CallKind kind, bool strict) noexcept
+{
+    return kind != CallKind::uncontendedLock || strict;
+}
+
+/**
+ * Resolve the real locking functions and warm up the unwinder, so neither
+ * allocates the first time a hook fires. Call once at startup.
+ */
+void initialise();
+
+/** Marks the calling thread as real-time for the lifetime of the object. */
+class ScopedAuditedRegion
+{
+public:
+    ScopedAuditedRegion() noexcept;
+    ~ScopedAuditedRegion() noexcept;
+
+    ScopedAuditedRegion(const ScopedAuditedRegion&) = delete;
+    ScopedAuditedRegion& operator=(const ScopedAuditedRegion&) = delete;
+};
+
+/** One distinct offending call stack. */
+struct CallSite
+{
+    CallKind kind = CallKind::allocation;
+    long long count = 0;
+    std::vector<std::string> frames; // demangled, innermost first, hook frames removed
+};
+
+/** Total recorded calls of each kind since the last reset(). */
+long long getCount(CallKind kind) noexcept;
+
+/** Distinct call sites recorded since the last reset(), most frequent first. */
+std::vector<CallSite> getCallSites();
+
+/** Number of calls whose stack didn't fit in the site table (still counted). */
+long long getNumUnrecordedSites() noexcept;
+
+/** Clear all counters. Only call while no audited region is active. */
+void reset() noexcept;
+
+} // namespace audit
@@ -0,0 +1,552 @@
+/*
+  ==============================================================================
+    RealtimeAudit.cpp - Real-time safety audit of the plugin's processBlock
+
+    Usage:
+      AdditiveSynthRealtimeAudit [--quick] [--strict] [--scenario=<name>]
+
+    Runs the processor on a dedicated "audio" thread at real-time pace while
+    the main (message) thread does what a host and the editor would do at the
+    same time: play notes, automate parameters, save/restore state, press the
+    on-screen keyboard, import waveforms, edit the morph slots, load custom
+    partial ratios and swap resynthesis libraries (analysed in memory or
+    mapped from a partial data file and paged in by the prefetcher).
+
+    Every allocation, deallocation, lock and wait made by the audio thread
+    inside processBlock is recorded (see AuditHooks.h) and summarised with
+    its call stack. Allocations, blocking (contended) locks and waits are
+    violations; locks acquired without waiting are reported as warnings, or as
+    violations with --strict. Lock sites on the allow-list below (the lock
+    juce::Synthesiser holds while rendering) stay warnings either way, so a
+    strict run fails on any other lock. Exits with code 1 on any violation.
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "Common/ProcessorHarness.h"
+#include "AuditHooks.h"
+#include "DSP/PartialAnalysis.h"
+#include "DSP/PartialDataFile.h"
+
+#include <iostream>
+
+namespace
+{
+
+constexpr double kSampleRate = 48000.0;
+constexpr int kBlockSize = 256;
+constexpr int kMaxBlockSize = kBlockSize * 2; // the notes scenario also sends oversized blocks
+
+using BlockScript = std::function<int(int blockIndex, juce::MidiBuffer& midi)>;
+using MessageThreadActions = std::function<void(AdditiveSynthesizerAudioProcessor&, juce::Random&)>;
+
+struct Scenario
+{
+    juce::String name;
+    juce::String description;
+    BlockScript script;            // fills the block's MIDI, returns its length in samples
+    MessageThreadActions actions;  // called repeatedly on the main thread while audio runs
+};
+
+//==============================================================================
+/** Renders blocks at real-time pace, auditing only the processBlock call itself. */
+class AudioThread : public juce::Thread
+{
+public:
+    AudioThread(AdditiveSynthesizerAudioProcessor& processorToUse, const BlockScript& scriptToUse, int blocks)
+        : juce::Thread("Audited Audio Thread"), processor(processorToUse), script(scriptToUse), numBlocks(blocks)
+    {
+    }
+
+    void run() override
+    {
+        juce::AudioBuffer<float> buffer(2, kMaxBlockSize);
+        juce::MidiBuffer midi;
+        midi.ensureSize(4096);
+
+        const auto startTime = juce::Time::getMillisecondCounterHiRes();
+        double renderedSeconds = 0.0;
+
+        for (int block = 0; block < numBlocks && !threadShouldExit(); ++block)
+        {
+            midi.clear();
+            const int numSamples = juce::jlimit(1, kMaxBlockSize, script(block, midi));
+            buffer.setSize(2, numSamples, false, false, true);
+
+            {
+                const audit::ScopedAuditedRegion auditedRegion;
+                processor.processBlock(buffer, midi);
+            }
+
+            // Keep to real time so message-thread activity overlaps the audio callbacks
+            renderedSeconds += numSamples / kSampleRate;
+            const auto ahead = startTime + renderedSeconds * 1000.0 - juce::Time::getMillisecondCounterHiRes();
+            if (ahead >= 1.0)
+                wait(static_cast<int>(ahead));
+        }
+    }
+
+private:
+    AdditiveSynthesizerAudioProcessor& processor;
+    const BlockScript& script;
+    int numBlocks;
+};
+
+//==============================================================================
+void addChord(juce::MidiBuffer& midi, std::initializer_list<int> notes, bool on, int samplePosition = 0)
+{
+    for (int note : notes)
+        midi.addEvent(on ? juce::MidiMessage::noteOn(1, note, 0.8f) : juce::MidiMessage::noteOff(1, note),
+                      samplePosition);
+}
+
+Scenario makeNotesScenario(int numBlocks)
+{
+    Scenario s;
+    s.name = "notes";
+    s.description = "chords, voice stealing, pitch wheel, sustain pedal, all-notes-off, oversized blocks";
+
+    s.script = [numBlocks](int block, juce::MidiBuffer& midi)
+    {
+        const int phase = block % 32;
+
+        if (phase == 0)
+            addChord(midi, { 48, 52, 55, 59, 62 }, true);
+        if (phase == 4)
+            addChord(midi, { 60, 64, 67, 71, 74, 77 }, true, kBlockSize / 2); // steals voices
+        if (phase == 8)
+            midi.addEvent(juce::MidiMessage::pitchWheel(1, 0x2000 + (block * 97) % 4096), 10);
+        if (phase == 10)
+            midi.addEvent(juce::MidiMessage::controllerEvent(1, 64, 127), 0);
+        if (phase == 12)
+            addChord(midi, { 48, 52, 55, 59, 62, 60, 64, 67, 71, 74, 77 }, false);
+        if (phase == 20)
+            midi.addEvent(juce::MidiMessage::controllerEvent(1, 64, 0), 0);
+        if (phase == 24)
+            midi.addEvent(juce::MidiMessage::allNotesOff(1), 0);
+
+        // Finish with blocks larger than announced in prepareToPlay
+        return block >= numBlocks - 16 ? kMaxBlockSize : kBlockSize;
+    };
+
+    return s;
+}
+
+Scenario makeAutomationScenario()
+{
+    Scenario s;
+    s.name = "automation";
+    s.description = "held chord while every parameter is automated and state is saved/restored";
+
+    s.script = [](int block, juce::MidiBuffer& midi)
+    {
+        if (block % 100 == 0)
+            addChord(midi, { 36, 43, 48, 55, 60, 64, 67, 72 }, true);
+        if (block % 100 == 90)
+            addChord(midi, { 36, 43, 48, 55, 60, 64, 67, 72 }, false);
+        return kBlockSize;
+    };
+
+    s.actions = [](AdditiveSynthesizerAudioProcessor& p, juce::Random& random)
+    {
+        for (auto* parameter : p.getParameters())
+            parameter->setValueNotifyingHost(random.nextFloat());
+
+        if (random.nextInt(20) == 0)
+        {
+            juce::MemoryBlock state;
+            p.getStateInformation(state);
+            p.setStateInformation(state.getData(), static_cast<int>(state.getSize()));
+        }
+    };
+
+    return s;
+}
+
+Scenario makeKeyboardScenario()
+{
+    Scenario s;
+    s.name = "keyboard";
+    s.description = "on-screen keyboard presses mixed with host notes";
+
+    s.script = [](int block, juce::MidiBuffer& midi)
+    {
+        if (block % 16 == 0)
+            addChord(midi, { 40, 47 }, true);
+        if (block % 16 == 12)
+            addChord(midi, { 40, 47 }, false);
+        return kBlockSize;
+    };
+
+    s.actions = [](AdditiveSynthesizerAudioProcessor& p, juce::Random& random)
+    {
+        auto& keyboard = p.getKeyboardState();
+        const int note = 60 + random.nextInt(24);
+
+        if (keyboard.isNoteOn(1, note))
+            keyboard.noteOff(1, note, 0.0f);
+        else
+            keyboard.noteOn(1, note, 0.7f);
+    };
+
+    return s;
+}
+
+Scenario makeImportScenario(const juce::File& waveformFile)
+{
+    Scenario s;
+    s.name = "import";
+    s.description = "waveform imports and filter mix changes under held notes";
+
+    s.script = [](int block, juce::MidiBuffer& midi)
+    {
+        if (block % 50 == 0)
+            addChord(midi, { 45, 52, 57, 61 }, true);
+        if (block % 50 == 45)
+            addChord(midi, { 45, 52, 57, 61 }, false);
+        return kBlockSize;
+    };
+
+    s.actions = [waveformFile](AdditiveSynthesizerAudioProcessor& p, juce::Random& random)
+    {
+        p.getWaveformAnalyzer().loadFile(waveformFile);
+        tools::setParameter(p, "waveFilterMix", random.nextFloat());
+    };
+
+    return s;
+}
+
+Scenario makeMorphScenario(const juce::File& waveformFile)
+{
+    Scenario s;
+    s.name = "morph";
+    s.description = "morph slots stored, loaded and cleared while notes play and the morph is automated";
+
+    s.script = [](int block, juce::MidiBuffer& midi)
+    {
+        if (block % 40 == 0)
+            addChord(midi, { 41, 48, 53, 57, 60 }, true);
+        if (block % 40 == 36)
+            addChord(midi, { 41, 48, 53, 57, 60 }, false);
+        return kBlockSize;
+    };
+
+    s.actions = [waveformFile](AdditiveSynthesizerAudioProcessor& p, juce::Random& random)
+    {
+        const int slot = random.nextInt(4);
+
+        switch (random.nextInt(3))
+        {
+            case 0:  p.storeMorphSlot(slot); break;
+            case 1:  p.loadMorphSlot(slot, waveformFile); break;
+            default: p.clearMorphSlot(slot); break;
+        }
+
+        tools::setParameter(p, "morphAmount", random.nextFloat());
+        tools::setParameter(p, "morphPosition", random.nextFloat());
+        tools::setParameter(p, "oscRatio", random.nextFloat());
+    };
+
+    return s;
+}
+
+Scenario makeRatiosScenario(const juce::Array<juce::File>& ratioFiles)
+{
+    Scenario s;
+    s.name = "ratios";
+    s.description = "custom partial ratio tables loaded while notes play, tuning switched in and out of Custom";
+
+    s.script = [](int block, juce::MidiBuffer& midi)
+    {
+        if (block % 30 == 0)
+            addChord(midi, { 38, 45, 50, 62, 69 }, true);
+        if (block % 30 == 26)
+            addChord(midi, { 38, 45, 50, 62, 69 }, false);
+        return kBlockSize;
+    };
+
+    s.actions = [ratioFiles](AdditiveSynthesizerAudioProcessor& p, juce::Random& random)
+    {
+        p.loadPartialRatios(ratioFiles[random.nextInt(ratioFiles.size())]);
+
+        // Mostly Custom, so the loaded tables are the ones playing
+        tools::setParameter(p, "partialTuning", random.nextInt(4) == 0 ? static_cast<float>(random.nextInt(5)) : 5.0f);
+    };
+
+    return s;
+}
+
+Scenario makeResynthesisScenario(const juce::Array<juce::File>& sources)
+{
+    Scenario s;
+    s.name = "resynthesis";
+    s.description = "resynthesised notes held past the prefetch window while libraries are published and retired";
+
+    // Notes outlast PartialPrefetcher::kWindowSeconds, so the voices keep asking for frames
+    s.script = [](int block, juce::MidiBuffer& midi)
+    {
+        if (block % 200 == 0)
+            addChord(midi, { 43, 55, 62, 67 }, true);
+        if (block % 200 == 190)
+            addChord(midi, { 43, 55, 62, 67 }, false);
+        if (block % 200 == 100)
+            addChord(midi, { 50, 74 }, true, kBlockSize / 3);
+        if (block % 200 == 150)
+            addChord(midi, { 50, 74 }, false);
+        return kBlockSize;
+    };
+
+    // A sample (analysed into memory) and a partial data file (mapped, paged in
+    // by the prefetcher) take turns. There is no message loop to run the
+    // processor's timer, so each load is published by waiting for it here.
+    s.actions = [sources](AdditiveSynthesizerAudioProcessor& p, juce::Random& random)
+    {
+        tools::setParameter(p, "oscSource", 1.0f);
+        tools::setParameter(p, "resynthesisSpeed", 0.25f + 1.5f * random.nextFloat());
+
+        if (random.nextInt(10) == 0 && p.loadResynthesisSample(sources[random.nextInt(sources.size())]))
+            p.waitForResynthesisSample();
+    };
+
+    return s;
+}
+
+juce::File createTestWaveform()
+{
+    juce::AudioBuffer<float> cycle(1, 4096);
+    for (int i = 0; i < cycle.getNumSamples(); ++i)
+        cycle.setSample(0, i, 0.5f * std::sin(juce::MathConstants<float>::twoPi * 3.0f * i / 4096.0f)
+                                  + 0.25f * std::sin(juce::MathConstants<float>::twoPi * 11.0f * i / 4096.0f));
+
+    auto file = juce::File::createTempFile(".wav");
+    tools::writeWavFile(file, cycle, kSampleRate);
+    return file;
+}
+
+/** A few seconds of a decaying, slightly detuned tone for resynthesis. */
+juce::File createTestSample()
+{
+    constexpr double seconds = 3.0;
+    constexpr double frequencies[] = { 110.0, 220.4, 331.1, 443.0, 555.6 };
+
+    juce::AudioBuffer<float> sample(1, static_cast<int>(kSampleRate * seconds));
+    sample.clear();
+    for (int partial = 0; partial < static_cast<int>(std::size(frequencies)); ++partial)
+        for (int i = 0; i < sample.getNumSamples(); ++i)
+        {
+            const double t = i / kSampleRate;
+            sample.addSample(0, i, static_cast<float>(0.3 / (partial + 1) * std::exp(-t * (0.5 + partial))
+                                                      * std::sin(juce::MathConstants<double>::twoPi * frequencies[partial] * t)));
+        }
+
+    auto file = juce::File::createTempFile(".wav");
+    tools::writeWavFile(file, sample, kSampleRate);
+    return file;
+}
+
+/** The sample analysed into a partial data file, which the processor memory-maps. */
+juce::File createTestLibrary(const juce::File& sampleFile)
+{
+    auto file = juce::File::createTempFile(synth::PartialDataFile::kFileExtension);
+    const auto tracks = synth::PartialAnalysis::analyseFile(sampleFile, {});
+    jassert(tracks != nullptr);
+
+    const bool written = synth::PartialDataFile::write(file, *synth::PartialLibrary::fromSets({ tracks }, file.getFileName()));
+    jassert(written);
+    juce::ignoreUnused(written);
+
+    return file;
+}
+
+juce::Array<juce::File> createTestRatios()
+{
+    juce::Array<juce::File> files;
+
+    for (const auto* text : { "1 2.76 5.40 8.93 13.34 18.64", "1, 3/2, 2, 5/2, 3, 7/2, 4, 9/2, 5, 11/2, 6, 13/2" })
+    {
+        files.add(juce::File::createTempFile(".txt"));
+        files.getReference(files.size() - 1).replaceWithText(text);
+    }
+
+    return files;
+}
+
+//==============================================================================
+struct ScenarioResult
+{
+    long long counts[static_cast<size_t>(audit::CallKind::numKinds)] = {};
+    std::vector<audit::CallSite> sites;
+};
+
+ScenarioResult runScenario(const Scenario& scenario, int numBlocks)
+{
+    auto processor = tools::createProcessor(kSampleRate, kBlockSize, false);
+    juce::Random random(0x5eed);
+
+    audit::reset();
+
+    AudioThread audioThread(*processor, scenario.script, numBlocks);
+    audioThread.startThread(juce::Thread::Priority::highest);
+
+    while (audioThread.isThreadRunning())
+    {
+        if (scenario.actions)
+            scenario.actions(*processor, random);
+        juce::Thread::sleep(1);
+    }
+
+    ScenarioResult result;
+    for (int k = 0; k < static_cast<int>(audit::CallKind::numKinds); ++k)
+        result.counts[k] = audit::getCount(static_cast<audit::CallKind>(k));
+    result.sites = audit::getCallSites();
+
+    processor->releaseResources();
+    return result;
+}
+
+//==============================================================================
+/**
+ * Uncontended locks accepted even with --strict, matched on the function that
+ * takes the lock (the first frame past juce::CriticalSection). Keep this list
+ * short and say why each entry is safe: anything not on it fails a strict run.
+ */
+struct AllowedLock
+{
+    const char* caller; // substring of the demangled frame
+    const char* reason;
+};
+
+constexpr AllowedLock kAllowedLocks[] = {
+    // Synthesiser::processNextBlock holds its CriticalSection for the whole
+    // block, and the note / controller handlers it dispatches take it again.
+    // Only the audio thread uses the synth, so the lock never blocks; if it
+    // ever did, the site would be recorded as a blocking lock and fail.
+    { "juce::Synthesiser::", "juce::Synthesiser's own lock, taken on every block" },
+};
+
+const AllowedLock* findAllowedLock(const audit::CallSite& site)
+{
+    if (site.kind != audit::CallKind::uncontendedLock)
+        return nullptr;
+
+    for (const auto& frame : site.frames)
+    {
+        if (frame.find("juce::CriticalSection::") != std::string::npos)
+            continue;
+
+        for (const auto& allowed : kAllowedLocks)
+            if (frame.find(allowed.caller) != std::string::npos)
+                return &allowed;
+
+        return nullptr;
+    }
+
+    return nullptr;
+}
+
+bool isViolation(const audit::CallSite& site, bool strict)
+{
+    return audit::isViolation(site.kind, strict) && findAllowedLock(site) == nullptr;
+}
+
+void printSites(const std::vector<audit::CallSite>& sites, bool strict)
+{
+    constexpr int kMaxSitesShown = 20;
+    constexpr int kMaxFramesShown = 12;
+
+    int shown = 0;
+    for (const auto& site : sites)
+    {
+        if (shown++ == kMaxSitesShown)
+        {
+            std::cout << "    ... " << (sites.size() - kMaxSitesShown) << " more call sites" << std::endl;
+            break;
+        }
+
+        const auto* allowed = findAllowedLock(site);
+        std::cout << "    [" << (isViolation(site, strict) ? "violation" : "warning")
+                  << "] " << audit::getKindName(site.kind) << " x" << site.count;
+        if (allowed != nullptr)
+            std::cout << " (allowed: " << allowed->reason << ")";
+        std::cout << std::endl;
+
+        for (size_t i = 0; i < site.frames.size() && i < kMaxFramesShown; ++i)
+            std::cout << "        " << site.frames[i] << std::endl;
+    }
+}
+
+} // namespace
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    audit::initialise();
+
+    const juce::ArgumentList args(argc, argv);
+    const bool strict = args.containsOption("--strict");
+    const int numBlocks = args.containsOption("--quick") ? 120 : 400;
+    const auto filter = args.getValueForOption("--scenario");
+
+    const auto waveformFile = createTestWaveform();
+    const auto sampleFile = createTestSample();
+    const auto libraryFile = createTestLibrary(sampleFile);
+    const auto ratioFiles = createTestRatios();
+
+    std::vector<Scenario> scenarios;
+    scenarios.push_back(makeNotesScenario(numBlocks));
+    scenarios.push_back(makeAutomationScenario());
+    scenarios.push_back(makeKeyboardScenario());
+    scenarios.push_back(makeImportScenario(waveformFile));
+    scenarios.push_back(makeMorphScenario(waveformFile));
+    scenarios.push_back(makeRatiosScenario(ratioFiles));
+    scenarios.push_back(makeResynthesisScenario({ sampleFile, libraryFile }));
+
+    long long totalViolations = 0;
+
+    for (const auto& scenario : scenarios)
+    {
+        if (filter.isNotEmpty() && !scenario.name.contains(filter))
+            continue;
+
+        std::cout << scenario.name << ": " << scenario.description << std::endl;
+
+        const auto result = runScenario(scenario, numBlocks);
+
+        long long violations = 0;
+        for (int k = 0; k < static_cast<int>(audit::CallKind::numKinds); ++k)
+        {
+            const auto kind = static_cast<audit::CallKind>(k);
+            std::cout << "    " << juce::String(audit::getKindName(kind)).paddedRight(' ', 18)
+                      << result.counts[k] << std::endl;
+
+            if (audit::isViolation(kind, strict))
+                violations += result.counts[k];
+        }
+
+        // Calls whose stack missed the site table can't be matched, so they still count
+        for (const auto& site : result.sites)
+            if (audit::isViolation(site.kind, strict) && findAllowedLock(site) != nullptr)
+                violations -= site.count;
+
+        printSites(result.sites, strict);
+        std::cout << "    => " << (violations > 0 ? "FAIL" : "ok") << std::endl << std::endl;
+        totalViolations += violations;
+    }
+
+    waveformFile.deleteFile();
+    sampleFile.deleteFile();
+    libraryFile.deleteFile();
+    for (const auto& file : ratioFiles)
+        file.deleteFile();
+
+    if (audit::getNumUnrecordedSites() > 0)
+        std::cout << audit::getNumUnrecordedSites() << " calls had stacks beyond the site table" << std::endl;
+
+    std::cout << (totalViolations > 0 ? "Real-time violations: " + juce::String(totalViolations)
+                                      : juce::String("No real-time violations"))
+              << std::endl;
+
+    return totalViolations > 0 ? 1 : 0;
+}
@@ -0,0 +1,454 @@
+/*
+  ==============================================================================
+    StressPlayer.cpp - End-to-end load test through the plugin processor
+
+    Usage:
+      AdditiveSynthStressPlayer [--quick] [--workload=<name>] [--midi=<file.mid>]
+                                [--rates=44100,48000,96000] [--blocks=64,256,1024]
+                                [--seconds=<length>] [--out=<results.json>]
+
+    Replays scripted workloads (and optionally a MIDI file) through
+    AdditiveSynthesizerAudioProcessor::processBlock at every combination of
+    sample rate and block size, timing each block individually. Reports the
+    per-block render time distribution and the worst deadline ratio (render
+    time / block duration): a ratio above 1 is an audible dropout on a real
+    device, however good the average looks.
+
+    Exits with code 1 if any block missed its deadline.
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "Common/ProcessorHarness.h"
+
+#include <iostream>
+
+namespace
+{
+
+//==============================================================================
+/** A patch plus a timed MIDI script and optional per-block automation. */
+struct Workload
+{
+    juce::String name;
+    juce::String description;
+    juce::MidiMessageSequence sequence; // timestamps in seconds
+    double lengthSeconds = 0.0;
+
+    std::function<void(AdditiveSynthesizerAudioProcessor&)> setup;
+    std::function<void(AdditiveSynthesizerAudioProcessor&, double seconds)> automate;
+};
+
+void addNote(juce::MidiMessageSequence& sequence, int note, float velocity,
+             double startSeconds, double durationSeconds)
+{
+    sequence.addEvent(juce::MidiMessage::noteOn(1, note, velocity), startSeconds);
+    sequence.addEvent(juce::MidiMessage::noteOff(1, note), startSeconds + durationSeconds);
+}
+
+void finalise(Workload& workload)
+{
+    workload.sequence.sort();
+    workload.sequence.updateMatchedPairs();
+}
+
+/** Full-polyphony chords with 8 unison voices, retriggered twice a second. */
+Workload makeDenseChords(double lengthSeconds)
+{
+    Workload w;
+    w.name = "dense-chords";
+    w.description = "8-note chords, 8x unison, retriggered every 500 ms";
+    w.lengthSeconds = lengthSeconds;
+
+    w.setup = [](AdditiveSynthesizerAudioProcessor& p)
+    {
+        tools::setParameter(p, "unisonCount", 8.0f);
+        tools::setParameter(p, "unisonDetune", 25.0f);
+        tools::setParameter(p, "stereoWidth", 1.0f);
+        tools::setParameter(p, "filterCutoff", 256.0f);
+        tools::setParameter(p, "envRelease", 0.4f);
+    };
+
+    static constexpr int chordShapes[][8] = {
+        { 36, 43, 48, 52, 55, 60, 64, 67 },
+        { 41, 48, 53, 57, 60, 65, 69, 72 },
+        { 38, 45, 50, 53, 57, 62, 65, 69 },
+        { 43, 50, 55, 59, 62, 67, 71, 74 },
+    };
+
+    int chord = 0;
+    for (double t = 0.0; t < lengthSeconds; t += 0.5, ++chord)
+        for (int note : chordShapes[chord % 4])
+            addNote(w.sequence, note, 0.9f, t, 0.45);
+
+    finalise(w);
+    return w;
+}
+
+/** 32nd-note arpeggio over four octaves: constant note-on traffic and voice stealing. */
+Workload makeFastArpeggio(double lengthSeconds)
+{
+    Workload w;
+    w.name = "fast-arpeggio";
+    w.description = "32nd notes at 180 BPM over 4 octaves, 4x unison, overlapping releases";
+    w.lengthSeconds = lengthSeconds;
+
+    w.setup = [](AdditiveSynthesizerAudioProcessor& p)
+    {
+        tools::setParameter(p, "unisonCount", 4.0f);
+        tools::setParameter(p, "envAttack", 0.001f);
+        tools::setParameter(p, "envRelease", 0.25f);
+    };
+
+    static constexpr int pattern[] = { 0, 4, 7, 11, 12, 16, 19, 23, 24, 28, 31, 35, 36, 31, 28, 24,
+                                       23, 19, 16, 12, 11, 7, 4 };
+    const double step = 60.0 / 180.0 / 8.0;
+
+    int index = 0;
+    for (double t = 0.0; t < lengthSeconds; t += step, ++index)
+    {
+        const int note = 36 + pattern[index % static_cast<int>(std::size(pattern))];
+        const float velocity = 0.5f + 0.5f * static_cast<float>((index * 7) % 11) / 10.0f;
+        addNote(w.sequence, note, velocity, t, step * 0.8);
+    }
+
+    finalise(w);
+    return w;
+}
+
+/** Slow overlapping pad chords whose long releases keep every voice busy. */
+Workload makeSustainedPads(double lengthSeconds)
+{
+    Workload w;
+    w.name = "sustained-pads";
+    w.description = "overlapping 5-note pads, 1 s attack, 8 s release, 6x unison";
+    w.lengthSeconds = lengthSeconds;
+
+    w.setup = [](AdditiveSynthesizerAudioProcessor& p)
+    {
+        tools::setParameter(p, "unisonCount", 6.0f);
+        tools::setParameter(p, "unisonDetune", 40.0f);
+        tools::setParameter(p, "stereoWidth", 1.0f);
+        tools::setParameter(p, "envAttack", 1.0f);
+        tools::setParameter(p, "envSustain", 0.7f);
+        tools::setParameter(p, "envRelease", 8.0f);
+    };
+
+    static constexpr int padShapes[][5] = {
+        { 48, 55, 60, 64, 71 },
+        { 45, 52, 57, 60, 67 },
+        { 50, 57, 62, 65, 72 },
+    };
+
+    int chord = 0;
+    for (double t = 0.0; t < lengthSeconds; t += 1.5, ++chord)
+        for (int note : padShapes[chord % 3])
+            addNote(w.sequence, note, 0.7f, t, 2.5);
+
+    finalise(w);
+    return w;
+}
+
+/** Held chord while every spectral parameter moves each block, forcing a rebuild per block. */
+Workload makeAutomationSweep(double lengthSeconds)
+{
+    Workload w;
+    w.name = "automation-sweep";
+    w.description = "held 8-note chord, 6 spectral parameters automated every block";
+    w.lengthSeconds = lengthSeconds;
+
+    w.setup = [](AdditiveSynthesizerAudioProcessor& p)
+    {
+        tools::setParameter(p, "unisonCount", 4.0f);
+        tools::setParameter(p, "envRelease", 1.0f);
+    };
+
+    w.automate = [](AdditiveSynthesizerAudioProcessor& p, double seconds)
+    {
+        const auto lfo = [seconds](double rateHz, double offset)
+        {
+            return static_cast<float>(0.5 + 0.5 * std::sin(juce::MathConstants<double>::twoPi
+                                                           * (rateHz * seconds + offset)));
+        };
+
+        tools::setParameter(p, "filterCutoff", 1.0f + 255.0f * lfo(0.25, 0.0));
+        tools::setParameter(p, "filterStretch", 0.5f + 1.5f * lfo(0.1, 0.25));
+        tools::setParameter(p, "filterBoost", 24.0f * lfo(0.7, 0.5));
+        tools::setParameter(p, "filterPhase", 360.0f * lfo(1.3, 0.0));
+        tools::setParameter(p, "oscRatio", lfo(0.4, 0.75));
+        tools::setParameter(p, "sawPhase", 360.0f * lfo(2.1, 0.1));
+    };
+
+    for (double t = 0.0; t < lengthSeconds; t += 4.0)
+        for (int note : { 36, 43, 48, 55, 60, 64, 67, 72 })
+            addNote(w.sequence, note, 0.8f, t, 3.9);
+
+    finalise(w);
+    return w;
+}
+
+Workload makeMidiFileWorkload(const juce::File& file)
+{
+    Workload w;
+    w.name = "midi:" + file.getFileName();
+    w.description = file.getFullPathName();
+
+    if (!tools::loadMidiFile(file, w.sequence))
+        return {};
+
+    // Leave room for release tails after the last event
+    w.lengthSeconds = w.sequence.getEndTime() + 2.0;
+    return w;
+}
+
+//==============================================================================
+struct RunResult
+{
+    juce::String workload;
+    double sampleRate = 0.0;
+    int blockSize = 0;
+
+    int numBlocks = 0;
+    double meanMicros = 0.0, p50Micros = 0.0, p90Micros = 0.0, p99Micros = 0.0,
+           p999Micros = 0.0, maxMicros = 0.0;
+    double budgetMicros = 0.0;
+    double worstRatio = 0.0;  // max render time / block duration
+    int missedDeadlines = 0;  // blocks with ratio > 1
+    double worstAtSeconds = 0.0;
+
+    juce::var toVar() const
+    {
+        auto* object = new juce::DynamicObject();
+        object->setProperty("workload", workload);
+        object->setProperty("sampleRate", sampleRate);
+        object->setProperty("blockSize", blockSize);
+        object->setProperty("blocks", numBlocks);
+        object->setProperty("budgetUs", budgetMicros);
+        object->setProperty("meanUs", meanMicros);
+        object->setProperty("p50Us", p50Micros);
+        object->setProperty("p90Us", p90Micros);
+        object->setProperty("p99Us", p99Micros);
+        object->setProperty("p999Us", p999Micros);
+        object->setProperty("maxUs", maxMicros);
+        object->setProperty("worstDeadlineRatio", worstRatio);
+        object->setProperty("worstAtSeconds", worstAtSeconds);
+        object->setProperty("missedDeadlines", missedDeadlines);
+        return juce::var(object);
+    }
+};
+
+double percentile(const std::vector<double>& sorted, double fraction)
+{
+    const auto index = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[juce::jmin(index, sorted.size() - 1)];
+}
+
+RunResult runWorkload(const Workload& workload, double sampleRate, int blockSize)
+{
+    auto processor = tools::createProcessor(sampleRate, blockSize, false);
+    if (workload.setup)
+        workload.setup(*processor);
+
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    juce::MidiBuffer midi;
+    tools::SequencePlayer player(workload.sequence, sampleRate);
+
+    const auto totalSamples = static_cast<juce::int64>(workload.lengthSeconds * sampleRate);
+    const double budgetSeconds = blockSize / sampleRate;
+
+    std::vector<double> blockMicros;
+    blockMicros.reserve(static_cast<size_t>(totalSamples / blockSize + 1));
+
+    RunResult result;
+    result.workload = workload.name;
+    result.sampleRate = sampleRate;
+    result.blockSize = blockSize;
+    result.budgetMicros = budgetSeconds * 1.0e6;
+
+    for (juce::int64 position = 0; position < totalSamples; position += blockSize)
+    {
+        const double seconds = static_cast<double>(position) / sampleRate;
+
+        // Automation and MIDI are prepared outside the timed region, like a host would
+        if (workload.automate)
+            workload.automate(*processor, seconds);
+
+        player.fillBlock(midi, position, blockSize);
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        processor->processBlock(buffer, midi);
+        const double elapsed = juce::Time::highResolutionTicksToSeconds(
+            juce::Time::getHighResolutionTicks() - start);
+
+        blockMicros.push_back(elapsed * 1.0e6);
+
+        const double ratio = elapsed / budgetSeconds;
+        if (ratio > result.worstRatio)
+        {
+            result.worstRatio = ratio;
+            result.worstAtSeconds = seconds;
+        }
+
+        if (ratio > 1.0)
+            ++result.missedDeadlines;
+    }
+
+    processor->releaseResources();
+
+    if (blockMicros.empty())
+        return result;
+
+    result.numBlocks = static_cast<int>(blockMicros.size());
+
+    double sum = 0.0;
+    for (double micros : blockMicros)
+        sum += micros;
+    result.meanMicros = sum / static_cast<double>(blockMicros.size());
+
+    std::sort(blockMicros.begin(), blockMicros.end());
+    result.p50Micros = percentile(blockMicros, 0.5);
+    result.p90Micros = percentile(blockMicros, 0.9);
+    result.p99Micros = percentile(blockMicros, 0.99);
+    result.p999Micros = percentile(blockMicros, 0.999);
+    result.maxMicros = blockMicros.back();
+
+    return result;
+}
+
+//==============================================================================
+std::vector<int> parseIntList(const juce::String& text, std::vector<int> fallback)
+{
+    if (text.isEmpty())
+        return fallback;
+
+    std::vector<int> values;
+    for (const auto& token : juce::StringArray::fromTokens(text, ",", {}))
+        if (token.trim().getIntValue() > 0)
+            values.push_back(token.trim().getIntValue());
+
+    return values.empty() ? fallback : values;
+}
+
+void printHeader()
+{
+    std::cout << juce::String("workload").paddedRight(' ', 26)
+              << juce::String("rate").paddedLeft(' ', 7)
+              << juce::String("block").paddedLeft(' ', 7)
+              << juce::String("budget").paddedLeft(' ', 10)
+              << juce::String("p50").paddedLeft(' ', 9)
+              << juce::String("p99").paddedLeft(' ', 9)
+              << juce::String("p99.9").paddedLeft(' ', 9)
+              << juce::String("max").paddedLeft(' ', 9)
+              << juce::String("worst").paddedLeft(' ', 8)
+              << juce::String("missed").paddedLeft(' ', 8) << std::endl;
+}
+
+void printResult(const RunResult& r)
+{
+    const auto us = [](double value) { return juce::String(value, 1).paddedLeft(' ', 9); };
+
+    std::cout << r.workload.paddedRight(' ', 26)
+              << juce::String(juce::roundToInt(r.sampleRate)).paddedLeft(' ', 7)
+              << juce::String(r.blockSize).paddedLeft(' ', 7)
+              << juce::String(r.budgetMicros, 1).paddedLeft(' ', 10)
+              << us(r.p50Micros) << us(r.p99Micros) << us(r.p999Micros) << us(r.maxMicros)
+              << juce::String(r.worstRatio, 3).paddedLeft(' ', 8)
+              << juce::String(r.missedDeadlines).paddedLeft(' ', 8) << std::endl;
+}
+
+} // namespace
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    // The processor's parameter state needs a message manager to exist
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    const juce::ArgumentList args(argc, argv);
+    const bool quick = args.containsOption("--quick");
+
+    const auto secondsText = args.getValueForOption("--seconds");
+    const double lengthSeconds = secondsText.isNotEmpty() ? secondsText.getDoubleValue()
+                                                          : (quick ? 4.0 : 20.0);
+
+    const auto rates = parseIntList(args.getValueForOption("--rates"),
+                                    quick ? std::vector<int>{ 48000 }
+                                          : std::vector<int>{ 44100, 48000, 96000 });
+    const auto blockSizes = parseIntList(args.getValueForOption("--blocks"),
+                                         quick ? std::vector<int>{ 64, 512 }
+                                               : std::vector<int>{ 32, 64, 128, 256, 512, 1024 });
+
+    std::vector<Workload> workloads;
+    workloads.push_back(makeDenseChords(lengthSeconds));
+    workloads.push_back(makeFastArpeggio(lengthSeconds));
+    workloads.push_back(makeSustainedPads(lengthSeconds));
+    workloads.push_back(makeAutomationSweep(lengthSeconds));
+
+    if (args.containsOption("--midi"))
+    {
+        const auto midiFile = args.getFileForOption("--midi");
+        auto workload = makeMidiFileWorkload(midiFile);
+        if (workload.name.isEmpty())
+        {
+            std::cerr << "Could not read MIDI file " << midiFile.getFullPathName() << std::endl;
+            return 1;
+        }
+        workloads.push_back(std::move(workload));
+    }
+
+    const auto filter = args.getValueForOption("--workload");
+
+    std::cout << "Workloads:" << std::endl;
+    for (const auto& w : workloads)
+        if (filter.isEmpty() || w.name.contains(filter))
+            std::cout << "  " << w.name << " - " << w.description << std::endl;
+    std::cout << "Times in microseconds; worst = max render time / block duration" << std::endl
+              << std::endl;
+
+    printHeader();
+
+    juce::Array<juce::var> results;
+    int totalMissed = 0;
+    double worstRatio = 0.0;
+
+    for (const auto& workload : workloads)
+    {
+        if (filter.isNotEmpty() && !workload.name.contains(filter))
+            continue;
+
+        for (int rate : rates)
+        {
+            for (int blockSize : blockSizes)
+            {
+                const auto result = runWorkload(workload, static_cast<double>(rate), blockSize);
+                printResult(result);
+
+                results.add(result.toVar());
+                totalMissed += result.missedDeadlines;
+                worstRatio = juce::jmax(worstRatio, result.worstRatio);
+            }
+        }
+    }
+
+    std::cout << std::endl << "Worst deadline ratio: " << juce::String(worstRatio, 3)
+              << ", missed deadlines: " << totalMissed << std::endl;
+
+    if (args.containsOption("--out"))
+    {
+        auto* root = new juce::DynamicObject();
+        root->setProperty("worstDeadlineRatio", worstRatio);
+        root->setProperty("missedDeadlines", totalMissed);
+        root->setProperty("runs", results);
+
+        const juce::File outFile = args.getFileForOption("--out");
+        if (!outFile.replaceWithText(juce::JSON::toString(juce::var(root))))
+        {
+            std::cerr << "Could not write " << outFile.getFullPathName() << std::endl;
+            return 1;
+        }
+        std::cout << "Results written to " << outFile.getFullPathName() << std::endl;
+    }
+
+    return totalMissed > 0 ? 1 : 0;
+}